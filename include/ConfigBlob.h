@@ -0,0 +1,166 @@
+/*
+ * ConfigBlob.h - Settings and schedule as one versioned, checksummed NVS blob
+ *
+ * Everything saveSettings() persists (except the MQTT CA certificate, which
+ * is large and rarely changes) is packed into ConfigData and written as a
+ * single NVS blob. Two keys, "cfgA" and "cfgB", take turns: each save goes
+ * to the slot not holding the newest blob, with a generation one higher and
+ * a CRC-32 over header and payload. Boot reads both and keeps the newest one
+ * whose CRC matches, so a save interrupted by a power cut leaves the previous
+ * configuration in place instead of a half-written schedule.
+ *
+ * The price is that any change, even one setpoint, rewrites the whole blob:
+ * about 48 NVS entries of 32 bytes, where per-key storage wrote one. Saves
+ * are coalesced (SettingsStore.h) and skipped when nothing changed, and the
+ * NVS wear line shows the resulting budget.
+ *
+ * Layout rules: append new fields at the end of ConfigData and never move,
+ * resize or retype existing ones. A blob written by older firmware is then a
+ * prefix of the current layout; configBlobLoad() copies what it has over the
+ * defaults already in `data`. A change that cannot be append-only must bump
+ * CONFIG_BLOB_VERSION and convert the old layout in configBlobLoad().
+ * Version 0 is the per-key layout of earlier firmware, which
+ * Main-Thermostat.cpp migrates from only when neither slot key exists.
+ *
+ * A slot with a layout version this firmware does not know (written by
+ * newer firmware) is never overwritten behind the user's back: the firmware
+ * runs on defaults and refuses to save until a factory reset calls
+ * configBlobAllowOverwrite(), so reinstalling the newer firmware still
+ * finds the settings. Slots that only fail their CRC hold nothing worth
+ * keeping; the firmware starts from defaults and the next save replaces them.
+ */
+
+#ifndef CONFIG_BLOB_H
+#define CONFIG_BLOB_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+
+const uint16_t CONFIG_BLOB_VERSION = 1;
+
+struct ConfigPeriod {
+    float heatTemp;
+    float coolTemp;
+    float autoTemp;
+    uint8_t hour;
+    uint8_t minute;
+    bool active;
+    uint8_t reserved;
+};
+
+struct ConfigDay {
+    ConfigPeriod day;
+    ConfigPeriod night;
+    bool enabled;
+    uint8_t reserved[3];
+};
+
+// Strings are NUL-terminated. settingSetText() rejects longer values; one
+// set another way is truncated when packed
+struct ConfigData {
+    float setTempHeat;
+    float setTempCool;
+    float setTempAuto;
+    float tempSwing;
+    float autoTempSwing;
+    float mqttTempDeadband;
+    float mqttHumidityDeadband;
+    float hydronicTempLow;
+    float hydronicTempHigh;
+    float stage2TempDelta;
+    float backupHeatMinTempRise;
+    float backupHeatMaxTempDrop;
+    float tempOffset;
+    float humidityOffset;
+    float euHumiditySetpoint;
+    float euHumidityDeadband;
+    uint32_t stage1MinRuntime;
+    uint32_t displaySleepTimeout;
+    uint32_t overrideEndTime;
+    int32_t fanMinutesPerHour;
+    int32_t mqttPort;
+    int32_t mqttStateHeartbeatMin;
+    int32_t backupHeatRelaySelection;
+    int32_t backupHeatDelayMinutes;
+    int32_t currentBrightness;
+    int32_t euHumidityRelaySelection;
+    int32_t weatherSource;
+    int32_t weatherUpdateInterval;
+    int32_t showerModeDuration;
+    ConfigDay schedule[7];
+
+    bool fanRelayNeeded;
+    bool useFahrenheit;
+    bool mqttEnabled;
+    bool mqttDeviceDiscovery;
+    bool mqttStateJson;
+    bool mqttHistoryFlash;
+    bool mqttTls;
+    bool use24HourClock;
+    bool hydronicHeatingEnabled;
+    bool hydronicLowTempAlertSent;
+    bool stage2HeatingEnabled;
+    bool stage2CoolingEnabled;
+    bool reversingValveEnabled;
+    bool backupHeatEnabled;
+    bool displaySleepEnabled;
+    bool ldrDimmingEnabled;
+    bool euHumidityControlEnabled;
+    bool showerModeEnabled;
+    bool scheduleEnabled;
+    bool scheduleOverride;
+
+    char thermostatMode[8];
+    char fanMode[8];
+    char thermostatRegion[4];
+    char activePeriod[12];
+    char hostname[32];
+    char timeZone[64];
+    char wifiSSID[33];
+    char wifiPassword[65];
+    char mqttServer[64];
+    char mqttUsername[64];
+    char mqttPassword[64];
+    char owmApiKey[48];
+    char owmCity[48];
+    char owmState[32];
+    char owmCountry[8];
+    char haUrl[128];
+    char haToken[256];
+    char haEntityId[96];
+};
+
+struct ConfigBlobStats {
+    uint32_t generation;     // Of the newest blob stored
+    char slot;               // 'A' or 'B', '-' if none yet
+    uint32_t bytes;          // One blob, header included
+    uint32_t loadUs;         // Boot-time read of both slots
+    uint32_t saves;          // Blobs written
+    uint32_t unchanged;      // Saves skipped, payload same as stored
+    uint32_t failures;       // Writes that failed or did not read back
+    uint32_t saveMsMax;
+    bool readOnly;           // Stored blob from newer firmware, saves refused
+};
+
+enum ConfigBlobLoadResult {
+    CONFIG_BLOB_LOADED,      // Newest valid blob copied into `data`
+    CONFIG_BLOB_ABSENT,      // Neither slot key exists
+    CONFIG_BLOB_CORRUPT,     // Keys exist, none passes its CRC; saves replace them
+    CONFIG_BLOB_UNKNOWN_VERSION // Newer layout in a slot; now read-only
+};
+
+// Newest valid blob into `data`, which must hold the defaults on entry
+ConfigBlobLoadResult configBlobLoad(Preferences& prefs, ConfigData& data);
+
+// Write `data` to the other slot. Call with nvsSaveMutex held. True if it
+// was written and read back, or was already stored; false while read-only.
+bool configBlobSave(Preferences& prefs, const ConfigData& data);
+
+// After CONFIG_BLOB_UNKNOWN_VERSION, until configBlobAllowOverwrite()
+bool configBlobReadOnly();
+// Factory reset only: let the next save replace the newer blob
+void configBlobAllowOverwrite();
+
+void configBlobGetStats(ConfigBlobStats& out);
+
+#endif // CONFIG_BLOB_H
@@ -0,0 +1,94 @@
+/*
+ * DebugLog.h - In-memory debug log ring served by /debug and /api/debug
+ *
+ * Multi-producer ring: debugLog() is called from the sensor task (core 1),
+ * loop() and the display task (core 0) and AsyncTCP callbacks, so writers
+ * reserve space with a single atomic add and copy their record in at most two
+ * segments without taking a lock. Readers never block writers; a record that
+ * gets overwritten while it is being read is detected and skipped.
+ *
+ * Records are either preformatted text or "binary": format pointer, millis()
+ * timestamp and raw arguments, expanded to text only when the log is read.
+ */
+
+#ifndef DEBUG_LOG_H
+#define DEBUG_LOG_H
+
+#include <Arduino.h>
+#include <stdarg.h>
+
+const uint32_t DEBUG_BUFFER_SIZE = 65536;     // 64KB ring (must be a power of two)
+const uint32_t DEBUG_RECORD_MAX_PAYLOAD = 1024; // Longer messages are truncated
+const uint32_t DEBUG_ARG_STRING_MAX = 96;       // %s arguments kept per binary record
+const size_t DEBUG_LINE_MAX = 256;              // Formatted line limit (matches debugLog())
+
+// debugLog() stores binary records (formatting deferred to /debug reads)
+#ifndef DEBUG_LOG_BINARY
+#define DEBUG_LOG_BINARY 1
+#endif
+
+// Serial copy of the log:
+//   0  none (debugLog() never formats on the hot path)
+//   1  a low-priority task drains the ring to Serial, so callers only pay for
+//      the ring append; lines still queued when the chip resets are lost
+//   2  debugLog() formats and prints synchronously (use when chasing a crash)
+#ifndef DEBUG_LOG_SERIAL_ECHO
+#define DEBUG_LOG_SERIAL_ECHO 1
+#endif
+
+// Append one message (normally a full line from debugLog()) to the ring
+void addToDebugBuffer(const char* message);
+void addToDebugBuffer(const char* message, size_t len);
+
+// Store a deferred-format record. `format` must be a string literal since it
+// is read again when the record is formatted. Consumes `args`. Returns false
+// (nothing stored) for conversions it can't capture, e.g. %n or %Lf; a
+// message dropped because the ring is blocked still returns true.
+bool addFormatToDebugBuffer(const char* format, va_list args);
+
+// Expand a binary record payload into text, as vsnprintf would have produced
+// it (truncated to outLen - 1). Optionally returns the record's millis() stamp.
+size_t formatBinaryRecord(const uint8_t* payload, uint32_t len, char* out, size_t outLen, uint32_t* timestamp);
+
+// Streaming reader. The cursor holds one decoded record, so a reader needs
+// about 1 KB instead of a copy of the whole ring; it is safe to keep one
+// across AsyncWebServer chunk callbacks while writers keep appending.
+//
+// Records are identified by their sequence number: the free-running byte
+// position of the record in the log stream. It only ever increases (modulo
+// 2^32, compared with wrap-around), so after a read `pos` is the cursor for
+// the next incremental read.
+struct DebugLogCursor {
+    uint32_t pos;   // Sequence number of the next record to load
+    uint32_t end;   // Write position when the read started; later records are left for the next read
+    uint16_t len;   // Bytes in text
+    uint16_t off;   // Bytes of text already consumed
+    bool lapped;    // Records between the requested start and pos were overwritten
+    uint32_t skipped; // Ring bytes lost that way (0 if unknown, e.g. after a reboot)
+    char text[DEBUG_RECORD_MAX_PAYLOAD];
+};
+
+// Start at the oldest record, or at the first record within the newest
+// maxBytes of the ring
+void debugLogCursorBegin(DebugLogCursor& cursor, uint32_t maxBytes);
+
+// Start at sequence number `since` (a previous cursor's pos). If those
+// records were already overwritten, or `since` is from before a reboot,
+// starts at the oldest record and sets cursor.lapped.
+void debugLogCursorSeek(DebugLogCursor& cursor, uint32_t since);
+
+// Load the next record into cursor.text; false once the read is complete
+bool debugLogCursorNext(DebugLogCursor& cursor);
+
+// Copy up to maxLen bytes of log text; 0 once the read is complete
+size_t debugLogRead(DebugLogCursor& cursor, char* out, size_t maxLen);
+
+// Messages dropped because a writer preempted mid-record was holding the
+// oldest slot of the ring
+uint32_t getDebugLogDropped();
+
+// Oldest-to-newest copy of the ring contents (host tools; the web handlers
+// stream through a cursor instead)
+String getDebugLog();
+
+#endif // DEBUG_LOG_H
@@ -0,0 +1,155 @@
+/*
+ * HvacControl.h - HVAC relay control core and schedule evaluation
+ *
+ * The relay state machine (staging, backup heat, EU dehumidification, fan
+ * modes) and the schedule period check live in src/HvacControl.cpp so they
+ * can be built both for the ESP32-S3 and for the host-native PlatformIO
+ * environment (see native/). Everything here depends only on Arduino.h and
+ * FreeRTOS semaphores; display, MQTT and NVS work stays in Main-Thermostat.cpp
+ * and is reached through the firmware hooks declared at the bottom.
+ */
+
+#ifndef HVAC_CONTROL_H
+#define HVAC_CONTROL_H
+
+#include <Arduino.h>
+#include <time.h>
+#include "HardwarePins.h"
+#include "Log.h" // LOG_* macros over debugLog() from Main-Thermostat.cpp
+
+// Schedule system structures
+struct SchedulePeriod {
+    int hour;        // 0-23
+    int minute;      // 0-59
+    float heatTemp;  // Target heating temperature
+    float coolTemp;  // Target cooling temperature
+    float autoTemp;  // Target auto mode temperature
+    bool active;     // Whether this period is enabled
+};
+
+struct DaySchedule {
+    SchedulePeriod day;    // Day period (default 6:00 AM)
+    SchedulePeriod night;  // Night period (default 10:00 PM)
+    bool enabled;          // Whether scheduling is enabled for this day
+};
+
+// Constants
+const int SECONDS_PER_HOUR = 3600;
+const unsigned long STAGE2_MIN_RUNTIME = 60000; // Minimum 60 seconds before stage 2 can deactivate
+const unsigned long scheduleOverrideDuration = 120; // Override duration in minutes (2 hours)
+
+// =============================================================================
+// CONTROL STATE (defined in HvacControl.cpp)
+// =============================================================================
+
+// Setpoints and fan behaviour
+extern float setTempHeat;
+extern float setTempCool;
+extern float setTempAuto;
+extern float tempSwing;
+extern float autoTempSwing;
+extern bool fanRelayNeeded;
+extern int fanMinutesPerHour;
+extern unsigned long lastFanRunTime;
+extern unsigned long fanRunDuration;
+
+// Mode and relay state flags
+extern bool heatingOn;
+extern bool coolingOn;
+extern bool fanOn;
+extern String thermostatMode;
+extern String fanMode;
+
+// Hybrid staging
+extern unsigned long stage1MinRuntime;
+extern float stage2TempDelta;
+extern unsigned long stage1StartTime;
+extern unsigned long stage2StartTime;
+extern bool stage1Active;
+extern bool stage2Active;
+extern bool stage2HeatingEnabled;
+extern bool stage2CoolingEnabled;
+extern bool reversingValveEnabled;
+
+// Backup heat
+extern bool backupHeatEnabled;
+extern int backupHeatRelaySelection;
+extern int backupHeatDelayMinutes;
+extern float backupHeatMinTempRise;
+extern float backupHeatMaxTempDrop;
+extern bool backupHeatActive;
+extern unsigned long backupHeatDemandStart;
+extern unsigned long backupHeatLastTempRiseTime;
+extern float backupHeatLastReferenceTemp;
+
+// US/EU region and EU dehumidification
+extern String thermostatRegion;
+extern bool euHumidityControlEnabled;
+extern int euHumidityRelaySelection;
+extern float euHumiditySetpoint;
+extern float euHumidityDeadband;
+extern bool euHumidityDemandActive;
+
+// Hydronic boiler interlock
+extern bool hydronicHeatingEnabled;
+extern float hydronicTempLow;
+extern float hydronicTempHigh;
+extern bool hydronicLockout;
+
+// Shower mode
+extern bool showerModeEnabled;
+extern int showerModeDuration;
+extern bool showerModeActive;
+extern unsigned long showerModeStartTime;
+
+// 7-day schedule
+extern DaySchedule weekSchedule[7];
+extern bool scheduleEnabled;
+extern bool scheduleOverride;
+extern unsigned long overrideEndTime;
+extern String activePeriod;
+extern bool scheduleUpdatedFlag;
+
+extern SemaphoreHandle_t controlRelaysMutex;
+
+// =============================================================================
+// INPUTS OWNED BY THE FIRMWARE (sensor task, display, settings)
+// =============================================================================
+extern float currentTemp;
+extern float currentHumidity;
+extern float hydronicTemp;
+extern bool ds18b20SensorPresent;
+extern bool displayIsAsleep;
+extern String timeZone;
+
+// =============================================================================
+// CONTROL API
+// =============================================================================
+void controlRelays(float currentTemp);
+void turnOffAllRelays();
+void activateHeating();
+void activateCooling();
+void handleFanControl();
+void controlFanSchedule();
+void enforceBackupHeatRelayConflicts();
+void enforceEUHumidityRelayConflicts();
+int getBackupHeatRelayPin();
+void setBackupHeatRelay(bool enabled);
+void clearBackupHeatState(const char* reason);
+void updateBackupHeatState(bool heatDemandActive, float currentTemp);
+
+void checkSchedule();
+void checkScheduleAt(const struct tm& timeinfo);
+String getCurrentPeriod();
+int getCurrentDayOfWeek();
+
+// =============================================================================
+// FIRMWARE HOOKS (implemented in Main-Thermostat.cpp, stubbed on native)
+// =============================================================================
+void applySchedule(int dayOfWeek, bool isDayPeriod);
+void updateStatusLEDs();
+void setDisplayUpdateFlag();
+void wakeDisplay();
+void buzzerBeep(int duration = 125);
+
+#endif // HVAC_CONTROL_H
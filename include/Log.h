@@ -0,0 +1,127 @@
+/*
+ * Log.h - Levelled, per-subsystem logging on top of debugLog()
+ *
+ *   LOG_INFO(HVAC, "Stage 2 HEATING activated (temp %.1f)\n", temp);
+ *
+ * prints "[HVAC] Stage 2 HEATING activated ..." through debugLog(). Each tag
+ * has a build-time ceiling (LOG_MAX_LEVEL, or LOG_MAX_LEVEL_<TAG> to override
+ * one subsystem); calls above it compile to nothing, including their
+ * argument expressions. Calls at or below the ceiling are still filtered by a
+ * per-tag runtime level, changed from the /debug page (/api/debug/levels).
+ *
+ * The format must be a string literal: the tag prefix is pasted onto it at
+ * compile time.
+ */
+
+#ifndef LOG_H
+#define LOG_H
+
+#include <Arduino.h>
+
+// Raw sink in Main-Thermostat.cpp (Serial + debug ring); always prints
+extern void debugLog(const char* format, ...);
+
+#define LOG_LEVEL_NONE  0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_INFO  3
+#define LOG_LEVEL_DEBUG 4
+#define LOG_LEVEL_TRACE 5
+
+// Highest level compiled in; TRACE (per-frame/per-cycle output) is left out
+// of normal builds. Build with -DLOG_MAX_LEVEL=LOG_LEVEL_TRACE to get it back.
+#ifndef LOG_MAX_LEVEL
+#define LOG_MAX_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+// Runtime level each tag starts at after boot
+#ifndef LOG_DEFAULT_LEVEL
+#define LOG_DEFAULT_LEVEL LOG_LEVEL_INFO
+#endif
+
+// Subsystem tags. Keep the tables in DebugLog.cpp in the same order.
+enum LogTag {
+    LOG_TAG_SYSTEM,
+    LOG_TAG_HVAC,
+    LOG_TAG_SCHEDULE,
+    LOG_TAG_SENSOR,
+    LOG_TAG_DISPLAY,
+    LOG_TAG_MOTION,
+    LOG_TAG_WIFI,
+    LOG_TAG_MQTT,
+    LOG_TAG_WEB,
+    LOG_TAG_OTA,
+    LOG_TAG_WEATHER,
+    LOG_TAG_SETTINGS,
+    LOG_TAG_COUNT
+};
+
+#ifndef LOG_MAX_LEVEL_SYSTEM
+#define LOG_MAX_LEVEL_SYSTEM LOG_MAX_LEVEL
+#endif
+#ifndef LOG_MAX_LEVEL_HVAC
+#define LOG_MAX_LEVEL_HVAC LOG_MAX_LEVEL
+#endif
+#ifndef LOG_MAX_LEVEL_SCHEDULE
+#define LOG_MAX_LEVEL_SCHEDULE LOG_MAX_LEVEL
+#endif
+#ifndef LOG_MAX_LEVEL_SENSOR
+#define LOG_MAX_LEVEL_SENSOR LOG_MAX_LEVEL
+#endif
+#ifndef LOG_MAX_LEVEL_DISPLAY
+#define LOG_MAX_LEVEL_DISPLAY LOG_MAX_LEVEL
+#endif
+#ifndef LOG_MAX_LEVEL_MOTION
+#define LOG_MAX_LEVEL_MOTION LOG_MAX_LEVEL
+#endif
+#ifndef LOG_MAX_LEVEL_WIFI
+#define LOG_MAX_LEVEL_WIFI LOG_MAX_LEVEL
+#endif
+#ifndef LOG_MAX_LEVEL_MQTT
+#define LOG_MAX_LEVEL_MQTT LOG_MAX_LEVEL
+#endif
+#ifndef LOG_MAX_LEVEL_WEB
+#define LOG_MAX_LEVEL_WEB LOG_MAX_LEVEL
+#endif
+#ifndef LOG_MAX_LEVEL_OTA
+#define LOG_MAX_LEVEL_OTA LOG_MAX_LEVEL
+#endif
+#ifndef LOG_MAX_LEVEL_WEATHER
+#define LOG_MAX_LEVEL_WEATHER LOG_MAX_LEVEL
+#endif
+#ifndef LOG_MAX_LEVEL_SETTINGS
+#define LOG_MAX_LEVEL_SETTINGS LOG_MAX_LEVEL
+#endif
+
+// Runtime level per tag (defined in DebugLog.cpp). Single-byte reads and
+// writes, so no locking is needed between the web handler and loggers.
+extern volatile uint8_t logRuntimeLevels[LOG_TAG_COUNT];
+
+const char* logTagName(LogTag tag);
+uint8_t logTagMaxLevel(LogTag tag);      // Build-time ceiling for the tag
+const char* logLevelName(uint8_t level);
+int logTagFromName(const char* name);     // -1 if unknown
+int logLevelFromName(const char* name);   // -1 if unknown; accepts 0-5 too
+bool setLogLevel(LogTag tag, uint8_t level);
+void setAllLogLevels(uint8_t level);
+
+// Tags are pasted/stringified directly in the level macros so a tag name
+// that happens to be a macro elsewhere (DISPLAY, OTA...) is never expanded.
+#define LOG_AT(tagId, maxLevel, level, prefix, fmt, ...)                         \
+    do {                                                                         \
+        if ((level) <= (maxLevel) && (level) <= logRuntimeLevels[tagId])         \
+            debugLog(prefix fmt, ##__VA_ARGS__);                                 \
+    } while (0)
+
+#define LOG_ERROR(tag, fmt, ...) \
+    LOG_AT(LOG_TAG_##tag, LOG_MAX_LEVEL_##tag, LOG_LEVEL_ERROR, "[" #tag "] ERROR: ", fmt, ##__VA_ARGS__)
+#define LOG_WARN(tag, fmt, ...) \
+    LOG_AT(LOG_TAG_##tag, LOG_MAX_LEVEL_##tag, LOG_LEVEL_WARN, "[" #tag "] WARNING: ", fmt, ##__VA_ARGS__)
+#define LOG_INFO(tag, fmt, ...) \
+    LOG_AT(LOG_TAG_##tag, LOG_MAX_LEVEL_##tag, LOG_LEVEL_INFO, "[" #tag "] ", fmt, ##__VA_ARGS__)
+#define LOG_DEBUG(tag, fmt, ...) \
+    LOG_AT(LOG_TAG_##tag, LOG_MAX_LEVEL_##tag, LOG_LEVEL_DEBUG, "[" #tag "] ", fmt, ##__VA_ARGS__)
+#define LOG_TRACE(tag, fmt, ...) \
+    LOG_AT(LOG_TAG_##tag, LOG_MAX_LEVEL_##tag, LOG_LEVEL_TRACE, "[" #tag "] ", fmt, ##__VA_ARGS__)
+
+#endif // LOG_H
@@ -0,0 +1,48 @@
+/*
+ * MqttCommandParser.h - In-place parser for the schedule/set command
+ *
+ * Parses the flat JSON object Home Assistant sends on <hostname>/schedule/set
+ * straight from the payload bytes into a fixed struct: no JsonDocument, no
+ * String, nothing on the heap. Only the known members are kept; anything
+ * else, including nested values, is skipped.
+ *
+ *   {"day": 0, "period": "day", "hour": 6, "minute": 30,
+ *    "heat": 72.0, "cool": 78.0, "auto": 74.0, "active": true, "enabled": true}
+ */
+
+#ifndef MQTT_COMMAND_PARSER_H
+#define MQTT_COMMAND_PARSER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// MqttScheduleUpdate::fields: which optional members were present
+enum {
+    MQTT_SCHEDULE_HOUR    = 1 << 0,
+    MQTT_SCHEDULE_MINUTE  = 1 << 1,
+    MQTT_SCHEDULE_HEAT    = 1 << 2,
+    MQTT_SCHEDULE_COOL    = 1 << 3,
+    MQTT_SCHEDULE_AUTO    = 1 << 4,
+    MQTT_SCHEDULE_ACTIVE  = 1 << 5,
+    MQTT_SCHEDULE_ENABLED = 1 << 6
+};
+
+struct MqttScheduleUpdate {
+    int day;             // MQTT numbering, 0 = Monday; -1 if missing
+    char period[8];      // "day" or "night" as sent; empty if missing
+    uint8_t fields;      // MQTT_SCHEDULE_* bits
+    int hour;
+    int minute;
+    float heat;
+    float cool;
+    float autoTemp;
+    bool active;
+    bool enabled;
+};
+
+// False if the payload is not a JSON object, or a number in it is not
+// strict JSON or does not fit its member (nan, inf, 0x10, 1e999 all fail).
+// Range checks (hour 0-23, setpoint limits) are the caller's.
+bool mqttParseScheduleUpdate(const char* json, size_t length, MqttScheduleUpdate& out);
+
+#endif // MQTT_COMMAND_PARSER_H
@@ -0,0 +1,57 @@
+/*
+ * MqttQueue.h - Bounded outbound MQTT publish queue
+ *
+ * loop(), the web handlers and the schedule code queue publishes here; the
+ * MQTT task is the only one that talks to the broker and drains it. Queuing
+ * copies the payload and never waits on the network, so a dead broker can't
+ * stall the UI.
+ *
+ * State topics are "newest value wins": queuing one that is still pending
+ * replaces the pending payload in place instead of taking another slot.
+ * Events (alerts) pass coalesce = false and always get their own slot. When
+ * the queue is full the new record is dropped and counted.
+ */
+
+#ifndef MQTT_QUEUE_H
+#define MQTT_QUEUE_H
+
+#include <Arduino.h>
+#include "MqttTopics.h"
+
+const size_t MQTT_QUEUE_DEPTH = 40;     // > MQTT_TOPIC_COUNT, so coalesced state topics alone never fill it
+const size_t MQTT_QUEUE_PAYLOAD = 448;  // Largest payload is the state JSON with every field present (~400 bytes)
+
+struct MqttPublish {
+    uint32_t queuedAt;     // millis() when the slot was first queued
+    uint8_t topic;         // MqttTopic
+    bool retained;
+    bool coalesce;
+    uint16_t length;
+    char payload[MQTT_QUEUE_PAYLOAD];
+};
+
+struct MqttQueueStats {
+    uint32_t depth;        // Records waiting now
+    uint32_t peak;         // Highest depth seen
+    uint32_t queued;       // Records accepted (new slots)
+    uint32_t coalesced;    // Publishes folded into a pending record
+    uint32_t dropped;      // Queue full, payload too large or queue lock timed out
+    uint32_t published;
+    uint32_t failed;       // PubSubClient refused (usually disconnected)
+    uint32_t latencyAvgMs; // Queue to broker, over published records
+    uint32_t latencyMaxMs;
+};
+
+// Create the queue lock; call once in setup() before any producer runs
+void mqttQueueBegin();
+
+// Queue a publish. Returns false if it was dropped.
+bool mqttQueuePublish(MqttTopic topic, const char* payload, bool retained, bool coalesce = true);
+
+// MQTT task: take the oldest record, then report how publishing it went
+bool mqttQueuePop(MqttPublish& out);
+void mqttQueueDone(const MqttPublish& record, bool published);
+
+void mqttQueueGetStats(MqttQueueStats& out);
+
+#endif // MQTT_QUEUE_H
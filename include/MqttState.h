@@ -0,0 +1,62 @@
+/*
+ * MqttState.h - Consolidated <hostname>/state JSON document
+ *
+ * Optional replacement for the per-field state topics. sendMQTTData() sets
+ * every field each cycle, but the document is only republished when a number
+ * moved past its deadband since it was last published, a text field changed,
+ * a field appeared or went away, or a field's max age ran out (heartbeat).
+ * It is written into one static buffer, so a cycle with nothing to send
+ * allocates nothing.
+ *
+ * loop() context only (sendMQTTData()); there is no lock.
+ */
+
+#ifndef MQTT_STATE_H
+#define MQTT_STATE_H
+
+#include <Arduino.h>
+
+enum MqttStateField {
+    // Numbers
+    MQTT_STATE_TEMPERATURE,
+    MQTT_STATE_HUMIDITY,
+    MQTT_STATE_PRESSURE,            // inHg
+    MQTT_STATE_GAS_RESISTANCE,
+    MQTT_STATE_AIR_QUALITY,
+    MQTT_STATE_TARGET_TEMPERATURE,
+    MQTT_STATE_HYDRONIC_TEMPERATURE,
+    MQTT_STATE_SUPPLY_TEMPERATURE,  // DS18B20 probes, °F
+    MQTT_STATE_RETURN_TEMPERATURE,
+    MQTT_STATE_SHOWER_REMAINING,    // Minutes
+    // Text, same values as the per-field topics
+    MQTT_STATE_MODE,
+    MQTT_STATE_FAN_MODE,
+    MQTT_STATE_ACTION,
+    MQTT_STATE_MOTION,
+    MQTT_STATE_SHOWER_MODE,
+    MQTT_STATE_SCHEDULE_ENABLED,
+    MQTT_STATE_ACTIVE_PERIOD,
+    MQTT_STATE_SCHEDULE_OVERRIDE,
+    MQTT_STATE_FIELD_COUNT
+};
+
+// JSON key of a field, e.g. for a Home Assistant value_template
+const char* mqttStateKey(MqttStateField field);
+
+// Smallest change of a number that triggers a publish; 0 = any change
+void mqttStateSetDeadband(MqttStateField field, float deadband);
+// Republish at least this often while the field is present; 0 = never
+void mqttStateSetMaxAge(MqttStateField field, uint32_t seconds);
+
+void mqttStateSetNumber(MqttStateField field, float value);       // NaN removes the field
+void mqttStateSetText(MqttStateField field, const char* value);   // NULL removes the field
+void mqttStateRemove(MqttStateField field);
+
+// The document if a publish is due, else NULL. The values returned become
+// the reference the deadbands are measured from.
+const char* mqttStateTake();
+
+// Publish on the next mqttStateTake() (reconnect, dropped publish)
+void mqttStateInvalidate();
+
+#endif // MQTT_STATE_H
@@ -0,0 +1,110 @@
+/*
+ * MqttTlsClient.h - TLS transport for PubSubClient with session resumption
+ *
+ * A Client that runs mbedTLS over a WiFiClient socket. The broker
+ * certificate must chain to the one CA given with setCACert() and match the
+ * configured server name; there is no insecure mode.
+ *
+ * After each handshake the negotiated session (ID and, if the broker issues
+ * one, ticket) is kept, and the next connect offers it. A broker that accepts
+ * it skips the certificate exchange and key agreement, which is most of the
+ * time and heap of a full handshake. A handshake that fails with a saved
+ * session drops it, so the next attempt is a full one.
+ *
+ * WiFiClientSecure in Arduino-ESP32 2.0 has no hook between its handshake
+ * setup and handshake, so it cannot offer a saved session; that is why this
+ * client exists. Used by the MQTT task only, except getStats(): each
+ * connect() ends by copying its counters under statsMutex, and getStats()
+ * reads that copy, so other tasks never see a half-updated set.
+ */
+
+#ifndef MQTT_TLS_CLIENT_H
+#define MQTT_TLS_CLIENT_H
+
+#include <Arduino.h>
+#include <Client.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <WiFiClient.h>
+#include <mbedtls/ssl.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/ctr_drbg.h>
+#include <mbedtls/x509_crt.h>
+
+struct MqttTlsStats {
+    uint32_t handshakes;      // Completed, full or resumed
+    uint32_t resumed;         // Completed with the saved session
+    uint32_t failures;        // TCP connect or handshake failed
+    uint32_t lastMs;          // Last handshake, TCP connect included
+    uint32_t lastFullMs;
+    uint32_t lastResumedMs;
+    uint32_t maxMs;
+    uint32_t heapLastBytes;   // Most heap in use during the last handshake
+    uint32_t heapPeakBytes;   // ... during any handshake
+    uint32_t heapHeldBytes;   // Still held once the last one completed
+    int32_t lastError;        // mbedTLS error code of the last failure
+};
+
+class MqttTlsClient : public Client {
+public:
+    MqttTlsClient();
+    ~MqttTlsClient();
+
+    // PEM CA certificate; false if it does not parse. Forgets the saved session.
+    bool setCACert(const char* pem);
+    // Per read/write and for the whole handshake
+    void setIoTimeout(uint32_t ms) { ioTimeoutMs = ms; }
+    void forgetSession();
+
+    int connect(IPAddress ip, uint16_t port) override;
+    int connect(const char* host, uint16_t port) override;
+    size_t write(uint8_t b) override;
+    size_t write(const uint8_t* buf, size_t size) override;
+    int available() override;
+    int read() override;
+    int read(uint8_t* buf, size_t size) override;
+    int peek() override;
+    void flush() override;
+    void stop() override;
+    uint8_t connected() override;
+    operator bool() override { return connected(); }
+
+    // Any task: the figures as of the last connect() to finish
+    void getStats(MqttTlsStats& out);
+
+private:
+    bool configure();
+    int connectOnce(const char* host, uint16_t port);
+    bool handshake(const char* host);
+    bool fill();
+    void sampleHeap();
+
+    static int tlsSend(void* ctx, const unsigned char* buf, size_t len);
+    static int tlsRecv(void* ctx, unsigned char* buf, size_t len, uint32_t timeoutMs);
+    static int tlsVerify(void* ctx, mbedtls_x509_crt* crt, int depth, uint32_t* flags);
+
+    WiFiClient tcp;
+    mbedtls_entropy_context entropy;
+    mbedtls_ctr_drbg_context drbg;
+    mbedtls_x509_crt ca;
+    mbedtls_ssl_config conf;
+    mbedtls_ssl_context ssl;
+    mbedtls_ssl_session session;
+    bool configured;
+    bool caLoaded;
+    bool haveSession;
+    bool open;                // ssl is set up on a live socket
+    bool certVerified;        // The broker sent a chain this handshake
+    uint32_t ioTimeoutMs;
+    uint32_t heapLow;         // Least free heap seen during the handshake
+
+    uint8_t rx[256];          // Decrypted bytes not read yet
+    size_t rxStart;
+    size_t rxEnd;
+
+    MqttTlsStats stats;       // MQTT task's working copy
+    MqttTlsStats published;   // Read by getStats(), under statsMutex
+    SemaphoreHandle_t statsMutex;
+};
+
+#endif // MQTT_TLS_CLIENT_H
@@ -0,0 +1,84 @@
+/*
+ * MqttTopics.h - Interned "<hostname>/..." MQTT topic table
+ *
+ * Every state and command topic is formatted once into a fixed buffer when
+ * MQTT starts and again only when the hostname changes, so publishing and
+ * dispatch never build topic Strings. Inbound topics are matched by checking
+ * the "<hostname>/" prefix and switching on a hash of the remainder.
+ */
+
+#ifndef MQTT_TOPICS_H
+#define MQTT_TOPICS_H
+
+#include <Arduino.h>
+
+// State topics published by the thermostat
+enum MqttTopic {
+    MQTT_TOPIC_CURRENT_TEMPERATURE,
+    MQTT_TOPIC_CURRENT_HUMIDITY,
+    MQTT_TOPIC_BAROMETRIC_PRESSURE,
+    MQTT_TOPIC_GAS_RESISTANCE,
+    MQTT_TOPIC_AIR_QUALITY_INDEX,
+    MQTT_TOPIC_TARGET_TEMPERATURE,
+    MQTT_TOPIC_MODE,
+    MQTT_TOPIC_FAN_MODE,
+    MQTT_TOPIC_ACTION,
+    MQTT_TOPIC_HYDRONIC_TEMPERATURE,
+    MQTT_TOPIC_DS18B20_SUPPLY_TEMPERATURE,
+    MQTT_TOPIC_DS18B20_RETURN_TEMPERATURE,
+    MQTT_TOPIC_HYDRONIC_ALERT,
+    MQTT_TOPIC_MOTION_DETECTED,
+    MQTT_TOPIC_SHOWER_MODE,
+    MQTT_TOPIC_SHOWER_TIME_REMAINING,
+    MQTT_TOPIC_SCHEDULE_ENABLED,
+    MQTT_TOPIC_ACTIVE_PERIOD,
+    MQTT_TOPIC_SCHEDULE_OVERRIDE,
+    MQTT_TOPIC_SCHEDULE_SUNDAY,     // .._SATURDAY follow, weekSchedule[] order
+    MQTT_TOPIC_SCHEDULE_MONDAY,
+    MQTT_TOPIC_SCHEDULE_TUESDAY,
+    MQTT_TOPIC_SCHEDULE_WEDNESDAY,
+    MQTT_TOPIC_SCHEDULE_THURSDAY,
+    MQTT_TOPIC_SCHEDULE_FRIDAY,
+    MQTT_TOPIC_SCHEDULE_SATURDAY,
+    MQTT_TOPIC_AVAILABILITY,
+    MQTT_TOPIC_POSTMORTEM,
+    MQTT_TOPIC_STATE,               // Consolidated JSON, see MqttState.h
+    MQTT_TOPIC_HISTORY,             // Samples recorded during an outage, see TelemetryBuffer.h
+    MQTT_TOPIC_NVS,                 // NVS write counters and wear estimate, see NvsWear.h
+    // Fixed topics, not under <hostname>/
+    MQTT_TOPIC_HA_NOTIFY,
+    MQTT_TOPIC_HA_STATUS,           // Subscribed: Home Assistant birth/will
+    MQTT_TOPIC_LEGACY_SET_TEMP_HEAT,
+    MQTT_TOPIC_LEGACY_SET_TEMP_COOL,
+    MQTT_TOPIC_LEGACY_SET_TEMP_AUTO,
+    MQTT_TOPIC_LEGACY_ACTIVE_PERIOD,
+    MQTT_TOPIC_COUNT
+};
+
+const int MQTT_TOPIC_FIRST_FIXED = MQTT_TOPIC_HA_NOTIFY;
+
+// Command topics the thermostat subscribes to
+enum MqttCommand {
+    MQTT_CMD_TARGET_TEMPERATURE,
+    MQTT_CMD_MODE,
+    MQTT_CMD_FAN_MODE,
+    MQTT_CMD_SHOWER_MODE,
+    MQTT_CMD_SCHEDULE_ENABLED,
+    MQTT_CMD_SCHEDULE_OVERRIDE,
+    MQTT_CMD_SCHEDULE,
+    MQTT_CMD_COUNT,
+    MQTT_CMD_UNKNOWN = -1
+};
+
+// Rebuild the table if `hostname` differs from the one it was built for.
+// Returns true when it was rebuilt (existing subscriptions are stale).
+bool mqttTopicsUpdate(const char* hostname);
+
+const char* mqttTopic(MqttTopic topic);
+const char* mqttCommandTopic(MqttCommand command);
+const char* mqttCommandName(MqttCommand command); // Suffix only, e.g. "mode/set"
+
+// Command for an inbound topic, or MQTT_CMD_UNKNOWN
+MqttCommand mqttCommandFromTopic(const char* topic);
+
+#endif // MQTT_TOPICS_H
@@ -0,0 +1,89 @@
+/*
+ * NvsWear.h - NVS write accounting and flash wear estimate
+ *
+ * Every NVS write the firmware issues (config blob, keys kept outside it,
+ * touch calibration) is recorded here with its key and the number of
+ * 32-byte NVS entries it consumes. NVS appends entries and erases a 4 KB
+ * page only once all of its 126 entries are used up, so the entries written
+ * are what wear the partition. Dividing them by the partition's entry capacity
+ * gives the erase cycles each sector has taken. Flash is rated for 100,000.
+ *
+ * Writes are attributed to the callers whose changes they save. Deferred
+ * saves (SettingsStore.h) can carry changes from several callers, so the
+ * per-caller counts may sum to more than the totals.
+ *
+ * Counters cover the time since boot. The lifetime figure is derived from
+ * the config blob generation, which survives reboots, so it costs no extra
+ * writes of its own. It is blob-only: keys stored outside the blob (CA
+ * certificate, touch calibration, SETTING_NOT_IN_BLOB entries) count only
+ * for the current boot, and the JSON names it cycles_lifetime_blob_only.
+ */
+
+#ifndef NVS_WEAR_H
+#define NVS_WEAR_H
+
+#include <Arduino.h>
+
+// Callers, as a bit mask (settingsMarkDirty(), saveSettings())
+const uint8_t NVS_WRITER_WEB = 0x01;          // /set, /control, /schedule_set
+const uint8_t NVS_WRITER_MQTT = 0x02;         // Command topics
+const uint8_t NVS_WRITER_TOUCH = 0x04;        // Buttons and settings screens
+const uint8_t NVS_WRITER_SCHEDULE = 0x08;     // Period changes applied by the scheduler
+const uint8_t NVS_WRITER_SYSTEM = 0x10;       // Migration, factory reset, alert latches
+const uint8_t NVS_WRITER_CALIBRATION = 0x20;  // Touch calibration
+const int NVS_WRITER_COUNT = 6;
+
+const int NVS_WEAR_KEYS = 24;                 // Distinct keys tracked; later ones are summed as "other"
+const int NVS_WEAR_HISTOGRAM_BUCKETS = 8;     // Save duration: <5, <10, <20, <50, <100, <200, <500, >=500 ms
+const uint32_t NVS_WEAR_ENDURANCE_CYCLES = 100000;
+const uint32_t NVS_WEAR_REPORT_INTERVAL_MS = 3600000; // MQTT, besides once per session
+
+enum NvsValueType { NVS_TYPE_SCALAR, NVS_TYPE_STRING, NVS_TYPE_BLOB };
+
+struct NvsWearCounter {
+    uint32_t writes;
+    uint32_t bytes;
+    uint32_t entries;         // 32-byte NVS entries consumed
+};
+
+struct NvsWearStats {
+    NvsWearCounter total;
+    NvsWearCounter writer[NVS_WRITER_COUNT];
+    uint32_t saves;                                   // nvsWearSaveBegin()/Done() pairs
+    uint32_t saveHistogram[NVS_WEAR_HISTOGRAM_BUCKETS];
+    uint32_t saveMsMax;
+    uint32_t partitionBytes;
+    uint32_t partitionEntries;                        // Capacity across all pages
+};
+
+// Call once in setup(), before the first settings load
+void nvsWearBegin();
+
+// Around one save, with nvsSaveMutex held. Writes recorded in between are
+// attributed to `writers`; any outside a save count as NVS_WRITER_SYSTEM.
+void nvsWearSaveBegin(uint8_t writers);
+void nvsWearSaveDone(uint32_t elapsedMs);
+
+// After a successful NVS write of `bytes` value bytes to `key`
+void nvsWearRecord(const char* key, NvsValueType type, size_t bytes);
+
+const char* nvsWriterName(int index);
+
+void nvsWearGetStats(NvsWearStats& out);
+
+// From one nvsWearGetStats() copy. Erase cycles per sector: since boot,
+// and over the device's life from config blob writes (at least the
+// since-boot figure).
+float nvsWearCyclesSinceBoot(const NvsWearStats& stats);
+float nvsWearCyclesLifetimeBlobOnly(const NvsWearStats& stats);
+// Years until NVS_WEAR_ENDURANCE_CYCLES at the write rate seen since boot;
+// negative while nothing has been written
+float nvsWearYearsRemaining(const NvsWearStats& stats);
+
+// Totals, callers, keys, histogram and wear estimate as JSON
+void nvsWearWriteJson(Print& out);
+// The same into `buf` (MQTT: a streamed publish needs its length up front,
+// and the counters move). Length written, 0 if it did not fit.
+size_t nvsWearFormatJson(char* buf, size_t size);
+
+#endif // NVS_WEAR_H
@@ -0,0 +1,67 @@
+/*
+ * PostMortem.h - Last-events trace that survives a soft reset
+ *
+ * A small ring of events (timestamp, task, event id, argument, free heap) in
+ * RTC no-init memory. After a watchdog, panic or brownout reset the previous
+ * boot's events are still there; postMortemBegin() takes a copy before the
+ * ring is reused, and it is served at /api/postmortem and published once to
+ * <hostname>/postmortem (retained) when MQTT first connects.
+ *
+ * If the firmware is built with core dumps to flash (the coredump partition
+ * in default_16mb.csv), the crashed task and PC from the dump are included.
+ */
+
+#ifndef POST_MORTEM_H
+#define POST_MORTEM_H
+
+#include <Arduino.h>
+
+const uint32_t POST_MORTEM_EVENTS = 64;       // Events kept per boot (20 bytes each)
+const uint32_t POST_MORTEM_HEAP_LOW = 24576;  // Free heap below this records PM_HEAP_LOW
+
+// Event ids are stored in RTC memory and read back by the next firmware,
+// which may be a newer build after OTA: only ever append.
+enum PostMortemEvent : uint16_t {
+    PM_BOOT = 1,        // arg: esp_reset_reason() of this boot
+    PM_HEARTBEAT,       // arg: largest free heap block
+    PM_HEAP_LOW,        // arg: largest free heap block
+    PM_WIFI_UP,         // arg: RSSI (signed)
+    PM_WIFI_DOWN,
+    PM_MQTT_UP,
+    PM_MQTT_DOWN,       // arg: PubSubClient state (signed)
+    PM_OTA_START,       // arg: upload size
+    PM_OTA_END,         // arg: 1 success, 0 failure
+    PM_RELAYS,          // arg: relay bitmask, see postMortemRelayMask()
+    PM_SENSOR_STALL,    // arg: ms since the sensor task last ran
+    PM_RESTART          // arg: PostMortemRestart
+};
+
+enum PostMortemRestart : uint32_t {
+    PM_RESTART_WEB = 1,
+    PM_RESTART_OTA,
+    PM_RESTART_WIFI_SETUP,
+    PM_RESTART_TOUCH_CAL,
+    PM_RESTART_FACTORY
+};
+
+// Call once, early in setup(), before anything records an event
+void postMortemBegin();
+
+// Append an event to this boot's ring. Safe from any task; not from ISRs.
+void postMortemRecord(PostMortemEvent event, uint32_t arg = 0);
+
+// Previous boot's trace was recovered (false after a power-on reset)
+bool postMortemAvailable();
+
+// Reset reason of this boot, e.g. "TASK_WDT"
+const char* postMortemResetReason();
+
+// Previous boot's report as JSON: reset reason, events oldest first and the
+// core dump summary if there is one
+void postMortemWriteJson(Print& out);
+size_t postMortemJsonLength(); // Bytes postMortemWriteJson() will write
+
+// Relay outputs packed as bits: H1 H2 C1 C2 FAN PUMP (bit 0 = H1)
+uint32_t postMortemRelayMask();
+
+#endif // POST_MORTEM_H
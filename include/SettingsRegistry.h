@@ -0,0 +1,186 @@
+/*
+ * SettingsRegistry.h - One descriptor per persisted setting
+ *
+ * SETTINGS[] (Main-Thermostat.cpp) lists every user setting once: its form
+ * and JSON name, the global holding it, its place in ConfigData, its
+ * pre-blob NVS key, default, range and form behaviour. Persistence (pack,
+ * unpack, legacy migration, factory reset), the /set form handler, MQTT
+ * commands and the web page all go through it, so adding a setting is a
+ * global, a ConfigData field and one SETTINGS line (plus its form markup).
+ *
+ * GET /api/state serializes the whole table (settingsWriteJson()) and
+ * POST /api/state feeds JSON members through the same form pass as /set.
+ *
+ * Names are looked up through a perfect hash (hash and displace) built from
+ * the table in settingsRegistryBegin(): one hash of the name, two table
+ * reads and one string compare, whatever the table size.
+ *
+ * The table is constexpr; the SETTING_* macros check each global's type
+ * against its entry, and Main-Thermostat.cpp static_asserts that names are
+ * unique and that the entries cover every ConfigData field.
+ */
+
+#ifndef SETTINGS_REGISTRY_H
+#define SETTINGS_REGISTRY_H
+
+#include <Arduino.h>
+#include <stddef.h>
+#include <Preferences.h>
+#include "ConfigBlob.h"
+
+enum SettingType : uint8_t {
+    SETTING_BOOL,
+    SETTING_INT,             // int
+    SETTING_ULONG,           // unsigned long
+    SETTING_FLOAT,
+    SETTING_STRING           // String
+};
+
+// Which form posts a setting. A checkbox missing from a POST is cleared
+// only if other fields of its group were posted.
+enum SettingGroup : uint8_t {
+    SETTING_GROUP_NONE,      // Not settable from /set (schedule state, alert latch)
+    SETTING_GROUP_MAIN,      // Settings tab
+    SETTING_GROUP_DISPLAY,   // Display and sensor calibration fields of the settings tab
+    SETTING_GROUP_WEATHER    // Weather tab
+};
+
+// Flags
+const uint8_t SETTING_CHECKBOX = 0x01;       // Form: absent means false
+const uint8_t SETTING_SETPOINT = 0x02;       // Form: a change starts a schedule override
+const uint8_t SETTING_KEEP_IF_EMPTY = 0x04;  // Form: an empty value leaves it unchanged
+const uint8_t SETTING_TRIM = 0x08;           // Form: surrounding whitespace is dropped
+const uint8_t SETTING_SECRET = 0x10;         // Logged as [SET]/[NOT SET]
+const uint8_t SETTING_KEEP_ON_RESET = 0x20;  // Factory reset leaves it (schedule state)
+
+const uint16_t SETTING_NOT_IN_BLOB = 0xFFFF; // Stored under its own NVS key
+const size_t SETTINGS_MAX = 96;
+
+struct SettingDesc {
+    const char* name;        // Form field and JSON name
+    const char* legacyKey;   // Per-key NVS name before the config blob, or NULL
+    void* value;             // The global, of `type`
+    SettingType type;
+    uint8_t group;           // SettingGroup
+    uint8_t flags;
+    uint16_t offset;         // In ConfigData, or SETTING_NOT_IN_BLOB
+    uint16_t size;           // Bytes in ConfigData
+    float def;               // Numeric default, stored units
+    const char* defText;     // String default
+    float min;               // Accepted range in form units; min > max: any
+    float max;
+    uint32_t scale;          // Stored value = form value * scale
+    const char* choices;     // "a|b|c": the only strings accepted, or NULL
+};
+
+#define SETTING_BLOB_FIELD(var) (uint16_t)offsetof(ConfigData, var), (uint16_t)sizeof(ConfigData::var)
+
+#define SETTING_BOOL(var, name, legacy, def, group, flags) \
+    { name, legacy, static_cast<bool*>(&var), SETTING_BOOL, group, flags, SETTING_BLOB_FIELD(var), \
+      (def) ? 1.0f : 0.0f, NULL, 1, 0, 1, NULL }
+#define SETTING_INT(var, name, legacy, def, min, max, group, flags) \
+    { name, legacy, static_cast<int*>(&var), SETTING_INT, group, flags, SETTING_BLOB_FIELD(var), \
+      def, NULL, min, max, 1, NULL }
+#define SETTING_ULONG(var, name, legacy, def, min, max, scale, group, flags) \
+    { name, legacy, static_cast<unsigned long*>(&var), SETTING_ULONG, group, flags, SETTING_BLOB_FIELD(var), \
+      def, NULL, min, max, scale, NULL }
+#define SETTING_FLOAT(var, name, legacy, def, min, max, group, flags) \
+    { name, legacy, static_cast<float*>(&var), SETTING_FLOAT, group, flags, SETTING_BLOB_FIELD(var), \
+      def, NULL, min, max, 1, NULL }
+#define SETTING_STRING(var, name, legacy, def, choices, group, flags) \
+    { name, legacy, static_cast<String*>(&var), SETTING_STRING, group, flags, SETTING_BLOB_FIELD(var), \
+      0, def, 1, 0, 1, choices }
+#define SETTING_STRING_KEY(var, name, def, group, flags) \
+    { name, NULL, static_cast<String*>(&var), SETTING_STRING, group, flags, SETTING_NOT_IN_BLOB, 0, \
+      0, def, 1, 0, 1, NULL }
+
+extern const SettingDesc SETTINGS[];
+extern const size_t SETTINGS_COUNT;
+
+// Compile-time checks over SETTINGS (static_assert in Main-Thermostat.cpp)
+constexpr bool settingNamesEqual(const char* a, const char* b)
+{
+    return *a == *b && (*a == '\0' || settingNamesEqual(a + 1, b + 1));
+}
+
+constexpr bool settingNameUnique(const SettingDesc* table, size_t count, size_t i, size_t j)
+{
+    return j >= count || (!settingNamesEqual(table[i].name, table[j].name) &&
+                          settingNameUnique(table, count, i, j + 1));
+}
+
+constexpr bool settingsNamesUnique(const SettingDesc* table, size_t count, size_t i = 0)
+{
+    return i >= count || (settingNameUnique(table, count, i, i + 1) && settingsNamesUnique(table, count, i + 1));
+}
+
+// ConfigData bytes the entries account for
+constexpr size_t settingsBlobBytes(const SettingDesc* table, size_t count, size_t i = 0)
+{
+    return i >= count ? 0 : (table[i].offset == SETTING_NOT_IN_BLOB ? 0 : table[i].size) +
+                            settingsBlobBytes(table, count, i + 1);
+}
+
+// Call once in setup(), before loadSettings()
+void settingsRegistryBegin();
+
+const SettingDesc* settingFind(const char* name, size_t length);
+const SettingDesc* settingFind(const char* name);
+
+enum SettingResult { SETTING_REJECTED, SETTING_UNCHANGED, SETTING_CHANGED };
+
+// Parse, range-check and store a form or MQTT value
+SettingResult settingSetText(const SettingDesc* setting, const char* text);
+// Whether settingSetText() would accept `text`, storing nothing; logs why not
+bool settingCheckText(const SettingDesc* setting, const char* text);
+
+// Current values by name, for the web page. Unknown names are logged and
+// read as 0 / "".
+bool settingBool(const char* name);
+int32_t settingInt(const char* name);
+uint32_t settingULong(const char* name);
+float settingFloat(const char* name);
+const String& settingString(const char* name);
+
+// Globals <-> ConfigData, fields in the table only (not the schedule)
+void settingsPack(ConfigData& data);
+void settingsUnpack(const ConfigData& data);
+
+// Factory reset: table defaults, except SETTING_KEEP_ON_RESET entries
+void settingsRestoreDefaults();
+
+// Pre-blob per-key values, defaults for missing keys. Count of keys found.
+size_t settingsReadLegacy(Preferences& prefs);
+// Remove those keys once the blob holds them. Count removed.
+size_t settingsRemoveLegacy(Preferences& prefs);
+
+// Every setting at LOG_DEBUG, secrets masked
+void settingsLog();
+
+// {"name":value,...} for every setting, numbers in form units; secrets are
+// written as "" (a client posts them only when the user enters a new one)
+void settingsWriteJson(Print& out);
+
+// `text` as a quoted, escaped JSON string
+void printJsonString(Print& out, const char* text);
+
+// One /set POST: feed each posted field, then finish
+struct SettingsForm {
+    uint32_t posted[(SETTINGS_MAX + 31) / 32];
+    uint32_t changed[(SETTINGS_MAX + 31) / 32];
+    uint8_t groups;          // 1 << SettingGroup for each group posted
+    uint8_t rejected;        // Values outside a setting's choices or too long
+};
+
+void settingsFormBegin(SettingsForm& form);
+// False if `name` is not a form setting
+bool settingsFormField(SettingsForm& form, const char* name, const char* value);
+bool settingsFormField(SettingsForm& form, const String& name, const String& value);
+// Clear the unchecked checkboxes of the groups posted. Not for JSON posts,
+// where a boolean that is not sent is left as it is.
+void settingsFormEnd(SettingsForm& form);
+bool settingsFormChanged(const SettingsForm& form, const char* name);
+bool settingsFormChangedFlag(const SettingsForm& form, uint8_t flag);
+bool settingsFormPosted(const SettingsForm& form, SettingGroup group);
+
+#endif // SETTINGS_REGISTRY_H
@@ -0,0 +1,67 @@
+/*
+ * SettingsStore.h - Write-behind persistence of settings and schedule to NVS
+ *
+ * Handlers (MQTT commands, /set, /control, touch buttons) mark what they
+ * changed and return; loop() writes it once changes have been quiet for
+ * SETTINGS_FLUSH_QUIET_MS, or SETTINGS_FLUSH_MAX_DELAY_MS after the first
+ * unsaved change if they keep coming. A slider drag or a schedule sync burst
+ * becomes one save.
+ *
+ * Settings and schedule are saved as one blob (ConfigBlob.h). Keys kept
+ * outside it go through settingsPut*(), which keeps a fingerprint of every
+ * key's stored value and skips the NVS write when it has not changed. Keys
+ * not seen yet since boot are compared against what NVS holds.
+ */
+
+#ifndef SETTINGS_STORE_H
+#define SETTINGS_STORE_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+
+// settingsMarkDirty() bits. saveSettings() writes both (one config blob).
+const uint8_t SETTINGS_DIRTY_SETTINGS = 1;
+const uint8_t SETTINGS_DIRTY_SCHEDULE = 2;
+
+const uint32_t SETTINGS_FLUSH_QUIET_MS = 2000;
+const uint32_t SETTINGS_FLUSH_MAX_DELAY_MS = 10000;
+
+struct SettingsStoreStats {
+    uint32_t requests;       // settingsMarkDirty() calls
+    uint32_t coalesced;      // Requests folded into a save already pending
+    uint32_t flushes;        // Saves that ran (deferred or immediate)
+    uint32_t keysWritten;    // NVS writes issued
+    uint32_t keysUnchanged;  // NVS writes skipped, value already stored
+    uint32_t latencyLastMs;  // First unsaved change to save done
+    uint32_t latencyMaxMs;
+    uint32_t durationMaxMs;  // Longest single save
+};
+
+// Call once in setup() after preferences.begin()
+void settingsStoreBegin(Preferences& prefs);
+
+// Any task: remember that something needs saving, and who changed it
+// (NVS_WRITER_* in NvsWear.h)
+void settingsMarkDirty(uint8_t what, uint8_t writer);
+
+// loop(): the SETTINGS_DIRTY_* bits whose save is due now; all pending bits
+// when `force` is set (before a restart)
+uint8_t settingsFlushDue(uint32_t now, bool force = false);
+
+// NVS_WRITER_* bits of the changes pending, for saveSettings()
+uint8_t settingsDirtyWriters();
+
+// End of saveSettings(): what was just written
+void settingsFlushDone(uint8_t what, uint32_t startedAt);
+
+// Write-if-changed. Call with nvsSaveMutex held. True if NVS was written.
+bool settingsPutBool(const char* key, bool value);
+bool settingsPutInt(const char* key, int32_t value);
+bool settingsPutUInt(const char* key, uint32_t value);
+bool settingsPutULong(const char* key, uint32_t value);
+bool settingsPutFloat(const char* key, float value);
+bool settingsPutString(const char* key, const String& value);
+
+void settingsStoreGetStats(SettingsStoreStats& out);
+
+#endif // SETTINGS_STORE_H
@@ -17,6 +17,7 @@
 #include "TFT_Setup_ESP32_S3_Thermostat.h"
 #include <Preferences.h>
 #include <WiFi.h>
+#include "NvsWear.h"
 
 // Keyboard mode for reusing on-screen keyboard
 enum KeyboardMode { KB_WIFI_SSID, KB_WIFI_PASS, KB_HOSTNAME };
@@ -49,7 +50,7 @@ extern bool isEnteringSSID;
 extern KeyboardMode keyboardMode;
 
 // External functions from Main
-extern void saveSettings();
+extern bool saveSettings(uint8_t writers);
 extern void updateDisplay(float temp, float hum);
 extern void drawButtons();
 extern void drawKeyboard(bool isUpperCase);
@@ -552,7 +553,7 @@ bool settingsHandleTouch(uint16_t x, uint16_t y) {
             autoTempSwing = editAutoTempSwing;
             fanRelayNeeded = editFanRelayNeeded;
             useFahrenheit = editUseFahrenheit;
-            saveSettings();
+            saveSettings(NVS_WRITER_TOUCH);
             setDisplayUpdateFlag();
             currentPage = PAGE_MENU;
             drawSettingsMenu();
@@ -623,7 +624,7 @@ bool settingsHandleTouch(uint16_t x, uint16_t y) {
             stage2TempDelta = editStage2TempDelta;
             stage2HeatingEnabled = editStage2HeatingEnabled;
             stage2CoolingEnabled = editStage2CoolingEnabled;
-            saveSettings();
+            saveSettings(NVS_WRITER_TOUCH);
             setDisplayUpdateFlag();
             currentPage = PAGE_MENU;
             drawSettingsMenu();
@@ -0,0 +1,62 @@
+/*
+ * TelemetryBuffer.h - Store-and-forward history for MQTT outages
+ *
+ * While MQTT is down loop() records a timestamped sample every minute; once
+ * the broker is back the samples are replayed oldest first to
+ * <hostname>/history at a paced rate, so energy reports don't get a gap for
+ * every Wi-Fi or broker outage.
+ *
+ * Samples are kept in a RAM ring (TELEMETRY_RAM_SAMPLES, 6 hours). With
+ * spill enabled, the oldest samples move to the otherwise unused "spiffs"
+ * data partition in batches when the ring fills, which holds months. The
+ * flash ring is written raw, sector by sector; it is not a filesystem and
+ * its contents are discarded on reboot. Without spill, or when flash is
+ * full too, the oldest samples are dropped and counted.
+ *
+ * loop() context only; there is no lock.
+ */
+
+#ifndef TELEMETRY_BUFFER_H
+#define TELEMETRY_BUFFER_H
+
+#include <Arduino.h>
+
+const size_t TELEMETRY_RAM_SAMPLES = 360;
+const size_t TELEMETRY_SPILL_BATCH = 64;          // Samples moved to flash at a time
+const int16_t TELEMETRY_NO_VALUE = INT16_MIN;     // Field not available
+
+enum TelemetryAction { TELEMETRY_OFF, TELEMETRY_IDLE, TELEMETRY_HEATING, TELEMETRY_COOLING };
+
+struct TelemetrySample {
+    uint32_t time;           // Unix seconds
+    int16_t temperature;     // Tenths of a degree, display unit
+    int16_t humidity;        // Tenths of a percent
+    int16_t target;          // Tenths of a degree
+    int16_t hydronic;        // Tenths of a degree
+    uint8_t action;          // TelemetryAction
+    uint8_t mode;            // Index into "off", "heat", "cool", "auto"
+    uint8_t reserved[2];
+};
+
+struct TelemetryStats {
+    uint32_t ramSamples;     // Waiting in RAM
+    uint32_t flashSamples;   // Waiting in flash
+    uint32_t flashCapacity;  // 0 if spill is off or the partition is missing
+    uint32_t recorded;
+    uint32_t replayed;
+    uint32_t dropped;        // Overwritten before they could be replayed
+    uint32_t sectorErases;
+};
+
+// Spill to flash on or off. Turning it off keeps replaying what is there.
+void telemetrySetSpill(bool enabled);
+
+void telemetryPush(const TelemetrySample& sample);
+
+// Oldest sample waiting, if any; telemetryPop() removes it once it is sent
+bool telemetryPeek(TelemetrySample& out);
+void telemetryPop();
+
+void telemetryGetStats(TelemetryStats& out);
+
+#endif // TELEMETRY_BUFFER_H
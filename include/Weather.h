@@ -15,9 +15,7 @@
 #include <HTTPClient.h>
 #include <ArduinoJson.h>
 #include "TFT_Setup_ESP32_S3_Thermostat.h"
-
-// Forward declaration for debugLog from Main-Thermostat.cpp
-extern void debugLog(const char* format, ...);
+#include "Log.h" // LOG_* macros over debugLog() from Main-Thermostat.cpp
 
 // Weather source types
 enum WeatherSource {
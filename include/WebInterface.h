@@ -3,546 +3,8 @@
 
 #include <Arduino.h>
 
-// Modern CSS styles embedded as string constants
-const char* CSS_STYLES = R"(
-<style>
-:root {
-  --primary-color: #1976d2;
-  --primary-dark: #1565c0;
-  --secondary-color: #03dac6;
-  --background: #fafafa;
-  --surface: #ffffff;
-  --error: #b00020;
-  --warning: #ff9800;
-  --success: #4caf50;
-  --on-surface: #000000;
-  --on-primary: #ffffff;
-  --border-radius: 8px;
-  --shadow: 0 2px 4px rgba(0,0,0,0.1);
-  --transition: all 0.3s ease;
-}
-
-* {
-  margin: 0;
-  padding: 0;
-  box-sizing: border-box;
-}
-
-body {
-  font-family: 'Segoe UI', Tahoma, Geneva, Verdana, sans-serif;
-  background: var(--background);
-  color: var(--on-surface);
-  line-height: 1.6;
-  padding: 20px;
-}
-
-.container {
-  max-width: 1200px;
-  margin: 0 auto;
-  background: var(--surface);
-  border-radius: var(--border-radius);
-  box-shadow: var(--shadow);
-  overflow: hidden;
-}
-
-.header {
-  background: linear-gradient(135deg, var(--primary-color), var(--primary-dark));
-  color: var(--on-primary);
-  padding: 24px;
-  text-align: center;
-}
-
-.header h1 {
-  font-size: 2rem;
-  font-weight: 300;
-  margin-bottom: 8px;
-}
-
-.header .version {
-  opacity: 0.8;
-  font-size: 0.9rem;
-}
-
-.nav-tabs {
-  display: flex;
-  background: var(--surface);
-  border-bottom: 1px solid #e0e0e0;
-}
-
-.nav-tab {
-  flex: 1;
-  padding: 16px 24px;
-  background: none;
-  border: none;
-  cursor: pointer;
-  font-size: 1rem;
-  color: var(--on-surface);
-  transition: var(--transition);
-  border-bottom: 3px solid transparent;
-}
-
-.nav-tab:hover {
-  background: #f5f5f5;
-}
-
-.nav-tab.active {
-  color: var(--primary-color);
-  border-bottom-color: var(--primary-color);
-}
-
-.content {
-  padding: 24px;
-}
-
-.tab-content {
-  display: none !important;
-}
-
-.tab-content.active {
-  display: block !important;
-}
-
-.status-grid {
-  display: grid;
-  grid-template-columns: repeat(auto-fit, minmax(280px, 1fr));
-  gap: 20px;
-  margin-bottom: 24px;
-}
-
-.status-card {
-  background: var(--surface);
-  border: 1px solid #e0e0e0;
-  border-radius: var(--border-radius);
-  padding: 20px;
-  box-shadow: var(--shadow);
-  transition: var(--transition);
-}
-
-.status-card:hover {
-  transform: translateY(-2px);
-  box-shadow: 0 4px 12px rgba(0,0,0,0.15);
-}
-
-.card-header {
-  display: flex;
-  align-items: center;
-  margin-bottom: 16px;
-}
-
-.card-icon {
-  width: 24px;
-  height: 24px;
-  margin-right: 12px;
-  color: var(--primary-color);
-}
-
-.card-title {
-  font-size: 1.1rem;
-  font-weight: 500;
-  color: var(--on-surface);
-}
-
-.temp-display {
-  font-size: 3rem;
-  font-weight: 300;
-  color: var(--primary-color);
-  text-align: center;
-  margin: 16px 0;
-}
-
-.temp-unit {
-  font-size: 1.5rem;
-  opacity: 0.7;
-}
-
-.status-indicator {
-  display: inline-block;
-  padding: 4px 12px;
-  border-radius: 16px;
-  font-size: 0.8rem;
-  font-weight: 500;
-  text-transform: uppercase;
-}
-
-.status-on {
-  background: var(--success);
-  color: white;
-}
-
-.status-off {
-  background: #757575;
-  color: white;
-}
-
-.status-auto {
-  background: var(--warning);
-  color: white;
-}
-
-.form-group {
-  margin-bottom: 20px;
-}
-
-.form-label {
-  display: block;
-  margin-bottom: 8px;
-  font-weight: 500;
-  color: var(--on-surface);
-}
-
-.form-input, .form-select {
-  width: 100%;
-  padding: 12px 16px;
-  border: 2px solid #e0e0e0;
-  border-radius: var(--border-radius);
-  font-size: 1rem;
-  transition: var(--transition);
-  background: var(--surface);
-}
-
-.form-input:focus, .form-select:focus {
-  outline: none;
-  border-color: var(--primary-color);
-  box-shadow: 0 0 0 3px rgba(25, 118, 210, 0.1);
-}
-
-.form-checkbox {
-  display: flex;
-  align-items: center;
-  margin-bottom: 16px;
-}
-
-.form-checkbox input {
-  margin-right: 12px;
-  transform: scale(1.2);
-}
-
-.btn {
-  display: inline-block;
-  padding: 12px 24px;
-  border: none;
-  border-radius: var(--border-radius);
-  font-size: 1rem;
-  font-weight: 500;
-  cursor: pointer;
-  text-decoration: none;
-  text-align: center;
-  transition: var(--transition);
-  margin: 4px;
-}
-
-.btn-primary {
-  background: var(--primary-color);
-  color: var(--on-primary);
-}
-
-.btn-primary:hover {
-  background: var(--primary-dark);
-  transform: translateY(-1px);
-}
-
-.btn-secondary {
-  background: #6c757d;
-  color: white;
-}
-
-.btn-secondary:hover {
-  background: #545b62;
-}
-
-.btn-warning {
-  background: var(--warning);
-  color: white;
-}
-
-.btn-warning:hover {
-  background: #e68900;
-}
-
-.btn-danger {
-  background: var(--error);
-  color: white;
-}
-
-.btn-danger:hover {
-  background: #8e0000;
-}
-
-.progress-bar {
-  width: 100%;
-  height: 8px;
-  background: #e0e0e0;
-  border-radius: 4px;
-  overflow: hidden;
-  margin: 16px 0;
-}
-
-.progress-fill {
-  height: 100%;
-  background: var(--primary-color);
-  transition: width 0.3s ease;
-}
-
-.alert {
-  padding: 16px;
-  border-radius: var(--border-radius);
-  margin-bottom: 20px;
-  border-left: 4px solid;
-}
-
-.alert-success {
-  background: #d4edda;
-  color: #155724;
-  border-color: var(--success);
-}
-
-.alert-warning {
-  background: #fff3cd;
-  color: #856404;
-  border-color: var(--warning);
-}
-
-.alert-error {
-  background: #f8d7da;
-  color: #721c24;
-  border-color: var(--error);
-}
-
-.settings-section {
-  margin-bottom: 32px;
-  padding: 24px;
-  border: 1px solid #e0e0e0;
-  border-radius: var(--border-radius);
-}
-
-.settings-section h3 {
-  margin-bottom: 20px;
-  color: var(--primary-color);
-  border-bottom: 2px solid #e0e0e0;
-  padding-bottom: 8px;
-}
-
-.info-card {
-  background: #f5f5f5;
-  border-radius: var(--border-radius);
-  padding: 16px;
-  margin-top: 16px;
-}
-
-.info-card h4 {
-  margin-bottom: 12px;
-  color: var(--primary-color);
-}
-
-.info-card p {
-  margin-bottom: 8px;
-  color: var(--on-surface);
-}
-
-.button-group {
-  display: flex;
-  gap: 12px;
-  margin-top: 24px;
-  flex-wrap: wrap;
-}
-
-.system-status {
-  display: grid;
-  grid-template-columns: repeat(auto-fit, minmax(200px, 1fr));
-  gap: 16px;
-  margin-bottom: 24px;
-}
-
-.relay-status {
-  display: flex;
-  justify-content: space-between;
-  align-items: center;
-  padding: 12px 16px;
-  background: #f8f9fa;
-  border-radius: var(--border-radius);
-  border-left: 4px solid #dee2e6;
-}
-
-.relay-status.active {
-  background: #e8f5e8;
-  border-left-color: var(--success);
-}
-
-@media (max-width: 768px) {
-  body {
-    padding: 10px;
-  }
-  
-  .header {
-    padding: 16px;
-  }
-  
-  .header h1 {
-    font-size: 1.5rem;
-  }
-  
-  .nav-tab {
-    padding: 12px 16px;
-    font-size: 0.9rem;
-  }
-  
-  .content {
-    padding: 16px;
-  }
-  
-  .temp-display {
-    font-size: 2.5rem;
-  }
-  
-  .status-grid {
-    grid-template-columns: 1fr;
-  }
-  
-  .button-group {
-    flex-direction: column;
-  }
-  
-  .btn {
-    width: 100%;
-  }
-}
-
-.loading {
-  display: inline-block;
-  width: 20px;
-  height: 20px;
-  border: 3px solid #f3f3f3;
-  border-top: 3px solid var(--primary-color);
-  border-radius: 50%;
-  animation: spin 1s linear infinite;
-}
-
-@keyframes spin {
-  0% { transform: rotate(0deg); }
-  100% { transform: rotate(360deg); }
-}
-
-.fade-in {
-  animation: fadeIn 0.5s ease-in;
-}
-
-@keyframes fadeIn {
-  0% { opacity: 0; transform: translateY(10px); }
-  100% { opacity: 1; transform: translateY(0); }
-}
-
-/* Schedule table styles */
-.schedule-table {
-  display: flex;
-  flex-direction: column;
-  border: 1px solid var(--border-color);
-  border-radius: 8px;
-  overflow: hidden;
-  background: white;
-  margin: 16px 0;
-}
-
-.schedule-row {
-  display: grid;
-  grid-template-columns: 1fr auto 1fr 2fr 1fr 2fr;
-  gap: 8px;
-  padding: 12px 16px;
-  border-bottom: 1px solid var(--border-color);
-  align-items: center;
-}
-
-.schedule-row:last-child {
-  border-bottom: none;
-}
-
-.schedule-header {
-  background: var(--primary-color);
-  color: white;
-  font-weight: 600;
-  font-size: 0.9rem;
-}
-
-.schedule-cell {
-  display: flex;
-  align-items: center;
-  justify-content: center;
-  text-align: center;
-  min-height: 40px;
-}
-
-.schedule-cell:first-child {
-  justify-content: flex-start;
-  text-align: left;
-}
-
-.temp-inputs {
-  display: flex;
-  gap: 4px;
-  flex-direction: column;
-}
-
-.temp-input {
-  width: 70px !important;
-  min-width: 70px;
-  font-size: 0.85rem;
-  padding: 4px 6px;
-}
-
-.time-input {
-  width: 90px !important;
-  min-width: 90px;
-  font-size: 0.85rem;
-  padding: 4px 6px;
-}
-
-.toggle-switch.small {
-  transform: scale(0.8);
-}
-
-/* Responsive schedule table */
-@media (max-width: 768px) {
-  .schedule-row {
-    grid-template-columns: 1fr;
-    gap: 8px;
-    text-align: left;
-  }
-  
-  .schedule-cell {
-    justify-content: flex-start;
-    text-align: left;
-    padding: 4px 0;
-  }
-  
-  .schedule-header .schedule-cell {
-    display: none;
-  }
-  
-  .schedule-header::before {
-    content: "Schedule Configuration";
-    font-weight: 600;
-  }
-  
-  .temp-inputs {
-    flex-direction: row;
-    gap: 8px;
-  }
-  
-  .temp-input, .time-input {
-    width: auto !important;
-    min-width: 60px;
-    flex: 1;
-  }
-}
-
-.temp-label {
-  font-size: 0.75rem;
-  font-weight: 600;
-  color: var(--text-color);
-  margin-bottom: 2px;
-  display: block;
-}
-</style>
-)";
+// Page styles and script are served gzipped from flash as /assets/app.<hash>.css
+// and .js (web/, WebAssets.h). The icons stay inline: pages embed them.
 
 // SVG Icons as string constants
 const char* ICON_TEMPERATURE = R"(<svg class="card-icon" viewBox="0 0 24 24" fill="currentColor"><path d="M15 13V5a3 3 0 0 0-6 0v8a5 5 0 1 0 6 0zm-3 4a1 1 0 1 1 0-2 1 1 0 0 1 0 2zm0-4a1 1 0 0 0-1 1v.5L9 16a3 3 0 1 0 6 0l-2-1.5V14a1 1 0 0 0-1-1z"/></svg>)";
@@ -575,356 +37,4 @@ const char* ICON_BACK = R"(<svg class="card-icon" viewBox="0 0 24 24" fill="curr
 
 const char* ICON_SAVE = R"(<svg class="card-icon" viewBox="0 0 24 24" fill="currentColor"><path d="M15,9H5V5H15M12,19A3,3 0 0,1 9,16A3,3 0 0,1 12,13A3,3 0 0,1 15,16A3,3 0 0,1 12,19M17,3H5C3.89,3 3,3.9 3,5V19A2,2 0 0,0 5,21H19A2,2 0 0,0 21,19V7L17,3Z"/></svg>)";
 
-// JavaScript for dynamic functionality
-const char* JAVASCRIPT_CODE = R"(
-<script>
-let currentTab = 'status';
-let updateInterval;
-
-function showTab(tabName) {
-    // Hide all tab contents
-    const contents = document.querySelectorAll('.tab-content');
-    contents.forEach(content => {
-        content.classList.remove('active');
-        content.classList.remove('fade-in');
-    });
-    
-    // Remove active class from all tabs
-    const tabs = document.querySelectorAll('.nav-tab');
-    tabs.forEach(tab => tab.classList.remove('active'));
-    
-    // Show selected tab content
-    const selectedContent = document.getElementById(tabName + '-content');
-    if (selectedContent) {
-        selectedContent.classList.add('active');
-        selectedContent.classList.add('fade-in');
-    }
-    
-    // Add active class to selected tab
-    const selectedTab = document.querySelector(".nav-tab[data-tab='" + tabName + "']");
-    if (selectedTab) {
-        selectedTab.classList.add('active');
-    }
-    
-    currentTab = tabName;
-    
-    // Handle auto-refresh for status tab
-    if (tabName === 'status') {
-        startAutoRefresh();
-    } else {
-        stopAutoRefresh();
-    }
-}
-
-function startAutoRefresh() {
-    stopAutoRefresh();
-    updateInterval = setInterval(() => {
-        if (currentTab === 'status') {
-            refreshStatus();
-        }
-    }, 10000);
-}
-
-function stopAutoRefresh() {
-    if (updateInterval) {
-        clearInterval(updateInterval);
-    }
-}
-
-function refreshStatus() {
-    const statusCards = document.querySelectorAll('.status-card');
-    statusCards.forEach(card => card.style.opacity = '0.7');
-
-  fetch('/status?ts=' + Date.now(), { cache: 'no-store' })
-  .then(response => {
-    if (!response.ok) throw new Error('HTTP ' + response.status);
-    return response.json();
-  })
-  .then(data => {
-    const tempDisplay = document.getElementById('current-temp-display');
-    if (tempDisplay && data.currentTemp !== undefined) {
-      const unitSpan = tempDisplay.querySelector('.temp-unit');
-      const unitHtml = unitSpan ? unitSpan.outerHTML : '';
-      const temp = Number.parseFloat(data.currentTemp);
-      if (!Number.isNaN(temp)) {
-        tempDisplay.innerHTML = temp.toFixed(1) + unitHtml;
-      }
-    }
-
-    const humidityDisplay = document.getElementById('current-humidity-value');
-    if (humidityDisplay && data.currentHumidity !== undefined) {
-      const hum = Number.parseFloat(data.currentHumidity);
-      if (!Number.isNaN(hum)) {
-        humidityDisplay.innerHTML = hum.toFixed(1) + "<span style='font-size: 1rem; opacity: 0.7;'>%</span>";
-      }
-    }
-
-    const modeIndicator = document.getElementById('thermostat-mode-indicator');
-    if (modeIndicator && data.thermostatMode) {
-      const mode = String(data.thermostatMode).toLowerCase();
-      modeIndicator.textContent = mode;
-      modeIndicator.classList.remove('status-on', 'status-off', 'status-auto');
-      if (mode === 'off') modeIndicator.classList.add('status-off');
-      else if (mode === 'auto') modeIndicator.classList.add('status-auto');
-      else modeIndicator.classList.add('status-on');
-    }
-
-    const fanMode = document.getElementById('fan-mode-value');
-    if (fanMode && data.fanMode) {
-      fanMode.textContent = 'Fan: ' + data.fanMode;
-    }
-  })
-  .catch(error => {
-    console.error('Status refresh error:', error);
-  })
-  .finally(() => {
-    statusCards.forEach(card => card.style.opacity = '1');
-  });
-}
-
-function confirmAction(actionName, actionUrl) {
-    if (confirm("Are you sure you want to " + actionName + "?")) {
-        window.location.href = actionUrl;
-    }
-}
-
-function showAlert(message, type) {
-    if (typeof type === 'undefined') type = 'success';
-    const alertDiv = document.createElement('div');
-    alertDiv.className = 'alert alert-' + type;
-    alertDiv.textContent = message;
-    
-    const container = document.querySelector('.container');
-    container.insertBefore(alertDiv, container.firstChild);
-    
-    setTimeout(() => {
-        alertDiv.remove();
-    }, 5000);
-}
-
-function handleSettingsSubmit(event) {
-    event.preventDefault();
-    
-    const form = event.target;
-    const formData = new FormData(form);
-    const submitBtn = form.querySelector('input[type="submit"]');
-    
-    // Show loading state
-    const originalValue = submitBtn.value;
-    submitBtn.value = 'Saving...';
-    submitBtn.disabled = true;
-    
-    fetch('/set', {
-        method: 'POST',
-        body: formData
-    })
-    .then(response => response.json())
-    .then(data => {
-        if (data.status === 'success') {
-            showAlert(data.message, 'success');
-            // Optional: refresh the page to show updated values
-            setTimeout(() => {
-                location.reload();
-            }, 2000);
-        } else {
-            showAlert('Error saving settings: ' + (data.message || 'Unknown error'), 'error');
-        }
-    })
-    .catch(error => {
-        showAlert('Error saving settings: ' + error.message, 'error');
-    })
-    .finally(() => {
-        // Restore button state
-        submitBtn.value = originalValue;
-        submitBtn.disabled = false;
-    });
-    
-    return false;
-}
-
-function handleScheduleSubmit(event) {
-    event.preventDefault();
-    
-    const form = event.target;
-    const formData = new FormData(form);
-    const submitBtn = form.querySelector('button[type="submit"]');
-    const statusDiv = document.getElementById('schedule-status');
-    
-    // Show loading state
-    const originalText = submitBtn.textContent;
-    submitBtn.textContent = 'Saving...';
-    submitBtn.disabled = true;
-    
-    fetch('/schedule_set', {
-        method: 'POST',
-        body: formData
-    })
-    .then(response => response.json())
-    .then(data => {
-        if (data.status === 'success') {
-            statusDiv.style.display = 'block';
-            statusDiv.style.backgroundColor = '#E8F5E9';
-            statusDiv.style.color = '#2E7D32';
-            statusDiv.textContent = '✓ ' + data.message;
-            setTimeout(() => {
-                statusDiv.style.display = 'none';
-            }, 5000);
-        } else {
-            statusDiv.style.display = 'block';
-            statusDiv.style.backgroundColor = '#FFEBEE';
-            statusDiv.style.color = '#C62828';
-            statusDiv.textContent = '✗ Error: ' + (data.message || 'Unknown error');
-        }
-    })
-    .catch(error => {
-        statusDiv.style.display = 'block';
-        statusDiv.style.backgroundColor = '#FFEBEE';
-        statusDiv.style.color = '#C62828';
-        statusDiv.textContent = '✗ Error saving schedule: ' + error.message;
-    })
-    .finally(() => {
-        // Restore button state
-        submitBtn.textContent = originalText;
-        submitBtn.disabled = false;
-    });
-    
-    return false;
-}
-
-// Initialize the interface when page loads
-document.addEventListener('DOMContentLoaded', function() {
-    // Check URL parameters for tab switching
-    const urlParams = new URLSearchParams(window.location.search);
-    const tabParam = urlParams.get('tab');
-    const initialTab = tabParam && ['status', 'settings', 'system'].includes(tabParam) ? tabParam : 'status';
-    showTab(initialTab);
-    
-    // Add form validation
-    const forms = document.querySelectorAll('form');
-    forms.forEach(form => {
-        form.addEventListener('submit', function(e) {
-            const submitBtn = form.querySelector('input[type="submit"]');
-            if (submitBtn) {
-                submitBtn.value = 'Saving...';
-                submitBtn.disabled = true;
-            }
-        });
-    });
-});
-
-// Weather source toggle function
-function updateWeatherFields(source) {
-    const owmSettings = document.getElementById('owm-settings');
-    const haSettings = document.getElementById('ha-settings');
-    
-    if (source == '1') {
-        owmSettings.style.display = 'block';
-        haSettings.style.display = 'none';
-    } else if (source == '2') {
-        owmSettings.style.display = 'none';
-        haSettings.style.display = 'block';
-    } else {
-        owmSettings.style.display = 'none';
-        haSettings.style.display = 'none';
-    }
-}
-
-// Handle weather form submission
-document.addEventListener('DOMContentLoaded', function() {
-    const weatherForm = document.getElementById('weather-form');
-    if (weatherForm) {
-        weatherForm.addEventListener('submit', function(e) {
-            e.preventDefault();
-            
-            // Get form data
-            const formData = new FormData(weatherForm);
-            
-            // Convert to URL encoded string
-            const params = new URLSearchParams(formData).toString();
-            
-            // Send AJAX request
-            fetch('/set', {
-                method: 'POST',
-                headers: {
-                    'Content-Type': 'application/x-www-form-urlencoded',
-                },
-                body: params
-            })
-            .then(response => response.json())
-            .then(data => {
-                // Show success message
-                alert('Weather settings saved successfully!');
-            })
-            .catch(error => {
-                console.error('Error:', error);
-                alert('Failed to save weather settings');
-            });
-        });
-    }
-});
-
-// Force weather update
-function forceWeatherUpdate() {
-    fetch('/weather_refresh', {
-        method: 'POST',
-        headers: {
-            'Content-Type': 'application/json',
-        }
-    })
-    .then(response => response.text())
-    .then(data => {
-        alert('Weather update triggered! Checking for new data...');
-    })
-    .catch(error => {
-        console.error('Error:', error);
-        alert('Failed to trigger weather update');
-    });
-}
-
-// Handle page visibility for auto-refresh
-document.addEventListener('visibilitychange', function() {
-    if (document.hidden) {
-        stopAutoRefresh();
-    } else if (currentTab === 'status') {
-        startAutoRefresh();
-    }
-});
-
-// Mutual exclusion for stage 2 heating and reversing valve
-document.addEventListener('DOMContentLoaded', function() {
-    const stage2Heat = document.getElementById('stage2HeatingEnabled');
-    const revValve = document.getElementById('reversingValveEnabled');
-  const stage2Cool = document.getElementById('stage2CoolingEnabled');
-  const backupHeat = document.getElementById('backupHeatEnabled');
-  const backupRelay = document.getElementById('backupHeatRelay');
-    
-  function applyRelayConflicts() {
-    if (stage2Heat && revValve && stage2Heat.checked && revValve.checked) {
-      revValve.checked = false;
-    }
-
-    if (backupHeat && backupRelay && backupHeat.checked) {
-      if (backupRelay.value === '1') {
-        if (stage2Heat) stage2Heat.checked = false;
-        if (revValve) revValve.checked = false;
-      }
-      if (backupRelay.value === '2') {
-        if (stage2Cool) stage2Cool.checked = false;
-      }
-    }
-  }
-
-  if (stage2Heat) stage2Heat.addEventListener('change', applyRelayConflicts);
-  if (revValve) revValve.addEventListener('change', applyRelayConflicts);
-  if (stage2Cool) stage2Cool.addEventListener('change', applyRelayConflicts);
-  if (backupHeat) backupHeat.addEventListener('change', applyRelayConflicts);
-  if (backupRelay) backupRelay.addEventListener('change', applyRelayConflicts);
-
-  if (stage2Heat || revValve || stage2Cool || backupHeat || backupRelay) {
-    applyRelayConflicts();
-    }
-});
-</script>
-)";
-
 #endif // WEBINTERFACE_H
\ No newline at end of file
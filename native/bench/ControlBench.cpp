@@ -0,0 +1,168 @@
+/*
+ * ControlBench.cpp - Per-cycle cost of the HVAC control core on the host
+ *
+ * Runs controlRelays() (and the fan/schedule helpers where relevant) through
+ * representative scenarios on the virtual clock and reports wall-clock time
+ * per call, debugLog() traffic and relay GPIO writes per call. Use it to spot
+ * regressions in the control path before flashing a unit.
+ *
+ *   pio run -e native && .pio/build/native/program [iterations] [--log-level L] [-v]
+ *
+ * debugLog() traffic depends on the runtime log level (default info); pass
+ * --log-level debug to see what the /debug page costs when turned up.
+ */
+
+#include <Arduino.h>
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include "HvacControl.h"
+#include "NativeHal.h"
+
+struct Scenario {
+    const char* name;
+    void (*configure)();
+    float baseTemp;      // Centre of the simulated room temperature swing
+    float amplitude;     // Peak deviation from baseTemp
+    float humidity;
+    bool runFanSchedule; // Also call controlFanSchedule() every 30 s, like loop()
+    bool runSchedule;    // Also call checkScheduleAt() every 60 s, like loop()
+};
+
+static const int relayPins[] = {
+    HEAT_RELAY_1_PIN, HEAT_RELAY_2_PIN, COOL_RELAY_1_PIN, COOL_RELAY_2_PIN, FAN_RELAY_PIN, PUMP_RELAY_PIN
+};
+
+static void configureHeat() { thermostatMode = "heat"; }
+static void configureHeatStaged()
+{
+    thermostatMode = "heat";
+    stage2HeatingEnabled = true;
+    backupHeatEnabled = true;
+    backupHeatRelaySelection = 0;
+}
+static void configureHydronic()
+{
+    thermostatMode = "heat";
+    hydronicHeatingEnabled = true;
+    ds18b20SensorPresent = true;
+    hydronicTemp = 120.0;
+}
+static void configureCoolStaged()
+{
+    thermostatMode = "cool";
+    stage2CoolingEnabled = true;
+    fanRelayNeeded = true;
+}
+static void configureAuto() { thermostatMode = "auto"; }
+static void configureEUDehumidify()
+{
+    thermostatMode = "cool";
+    thermostatRegion = "EU";
+    euHumidityControlEnabled = true;
+    euHumidityRelaySelection = 2;
+}
+static void configureFanCycle()
+{
+    thermostatMode = "off";
+    fanMode = "cycle";
+}
+static void configureScheduled()
+{
+    thermostatMode = "heat";
+    scheduleEnabled = true;
+}
+
+static const Scenario scenarios[] = {
+    { "heat 1-stage",       configureHeat,         72.0f, 2.0f, 45.0f, false, false },
+    { "heat 2-stage+backup",configureHeatStaged,   70.0f, 4.0f, 45.0f, false, false },
+    { "heat hydronic",      configureHydronic,     72.0f, 2.0f, 45.0f, false, false },
+    { "cool 2-stage",       configureCoolStaged,   77.0f, 4.0f, 55.0f, false, false },
+    { "auto",               configureAuto,         74.0f, 5.0f, 50.0f, false, false },
+    { "cool EU dehumidify", configureEUDehumidify, 76.0f, 2.0f, 68.0f, false, false },
+    { "off + fan cycle",    configureFanCycle,     74.0f, 1.0f, 50.0f, true,  false },
+    { "heat + schedule",    configureScheduled,    71.0f, 2.0f, 45.0f, false, true  },
+};
+
+static void runScenario(const Scenario& sc, long iterations)
+{
+    nativeResetControlState();
+    nativeClockSet(0);
+    nativePinsReset();
+    nativeLogResetCounters();
+    sc.configure();
+    currentHumidity = sc.humidity;
+
+    struct tm calendar;
+    memset(&calendar, 0, sizeof(calendar));
+    calendar.tm_wday = 1;
+
+    double elapsedNs = 0;
+    for (long i = 0; i < iterations; i++) {
+        nativeClockAdvance(1000); // loop() calls controlRelays() once per second
+        // 10-minute triangle wave around baseTemp
+        long phase = i % 600;
+        float frac = (phase < 300) ? (phase / 300.0f) : ((600 - phase) / 300.0f);
+        float temp = sc.baseTemp - sc.amplitude + 2.0f * sc.amplitude * frac;
+        currentTemp = temp;
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        controlRelays(temp);
+        if (sc.runFanSchedule && (i % 30) == 0) {
+            controlFanSchedule();
+        }
+        if (sc.runSchedule && (i % 60) == 0) {
+            unsigned long minuteOfWeek = (millis() / 60000UL) % (7UL * 24UL * 60UL);
+            calendar.tm_wday = (int)(minuteOfWeek / (24UL * 60UL));
+            calendar.tm_hour = (int)((minuteOfWeek / 60UL) % 24UL);
+            calendar.tm_min = (int)(minuteOfWeek % 60UL);
+            checkScheduleAt(calendar);
+        }
+        elapsedNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    unsigned long relayWrites = 0;
+    unsigned long relayEdges = 0;
+    for (size_t p = 0; p < sizeof(relayPins) / sizeof(relayPins[0]); p++) {
+        relayWrites += nativePinWriteCount(relayPins[p]);
+        relayEdges += nativePinEdgeCount(relayPins[p]);
+    }
+
+    printf("%-20s %10.0f %10.2f %10.1f %10.2f %8lu\n",
+           sc.name,
+           elapsedNs / iterations,
+           (double)nativeLogCalls() / iterations,
+           (double)nativeLogBytes() / iterations,
+           (double)relayWrites / iterations,
+           relayEdges);
+}
+
+int main(int argc, char** argv)
+{
+    long iterations = 100000;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-v") == 0) {
+            nativeLogEcho(true);
+        } else if (strcmp(argv[i], "--log-level") == 0 && i + 1 < argc) {
+            int level = logLevelFromName(argv[++i]);
+            if (level < 0) {
+                printf("unknown log level %s\n", argv[i]);
+                return 1;
+            }
+            setAllLogLevels((uint8_t)level);
+        } else {
+            iterations = atol(argv[i]);
+        }
+    }
+    if (iterations <= 0) iterations = 100000;
+
+    controlRelaysMutex = xSemaphoreCreateMutex();
+
+    printf("HVAC control core benchmark: %ld cycles per scenario (1 s virtual cadence, HVAC log level %s)\n\n",
+           iterations, logLevelName(logRuntimeLevels[LOG_TAG_HVAC]));
+    printf("%-20s %10s %10s %10s %10s %8s\n", "scenario", "ns/call", "logs/call", "logB/call", "gpio/call", "edges");
+    for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+        runScenario(scenarios[i], iterations);
+    }
+    return 0;
+}
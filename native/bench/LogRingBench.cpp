@@ -0,0 +1,409 @@
+/*
+ * LogRingBench.cpp - Debug log ring under writer contention
+ *
+ * Compares the previous mutex-guarded byte-at-a-time ring with the lock-free
+ * ring in DebugLog.cpp. Several writer threads append log lines while a
+ * reader repeatedly snapshots the whole log (what /api/debug/plain does).
+ * Reports writer throughput and per-append latency percentiles, and checks
+ * that every line a reader sees from the lock-free ring is intact and that
+ * each writer's lines appear in order.
+ *
+ * A second, single-threaded section compares debugLog()'s old path
+ * (vsnprintf + text record) with deferred-format binary records: cost per
+ * call, how many events fit in the ring, and that decoded binary records
+ * read back exactly as vsnprintf would have printed them.
+ *
+ *   pio run -e native_logbench && .pio/build/native_logbench/program [lines-per-writer]
+ */
+
+#include <Arduino.h>
+#include <algorithm>
+#include <stdarg.h>
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+#include "DebugLog.h"
+
+// =============================================================================
+// BASELINE: the mutex ring DebugLog.cpp replaced
+// =============================================================================
+static char legacyBuffer[DEBUG_BUFFER_SIZE];
+static int legacyIndex = 0;
+static bool legacyWrapped = false;
+static SemaphoreHandle_t legacyMutex = NULL;
+
+static void legacyAdd(const char* message)
+{
+    bool haveLock = (xSemaphoreTake(legacyMutex, portMAX_DELAY) == pdTRUE);
+    int len = strlen(message);
+    if (len > (int)DEBUG_BUFFER_SIZE) len = DEBUG_BUFFER_SIZE;
+    for (int i = 0; i < len; i++) {
+        legacyBuffer[legacyIndex] = message[i];
+        legacyIndex = (legacyIndex + 1) % DEBUG_BUFFER_SIZE;
+        if (legacyIndex == 0) {
+            legacyWrapped = true;
+        }
+    }
+    if (haveLock) xSemaphoreGive(legacyMutex);
+}
+
+static String legacyGet()
+{
+    String result = "";
+    bool haveLock = (xSemaphoreTake(legacyMutex, portMAX_DELAY) == pdTRUE);
+    int count = legacyWrapped ? DEBUG_BUFFER_SIZE : legacyIndex;
+    int startIdx = legacyWrapped ? legacyIndex : 0;
+    result.reserve(count + 16);
+    for (int i = 0; i < count; i++) {
+        result += legacyBuffer[(startIdx + i) % DEBUG_BUFFER_SIZE];
+    }
+    if (haveLock) xSemaphoreGive(legacyMutex);
+    return result;
+}
+
+// =============================================================================
+// HARNESS
+// =============================================================================
+struct RunResult {
+    double seconds;
+    double linesPerSec;
+    double p50Ns, p99Ns, maxNs;
+    unsigned long snapshots;
+    unsigned long badLines;
+    unsigned long dropped;
+};
+
+static const int MAX_WRITERS = 8;
+// Acceptable drops per lock-free run: 1 in 1000 messages. Writers wait a
+// bounded time for an unfinished tail record, so drops need a writer that is
+// preempted mid-copy for longer than that wait.
+static const long DROP_LIMIT_DIVISOR = 1000;
+
+// Lines look like "[R2 W3] seq=000123 ..." with a writer-specific tail length,
+// mimicking the mix of short and long debugLog() lines. The ring is shared by
+// all runs, so the run id keeps earlier runs' lines out of the order check.
+static void formatLine(char* out, size_t outLen, int run, int writer, long seq)
+{
+    static const char filler[] = "controlRelays EXIT: RelayPins H1=0 H2=0 C1=1 C2=0 F=1 | Flags heat=0 cool=1 fan=1 stage1=1 stage2=0";
+    int tail = 20 + (int)((seq * 7 + writer * 13) % 80);
+    snprintf(out, outLen, "[R%d W%d] seq=%06ld %.*s\n", run, writer, seq, tail, filler);
+}
+
+// Every line must be complete and each writer's sequence numbers strictly increasing
+static unsigned long checkSnapshot(const String& log, int run)
+{
+    std::vector<long> last(MAX_WRITERS, -1);
+    unsigned long bad = 0;
+    const char* p = log.c_str();
+    while (*p) {
+        const char* nl = strchr(p, '\n');
+        if (nl == nullptr) { bad++; break; }
+        int r = -1;
+        int w = -1;
+        long seq = -1;
+        if (sscanf(p, "[R%d W%d] seq=%ld", &r, &w, &seq) != 3 || w < 0 || w >= MAX_WRITERS ||
+            (r == run && seq <= last[w])) {
+            bad++;
+        } else {
+            char expect[160];
+            formatLine(expect, sizeof(expect), r, w, seq);
+            if (strncmp(p, expect, (size_t)(nl - p + 1)) != 0 || expect[nl - p + 1] != '\0') bad++;
+            if (r == run) last[w] = seq;
+        }
+        p = nl + 1;
+    }
+    return bad;
+}
+
+// Same walk the chunked /api/debug/plain response does: small, odd-sized
+// chunks with writers running in between
+static String streamedGet()
+{
+    String result = "";
+    DebugLogCursor cursor;
+    debugLogCursorBegin(cursor, DEBUG_BUFFER_SIZE);
+    char chunk[517];
+    size_t n;
+    while ((n = debugLogRead(cursor, chunk, sizeof(chunk))) > 0) {
+        result.concat(chunk, (unsigned int)n);
+        std::this_thread::yield();
+    }
+    return result;
+}
+
+static RunResult runContention(int run, bool lockFree, int writers, long linesPerWriter)
+{
+    std::atomic<bool> stop(false);
+    std::atomic<unsigned long> snapshots(0);
+    std::atomic<unsigned long> badLines(0);
+    std::vector<std::vector<uint32_t>> latencies(writers);
+
+    std::thread reader([&]() {
+        while (!stop.load()) {
+            String snap = !lockFree ? legacyGet() : (snapshots & 1) ? streamedGet() : getDebugLog();
+            if (lockFree) badLines += checkSnapshot(snap, run);
+            snapshots++;
+        }
+    });
+
+    uint32_t droppedBefore = getDebugLogDropped();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int w = 0; w < writers; w++) {
+        threads.emplace_back([&, w]() {
+            std::vector<uint32_t>& lat = latencies[w];
+            lat.reserve(linesPerWriter);
+            char line[160];
+            for (long i = 0; i < linesPerWriter; i++) {
+                formatLine(line, sizeof(line), run, w, i);
+                std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+                if (lockFree) addToDebugBuffer(line);
+                else legacyAdd(line);
+                lat.push_back((uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - t0).count());
+            }
+        });
+    }
+    for (size_t i = 0; i < threads.size(); i++) threads[i].join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    stop = true;
+    reader.join();
+    if (lockFree) badLines += checkSnapshot(getDebugLog(), run);
+
+    std::vector<uint32_t> all;
+    for (int w = 0; w < writers; w++) all.insert(all.end(), latencies[w].begin(), latencies[w].end());
+    std::sort(all.begin(), all.end());
+
+    RunResult r;
+    r.seconds = seconds;
+    r.linesPerSec = (double)all.size() / seconds;
+    r.p50Ns = all[all.size() / 2];
+    r.p99Ns = all[(all.size() * 99) / 100];
+    r.maxNs = all.back();
+    r.snapshots = snapshots.load();
+    r.badLines = badLines.load();
+    r.dropped = getDebugLogDropped() - droppedBefore;
+    return r;
+}
+
+// =============================================================================
+// INCREMENTAL TAIL (/api/debug?since=)
+// =============================================================================
+// One writer, one poller reading only what is new since its last cursor, the
+// way the /debug page does. Every line must arrive exactly once and in order,
+// except for gaps the poll reported as overwritten.
+static unsigned long tailFailures = 0;
+
+static void runIncrementalTail(long lines, int pollUs)
+{
+    std::atomic<bool> stop(false);
+    unsigned long polls = 0;
+    unsigned long lappedPolls = 0;
+    unsigned long bytes = 0;
+    long expect = 0;
+    long missed = 0;
+
+    DebugLogCursor start;
+    debugLogCursorBegin(start, 0);
+    uint32_t since = start.end;
+
+    std::thread poller([&]() {
+        DebugLogCursor cursor;
+        String pending = "";
+        bool done = false;
+        while (!done) {
+            done = stop.load();
+            debugLogCursorSeek(cursor, since);
+            String chunk = "";
+            while (debugLogCursorNext(cursor)) chunk.concat(cursor.text, cursor.len);
+            since = cursor.pos;
+            polls++;
+            bytes += chunk.length();
+            if (cursor.lapped) lappedPolls++;
+
+            const char* p = chunk.c_str();
+            while (*p) {
+                long seq = -1;
+                if (sscanf(p, "[T] seq=%ld", &seq) != 1) {
+                    tailFailures++;
+                } else if (seq != expect) {
+                    if (seq < expect || !cursor.lapped) tailFailures++;
+                    else missed += seq - expect;
+                }
+                expect = seq + 1;
+                const char* nl = strchr(p, '\n');
+                if (nl == nullptr) break;
+                p = nl + 1;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(pollUs));
+        }
+    });
+
+    char line[64];
+    for (long i = 0; i < lines; i++) {
+        snprintf(line, sizeof(line), "[T] seq=%ld\n", i);
+        addToDebugBuffer(line);
+        if ((i & 63) == 0) std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    stop = true;
+    poller.join();
+    if (expect != lines) tailFailures++;
+
+    printf("%8d %8lu %14.0f %10lu %10ld\n", pollUs, polls, polls ? (double)bytes / polls : 0.0, lappedPolls, missed);
+}
+
+// =============================================================================
+// DEFERRED FORMATTING
+// =============================================================================
+static void textLog(const char* format, ...)
+{
+    char buffer[DEBUG_LINE_MAX];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    addToDebugBuffer(buffer);
+}
+
+static void binaryLog(const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    bool stored = addFormatToDebugBuffer(format, args);
+    va_end(args);
+    if (!stored) printf("  binary encoder rejected \"%s\"\n", format);
+}
+
+// Representative hot-path lines (copied from controlRelays()/the sensor task)
+static void logSample(bool binary, long i)
+{
+    void (*log)(const char*, ...) = binary ? binaryLog : textLog;
+    float temp = 68.0f + (float)(i % 50) * 0.1f;
+    log("controlRelays ENTRY: mode=%s temp=%.1f setpoint=%.1f swing=%.1f\n", "heat", temp, 70.0f, 1.0f);
+    log("[HVAC] stage1Active=%d stage2Active=%d runtime=%lu ms\n", 1, (int)(i & 1), (unsigned long)i * 1000UL);
+    log("Sensor: temp=%.2f hum=%.1f%% pressure=%.1f heap=%u\n", temp, 45.5f, 1013.2f, 180000u);
+}
+
+// Last line of the ring, without the newline
+static String lastLine()
+{
+    String log = getDebugLog();
+    const char* p = log.c_str();
+    const char* end = p + log.length();
+    if (end > p && end[-1] == '\n') end--;
+    const char* start = end;
+    while (start > p && start[-1] != '\n') start--;
+    return String(start).substring(0, (unsigned int)(end - start));
+}
+
+static unsigned long fidelityFailures = 0;
+
+static void checkFormat(const char* format, ...)
+{
+    char expect[DEBUG_LINE_MAX];
+    va_list args;
+    va_start(args, format);
+    va_list copy;
+    va_copy(copy, args);
+    vsnprintf(expect, sizeof(expect), format, copy);
+    va_end(copy);
+    bool stored = addFormatToDebugBuffer(format, args);
+    va_end(args);
+    addToDebugBuffer("\n");
+
+    String got = lastLine();
+    if (!stored || got != String(expect)) {
+        fidelityFailures++;
+        printf("  MISMATCH %-28s expected \"%s\" got \"%s\"\n", format, expect, got.c_str());
+    }
+}
+
+static void runFidelity()
+{
+    checkFormat("plain text");
+    checkFormat("int %d neg %i hex %X %x pct %%", 42, -7, 0xBEEFu, 255u);
+    checkFormat("unsigned %u long %lu %ld", 4000000000u, 123456789UL, -5L);
+    checkFormat("ll %lld %llu size %zu", -1234567890123LL, 9876543210ULL, (size_t)77);
+    checkFormat("float %.1f %.2f %f %e %g", 71.25f, -3.14159, 2.5, 12345.678, 0.0001);
+    checkFormat("width [%5d] [%-6s] [%08.3f] [%+d]", 12, "ab", 3.5, 9);
+    checkFormat("star [%*d] [%.*f] [%-*.*s]", 6, 42, 3, 1.23456, 8, 3, "abcdef");
+    checkFormat("str %s null %s empty '%s'", "HEAT", (const char*)nullptr, "");
+    checkFormat("char %c%c%c", 'o', 'k', '!');
+    checkFormat("ptr %p", (void*)0x1234);
+    checkFormat("short %hd %hhu", (short)-3, (unsigned char)200);
+    // Strings are captured at most DEBUG_ARG_STRING_MAX long
+    char longArg[DEBUG_ARG_STRING_MAX + 1];
+    memset(longArg, 'x', DEBUG_ARG_STRING_MAX);
+    longArg[DEBUG_ARG_STRING_MAX] = '\0';
+    checkFormat("long str %s end", longArg);
+}
+
+static void runDeferredFormatting(long events)
+{
+    printf("\nDeferred formatting (single thread, %ld events per mode)\n", events);
+    printf("%-8s %10s %14s %16s\n", "record", "ns/event", "bytes/event", "events in ring");
+
+    for (int binary = 0; binary <= 1; binary++) {
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        for (long i = 0; i < events; i += 3) logSample(binary != 0, i);
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+
+        // Measure retention: fill the ring with a fresh batch and count what's readable
+        const char* marker = "=== retention ===\n";
+        addToDebugBuffer(marker);
+        for (long i = 0; i < 3000; i += 3) logSample(binary != 0, i);
+        String log = getDebugLog();
+        long lines = 0;
+        for (unsigned int c = 0; c < log.length(); c++) {
+            if (log[c] == '\n') lines++;
+        }
+        // Record sizes: header (8) + payload, rounded up to 4 bytes
+        double bytesPerEvent = (double)DEBUG_BUFFER_SIZE / (double)lines;
+        printf("%-8s %10.0f %14.1f %16ld\n", binary ? "binary" : "text", ns / (double)events, bytesPerEvent, lines);
+    }
+
+    runFidelity();
+    printf("decode mismatches: %lu\n", fidelityFailures);
+}
+
+int main(int argc, char** argv)
+{
+    long linesPerWriter = argc > 1 ? atol(argv[1]) : 200000;
+    if (linesPerWriter <= 0) linesPerWriter = 200000;
+    legacyMutex = xSemaphoreCreateMutex();
+
+    printf("Debug log ring contention: %ld lines per writer, 1 reader snapshotting continuously\n", linesPerWriter);
+    printf("hardware threads: %u\n\n", std::thread::hardware_concurrency());
+    printf("%-10s %7s %12s %9s %9s %11s %9s %6s %8s\n", "ring", "writers", "lines/s", "p50 ns", "p99 ns", "max ns", "reads", "bad", "dropped");
+
+    const int writerCounts[] = { 1, 2, 4, MAX_WRITERS };
+    int run = 0;
+    unsigned long totalBad = 0;
+    unsigned long dropRunsOverLimit = 0;
+    for (size_t i = 0; i < sizeof(writerCounts) / sizeof(writerCounts[0]); i++) {
+        for (int lockFree = 0; lockFree <= 1; lockFree++) {
+            RunResult r = runContention(run++, lockFree != 0, writerCounts[i], linesPerWriter);
+            if (lockFree) totalBad += r.badLines;
+            if (lockFree && r.dropped > (unsigned long)(writerCounts[i] * linesPerWriter / DROP_LIMIT_DIVISOR)) dropRunsOverLimit++;
+            printf("%-10s %7d %12.0f %9.0f %9.0f %11.0f %9lu %6s %8s\n",
+                   lockFree ? "lock-free" : "mutex", writerCounts[i], r.linesPerSec,
+                   r.p50Ns, r.p99Ns, r.maxNs, r.snapshots,
+                   lockFree ? String((unsigned long)r.badLines).c_str() : "-",
+                   lockFree ? String((unsigned long)r.dropped).c_str() : "-");
+        }
+    }
+
+    printf("runs over the drop limit (1/%ld): %lu\n", DROP_LIMIT_DIVISOR, dropRunsOverLimit);
+
+    printf("\nIncremental tail: %ld lines, poller reading since its last cursor\n", linesPerWriter);
+    printf("%8s %8s %14s %10s %10s\n", "poll us", "polls", "bytes/poll", "lapped", "missed");
+    runIncrementalTail(linesPerWriter, 1000);
+    runIncrementalTail(linesPerWriter, 200000);
+    printf("tail errors: %lu\n\n", tailFailures);
+
+    runDeferredFormatting(linesPerWriter * 3);
+    return totalBad == 0 && dropRunsOverLimit == 0 && fidelityFailures == 0 && tailFailures == 0 ? 0 : 1;
+}
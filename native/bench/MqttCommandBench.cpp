@@ -0,0 +1,178 @@
+/*
+ * MqttCommandBench.cpp - Heap allocations per inbound MQTT command
+ *
+ * Compares how processMQTTCommands() used to hand a schedule/set payload to
+ * its handler (String copy of the payload, JsonDocument, String for the
+ * period) with the in-place parser in MqttCommandParser.cpp. Every
+ * operator new and every JsonDocument allocation is counted, so the table
+ * shows allocations per message next to the time per message. Both paths
+ * must decode the same fields from every payload, and the parser must
+ * reject every one of INVALID_PAYLOADS.
+ *
+ *   pio run -e native_mqttbench && .pio/build/native_mqttbench/program [messages]
+ */
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <chrono>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "MqttCommandParser.h"
+
+// =============================================================================
+// ALLOCATION COUNTING
+// =============================================================================
+static unsigned long allocations = 0;
+
+void* operator new(size_t size)
+{
+    allocations++;
+    void* p = malloc(size ? size : 1);
+    if (p == NULL) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+// ArduinoJson allocates with malloc(), not operator new
+struct CountingAllocator : ArduinoJson::Allocator {
+    void* allocate(size_t size) override { allocations++; return malloc(size); }
+    void deallocate(void* p) override { free(p); }
+    void* reallocate(void* p, size_t size) override { allocations++; return realloc(p, size); }
+};
+static CountingAllocator countingAllocator;
+
+static const char* const PAYLOADS[] = {
+    "{\"day\": 0, \"period\": \"day\", \"hour\": 6, \"minute\": 30, \"heat\": 72.0, \"cool\": 78.0, \"auto\": 74.0, \"active\": true}",
+    "{\"day\":6,\"period\":\"night\",\"heat\":66.5}",
+    "{\"day\": 3, \"period\": \"night\", \"enabled\": false}",
+    "{\"day\":2,\"period\":\"day\",\"minute\":45,\"active\":false}"
+};
+static const int PAYLOAD_COUNT = sizeof(PAYLOADS) / sizeof(PAYLOADS[0]);
+
+// Not JSON numbers, or not representable: the parser must reject each one
+static const char* const INVALID_PAYLOADS[] = {
+    "{\"day\":0,\"period\":\"day\",\"heat\":nan}",
+    "{\"day\":0,\"period\":\"day\",\"heat\":NaN}",
+    "{\"day\":0,\"period\":\"day\",\"cool\":inf}",
+    "{\"day\":0,\"period\":\"day\",\"cool\":-Infinity}",
+    "{\"day\":0,\"period\":\"day\",\"cool\":1e999}",
+    "{\"day\":0,\"period\":\"day\",\"auto\":1e39}",
+    "{\"day\":0,\"period\":\"day\",\"hour\":0x10}",
+    "{\"day\":0,\"period\":\"day\",\"hour\":+6}",
+    "{\"day\":0,\"period\":\"day\",\"minute\":1e20}",
+    "{\"day\":0,\"period\":\"day\",\"heat\":07}",
+    "{\"day\":0,\"period\":\"day\",\"heat\":72.}"
+};
+static const int INVALID_COUNT = sizeof(INVALID_PAYLOADS) / sizeof(INVALID_PAYLOADS[0]);
+
+// What the schedule handler acts on; filled the same way by both paths
+struct Decoded {
+    int day;
+    char period[8];
+    uint8_t fields;
+    int hour, minute;
+    float heat, cool, autoTemp;
+    bool active, enabled;
+};
+
+// =============================================================================
+// BASELINE: String + JsonDocument, as mqttHandleSchedule() used to
+// =============================================================================
+static bool legacyDecode(const char* payload, Decoded& out)
+{
+    memset(&out, 0, sizeof(out));
+    String message = payload;
+    JsonDocument doc(&countingAllocator);
+    if (deserializeJson(doc, message.c_str(), message.length())) return false;
+
+    out.day = doc["day"] | -1;
+    String period = doc["period"] | "";
+    strncpy(out.period, period.c_str(), sizeof(out.period) - 1);
+    if (doc["hour"].is<JsonVariant>())    { out.hour = doc["hour"];        out.fields |= MQTT_SCHEDULE_HOUR; }
+    if (doc["minute"].is<JsonVariant>())  { out.minute = doc["minute"];    out.fields |= MQTT_SCHEDULE_MINUTE; }
+    if (doc["heat"].is<JsonVariant>())    { out.heat = doc["heat"];        out.fields |= MQTT_SCHEDULE_HEAT; }
+    if (doc["cool"].is<JsonVariant>())    { out.cool = doc["cool"];        out.fields |= MQTT_SCHEDULE_COOL; }
+    if (doc["auto"].is<JsonVariant>())    { out.autoTemp = doc["auto"];    out.fields |= MQTT_SCHEDULE_AUTO; }
+    if (doc["active"].is<JsonVariant>())  { out.active = doc["active"];    out.fields |= MQTT_SCHEDULE_ACTIVE; }
+    if (doc["enabled"].is<JsonVariant>()) { out.enabled = doc["enabled"];  out.fields |= MQTT_SCHEDULE_ENABLED; }
+    return true;
+}
+
+// =============================================================================
+// NEW: in-place parser straight from the queued payload
+// =============================================================================
+static bool parserDecode(const char* payload, Decoded& out)
+{
+    MqttScheduleUpdate update;
+    if (!mqttParseScheduleUpdate(payload, strlen(payload), update)) return false;
+    memset(&out, 0, sizeof(out));
+    out.day = update.day;
+    memcpy(out.period, update.period, sizeof(out.period));
+    out.fields = update.fields;
+    out.hour = update.hour;
+    out.minute = update.minute;
+    out.heat = update.heat;
+    out.cool = update.cool;
+    out.autoTemp = update.autoTemp;
+    out.active = update.active;
+    out.enabled = update.enabled;
+    return true;
+}
+
+static bool sameDecode(const Decoded& a, const Decoded& b)
+{
+    return a.day == b.day && strcmp(a.period, b.period) == 0 && a.fields == b.fields &&
+           a.hour == b.hour && a.minute == b.minute && a.heat == b.heat && a.cool == b.cool &&
+           a.autoTemp == b.autoTemp && a.active == b.active && a.enabled == b.enabled;
+}
+
+typedef bool (*DecodeFn)(const char* payload, Decoded& out);
+
+static void run(const char* name, DecodeFn decode, long messages)
+{
+    volatile int sink = 0;
+    unsigned long before = allocations;
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < messages; i++) {
+        Decoded d;
+        if (decode(PAYLOADS[i % PAYLOAD_COUNT], d)) sink += d.day + d.fields;
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    printf("%-10s %12.0f %14.2f\n", name, ns / messages, (double)(allocations - before) / messages);
+    (void)sink;
+}
+
+int main(int argc, char** argv)
+{
+    long messages = argc > 1 ? atol(argv[1]) : 1000000;
+    if (messages <= 0) messages = 1000000;
+
+    unsigned long mismatches = 0;
+    for (int i = 0; i < PAYLOAD_COUNT; i++) {
+        Decoded legacy, parsed;
+        bool legacyOk = legacyDecode(PAYLOADS[i], legacy);
+        bool parsedOk = parserDecode(PAYLOADS[i], parsed);
+        if (legacyOk != parsedOk || !sameDecode(legacy, parsed)) {
+            printf("  MISMATCH %s\n", PAYLOADS[i]);
+            mismatches++;
+        }
+    }
+    for (int i = 0; i < INVALID_COUNT; i++) {
+        Decoded parsed;
+        if (parserDecode(INVALID_PAYLOADS[i], parsed)) {
+            printf("  ACCEPTED %s\n", INVALID_PAYLOADS[i]);
+            mismatches++;
+        }
+    }
+
+    printf("schedule/set decode: %ld messages over %d payloads\n", messages, PAYLOAD_COUNT);
+    printf("%-10s %12s %14s\n", "path", "ns/message", "allocs/message");
+    run("legacy", legacyDecode, messages);
+    run("in-place", parserDecode, messages);
+    printf("decode mismatches: %lu\n", mismatches);
+    return mismatches == 0 ? 0 : 1;
+}
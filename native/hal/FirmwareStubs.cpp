@@ -0,0 +1,160 @@
+/*
+ * FirmwareStubs.cpp - Host stand-ins for the parts of Main-Thermostat.cpp that
+ * the control core reaches into (sensor inputs, display/LED hooks, debugLog)
+ */
+
+#include "HvacControl.h"
+#include <stdio.h>
+#include <string.h>
+#include "NativeHal.h"
+
+// Inputs normally owned by the sensor task / settings in Main-Thermostat.cpp
+float currentTemp = 0.0;
+float currentHumidity = 0.0;
+float hydronicTemp = 0.0;
+bool ds18b20SensorPresent = false;
+bool displayIsAsleep = false;
+String timeZone = "CST6CDT,M3.2.0,M11.1.0";
+
+// =============================================================================
+// debugLog sink
+// =============================================================================
+static bool logEcho = false;
+static bool logFormat = true;
+static unsigned long logCalls = 0;
+static unsigned long logBytes = 0;
+
+void nativeLogEcho(bool enabled) { logEcho = enabled; }
+void nativeLogFormat(bool enabled) { logFormat = enabled; }
+unsigned long nativeLogCalls() { return logCalls; }
+unsigned long nativeLogBytes() { return logBytes; }
+void nativeLogResetCounters() { logCalls = 0; logBytes = 0; }
+
+// Same formatting cost as the firmware (256-byte vsnprintf per call) so
+// control-cycle timings include it; output is only printed when echo is on.
+// Simulations that only need call counts can switch formatting off.
+void debugLog(const char* format, ...)
+{
+    if (!logFormat && !logEcho) {
+        logCalls++;
+        return;
+    }
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    logCalls++;
+    if (len > 0) {
+        logBytes += (len < (int)sizeof(buffer)) ? len : (int)sizeof(buffer) - 1;
+    }
+    if (logEcho) {
+        fputs(buffer, stdout);
+    }
+}
+
+// =============================================================================
+// Firmware hooks
+// =============================================================================
+static unsigned long applyScheduleCalls = 0;
+
+unsigned long nativeApplyScheduleCount() { return applyScheduleCalls; }
+
+// Mirrors the setpoint part of applySchedule(); NVS, MQTT and display updates
+// have no host equivalent.
+void applySchedule(int dayOfWeek, bool isDayPeriod)
+{
+    DaySchedule& schedule = weekSchedule[dayOfWeek];
+    SchedulePeriod& period = isDayPeriod ? schedule.day : schedule.night;
+
+    if (!period.active) return;
+
+    setTempHeat = period.heatTemp;
+    setTempCool = period.coolTemp;
+    setTempAuto = period.autoTemp;
+    applyScheduleCalls++;
+}
+
+void updateStatusLEDs() {}
+void setDisplayUpdateFlag() {}
+void buzzerBeep(int duration) { (void)duration; }
+
+void wakeDisplay()
+{
+    displayIsAsleep = false;
+}
+
+// =============================================================================
+// Control state reset
+// =============================================================================
+void nativeResetControlState()
+{
+    // weekSchedule is constant-initialised, so the first call still sees the
+    // boot defaults and can keep a copy for later resets
+    static DaySchedule defaultWeek[7];
+    static bool haveDefaultWeek = false;
+    if (!haveDefaultWeek) {
+        memcpy(defaultWeek, weekSchedule, sizeof(defaultWeek));
+        haveDefaultWeek = true;
+    }
+    memcpy(weekSchedule, defaultWeek, sizeof(defaultWeek));
+
+    setTempHeat = 72.0;
+    setTempCool = 76.0;
+    setTempAuto = 74.0;
+    tempSwing = 1.0;
+    autoTempSwing = 3.0;
+    fanRelayNeeded = false;
+    fanMinutesPerHour = 15;
+    lastFanRunTime = 0;
+    fanRunDuration = 0;
+    heatingOn = false;
+    coolingOn = false;
+    fanOn = false;
+    thermostatMode = "off";
+    fanMode = "auto";
+    stage1MinRuntime = 300;
+    stage2TempDelta = 2.0;
+    stage1StartTime = 0;
+    stage2StartTime = 0;
+    stage1Active = false;
+    stage2Active = false;
+    stage2HeatingEnabled = false;
+    stage2CoolingEnabled = false;
+    reversingValveEnabled = false;
+    backupHeatEnabled = false;
+    backupHeatRelaySelection = 0;
+    backupHeatDelayMinutes = 30;
+    backupHeatMinTempRise = 0.5f;
+    backupHeatMaxTempDrop = 1.5f;
+    backupHeatActive = false;
+    backupHeatDemandStart = 0;
+    backupHeatLastTempRiseTime = 0;
+    backupHeatLastReferenceTemp = NAN;
+    thermostatRegion = "US";
+    euHumidityControlEnabled = false;
+    euHumidityRelaySelection = 0;
+    euHumiditySetpoint = 60.0f;
+    euHumidityDeadband = 5.0f;
+    euHumidityDemandActive = false;
+    hydronicHeatingEnabled = false;
+    hydronicTempLow = 110.0;
+    hydronicTempHigh = 130.0;
+    hydronicLockout = false;
+    showerModeEnabled = false;
+    showerModeDuration = 30;
+    showerModeActive = false;
+    showerModeStartTime = 0;
+    scheduleEnabled = false;
+    scheduleOverride = false;
+    overrideEndTime = 0;
+    activePeriod = "manual";
+    scheduleUpdatedFlag = false;
+
+    currentTemp = 0.0;
+    currentHumidity = 0.0;
+    hydronicTemp = 0.0;
+    ds18b20SensorPresent = false;
+    displayIsAsleep = false;
+    applyScheduleCalls = 0;
+}
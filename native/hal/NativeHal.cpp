@@ -0,0 +1,105 @@
+/*
+ * NativeHal.cpp - Virtual clock, GPIO table and FreeRTOS mutexes for host builds
+ */
+
+#include <Arduino.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include "NativeHal.h"
+
+// =============================================================================
+// VIRTUAL CLOCK
+// =============================================================================
+static std::atomic<uint64_t> virtualMillis(0);
+
+void nativeClockSet(uint64_t ms) { virtualMillis.store(ms); }
+void nativeClockAdvance(uint64_t ms) { virtualMillis.fetch_add(ms); }
+uint64_t nativeClockNow() { return virtualMillis.load(); }
+
+unsigned long millis() { return (unsigned long)virtualMillis.load(); }
+unsigned long micros() { return (unsigned long)(virtualMillis.load() * 1000ULL); }
+void delay(uint32_t ms) { nativeClockAdvance(ms); }
+
+void vTaskDelay(TickType_t ticks) { nativeClockAdvance(ticks); }
+TickType_t xTaskGetTickCount() { return (TickType_t)virtualMillis.load(); }
+
+// =============================================================================
+// GPIO
+// =============================================================================
+static uint8_t pinLevel[NATIVE_PIN_COUNT];
+static uint8_t pinModes[NATIVE_PIN_COUNT];
+static unsigned long pinEdges[NATIVE_PIN_COUNT];
+static unsigned long pinWrites[NATIVE_PIN_COUNT];
+
+void nativePinsReset()
+{
+    for (int i = 0; i < NATIVE_PIN_COUNT; i++) {
+        pinLevel[i] = LOW;
+        pinModes[i] = INPUT;
+        pinEdges[i] = 0;
+        pinWrites[i] = 0;
+    }
+}
+
+int nativePinState(int pin) { return (pin >= 0 && pin < NATIVE_PIN_COUNT) ? pinLevel[pin] : LOW; }
+unsigned long nativePinEdgeCount(int pin) { return (pin >= 0 && pin < NATIVE_PIN_COUNT) ? pinEdges[pin] : 0; }
+unsigned long nativePinWriteCount(int pin) { return (pin >= 0 && pin < NATIVE_PIN_COUNT) ? pinWrites[pin] : 0; }
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    if (pin < NATIVE_PIN_COUNT) pinModes[pin] = mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+    if (pin >= NATIVE_PIN_COUNT) return;
+    uint8_t level = val ? HIGH : LOW;
+    pinWrites[pin]++;
+    if (pinLevel[pin] != level) {
+        pinEdges[pin]++;
+        pinLevel[pin] = level;
+    }
+}
+
+int digitalRead(uint8_t pin)
+{
+    return nativePinState(pin);
+}
+
+// =============================================================================
+// FREERTOS MUTEXES
+// =============================================================================
+struct NativeSemaphore {
+    std::timed_mutex mutex;
+};
+
+SemaphoreHandle_t xSemaphoreCreateMutex()
+{
+    return new NativeSemaphore();
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticksToWait)
+{
+    if (sem == NULL) return pdFALSE;
+    if (ticksToWait == portMAX_DELAY) {
+        sem->mutex.lock();
+        return pdTRUE;
+    }
+    if (ticksToWait == 0) {
+        return sem->mutex.try_lock() ? pdTRUE : pdFALSE;
+    }
+    return sem->mutex.try_lock_for(std::chrono::milliseconds(ticksToWait)) ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    if (sem == NULL) return pdFALSE;
+    sem->mutex.unlock();
+    return pdTRUE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+    delete sem;
+}
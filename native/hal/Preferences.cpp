@@ -0,0 +1,159 @@
+/*
+ * Preferences.cpp - In-memory NVS stand-in for host builds
+ *
+ * Like ESP-IDF NVS, writing a value identical to the stored one is a no-op
+ * and is not counted as a flash write.
+ */
+
+#include <Preferences.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include <vector>
+
+struct NativeNvsItem {
+    std::vector<uint8_t> data;
+};
+
+typedef std::map<std::string, NativeNvsItem> NativeNvsNamespace;
+
+static std::map<std::string, NativeNvsNamespace>& nvsStore()
+{
+    static std::map<std::string, NativeNvsNamespace> store;
+    return store;
+}
+
+static unsigned long nvsWrites = 0;
+static unsigned long nvsBytes = 0;
+
+unsigned long Preferences::writeCount() { return nvsWrites; }
+unsigned long Preferences::bytesWritten() { return nvsBytes; }
+void Preferences::resetCounters() { nvsWrites = 0; nvsBytes = 0; }
+
+bool Preferences::begin(const char* name, bool readOnly, const char* partitionLabel)
+{
+    (void)partitionLabel;
+    if (name == nullptr || strlen(name) > 15) return false; // NVS namespace limit
+    ns_ = name;
+    readOnly_ = readOnly;
+    started_ = true;
+    nvsStore()[ns_.c_str()];
+    return true;
+}
+
+void Preferences::end()
+{
+    started_ = false;
+}
+
+bool Preferences::clear()
+{
+    if (!started_ || readOnly_) return false;
+    nvsStore()[ns_.c_str()].clear();
+    return true;
+}
+
+bool Preferences::remove(const char* key)
+{
+    if (!started_ || readOnly_ || key == nullptr) return false;
+    return nvsStore()[ns_.c_str()].erase(key) > 0;
+}
+
+bool Preferences::isKey(const char* key)
+{
+    if (!started_ || key == nullptr) return false;
+    NativeNvsNamespace& ns = nvsStore()[ns_.c_str()];
+    return ns.find(key) != ns.end();
+}
+
+size_t Preferences::put(const char* key, const void* data, size_t len)
+{
+    if (!started_ || readOnly_ || key == nullptr || strlen(key) > 15) return 0; // NVS key limit
+    NativeNvsItem& item = nvsStore()[ns_.c_str()][key];
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    std::vector<uint8_t> incoming(bytes, bytes + len);
+    if (item.data != incoming) {
+        item.data.swap(incoming);
+        nvsWrites++;
+        nvsBytes += len;
+    }
+    return len;
+}
+
+bool Preferences::get(const char* key, void* data, size_t len)
+{
+    if (!started_ || key == nullptr) return false;
+    NativeNvsNamespace& ns = nvsStore()[ns_.c_str()];
+    NativeNvsNamespace::iterator it = ns.find(key);
+    if (it == ns.end() || it->second.data.size() != len) return false;
+    memcpy(data, it->second.data.data(), len);
+    return true;
+}
+
+size_t Preferences::putBool(const char* key, bool value) { uint8_t v = value ? 1 : 0; return put(key, &v, sizeof(v)); }
+size_t Preferences::putInt(const char* key, int32_t value) { return put(key, &value, sizeof(value)); }
+size_t Preferences::putUInt(const char* key, uint32_t value) { return put(key, &value, sizeof(value)); }
+size_t Preferences::putULong(const char* key, uint32_t value) { return put(key, &value, sizeof(value)); }
+size_t Preferences::putFloat(const char* key, float value) { return put(key, &value, sizeof(value)); }
+size_t Preferences::putString(const char* key, const char* value) { return put(key, value, strlen(value) + 1); }
+size_t Preferences::putString(const char* key, const String& value) { return putString(key, value.c_str()); }
+size_t Preferences::putBytes(const char* key, const void* value, size_t len) { return put(key, value, len); }
+
+bool Preferences::getBool(const char* key, bool defaultValue)
+{
+    uint8_t v;
+    return get(key, &v, sizeof(v)) ? (v != 0) : defaultValue;
+}
+
+int32_t Preferences::getInt(const char* key, int32_t defaultValue)
+{
+    int32_t v;
+    return get(key, &v, sizeof(v)) ? v : defaultValue;
+}
+
+uint32_t Preferences::getUInt(const char* key, uint32_t defaultValue)
+{
+    uint32_t v;
+    return get(key, &v, sizeof(v)) ? v : defaultValue;
+}
+
+uint32_t Preferences::getULong(const char* key, uint32_t defaultValue)
+{
+    return getUInt(key, defaultValue);
+}
+
+float Preferences::getFloat(const char* key, float defaultValue)
+{
+    float v;
+    return get(key, &v, sizeof(v)) ? v : defaultValue;
+}
+
+String Preferences::getString(const char* key, const String& defaultValue)
+{
+    if (!started_ || key == nullptr) return defaultValue;
+    NativeNvsNamespace& ns = nvsStore()[ns_.c_str()];
+    NativeNvsNamespace::iterator it = ns.find(key);
+    if (it == ns.end() || it->second.data.empty()) return defaultValue;
+    return String(reinterpret_cast<const char*>(it->second.data.data()));
+}
+
+size_t Preferences::getBytesLength(const char* key)
+{
+    if (!started_ || key == nullptr) return 0;
+    NativeNvsNamespace& ns = nvsStore()[ns_.c_str()];
+    NativeNvsNamespace::iterator it = ns.find(key);
+    return it == ns.end() ? 0 : it->second.data.size();
+}
+
+size_t Preferences::getBytes(const char* key, void* buf, size_t maxLen)
+{
+    size_t len = getBytesLength(key);
+    if (len == 0 || len > maxLen) return 0;
+    memcpy(buf, nvsStore()[ns_.c_str()][key].data.data(), len);
+    return len;
+}
+
+size_t Preferences::freeEntries()
+{
+    return 0x7fff; // Host store is unbounded
+}
@@ -0,0 +1,58 @@
+/*
+ * Arduino.h - Host-native Arduino/ESP32 HAL shim
+ *
+ * Lets the shared control sources (src/HvacControl.cpp) compile on Linux for
+ * the [env:native*] PlatformIO environments. GPIO writes land in a pin table,
+ * millis()/delay()/vTaskDelay() run on a virtual clock that only moves when
+ * the harness advances it, and FreeRTOS mutexes map onto std::timed_mutex.
+ * Inspection and clock control for harnesses are in NativeHal.h.
+ */
+
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+#include <stdint.h>
+#include <stdarg.h>
+#include <math.h>
+#include <stdlib.h>
+#include <cmath>
+#include <cstdlib>
+
+#include "WString.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+using std::abs;
+using std::isnan;
+
+typedef uint8_t byte;
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT          0x01
+#define OUTPUT         0x03
+#define INPUT_PULLUP   0x05
+#define INPUT_PULLDOWN 0x09
+
+template <typename T, typename L, typename H>
+static inline T constrain(T amt, L low, H high)
+{
+    return amt < (T)low ? (T)low : (amt > (T)high ? (T)high : amt);
+}
+
+static inline long map(long x, long inMin, long inMax, long outMin, long outMax)
+{
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+
+#endif // NATIVE_ARDUINO_H
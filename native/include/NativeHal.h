@@ -0,0 +1,38 @@
+/*
+ * NativeHal.h - Harness-side controls for the host-native HAL shim
+ *
+ * The firmware sources never include this; only native/ harnesses do.
+ */
+
+#ifndef NATIVE_HAL_H
+#define NATIVE_HAL_H
+
+#include <stdint.h>
+
+// Virtual clock (milliseconds). Unlike the ESP32, it does not wrap at 2^32.
+void nativeClockSet(uint64_t ms);
+void nativeClockAdvance(uint64_t ms);
+uint64_t nativeClockNow();
+
+// GPIO table
+const int NATIVE_PIN_COUNT = 49; // GPIO0..GPIO48 on the ESP32-S3
+void nativePinsReset();
+int nativePinState(int pin);
+unsigned long nativePinEdgeCount(int pin);   // LOW<->HIGH transitions since reset
+unsigned long nativePinWriteCount(int pin);  // digitalWrite() calls since reset
+
+// debugLog() sink (implemented in FirmwareStubs.cpp)
+void nativeLogEcho(bool enabled);            // also print formatted lines to stdout
+void nativeLogFormat(bool enabled);          // false: only count calls (long simulations)
+unsigned long nativeLogCalls();
+unsigned long nativeLogBytes();
+void nativeLogResetCounters();
+
+// Firmware hook counters (implemented in FirmwareStubs.cpp)
+unsigned long nativeApplyScheduleCount();
+
+// Restore every HvacControl.cpp global to its boot default so harness
+// scenarios don't leak settings into each other
+void nativeResetControlState();
+
+#endif // NATIVE_HAL_H
@@ -0,0 +1,61 @@
+/*
+ * Preferences.h - Host-native stand-in for the ESP32 Preferences (NVS) class
+ *
+ * Keys live in an in-memory map per namespace, shared across instances the
+ * same way NVS is, so load/save code can be exercised without flash. Every
+ * put* that changes storage bumps writeCount()/bytesWritten() so harnesses
+ * can measure persistence cost.
+ */
+
+#ifndef NATIVE_PREFERENCES_H
+#define NATIVE_PREFERENCES_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <math.h>
+#include "WString.h"
+
+class Preferences {
+public:
+    bool begin(const char* name, bool readOnly = false, const char* partitionLabel = nullptr);
+    void end();
+
+    bool clear();
+    bool remove(const char* key);
+    bool isKey(const char* key);
+
+    size_t putBool(const char* key, bool value);
+    size_t putInt(const char* key, int32_t value);
+    size_t putUInt(const char* key, uint32_t value);
+    size_t putULong(const char* key, uint32_t value);
+    size_t putFloat(const char* key, float value);
+    size_t putString(const char* key, const char* value);
+    size_t putString(const char* key, const String& value);
+    size_t putBytes(const char* key, const void* value, size_t len);
+
+    bool getBool(const char* key, bool defaultValue = false);
+    int32_t getInt(const char* key, int32_t defaultValue = 0);
+    uint32_t getUInt(const char* key, uint32_t defaultValue = 0);
+    uint32_t getULong(const char* key, uint32_t defaultValue = 0);
+    float getFloat(const char* key, float defaultValue = NAN);
+    String getString(const char* key, const String& defaultValue = String());
+    size_t getBytesLength(const char* key);
+    size_t getBytes(const char* key, void* buf, size_t maxLen);
+
+    size_t freeEntries();
+
+    // Host-only accounting
+    static unsigned long writeCount();
+    static unsigned long bytesWritten();
+    static void resetCounters();
+
+private:
+    size_t put(const char* key, const void* data, size_t len);
+    bool get(const char* key, void* data, size_t len);
+
+    String ns_;
+    bool started_ = false;
+    bool readOnly_ = false;
+};
+
+#endif // NATIVE_PREFERENCES_H
@@ -0,0 +1,97 @@
+/*
+ * WString.h - Host-native stand-in for the Arduino String class
+ *
+ * Backed by std::string. Only the subset of the Arduino API that the shared
+ * firmware sources use is provided; extend it as more code moves to native.
+ */
+
+#ifndef NATIVE_WSTRING_H
+#define NATIVE_WSTRING_H
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <strings.h>
+#include <string>
+
+class String {
+public:
+    String() {}
+    String(const char* s) : str_(s ? s : "") {}
+    String(const std::string& s) : str_(s) {}
+    explicit String(char c) : str_(1, c) {}
+    explicit String(int v) : str_(std::to_string(v)) {}
+    explicit String(unsigned int v) : str_(std::to_string(v)) {}
+    explicit String(long v) : str_(std::to_string(v)) {}
+    explicit String(unsigned long v) : str_(std::to_string(v)) {}
+    explicit String(float v, unsigned int decimals = 2) { setFloat(v, decimals); }
+    explicit String(double v, unsigned int decimals = 2) { setFloat(v, decimals); }
+
+    const char* c_str() const { return str_.c_str(); }
+    unsigned int length() const { return (unsigned int)str_.size(); }
+    bool isEmpty() const { return str_.empty(); }
+    bool reserve(unsigned int size) { str_.reserve(size); return true; }
+    char charAt(unsigned int i) const { return i < str_.size() ? str_[i] : 0; }
+    char operator[](unsigned int i) const { return charAt(i); }
+
+    bool equals(const String& o) const { return str_ == o.str_; }
+    bool equalsIgnoreCase(const String& o) const { return strcasecmp(c_str(), o.c_str()) == 0; }
+    bool startsWith(const String& p) const { return str_.compare(0, p.str_.size(), p.str_) == 0; }
+    bool endsWith(const String& s) const {
+        return str_.size() >= s.str_.size() &&
+               str_.compare(str_.size() - s.str_.size(), s.str_.size(), s.str_) == 0;
+    }
+    int indexOf(char c, unsigned int from = 0) const {
+        size_t pos = str_.find(c, from);
+        return pos == std::string::npos ? -1 : (int)pos;
+    }
+    int indexOf(const String& s, unsigned int from = 0) const {
+        size_t pos = str_.find(s.str_, from);
+        return pos == std::string::npos ? -1 : (int)pos;
+    }
+    String substring(unsigned int from) const { return from < str_.size() ? String(str_.substr(from)) : String(); }
+    String substring(unsigned int from, unsigned int to) const {
+        if (from > to) { unsigned int t = from; from = to; to = t; }
+        if (from >= str_.size()) return String();
+        return String(str_.substr(from, to - from));
+    }
+    long toInt() const { return strtol(str_.c_str(), nullptr, 10); }
+    float toFloat() const { return strtof(str_.c_str(), nullptr); }
+    void trim() {
+        size_t b = str_.find_first_not_of(" \t\r\n");
+        size_t e = str_.find_last_not_of(" \t\r\n");
+        str_ = (b == std::string::npos) ? std::string() : str_.substr(b, e - b + 1);
+    }
+
+    bool concat(const char* s, unsigned int len) { if (s) str_.append(s, len); return true; }
+    String& operator+=(const String& o) { str_ += o.str_; return *this; }
+    String& operator+=(const char* s) { if (s) str_ += s; return *this; }
+    String& operator+=(char c) { str_ += c; return *this; }
+    String& operator+=(int v) { str_ += std::to_string(v); return *this; }
+    String& operator+=(unsigned long v) { str_ += std::to_string(v); return *this; }
+    String& operator+=(float v) { return *this += String(v); }
+
+    friend String operator+(const String& a, const String& b) { return String(a.str_ + b.str_); }
+    friend String operator+(const String& a, const char* b) { return String(a.str_ + (b ? b : "")); }
+    friend String operator+(const char* a, const String& b) { return String(std::string(a ? a : "") + b.str_); }
+    friend String operator+(const String& a, char c) { return String(a.str_ + c); }
+
+    friend bool operator==(const String& a, const String& b) { return a.str_ == b.str_; }
+    friend bool operator==(const String& a, const char* b) { return a.str_ == (b ? b : ""); }
+    friend bool operator==(const char* a, const String& b) { return b == a; }
+    friend bool operator!=(const String& a, const String& b) { return !(a == b); }
+    friend bool operator!=(const String& a, const char* b) { return !(a == b); }
+    friend bool operator!=(const char* a, const String& b) { return !(b == a); }
+    friend bool operator<(const String& a, const String& b) { return a.str_ < b.str_; }
+
+private:
+    void setFloat(double v, unsigned int decimals) {
+        char buf[48];
+        snprintf(buf, sizeof(buf), "%.*f", (int)decimals, v);
+        str_ = buf;
+    }
+
+    std::string str_;
+};
+
+#endif // NATIVE_WSTRING_H
@@ -0,0 +1,29 @@
+/*
+ * freertos/FreeRTOS.h - Host-native FreeRTOS type shim
+ *
+ * One tick is one millisecond, matching CONFIG_FREERTOS_HZ=1000 on the
+ * ESP32-S3 Arduino core, so pdMS_TO_TICKS() timeouts keep their meaning.
+ */
+
+#ifndef NATIVE_FREERTOS_H
+#define NATIVE_FREERTOS_H
+
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define pdTRUE  ((BaseType_t)1)
+#define pdFALSE ((BaseType_t)0)
+#define pdPASS  pdTRUE
+#define pdFAIL  pdFALSE
+
+#define portMAX_DELAY      ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS ((TickType_t)1)
+#define pdMS_TO_TICKS(ms)  ((TickType_t)(ms))
+
+// No interrupts on the host
+static inline BaseType_t xPortInIsrContext() { return pdFALSE; }
+
+#endif // NATIVE_FREERTOS_H
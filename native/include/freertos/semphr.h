@@ -0,0 +1,23 @@
+/*
+ * freertos/semphr.h - Host-native mutex semaphores
+ *
+ * Mutexes are real (std::timed_mutex) so multi-threaded host benchmarks see
+ * genuine contention. Timeouts are measured in host wall-clock milliseconds,
+ * not on the virtual millis() clock, so a harness never deadlocks on a lock
+ * it forgot to advance time for.
+ */
+
+#ifndef NATIVE_FREERTOS_SEMPHR_H
+#define NATIVE_FREERTOS_SEMPHR_H
+
+#include "FreeRTOS.h"
+
+struct NativeSemaphore;
+typedef NativeSemaphore* SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex();
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticksToWait);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem);
+void vSemaphoreDelete(SemaphoreHandle_t sem);
+
+#endif // NATIVE_FREERTOS_SEMPHR_H
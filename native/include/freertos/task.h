@@ -0,0 +1,22 @@
+/*
+ * freertos/task.h - Host-native task delay shim
+ *
+ * vTaskDelay() advances the virtual clock instead of sleeping; there is no
+ * scheduler, so harnesses drive the firmware task bodies themselves.
+ * taskYIELD() yields the calling host thread (benches run real threads).
+ */
+
+#ifndef NATIVE_FREERTOS_TASK_H
+#define NATIVE_FREERTOS_TASK_H
+
+#include <sched.h>
+#include "FreeRTOS.h"
+
+typedef void* TaskHandle_t;
+
+void vTaskDelay(TickType_t ticks);
+TickType_t xTaskGetTickCount();
+
+#define taskYIELD() sched_yield()
+
+#endif // NATIVE_FREERTOS_TASK_H
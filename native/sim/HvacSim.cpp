@@ -0,0 +1,519 @@
+/*
+ * HvacSim.cpp - Accelerated virtual-time HVAC simulator
+ *
+ * Couples PlantModel with the real control code in HvacControl.cpp and runs
+ * it on the virtual millis() clock with the same cadence as the firmware:
+ *   - sensor read + EMA filter + controlRelays() every 5 s (sensor task)
+ *   - controlFanSchedule() every 30 s and checkScheduleAt() every 60 s (loop)
+ * A simulated year takes a few seconds per scenario, so tempSwing,
+ * stage1MinRuntime and stage2TempDelta can be tuned against a model of the
+ * building before touching a live system.
+ *
+ *   pio run -e native_sim && .pio/build/native_sim/program [options]
+ *
+ *   --days N            simulated days per scenario (default 365)
+ *   --scenario NAME     run one scenario (default: all, see --list)
+ *   --swing F           tempSwing override (°F)
+ *   --auto-swing F      autoTempSwing override (°F)
+ *   --stage1-min S      stage1MinRuntime override (seconds)
+ *   --stage2-delta F    stage2TempDelta override (°F)
+ *   --control-period S  seconds between controlRelays() calls (default 5;
+ *                       1 also reproduces the 1 s loop() re-evaluation)
+ *   --log-level L       runtime level for every log tag (default info)
+ *   --list              list scenarios and exit
+ *   -v                  echo debugLog() output (very slow)
+ */
+
+#include <Arduino.h>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "HvacControl.h"
+#include "NativeHal.h"
+#include "PlantModel.h"
+
+static const int SENSOR_PERIOD_S = 5;          // Sensor task cadence in Main-Thermostat.cpp
+static const float TEMP_EMA_ALPHA = 0.1f;      // Same smoothing as the sensor task
+static const float HUMIDITY_EMA_ALPHA = 0.15f;
+static const float SENSOR_NOISE = 0.1f;        // ± °F / %RH uniform sensor noise
+
+// =============================================================================
+// BUILDINGS AND SCENARIOS
+// =============================================================================
+
+// 1,800 ft² house, design load ~25k BTU/h at 9°F
+static const BuildingParams coldClimate = {
+    4000.0f, 450.0f, 2000.0f, 4000.0f,
+    45.0f, 27.0f, 9.0f,
+    35.0f, 20.0f, 1.0f, 4.0f
+};
+
+// Same house in a hot/humid climate, design load ~18k BTU/h at 93°F
+static const BuildingParams hotHumidClimate = {
+    4000.0f, 450.0f, 2500.0f, 8000.0f,
+    72.0f, 12.0f, 9.0f,
+    50.0f, 15.0f, 1.5f, 4.0f
+};
+
+// Heating and cooling seasons of similar weight
+static const BuildingParams mixedClimate = {
+    4000.0f, 450.0f, 2000.0f, 6000.0f,
+    58.0f, 22.0f, 11.0f,
+    45.0f, 15.0f, 1.2f, 4.0f
+};
+
+static EquipmentParams noEquipment()
+{
+    EquipmentParams e;
+    memset(&e, 0, sizeof(e));
+    e.boilerSetpoint = 180.0f;
+    e.boilerDifferential = 15.0f;
+    e.waterMass = 300.0f;
+    return e;
+}
+
+static EquipmentParams singleStageFurnace()
+{
+    EquipmentParams e = noEquipment();
+    e.heatStage1 = 40000.0f;
+    return e;
+}
+
+static EquipmentParams twoStageFurnace()
+{
+    EquipmentParams e = noEquipment();
+    e.heatStage1 = 20000.0f;
+    e.heatStage2 = 20000.0f;
+    return e;
+}
+
+static EquipmentParams heatPumpWithStrips()
+{
+    EquipmentParams e = noEquipment();
+    e.heatStage1 = 30000.0f;
+    e.heatPumpDerate = 0.02f;
+    e.backupHeat = 30000.0f;
+    e.coolStage1 = 24000.0f;
+    e.coolDryRate = 3.0f;
+    return e;
+}
+
+static EquipmentParams twoStageAC()
+{
+    EquipmentParams e = noEquipment();
+    e.coolStage1 = 18000.0f;
+    e.coolStage2 = 12000.0f;
+    e.coolDryRate = 3.0f;
+    e.dehumidifierRate = 8.0f;
+    return e;
+}
+
+static EquipmentParams furnaceAndAC()
+{
+    EquipmentParams e = twoStageFurnace();
+    e.coolStage1 = 18000.0f;
+    e.coolDryRate = 3.0f;
+    return e;
+}
+
+// Boiler too small for the design day: long zone calls pull the loop down
+// into the hydronic lockout band
+static EquipmentParams undersizedBoiler()
+{
+    EquipmentParams e = noEquipment();
+    e.boilerInput = 20000.0f;
+    e.emitterUA = 700.0f;
+    e.loopLossUA = 30.0f;
+    return e;
+}
+
+static void configureFurnace1Stage() { thermostatMode = "heat"; }
+
+static void configureFurnace2Stage()
+{
+    thermostatMode = "heat";
+    stage2HeatingEnabled = true;
+}
+
+static void configureHeatPumpBackup()
+{
+    thermostatMode = "heat";
+    reversingValveEnabled = true;
+    backupHeatEnabled = true;
+    backupHeatRelaySelection = 0; // PUMP relay drives the strips
+}
+
+static void configureAC2Stage()
+{
+    thermostatMode = "cool";
+    stage2CoolingEnabled = true;
+}
+
+static void configureAuto()
+{
+    thermostatMode = "auto";
+    stage2HeatingEnabled = true;
+}
+
+static void configureEUDehumidify()
+{
+    thermostatMode = "cool";
+    thermostatRegion = "EU";
+    euHumidityControlEnabled = true;
+    euHumidityRelaySelection = 2; // PUMP relay drives a standalone dehumidifier
+}
+
+static void configureHydronic()
+{
+    thermostatMode = "heat";
+    hydronicHeatingEnabled = true;
+    ds18b20SensorPresent = true;
+}
+
+static void configureScheduledSetback()
+{
+    thermostatMode = "heat";
+    stage2HeatingEnabled = true;
+    scheduleEnabled = true;
+}
+
+struct SimScenario {
+    const char* name;
+    const char* description;
+    const BuildingParams* building;
+    EquipmentParams (*equipment)();
+    void (*configure)();
+};
+
+static const SimScenario scenarios[] = {
+    { "furnace-1stage",  "40k single-stage furnace, cold climate",               &coldClimate,     singleStageFurnace,  configureFurnace1Stage },
+    { "furnace-2stage",  "20k+20k two-stage furnace, cold climate",              &coldClimate,     twoStageFurnace,     configureFurnace2Stage },
+    { "heatpump-backup", "30k heat pump + 30k strips on PUMP relay",             &coldClimate,     heatPumpWithStrips,  configureHeatPumpBackup },
+    { "ac-2stage",       "18k+12k two-stage AC, hot/humid climate",              &hotHumidClimate, twoStageAC,          configureAC2Stage },
+    { "auto-mixed",      "2-stage furnace + AC in auto mode, mixed climate",     &mixedClimate,    furnaceAndAC,        configureAuto },
+    { "eu-dehumidify",   "AC + dehumidifier on PUMP relay (EU humidity control)",&hotHumidClimate, twoStageAC,          configureEUDehumidify },
+    { "hydronic-boiler", "20k boiler (undersized) on a 700 BTU/h·°F emitter loop",&coldClimate,     undersizedBoiler,    configureHydronic },
+    { "setback-2stage",  "2-stage furnace with the default 72/68 schedule",      &coldClimate,     twoStageFurnace,     configureScheduledSetback },
+};
+
+// =============================================================================
+// OPTIONS
+// =============================================================================
+struct SimOptions {
+    int days = 365;
+    int controlPeriod = SENSOR_PERIOD_S;
+    const char* scenario = nullptr;
+    float swing = NAN;
+    float autoSwing = NAN;
+    long stage1Min = -1;
+    float stage2Delta = NAN;
+};
+
+static void applyOverrides(const SimOptions& opt)
+{
+    if (!isnan(opt.swing)) tempSwing = opt.swing;
+    if (!isnan(opt.autoSwing)) autoTempSwing = opt.autoSwing;
+    if (opt.stage1Min >= 0) stage1MinRuntime = (unsigned long)opt.stage1Min;
+    if (!isnan(opt.stage2Delta)) stage2TempDelta = opt.stage2Delta;
+}
+
+// =============================================================================
+// STATISTICS
+// =============================================================================
+struct SimStats {
+    double seconds = 0;
+    unsigned long primaryStarts = 0;   // Stage-1 heat or cool relay energised
+    unsigned long maxStartsInHour = 0;
+    unsigned long activeHours = 0;     // Hours with any stage-1 runtime
+    double heatSeconds = 0;
+    double coolSeconds = 0;
+    double stage2Seconds = 0;
+    unsigned long stage2Starts = 0;
+    unsigned long backupTrips = 0;
+    double backupSeconds = 0;
+    double fanSeconds = 0;
+    double dehumidifySeconds = 0;
+    double belowBandSeconds = 0;
+    double aboveBandSeconds = 0;
+    float worstExcursion = 0;
+    unsigned long lockoutEvents = 0;
+    double lockoutSeconds = 0;
+    float minSupplyTemp = 1000.0f;
+    double humidityAboveSetpointSeconds = 0;
+    double humiditySum = 0;
+    unsigned long sampledEdges = 0;    // Relay transitions visible between control cycles
+    unsigned long rawEdges = 0;        // All relay transitions, including glitches within a cycle
+};
+
+static const int relayPins[] = {
+    HEAT_RELAY_1_PIN, HEAT_RELAY_2_PIN, COOL_RELAY_1_PIN, COOL_RELAY_2_PIN, FAN_RELAY_PIN, PUMP_RELAY_PIN
+};
+static const int RELAY_COUNT = sizeof(relayPins) / sizeof(relayPins[0]);
+
+// Band the occupant cares about for the active mode, using the live setpoints
+// (a schedule change legitimately counts as "outside" until recovered)
+static const long OVERSHOOT_WINDOW_S = 1800; // Overshoot counts only this long after the equipment ran
+
+static bool swingBand(float& low, float& high)
+{
+    if (thermostatMode == "heat") {
+        low = setTempHeat - tempSwing;
+        high = setTempHeat + tempSwing;
+    } else if (thermostatMode == "cool") {
+        low = setTempCool - tempSwing;
+        high = setTempCool + tempSwing;
+    } else if (thermostatMode == "auto") {
+        low = setTempAuto - autoTempSwing;
+        high = setTempAuto + autoTempSwing;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static float initialRoomTemp()
+{
+    if (thermostatMode == "cool") return setTempCool;
+    if (thermostatMode == "auto") return setTempAuto;
+    return setTempHeat;
+}
+
+// Deterministic noise so runs are reproducible
+static uint32_t noiseState = 1;
+static float sensorNoise()
+{
+    noiseState ^= noiseState << 13;
+    noiseState ^= noiseState >> 17;
+    noiseState ^= noiseState << 5;
+    return ((noiseState & 0xffff) / 32767.5f - 1.0f) * SENSOR_NOISE;
+}
+
+// =============================================================================
+// SIMULATION
+// =============================================================================
+static SimStats runScenario(const SimScenario& sc, const SimOptions& opt)
+{
+    nativeResetControlState();
+    nativeClockSet(0);
+    nativePinsReset();
+    nativeLogResetCounters();
+    noiseState = 1;
+    sc.configure();
+    applyOverrides(opt);
+
+    PlantModel plant(*sc.building, sc.equipment());
+    plant.reset(initialRoomTemp(), sc.building->humidityMean);
+    currentTemp = plant.state().roomTemp;
+    currentHumidity = plant.state().humidity;
+    hydronicTemp = plant.state().supplyTemp;
+
+    SimStats stats;
+    uint8_t prevPin[RELAY_COUNT] = {0};
+    PlantOutputs out = plant.readOutputs();
+    bool prevBackupActive = false;
+    bool prevLockout = false;
+    unsigned long startsThisHour = 0;
+    bool runThisHour = false;
+    long lastHeatRun = -OVERSHOOT_WINDOW_S - 1;
+    long lastCoolRun = -OVERSHOOT_WINDOW_S - 1;
+
+    const long totalSeconds = (long)opt.days * 86400L;
+    for (long t = 1; t <= totalSeconds; t++) {
+        nativeClockAdvance(1000);
+        plant.step(1.0f, (double)t, out);
+        const PlantState& ps = plant.state();
+
+        if (t % SENSOR_PERIOD_S == 0) {
+            currentTemp = TEMP_EMA_ALPHA * (ps.roomTemp + sensorNoise()) + (1.0f - TEMP_EMA_ALPHA) * currentTemp;
+            currentHumidity = HUMIDITY_EMA_ALPHA * (ps.humidity + sensorNoise()) + (1.0f - HUMIDITY_EMA_ALPHA) * currentHumidity;
+            hydronicTemp = ps.supplyTemp;
+        }
+        if (t % opt.controlPeriod == 0) {
+            controlRelays(currentTemp);
+        }
+        if (t % 30 == 0) {
+            controlFanSchedule();
+        }
+        if (scheduleEnabled && t % 60 == 0) {
+            struct tm calendar;
+            memset(&calendar, 0, sizeof(calendar));
+            calendar.tm_yday = (int)((t / 86400L) % 365);
+            calendar.tm_wday = (int)((t / 86400L) % 7);
+            calendar.tm_hour = (int)((t / 3600L) % 24);
+            calendar.tm_min = (int)((t / 60L) % 60);
+            checkScheduleAt(calendar);
+        }
+
+        PlantOutputs next = plant.readOutputs();
+        if ((next.heat1 && !out.heat1) || (next.cool1 && !out.cool1)) {
+            stats.primaryStarts++;
+            startsThisHour++;
+        }
+        if ((next.heat2 && !out.heat2) || (next.cool2 && !out.cool2)) stats.stage2Starts++;
+        out = next;
+
+        for (int i = 0; i < RELAY_COUNT; i++) {
+            uint8_t level = (uint8_t)nativePinState(relayPins[i]);
+            if (level != prevPin[i]) stats.sampledEdges++;
+            prevPin[i] = level;
+        }
+
+        if (out.heat1 || out.backup) lastHeatRun = t;
+        if (out.cool1 || out.dehumidifier) lastCoolRun = t;
+        if (out.heat1) stats.heatSeconds++;
+        if (out.cool1) stats.coolSeconds++;
+        if (out.heat1 || out.cool1) runThisHour = true;
+        if (out.heat2 || out.cool2) stats.stage2Seconds++;
+        if (out.backup) stats.backupSeconds++;
+        if (out.fan) stats.fanSeconds++;
+        if (out.dehumidifier) stats.dehumidifySeconds++;
+        if (backupHeatActive && !prevBackupActive) stats.backupTrips++;
+        prevBackupActive = backupHeatActive;
+        if (hydronicLockout) {
+            stats.lockoutSeconds++;
+            if (!prevLockout) stats.lockoutEvents++;
+        }
+        prevLockout = hydronicLockout;
+        if (hydronicHeatingEnabled && ps.supplyTemp < stats.minSupplyTemp) stats.minSupplyTemp = ps.supplyTemp;
+
+        // A heat-only system can't be blamed for a warm summer day (nor cool-only
+        // for a cold one), so excursions on the uncontrolled side only count as
+        // overshoot shortly after the equipment ran
+        float low, high;
+        if (swingBand(low, high)) {
+            bool countBelow = thermostatMode != "cool" || (t - lastCoolRun) <= OVERSHOOT_WINDOW_S;
+            bool countAbove = thermostatMode != "heat" || (t - lastHeatRun) <= OVERSHOOT_WINDOW_S;
+            float excursion = 0.0f;
+            if (ps.roomTemp < low && countBelow) {
+                excursion = low - ps.roomTemp;
+                stats.belowBandSeconds++;
+            } else if (ps.roomTemp > high && countAbove) {
+                excursion = ps.roomTemp - high;
+                stats.aboveBandSeconds++;
+            }
+            if (excursion > stats.worstExcursion) stats.worstExcursion = excursion;
+        }
+        stats.humiditySum += ps.humidity;
+        if (euHumidityControlEnabled && ps.humidity > euHumiditySetpoint) stats.humidityAboveSetpointSeconds++;
+
+        if (t % 3600 == 0) {
+            if (startsThisHour > stats.maxStartsInHour) stats.maxStartsInHour = startsThisHour;
+            if (runThisHour) stats.activeHours++;
+            startsThisHour = 0;
+            runThisHour = false;
+        }
+    }
+
+    stats.seconds = (double)totalSeconds;
+    for (int i = 0; i < RELAY_COUNT; i++) {
+        stats.rawEdges += nativePinEdgeCount(relayPins[i]);
+    }
+    return stats;
+}
+
+static void printStats(const SimScenario& sc, const SimStats& s, double wallSeconds)
+{
+    double hours = s.seconds / 3600.0;
+    double primaryHours = (s.heatSeconds + s.coolSeconds) / 3600.0;
+
+    printf("\n[%s] %s\n", sc.name, sc.description);
+    printf("  simulated %.0f days in %.2f s wall (%.0fx)\n", s.seconds / 86400.0, wallSeconds, s.seconds / wallSeconds);
+    printf("  settings: swing=%.1f autoSwing=%.1f stage1MinRuntime=%lus stage2Delta=%.1f\n",
+           tempSwing, autoTempSwing, stage1MinRuntime, stage2TempDelta);
+    printf("  relay cycles: %.2f starts/h while running (%lu starts over %lu h), worst hour %lu\n",
+           s.activeHours ? (double)s.primaryStarts / s.activeHours : 0.0, s.primaryStarts, s.activeHours, s.maxStartsInHour);
+    printf("  stage 2: %lu starts, %.1f%% of stage-1 runtime\n",
+           s.stage2Starts, primaryHours > 0 ? 100.0 * s.stage2Seconds / (s.heatSeconds + s.coolSeconds) : 0.0);
+    printf("  backup heat: %lu trips, %.1f h\n", s.backupTrips, s.backupSeconds / 3600.0);
+    printf("  outside swing band: %.2f%% below, %.2f%% above, worst %.1f F\n",
+           100.0 * s.belowBandSeconds / s.seconds, 100.0 * s.aboveBandSeconds / s.seconds, s.worstExcursion);
+    printf("  runtime: heat %.0f h, cool %.0f h, fan relay %.0f h, dehumidifier %.0f h\n",
+           s.heatSeconds / 3600.0, s.coolSeconds / 3600.0, s.fanSeconds / 3600.0, s.dehumidifySeconds / 3600.0);
+    printf("  mean humidity %.1f%%", s.humiditySum / s.seconds);
+    if (euHumidityControlEnabled) {
+        printf(", above %.0f%% setpoint %.1f%% of time", euHumiditySetpoint, 100.0 * s.humidityAboveSetpointSeconds / s.seconds);
+    }
+    printf("\n");
+    if (hydronicHeatingEnabled) {
+        printf("  hydronic: %lu lockouts, %.1f h locked out, min supply %.1f F\n",
+               s.lockoutEvents, s.lockoutSeconds / 3600.0, s.minSupplyTemp);
+    }
+    printf("  relay edges: %.2f/h between cycles, %.2f/h including in-cycle glitches\n",
+           s.sampledEdges / hours, s.rawEdges / hours);
+}
+
+static void usage()
+{
+    printf("usage: program [--days N] [--scenario NAME] [--swing F] [--auto-swing F]\n"
+           "               [--stage1-min S] [--stage2-delta F] [--control-period S]\n"
+           "               [--log-level L] [--list] [-v]\n");
+}
+
+int main(int argc, char** argv)
+{
+    SimOptions opt;
+    bool echo = false;
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* val = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (strcmp(arg, "--list") == 0) {
+            for (size_t s = 0; s < sizeof(scenarios) / sizeof(scenarios[0]); s++) {
+                printf("%-16s %s\n", scenarios[s].name, scenarios[s].description);
+            }
+            return 0;
+        } else if (strcmp(arg, "-v") == 0) {
+            echo = true;
+        } else if (val == nullptr) {
+            usage();
+            return 1;
+        } else if (strcmp(arg, "--days") == 0) {
+            opt.days = atoi(val); i++;
+        } else if (strcmp(arg, "--scenario") == 0) {
+            opt.scenario = val; i++;
+        } else if (strcmp(arg, "--swing") == 0) {
+            opt.swing = (float)atof(val); i++;
+        } else if (strcmp(arg, "--auto-swing") == 0) {
+            opt.autoSwing = (float)atof(val); i++;
+        } else if (strcmp(arg, "--stage1-min") == 0) {
+            opt.stage1Min = atol(val); i++;
+        } else if (strcmp(arg, "--stage2-delta") == 0) {
+            opt.stage2Delta = (float)atof(val); i++;
+        } else if (strcmp(arg, "--control-period") == 0) {
+            opt.controlPeriod = atoi(val); i++;
+        } else if (strcmp(arg, "--log-level") == 0) {
+            int level = logLevelFromName(val); i++;
+            if (level < 0) {
+                usage();
+                return 1;
+            }
+            setAllLogLevels((uint8_t)level);
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (opt.days <= 0 || opt.controlPeriod <= 0) {
+        usage();
+        return 1;
+    }
+
+    nativeLogEcho(echo);
+    nativeLogFormat(false);
+    controlRelaysMutex = xSemaphoreCreateMutex();
+
+    bool ran = false;
+    for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+        if (opt.scenario != nullptr && strcmp(opt.scenario, scenarios[i].name) != 0) continue;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        SimStats stats = runScenario(scenarios[i], opt);
+        double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        printStats(scenarios[i], stats, wall);
+        ran = true;
+    }
+    if (!ran) {
+        printf("Unknown scenario '%s' (see --list)\n", opt.scenario);
+        return 1;
+    }
+    return 0;
+}
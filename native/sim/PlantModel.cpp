@@ -0,0 +1,124 @@
+/*
+ * PlantModel.cpp - Lumped thermal/humidity model of a house and its equipment
+ */
+
+#include "PlantModel.h"
+#include <math.h>
+#include "HvacControl.h"
+#include "NativeHal.h"
+
+static const double SECONDS_PER_DAY = 86400.0;
+static const double DAYS_PER_YEAR = 365.0;
+static const float HEAT_PUMP_RATING_TEMP = 47.0f; // AHRI high-temperature heating rating point
+
+PlantModel::PlantModel(const BuildingParams& building, const EquipmentParams& equipment)
+    : building_(building), equipment_(equipment)
+{
+    reset(70.0f, building.humidityMean);
+}
+
+void PlantModel::reset(float roomTemp, float humidity)
+{
+    state_.roomTemp = roomTemp;
+    state_.humidity = humidity;
+    state_.outdoorTemp = outdoorTempAt(0);
+    state_.supplyTemp = equipment_.boilerSetpoint;
+    state_.boilerFiring = false;
+}
+
+float PlantModel::outdoorTempAt(double simSeconds) const
+{
+    double day = simSeconds / SECONDS_PER_DAY;
+    double hour = fmod(simSeconds, SECONDS_PER_DAY) / 3600.0;
+    // Coldest around January 15th and 3am, warmest mid-July and 3pm
+    double annual = -cos(2.0 * M_PI * (day - 15.0) / DAYS_PER_YEAR);
+    double daily = cos(2.0 * M_PI * (hour - 15.0) / 24.0);
+    return (float)(building_.outdoorMean + building_.outdoorAnnualAmp * annual + building_.outdoorDailyAmp * daily);
+}
+
+PlantOutputs PlantModel::readOutputs() const
+{
+    PlantOutputs out;
+    bool h1 = nativePinState(HEAT_RELAY_1_PIN) == HIGH;
+    bool h2 = nativePinState(HEAT_RELAY_2_PIN) == HIGH;
+    bool c1 = nativePinState(COOL_RELAY_1_PIN) == HIGH;
+    bool c2 = nativePinState(COOL_RELAY_2_PIN) == HIGH;
+    bool pump = nativePinState(PUMP_RELAY_PIN) == HIGH;
+
+    out.heat1 = h1;
+    out.heat2 = h2 && !reversingValveEnabled; // With a heat pump H2 is the O/B valve, not capacity
+    out.cool1 = c1;
+    out.cool2 = c2;
+    out.backup = false;
+    out.dehumidifier = false;
+    out.fan = nativePinState(FAN_RELAY_PIN) == HIGH;
+
+    if (backupHeatEnabled) {
+        if (backupHeatRelaySelection == 1) {
+            out.backup = h2;
+            out.heat2 = false;
+        } else if (backupHeatRelaySelection == 2) {
+            out.backup = c2;
+            out.cool2 = false;
+        } else {
+            out.backup = pump;
+        }
+    } else if (euHumidityControlEnabled && euHumidityRelaySelection == 2) {
+        out.dehumidifier = pump;
+    }
+    return out;
+}
+
+void PlantModel::step(float dtSeconds, double simSeconds, const PlantOutputs& out)
+{
+    double day = simSeconds / SECONDS_PER_DAY;
+    double hour = fmod(simSeconds, SECONDS_PER_DAY) / 3600.0;
+    float hours = dtSeconds / 3600.0f;
+
+    state_.outdoorTemp = outdoorTempAt(simSeconds);
+    float room = state_.roomTemp;
+
+    float solar = 0.0f;
+    if (hour > 6.0 && hour < 18.0) {
+        solar = building_.solarGainPeak * (float)sin(M_PI * (hour - 6.0) / 12.0);
+    }
+
+    float heat = 0.0f;
+    if (hydronicHeatingEnabled) {
+        // Zone call draws heat from the loop; the boiler runs on its own aquastat
+        float zoneDraw = out.heat1 ? equipment_.emitterUA * fmaxf(0.0f, state_.supplyTemp - room) : 0.0f;
+        if (state_.supplyTemp < equipment_.boilerSetpoint - equipment_.boilerDifferential) {
+            state_.boilerFiring = true;
+        } else if (state_.supplyTemp >= equipment_.boilerSetpoint) {
+            state_.boilerFiring = false;
+        }
+        float loopQ = (state_.boilerFiring ? equipment_.boilerInput : 0.0f)
+                      - zoneDraw - equipment_.loopLossUA * (state_.supplyTemp - room);
+        state_.supplyTemp += loopQ * hours / equipment_.waterMass;
+        heat += zoneDraw;
+    } else {
+        float capacityFactor = 1.0f;
+        if (equipment_.heatPumpDerate > 0.0f && state_.outdoorTemp < HEAT_PUMP_RATING_TEMP) {
+            capacityFactor = fmaxf(0.1f, 1.0f - equipment_.heatPumpDerate * (HEAT_PUMP_RATING_TEMP - state_.outdoorTemp));
+        }
+        if (out.heat1) heat += equipment_.heatStage1 * capacityFactor;
+        if (out.heat2) heat += equipment_.heatStage2 * capacityFactor;
+    }
+    if (out.backup) heat += equipment_.backupHeat;
+
+    float cool = 0.0f;
+    if (out.cool1) cool += equipment_.coolStage1;
+    if (out.cool2) cool += equipment_.coolStage2;
+
+    float q = building_.ua * (state_.outdoorTemp - room) + building_.internalGain + solar + heat - cool;
+    state_.roomTemp = room + q * hours / building_.thermalMass;
+
+    // Humidity: relax toward a seasonal equilibrium, add occupant moisture,
+    // remove it with running cooling stages or a dehumidifier
+    float summer = (float)(0.5 * (1.0 - cos(2.0 * M_PI * (day - 15.0) / DAYS_PER_YEAR)));
+    float equilibrium = building_.humidityMean + building_.humiditySeasonAmp * summer;
+    float drying = (out.cool1 ? equipment_.coolDryRate : 0.0f) + (out.cool2 ? equipment_.coolDryRate : 0.0f)
+                   + (out.dehumidifier ? equipment_.dehumidifierRate : 0.0f);
+    float dRh = (equilibrium - state_.humidity) / building_.humidityTau + building_.humidityGain - drying;
+    state_.humidity = constrain(state_.humidity + dRh * hours, 5.0f, 99.0f);
+}
@@ -0,0 +1,89 @@
+/*
+ * PlantModel.h - Lumped thermal/humidity model of a house and its equipment
+ *
+ * One air/structure node (thermal mass + UA loss to outdoors), seasonal and
+ * diurnal outdoor temperature, internal and solar gains, staged heating and
+ * cooling capacity, an optional boiler loop for hydronic systems and a
+ * simple relative-humidity balance. Units are °F, BTU and BTU/h to match the
+ * firmware's default Fahrenheit setpoints.
+ *
+ * The model reads relay outputs straight from the native GPIO table, so it
+ * sees exactly what the real control code wrote.
+ */
+
+#ifndef PLANT_MODEL_H
+#define PLANT_MODEL_H
+
+struct BuildingParams {
+    float thermalMass;        // BTU/°F of air + furnishings that the thermostat "sees"
+    float ua;                 // BTU/h·°F envelope + infiltration loss
+    float internalGain;       // BTU/h from occupants/appliances
+    float solarGainPeak;      // BTU/h at solar noon
+    float outdoorMean;        // °F annual mean
+    float outdoorAnnualAmp;   // °F half-swing between January and July
+    float outdoorDailyAmp;    // °F half-swing between 5am and 3pm
+    float humidityMean;       // %RH indoor equilibrium without gains
+    float humiditySeasonAmp;  // %RH added at the height of summer
+    float humidityGain;       // %RH/h from occupants, cooking, showers
+    float humidityTau;        // h for infiltration to pull RH back to equilibrium
+};
+
+struct EquipmentParams {
+    float heatStage1;         // BTU/h (furnace low fire, heat pump compressor, hydronic zone unused)
+    float heatStage2;         // BTU/h added by stage 2
+    float heatPumpDerate;     // Capacity loss per °F below 47°F outdoor (0 = combustion furnace)
+    float backupHeat;         // BTU/h of backup/auxiliary heat
+    float coolStage1;         // BTU/h sensible
+    float coolStage2;         // BTU/h sensible added by stage 2
+    float coolDryRate;        // %RH/h removed per running cooling stage
+    float dehumidifierRate;   // %RH/h removed by a standalone dehumidifier (EU relay on PUMP)
+    // Hydronic loop (used when hydronicHeatingEnabled is set)
+    float boilerInput;        // BTU/h
+    float boilerSetpoint;     // °F aquastat high limit
+    float boilerDifferential; // °F below setpoint before the boiler refires
+    float waterMass;          // BTU/°F of water + iron in the loop
+    float emitterUA;          // BTU/h·°F from water to room when the zone is calling
+    float loopLossUA;         // BTU/h·°F standby loss from the loop
+};
+
+struct PlantState {
+    float roomTemp;           // °F true room temperature
+    float humidity;           // %RH true room humidity
+    float outdoorTemp;        // °F
+    float supplyTemp;         // °F boiler loop (hydronic only)
+    bool boilerFiring;
+};
+
+struct PlantOutputs {
+    bool heat1;               // Stage 1 heat / compressor in heat / hydronic zone call
+    bool heat2;               // Stage 2 heat
+    bool cool1;
+    bool cool2;
+    bool backup;
+    bool dehumidifier;
+    bool fan;
+};
+
+class PlantModel {
+public:
+    PlantModel(const BuildingParams& building, const EquipmentParams& equipment);
+
+    void reset(float roomTemp, float humidity);
+
+    // Decode relay pins according to the firmware's current relay assignments
+    // (backup heat / EU humidity relay selection, reversing valve).
+    PlantOutputs readOutputs() const;
+
+    // Advance the plant by dtSeconds at the given time of year.
+    void step(float dtSeconds, double simSeconds, const PlantOutputs& out);
+
+    const PlantState& state() const { return state_; }
+    float outdoorTempAt(double simSeconds) const;
+
+private:
+    BuildingParams building_;
+    EquipmentParams equipment_;
+    PlantState state_;
+};
+
+#endif // PLANT_MODEL_H
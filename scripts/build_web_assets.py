@@ -0,0 +1,89 @@
+# build_web_assets.py - gzip web/ assets into include/WebAssets.h
+#
+# PlatformIO pre-build script (extra_scripts in platformio.ini); also runs
+# stand-alone: python3 scripts/build_web_assets.py
+#
+# Each asset is compressed once here instead of per request on the device,
+# and named after a hash of its content, so browsers can cache it forever
+# (Cache-Control: immutable) and an edit gets a new URL. {{PREFIX_PATH}} in a
+# later asset is replaced by that URL, which is how index.html (the page
+# shell, served at /) links the current CSS and JS. Output is
+# deterministic (gzip mtime 0) and the header is only rewritten when it
+# changes, so unchanged assets cause no rebuild.
+
+import gzip
+import hashlib
+import os
+
+ASSETS = [
+    # (source in web/, C identifier prefix, MIME type)
+    ("app.css", "WEB_APP_CSS", "text/css"),
+    ("app.js", "WEB_APP_JS", "application/javascript"),
+    ("index.html", "WEB_INDEX", "text/html"),  # Last: links the ones above
+]
+
+HEADER = """/*
+ * WebAssets.h - Gzipped web assets (generated, do not edit)
+ *
+ * Generated by scripts/build_web_assets.py from web/ before each build.
+ * Edit the files in web/ instead.
+ */
+
+#ifndef WEB_ASSETS_H
+#define WEB_ASSETS_H
+
+#include <Arduino.h>
+
+"""
+
+
+def project_dir():
+    try:
+        Import("env")  # noqa: F821 - defined by PlatformIO/SCons
+        return env.subst("$PROJECT_DIR")  # noqa: F821
+    except NameError:
+        return os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+
+def render_asset(name, prefix, mime, data, paths):
+    for key, path in paths.items():
+        data = data.replace(("{{%s}}" % key).encode(), path.encode())
+    digest = hashlib.sha256(data).hexdigest()
+    packed = gzip.compress(data, compresslevel=9, mtime=0)
+    base, ext = os.path.splitext(name)
+    path = "/assets/%s.%s%s" % (base, digest[:8], ext)
+    paths[prefix + "_PATH"] = path
+    out = []
+    out.append("// web/%s: %d bytes, %d gzipped\n" % (name, len(data), len(packed)))
+    out.append('#define %s_PATH "%s"\n' % (prefix, path))
+    out.append('#define %s_ETAG "\\"%s\\""\n' % (prefix, digest[:16]))
+    out.append('#define %s_TYPE "%s"\n' % (prefix, mime))
+    out.append("const size_t %s_GZ_LEN = %d;\n" % (prefix, len(packed)))
+    out.append("const uint8_t %s_GZ[] PROGMEM = {\n" % prefix)
+    for i in range(0, len(packed), 16):
+        out.append("    " + ", ".join("0x%02x" % b for b in packed[i:i + 16]) + ",\n")
+    out.append("};\n\n")
+    return "".join(out), len(data), len(packed)
+
+
+def build(root):
+    text = HEADER
+    paths = {}
+    for name, prefix, mime in ASSETS:
+        with open(os.path.join(root, "web", name), "rb") as f:
+            data = f.read()
+        block, raw, packed = render_asset(name, prefix, mime, data, paths)
+        text += block
+        print("Web asset %s: %d -> %d bytes gzipped" % (name, raw, packed))
+    text += "#endif // WEB_ASSETS_H\n"
+
+    target = os.path.join(root, "include", "WebAssets.h")
+    if os.path.exists(target):
+        with open(target) as f:
+            if f.read() == text:
+                return
+    with open(target, "w") as f:
+        f.write(text)
+
+
+build(project_dir())
@@ -0,0 +1,202 @@
+/*
+ * ConfigBlob.cpp - Settings and schedule as one versioned, checksummed NVS blob
+ *
+ * One static record is used for loading, saving and reading back, so a save
+ * costs no heap and little stack. Saves whose payload CRC matches the stored
+ * one are skipped without touching flash.
+ */
+
+#include "ConfigBlob.h"
+#include <stddef.h>
+#include <string.h>
+#include "Log.h"
+#include "NvsWear.h"
+
+static const uint32_t CONFIG_BLOB_MAGIC = 0x47464354; // "TCFG"
+static const char* const SLOT_KEYS[2] = { "cfgA", "cfgB" };
+
+struct ConfigHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t length;         // Payload bytes
+    uint32_t generation;
+    uint32_t crc;            // Header fields above, then payload
+};
+
+// Room for a longer blob from newer firmware (after a downgrade)
+static const size_t MAX_PAYLOAD = sizeof(ConfigData) + 512;
+
+static struct {
+    ConfigHeader header;
+    uint8_t payload[MAX_PAYLOAD];
+} record;
+
+static_assert(sizeof(ConfigHeader) == 16, "header layout is stored in NVS");
+static_assert(sizeof(ConfigData) == 1424, "stored layout changed: append only, see ConfigBlob.h");
+
+static int newestSlot = -1;
+static bool readOnly = false;      // Stored blob from newer firmware: never overwrite it
+static uint32_t newestGeneration = 0;
+static uint32_t newestPayloadCrc = 0;
+
+static ConfigBlobStats stats;
+
+static uint32_t crc32(uint32_t crc, const void* data, size_t length)
+{
+    static const uint32_t NIBBLE[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
+    const uint8_t* p = (const uint8_t*)data;
+    crc = ~crc;
+    while (length--) {
+        crc ^= *p++;
+        crc = (crc >> 4) ^ NIBBLE[crc & 15];
+        crc = (crc >> 4) ^ NIBBLE[crc & 15];
+    }
+    return ~crc;
+}
+
+static uint32_t recordCrc(const ConfigHeader& header, const void* payload)
+{
+    uint32_t crc = crc32(0, &header, offsetof(ConfigHeader, crc));
+    return crc32(crc, payload, header.length);
+}
+
+enum SlotState { SLOT_EMPTY, SLOT_VALID, SLOT_CORRUPT, SLOT_UNKNOWN_VERSION };
+
+// Read a slot into `record` and say whether this firmware can use it
+static SlotState readSlot(Preferences& prefs, int slot)
+{
+    const char* key = SLOT_KEYS[slot];
+    size_t length = prefs.isKey(key) ? prefs.getBytesLength(key) : 0;
+    if (length == 0) return SLOT_EMPTY;
+    if (length < sizeof(ConfigHeader) || length > sizeof(record) ||
+        prefs.getBytes(key, &record, length) != length) {
+        LOG_WARN(SETTINGS, "Config slot %c: unreadable (%u bytes)\n", 'A' + slot, (unsigned)length);
+        return SLOT_CORRUPT;
+    }
+    const ConfigHeader& h = record.header;
+    if (h.magic != CONFIG_BLOB_MAGIC || sizeof(ConfigHeader) + h.length != length ||
+        recordCrc(h, record.payload) != h.crc) {
+        LOG_WARN(SETTINGS, "Config slot %c: bad header or CRC (version %u, length %u)\n",
+                 'A' + slot, (unsigned)h.version, (unsigned)h.length);
+        return SLOT_CORRUPT;
+    }
+    if (h.version != CONFIG_BLOB_VERSION) {
+        LOG_ERROR(SETTINGS, "Config slot %c: layout version %u, this firmware reads %u\n",
+                  'A' + slot, (unsigned)h.version, (unsigned)CONFIG_BLOB_VERSION);
+        return SLOT_UNKNOWN_VERSION;
+    }
+    return SLOT_VALID;
+}
+
+ConfigBlobLoadResult configBlobLoad(Preferences& prefs, ConfigData& data)
+{
+    uint32_t start = micros();
+    newestSlot = -1;
+    bool present = false;
+    bool unknownVersion = false;
+    for (int slot = 0; slot < 2; slot++) {
+        SlotState state = readSlot(prefs, slot);
+        if (state != SLOT_EMPTY) present = true;
+        if (state == SLOT_UNKNOWN_VERSION) unknownVersion = true;
+        if (state != SLOT_VALID) continue;
+        if (newestSlot >= 0 && (int32_t)(record.header.generation - newestGeneration) <= 0) continue;
+        // Same version, so the layout only grew at the end: a shorter blob
+        // (older firmware) leaves the later fields at their defaults, and
+        // fields a longer one (newer firmware) appended are dropped
+        size_t length = record.header.length < sizeof(data) ? record.header.length : sizeof(data);
+        memcpy(&data, record.payload, length);
+        newestSlot = slot;
+        newestGeneration = record.header.generation;
+        newestPayloadCrc = crc32(0, record.payload, record.header.length);
+    }
+    stats.loadUs = micros() - start;
+    stats.generation = newestGeneration;
+    stats.slot = newestSlot >= 0 ? 'A' + newestSlot : '-';
+    stats.bytes = sizeof(ConfigHeader) + sizeof(ConfigData);
+
+    // A layout this firmware doesn't know may be the newest one even when
+    // the other slot is readable, so neither is trusted or overwritten
+    if (unknownVersion) {
+        newestSlot = -1;
+        readOnly = true;
+        stats.readOnly = true;
+        LOG_ERROR(SETTINGS, "Config blob from newer firmware, running on defaults; it is kept until a factory reset\n");
+        return CONFIG_BLOB_UNKNOWN_VERSION;
+    }
+    if (present && newestSlot < 0) {
+        LOG_ERROR(SETTINGS, "Config blob corrupt in every slot, running on defaults\n");
+        return CONFIG_BLOB_CORRUPT;
+    }
+    if (newestSlot < 0) return CONFIG_BLOB_ABSENT;
+    LOG_INFO(SETTINGS, "Config loaded from slot %c, generation %lu, in %luus\n",
+             stats.slot, (unsigned long)newestGeneration, (unsigned long)stats.loadUs);
+    return CONFIG_BLOB_LOADED;
+}
+
+bool configBlobReadOnly()
+{
+    return readOnly;
+}
+
+void configBlobAllowOverwrite()
+{
+    if (readOnly) LOG_WARN(SETTINGS, "Config blob: the newer firmware's blob will be replaced\n");
+    readOnly = false;
+    stats.readOnly = false;
+}
+
+bool configBlobSave(Preferences& prefs, const ConfigData& data)
+{
+    if (readOnly) {
+        LOG_ERROR(SETTINGS, "Config not saved: the stored blob is from newer firmware and kept until a factory reset\n");
+        return false;
+    }
+    uint32_t start = millis();
+    uint32_t payloadCrc = crc32(0, &data, sizeof(data));
+    if (newestSlot >= 0 && payloadCrc == newestPayloadCrc) {
+        stats.unchanged++;
+        return true;
+    }
+
+    int slot = newestSlot == 0 ? 1 : 0;
+    ConfigHeader& h = record.header;
+    h.magic = CONFIG_BLOB_MAGIC;
+    h.version = CONFIG_BLOB_VERSION;
+    h.length = sizeof(data);
+    h.generation = newestSlot >= 0 ? newestGeneration + 1 : 1;
+    memcpy(record.payload, &data, sizeof(data));
+    h.crc = recordCrc(h, record.payload);
+    uint32_t generation = h.generation;
+    size_t length = sizeof(ConfigHeader) + sizeof(data);
+
+    // Read back: a slot that does not verify must not become the newest
+    bool ok = prefs.putBytes(SLOT_KEYS[slot], &record, length) == length;
+    if (ok) nvsWearRecord(SLOT_KEYS[slot], NVS_TYPE_BLOB, length);
+    ok = ok && readSlot(prefs, slot) == SLOT_VALID && record.header.generation == generation;
+    uint32_t elapsed = millis() - start;
+    if (elapsed > stats.saveMsMax) stats.saveMsMax = elapsed;
+    if (!ok) {
+        stats.failures++;
+        LOG_ERROR(SETTINGS, "Config save to slot %c failed, keeping generation %lu\n",
+                  'A' + slot, (unsigned long)newestGeneration);
+        return false;
+    }
+    newestSlot = slot;
+    newestGeneration = generation;
+    newestPayloadCrc = payloadCrc;
+    stats.saves++;
+    stats.generation = generation;
+    stats.slot = 'A' + slot;
+    LOG_DEBUG(SETTINGS, "Config generation %lu written to slot %c in %lums\n",
+              (unsigned long)generation, stats.slot, (unsigned long)elapsed);
+    return true;
+}
+
+void configBlobGetStats(ConfigBlobStats& out)
+{
+    out = stats;
+    if (out.slot == 0) out.slot = '-';
+}
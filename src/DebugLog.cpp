@@ -0,0 +1,659 @@
+/*
+ * DebugLog.cpp - Lock-free multi-producer debug log ring
+ *
+ * Record layout (records start on 4-byte boundaries, payload may wrap):
+ *   word 0  payload length (bits 0-15) | lap tag (16-23) | state (24-31)
+ *   word 1  logical position of the record, used to resync after a torn read
+ *   payload bytes, padded to a multiple of 4
+ *
+ * State is WRITING while the payload is copied, then TEXT (payload is the
+ * formatted line) or BINARY (deferred formatting):
+ *   uint32 millis() | const char* format | raw arguments in format order
+ * Integers/doubles/pointers are stored at their native size, %s arguments as
+ * a length byte plus up to DEBUG_ARG_STRING_MAX characters (the pointer may
+ * not outlive the call). The format string is only dereferenced again when
+ * the record is read, so it must be a literal.
+ *
+ * Positions are free-running 32-bit byte counters; ring offset = pos & mask
+ * and the lap tag is (pos / DEBUG_BUFFER_SIZE) & 0xFF, so a header left over
+ * from a previous lap never matches the record expected at that position.
+ *
+ * Writers:  push the tail past anything [pos, pos+size) would overwrite, then
+ *           claim it with a compare-and-swap on the reservation counter,
+ *           write the header as WRITING, copy the payload, then publish it
+ *           as TEXT/BINARY (release). The tail never moves past a record
+ *           that is still being written: a writer preempted for a whole lap
+ *           would otherwise copy its payload over newer records. If the
+ *           record at the tail is unfinished the writer spins, then yields,
+ *           a bounded number of times for it to be published; only then is
+ *           the new message dropped and counted.
+ * Readers:  walk from the tail, stop at the first uncommitted record, and
+ *           after copying a payload re-check the reservation counter; if a
+ *           writer has lapped the record it is dropped and the walk resumes
+ *           from the new tail. A DebugLogCursor holds one decoded record at a
+ *           time, so the web handlers can stream the log in chunks.
+ */
+
+#include "DebugLog.h"
+#include <atomic>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Log.h"
+
+static const uint32_t DEBUG_BUFFER_MASK = DEBUG_BUFFER_SIZE - 1;
+static const uint32_t RECORD_HEADER_SIZE = 8;
+// Waiting for an unfinished record at the tail: busy re-checks first (the
+// other writer is usually mid-memcpy on the other core), then yields so a
+// preempted writer of the same priority can finish
+static const int TAIL_WAIT_SPINS = 64;
+static const int TAIL_WAIT_YIELDS = 8;
+
+static const uint8_t RECORD_WRITING = 0x5A;
+static const uint8_t RECORD_TEXT = 0xC3;
+static const uint8_t RECORD_BINARY = 0xB1;
+
+static_assert((DEBUG_BUFFER_SIZE & DEBUG_BUFFER_MASK) == 0, "DEBUG_BUFFER_SIZE must be a power of two");
+static_assert(DEBUG_RECORD_MAX_PAYLOAD <= 0xFFFF, "payload length must fit the 16-bit header field");
+
+alignas(4) static uint8_t debugBuffer[DEBUG_BUFFER_SIZE];
+static std::atomic<uint32_t> debugReserve(0); // Next free byte (free-running)
+static std::atomic<uint32_t> debugTail(0);    // Oldest record that has not been overwritten
+static std::atomic<uint32_t> debugDropped(0); // Messages lost to an unfinished record at the tail
+
+static inline uint32_t* headerWord(uint32_t pos)
+{
+    return reinterpret_cast<uint32_t*>(&debugBuffer[pos & DEBUG_BUFFER_MASK]);
+}
+
+static inline uint32_t lapTag(uint32_t pos)
+{
+    return (pos / DEBUG_BUFFER_SIZE) & 0xFF;
+}
+
+static inline uint32_t makeHeader(uint32_t len, uint32_t pos, uint8_t state)
+{
+    return len | (lapTag(pos) << 16) | ((uint32_t)state << 24);
+}
+
+static inline uint32_t recordSize(uint32_t len)
+{
+    return (RECORD_HEADER_SIZE + len + 3) & ~3u;
+}
+
+// Difference of two free-running positions, valid across 2^32 wraparound
+static inline int32_t posDiff(uint32_t a, uint32_t b)
+{
+    return (int32_t)(a - b);
+}
+
+// Payload length of the committed record at pos, or -1 if there is none for
+// this lap (still being written, stale header from a previous lap, or never
+// written).
+static int32_t recordLengthAt(uint32_t pos, uint8_t* stateOut = nullptr)
+{
+    uint32_t w0 = __atomic_load_n(headerWord(pos), __ATOMIC_ACQUIRE);
+    uint32_t len = w0 & 0xFFFF;
+    uint8_t state = (uint8_t)(w0 >> 24);
+    if (((w0 >> 16) & 0xFF) != lapTag(pos) || len > DEBUG_RECORD_MAX_PAYLOAD) return -1;
+    if (state != RECORD_TEXT && state != RECORD_BINARY) return -1;
+    if (__atomic_load_n(headerWord(pos + 4), __ATOMIC_RELAXED) != pos) return -1;
+    if (stateOut != nullptr) *stateOut = state;
+    return (int32_t)len;
+}
+
+// Move the tail so nothing before `limit` is considered readable any more.
+// False if a record in the way is still being written (or reserved but
+// without a header yet); it can't be reclaimed until its writer finishes.
+static bool reclaimUpTo(uint32_t limit)
+{
+    uint32_t tail = debugTail.load(std::memory_order_acquire);
+    while (posDiff(limit, tail) > 0) {
+        int32_t len = recordLengthAt(tail);
+        if (len < 0) return false;
+        uint32_t next = tail + recordSize((uint32_t)len);
+        if (debugTail.compare_exchange_weak(tail, next, std::memory_order_acq_rel, std::memory_order_acquire)) {
+            tail = next;
+        }
+    }
+    return true;
+}
+
+static void copyIn(uint32_t pos, const char* src, uint32_t len)
+{
+    uint32_t off = pos & DEBUG_BUFFER_MASK;
+    uint32_t first = DEBUG_BUFFER_SIZE - off;
+    if (first >= len) {
+        memcpy(&debugBuffer[off], src, len);
+    } else {
+        memcpy(&debugBuffer[off], src, first);
+        memcpy(debugBuffer, src + first, len - first);
+    }
+}
+
+static void copyOut(uint32_t pos, char* dest, uint32_t len)
+{
+    uint32_t off = pos & DEBUG_BUFFER_MASK;
+    uint32_t first = DEBUG_BUFFER_SIZE - off;
+    if (first >= len) {
+        memcpy(dest, &debugBuffer[off], len);
+    } else {
+        memcpy(dest, &debugBuffer[off], first);
+        memcpy(dest + first, debugBuffer, len - first);
+    }
+}
+
+// Claim space for a payload of len bytes and mark it WRITING; the caller
+// copies the payload to pos + RECORD_HEADER_SIZE and then calls commitRecord().
+// False (message dropped) if the space stays held by an unfinished record.
+static bool reserveRecord(uint32_t len, uint32_t& pos)
+{
+    uint32_t size = recordSize(len);
+    int waits = 0;
+    // Same S32C1I compare-and-swap loop a fetch_add compiles to on the
+    // ESP32-S3, with the reclaim done before the space is claimed
+    pos = debugReserve.load(std::memory_order_acquire);
+    do {
+        while (!reclaimUpTo(pos + size - DEBUG_BUFFER_SIZE)) {
+            if (waits >= TAIL_WAIT_SPINS + TAIL_WAIT_YIELDS || (waits >= TAIL_WAIT_SPINS && xPortInIsrContext())) {
+                debugDropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            if (waits++ >= TAIL_WAIT_SPINS) taskYIELD();
+            pos = debugReserve.load(std::memory_order_acquire);
+        }
+    } while (!debugReserve.compare_exchange_weak(pos, pos + size, std::memory_order_acq_rel, std::memory_order_acquire));
+
+    __atomic_store_n(headerWord(pos + 4), pos, __ATOMIC_RELAXED);
+    __atomic_store_n(headerWord(pos), makeHeader(len, pos, RECORD_WRITING), __ATOMIC_RELEASE);
+    return true;
+}
+
+static void commitRecord(uint32_t pos, uint32_t len, uint8_t state)
+{
+    __atomic_store_n(headerWord(pos), makeHeader(len, pos, state), __ATOMIC_RELEASE);
+}
+
+void addToDebugBuffer(const char* message, size_t len)
+{
+    if (message == nullptr || len == 0) return;
+    if (len > DEBUG_RECORD_MAX_PAYLOAD) len = DEBUG_RECORD_MAX_PAYLOAD;
+
+    uint32_t pos;
+    if (!reserveRecord((uint32_t)len, pos)) return;
+    copyIn(pos + RECORD_HEADER_SIZE, message, (uint32_t)len);
+    commitRecord(pos, (uint32_t)len, RECORD_TEXT);
+}
+
+void addToDebugBuffer(const char* message)
+{
+    if (message == nullptr) return;
+    addToDebugBuffer(message, strlen(message));
+}
+
+// =============================================================================
+// DEFERRED FORMATTING
+// =============================================================================
+enum ArgClass {
+    ARG_INT,
+    ARG_LONG,
+    ARG_LLONG,
+    ARG_SIZE,
+    ARG_DOUBLE,
+    ARG_STRING,
+    ARG_POINTER,
+    ARG_UNSUPPORTED
+};
+
+struct FormatSpec {
+    const char* start;   // The '%'
+    const char* end;     // One past the conversion character
+    ArgClass arg;
+    bool starWidth;
+    bool starPrecision;
+};
+
+// Parse the conversion at p (which points at '%'). Returns false for "%%".
+static bool parseSpec(const char* p, FormatSpec& spec)
+{
+    spec.start = p;
+    spec.starWidth = false;
+    spec.starPrecision = false;
+    p++;
+    if (*p == '%') {
+        spec.end = p + 1;
+        return false;
+    }
+    while (*p != '\0' && strchr("-+ #0", *p) != nullptr) p++;
+    if (*p == '*') { spec.starWidth = true; p++; }
+    while (*p >= '0' && *p <= '9') p++;
+    if (*p == '.') {
+        p++;
+        if (*p == '*') { spec.starPrecision = true; p++; }
+        while (*p >= '0' && *p <= '9') p++;
+    }
+
+    int longs = 0;
+    bool sizeMod = false;
+    bool otherMod = false;
+    while (*p != '\0' && strchr("hlzjtLq", *p) != nullptr) {
+        if (*p == 'l') longs++;
+        else if (*p == 'z') sizeMod = true;
+        else if (*p != 'h') otherMod = true;
+        p++;
+    }
+
+    char conv = *p;
+    spec.end = (conv != '\0') ? p + 1 : p;
+    spec.arg = ARG_UNSUPPORTED;
+    if (otherMod) return true;
+    switch (conv) {
+        case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+            spec.arg = sizeMod ? ARG_SIZE : (longs >= 2 ? ARG_LLONG : (longs == 1 ? ARG_LONG : ARG_INT));
+            break;
+        case 'c':
+            if (longs == 0 && !sizeMod) spec.arg = ARG_INT;
+            break;
+        case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+            if (longs <= 1 && !sizeMod) spec.arg = ARG_DOUBLE;
+            break;
+        case 's':
+            if (longs == 0 && !sizeMod) spec.arg = ARG_STRING;
+            break;
+        case 'p':
+            spec.arg = ARG_POINTER;
+            break;
+        default:
+            break; // %n, wide strings, long double: format as text instead
+    }
+    return true;
+}
+
+static size_t argStorageSize(ArgClass arg)
+{
+    switch (arg) {
+        case ARG_INT:     return sizeof(int);
+        case ARG_LONG:    return sizeof(long);
+        case ARG_LLONG:   return sizeof(long long);
+        case ARG_SIZE:    return sizeof(size_t);
+        case ARG_DOUBLE:  return sizeof(double);
+        case ARG_POINTER: return sizeof(void*);
+        default:          return 0;
+    }
+}
+
+static const char* const NULL_STRING_ARG = "(null)";
+
+// Walk the arguments once to size the record; returns 0 if the format can't
+// be captured or the record would be too large
+static uint32_t binaryPayloadSize(const char* format, va_list args)
+{
+    uint32_t size = sizeof(uint32_t) + sizeof(const char*);
+    for (const char* p = strchr(format, '%'); p != nullptr; p = strchr(p, '%')) {
+        FormatSpec spec;
+        if (!parseSpec(p, spec)) { p = spec.end; continue; }
+        if (spec.arg == ARG_UNSUPPORTED) return 0;
+        if (spec.starWidth) { (void)va_arg(args, int); size += sizeof(int); }
+        if (spec.starPrecision) { (void)va_arg(args, int); size += sizeof(int); }
+        switch (spec.arg) {
+            case ARG_INT:     (void)va_arg(args, int); break;
+            case ARG_LONG:    (void)va_arg(args, long); break;
+            case ARG_LLONG:   (void)va_arg(args, long long); break;
+            case ARG_SIZE:    (void)va_arg(args, size_t); break;
+            case ARG_DOUBLE:  (void)va_arg(args, double); break;
+            case ARG_POINTER: (void)va_arg(args, void*); break;
+            case ARG_STRING: {
+                const char* str = va_arg(args, const char*);
+                size += 1 + (uint32_t)strnlen(str != nullptr ? str : NULL_STRING_ARG, DEBUG_ARG_STRING_MAX);
+                break;
+            }
+            default: return 0;
+        }
+        size += (uint32_t)argStorageSize(spec.arg);
+        if (size > DEBUG_RECORD_MAX_PAYLOAD) return 0;
+        p = spec.end;
+    }
+    return size;
+}
+
+bool addFormatToDebugBuffer(const char* format, va_list args)
+{
+    if (format == nullptr) return false;
+
+    va_list sizing;
+    va_copy(sizing, args);
+    uint32_t len = binaryPayloadSize(format, sizing);
+    va_end(sizing);
+    if (len == 0) return false;
+
+    uint32_t pos;
+    if (!reserveRecord(len, pos)) return true; // Dropped and counted; don't retry as text
+    uint32_t at = pos + RECORD_HEADER_SIZE;
+    uint32_t now = (uint32_t)millis();
+    copyIn(at, (const char*)&now, sizeof(now));
+    at += sizeof(now);
+    copyIn(at, (const char*)&format, sizeof(format));
+    at += sizeof(format);
+
+    for (const char* p = strchr(format, '%'); p != nullptr; p = strchr(p, '%')) {
+        FormatSpec spec;
+        if (!parseSpec(p, spec)) { p = spec.end; continue; }
+        if (spec.starWidth) { int v = va_arg(args, int); copyIn(at, (const char*)&v, sizeof(v)); at += sizeof(v); }
+        if (spec.starPrecision) { int v = va_arg(args, int); copyIn(at, (const char*)&v, sizeof(v)); at += sizeof(v); }
+        switch (spec.arg) {
+            case ARG_INT:     { int v = va_arg(args, int); copyIn(at, (const char*)&v, sizeof(v)); break; }
+            case ARG_LONG:    { long v = va_arg(args, long); copyIn(at, (const char*)&v, sizeof(v)); break; }
+            case ARG_LLONG:   { long long v = va_arg(args, long long); copyIn(at, (const char*)&v, sizeof(v)); break; }
+            case ARG_SIZE:    { size_t v = va_arg(args, size_t); copyIn(at, (const char*)&v, sizeof(v)); break; }
+            case ARG_DOUBLE:  { double v = va_arg(args, double); copyIn(at, (const char*)&v, sizeof(v)); break; }
+            case ARG_POINTER: { void* v = va_arg(args, void*); copyIn(at, (const char*)&v, sizeof(v)); break; }
+            case ARG_STRING: {
+                const char* str = va_arg(args, const char*);
+                if (str == nullptr) str = NULL_STRING_ARG;
+                uint8_t n = (uint8_t)strnlen(str, DEBUG_ARG_STRING_MAX);
+                copyIn(at, (const char*)&n, 1);
+                copyIn(at + 1, str, n);
+                at += 1 + n;
+                break;
+            }
+            default: break;
+        }
+        at += (uint32_t)argStorageSize(spec.arg);
+        p = spec.end;
+    }
+
+    commitRecord(pos, len, RECORD_BINARY);
+    return true;
+}
+
+// Bounds-checked reader over a copied-out binary payload
+struct PayloadReader {
+    const uint8_t* data;
+    uint32_t len;
+    uint32_t at;
+
+    bool read(void* dest, uint32_t n)
+    {
+        if (at + n > len) return false;
+        memcpy(dest, data + at, n);
+        at += n;
+        return true;
+    }
+};
+
+// Rebuild the spec text with '*' replaced by the stored width/precision
+static bool expandSpec(const FormatSpec& spec, PayloadReader& in, char* out, size_t outLen)
+{
+    size_t n = 0;
+    for (const char* c = spec.start; c < spec.end; c++) {
+        if (*c == '*') {
+            int v;
+            if (!in.read(&v, sizeof(v))) return false;
+            int w = snprintf(out + n, outLen - n, "%d", v);
+            if (w < 0 || (size_t)w >= outLen - n) return false;
+            n += (size_t)w;
+        } else {
+            if (n + 1 >= outLen) return false;
+            out[n++] = *c;
+        }
+    }
+    out[n] = '\0';
+    return true;
+}
+
+size_t formatBinaryRecord(const uint8_t* payload, uint32_t len, char* out, size_t outLen, uint32_t* timestamp)
+{
+    if (outLen == 0) return 0;
+    PayloadReader in = { payload, len, 0 };
+    uint32_t now;
+    const char* format;
+    if (!in.read(&now, sizeof(now)) || !in.read(&format, sizeof(format))) {
+        out[0] = '\0';
+        return 0;
+    }
+    if (timestamp != nullptr) *timestamp = now;
+
+    size_t n = 0;
+    const char* p = format;
+    while (*p != '\0' && n + 1 < outLen) {
+        if (*p != '%') {
+            out[n++] = *p++;
+            continue;
+        }
+        FormatSpec spec;
+        if (!parseSpec(p, spec)) {
+            out[n++] = '%';
+            p = spec.end;
+            continue;
+        }
+
+        char specText[32];
+        if (!expandSpec(spec, in, specText, sizeof(specText))) break;
+        int w = 0;
+        switch (spec.arg) {
+            case ARG_INT:     { int v;       if (!in.read(&v, sizeof(v))) goto done; w = snprintf(out + n, outLen - n, specText, v); break; }
+            case ARG_LONG:    { long v;      if (!in.read(&v, sizeof(v))) goto done; w = snprintf(out + n, outLen - n, specText, v); break; }
+            case ARG_LLONG:   { long long v; if (!in.read(&v, sizeof(v))) goto done; w = snprintf(out + n, outLen - n, specText, v); break; }
+            case ARG_SIZE:    { size_t v;    if (!in.read(&v, sizeof(v))) goto done; w = snprintf(out + n, outLen - n, specText, v); break; }
+            case ARG_DOUBLE:  { double v;    if (!in.read(&v, sizeof(v))) goto done; w = snprintf(out + n, outLen - n, specText, v); break; }
+            case ARG_POINTER: { void* v;     if (!in.read(&v, sizeof(v))) goto done; w = snprintf(out + n, outLen - n, specText, v); break; }
+            case ARG_STRING: {
+                uint8_t sl;
+                char str[DEBUG_ARG_STRING_MAX + 1];
+                if (!in.read(&sl, 1) || sl > DEBUG_ARG_STRING_MAX || !in.read(str, sl)) goto done;
+                str[sl] = '\0';
+                w = snprintf(out + n, outLen - n, specText, str);
+                break;
+            }
+            default:
+                goto done;
+        }
+        if (w < 0) break;
+        n += ((size_t)w < outLen - n) ? (size_t)w : outLen - n - 1;
+        p = spec.end;
+    }
+done:
+    out[n] = '\0';
+    return n;
+}
+
+// =============================================================================
+// READERS
+// =============================================================================
+uint32_t getDebugLogDropped()
+{
+    return debugDropped.load(std::memory_order_relaxed);
+}
+
+void debugLogCursorBegin(DebugLogCursor& cursor, uint32_t maxBytes)
+{
+    cursor.end = debugReserve.load(std::memory_order_acquire);
+    cursor.pos = debugTail.load(std::memory_order_acquire);
+    cursor.len = 0;
+    cursor.off = 0;
+    cursor.lapped = false;
+    cursor.skipped = 0;
+
+    // Skip whole records until at most maxBytes of ring remain. A record
+    // that fails validation ends the skip; debugLogCursorNext() resyncs.
+    while (posDiff(cursor.end, cursor.pos) > (int32_t)maxBytes) {
+        int32_t len = recordLengthAt(cursor.pos);
+        if (len < 0) break;
+        cursor.pos += recordSize((uint32_t)len);
+    }
+}
+
+void debugLogCursorSeek(DebugLogCursor& cursor, uint32_t since)
+{
+    cursor.end = debugReserve.load(std::memory_order_acquire);
+    cursor.pos = since;
+    cursor.len = 0;
+    cursor.off = 0;
+    cursor.lapped = false;
+    cursor.skipped = 0;
+
+    // Behind the tail: those records are gone. Ahead of the write position:
+    // a cursor from before a reboot. Either way restart from the oldest record.
+    uint32_t tail = debugTail.load(std::memory_order_acquire);
+    if (posDiff(since, tail) < 0) {
+        cursor.skipped = tail - since;
+        cursor.pos = tail;
+        cursor.lapped = true;
+    } else if (posDiff(since, cursor.end) > 0) {
+        cursor.pos = tail;
+        cursor.lapped = true;
+    }
+}
+
+bool debugLogCursorNext(DebugLogCursor& cursor)
+{
+    cursor.len = 0;
+    cursor.off = 0;
+    while (posDiff(cursor.end, cursor.pos) > 0) {
+        uint32_t pos = cursor.pos;
+        uint8_t state = 0;
+        int32_t len = recordLengthAt(pos, &state);
+        if (len < 0) {
+            // Either the newest record is still being written (stop here) or
+            // writers lapped us and the tail has moved on (resume from it)
+            uint32_t tail = debugTail.load(std::memory_order_acquire);
+            if (posDiff(tail, pos) <= 0) {
+                // Leave pos on the unfinished record so a later read resumes there
+                cursor.end = pos;
+                return false;
+            }
+            cursor.skipped += tail - pos;
+            cursor.pos = tail;
+            cursor.lapped = true;
+            continue;
+        }
+
+        copyOut(pos + RECORD_HEADER_SIZE, cursor.text, (uint32_t)len);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (posDiff(debugReserve.load(std::memory_order_relaxed), pos + DEBUG_BUFFER_SIZE) > 0) {
+            // Overwritten while copying - drop it. The header was intact when
+            // read, so its length still leads to the next record if the
+            // writer hasn't moved the tail yet.
+            uint32_t tail = debugTail.load(std::memory_order_acquire);
+            cursor.pos = posDiff(tail, pos) > 0 ? tail : pos + recordSize((uint32_t)len);
+            cursor.skipped += cursor.pos - pos;
+            cursor.lapped = true;
+            continue;
+        }
+        cursor.pos = pos + recordSize((uint32_t)len);
+
+        if (state == RECORD_BINARY) {
+            char line[DEBUG_LINE_MAX];
+            size_t lineLen = formatBinaryRecord((const uint8_t*)cursor.text, (uint32_t)len, line, sizeof(line), nullptr);
+            memcpy(cursor.text, line, lineLen);
+            cursor.len = (uint16_t)lineLen;
+        } else {
+            cursor.len = (uint16_t)len;
+        }
+        if (cursor.len > 0) return true;
+    }
+    return false;
+}
+
+size_t debugLogRead(DebugLogCursor& cursor, char* out, size_t maxLen)
+{
+    size_t n = 0;
+    while (n < maxLen) {
+        if (cursor.off >= cursor.len && !debugLogCursorNext(cursor)) break;
+        size_t chunk = cursor.len - cursor.off;
+        if (chunk > maxLen - n) chunk = maxLen - n;
+        memcpy(out + n, cursor.text + cursor.off, chunk);
+        cursor.off += (uint16_t)chunk;
+        n += chunk;
+    }
+    return n;
+}
+
+String getDebugLog()
+{
+    String result = "";
+    DebugLogCursor cursor;
+    debugLogCursorBegin(cursor, DEBUG_BUFFER_SIZE);
+    uint32_t span = (uint32_t)posDiff(cursor.end, cursor.pos);
+    result.reserve((span < DEBUG_BUFFER_SIZE ? span : DEBUG_BUFFER_SIZE) + 16);
+    while (debugLogCursorNext(cursor)) {
+        result.concat(cursor.text, cursor.len);
+    }
+    return result;
+}
+
+// =============================================================================
+// LOG LEVELS (see Log.h)
+// =============================================================================
+static const char* const LOG_TAG_NAMES[LOG_TAG_COUNT] = {
+    "SYSTEM", "HVAC", "SCHEDULE", "SENSOR", "DISPLAY", "MOTION",
+    "WIFI", "MQTT", "WEB", "OTA", "WEATHER", "SETTINGS"
+};
+
+// Build-time ceilings, reported to the /debug page
+static const uint8_t LOG_TAG_MAX_LEVELS[LOG_TAG_COUNT] = {
+    LOG_MAX_LEVEL_SYSTEM, LOG_MAX_LEVEL_HVAC, LOG_MAX_LEVEL_SCHEDULE, LOG_MAX_LEVEL_SENSOR,
+    LOG_MAX_LEVEL_DISPLAY, LOG_MAX_LEVEL_MOTION, LOG_MAX_LEVEL_WIFI, LOG_MAX_LEVEL_MQTT,
+    LOG_MAX_LEVEL_WEB, LOG_MAX_LEVEL_OTA, LOG_MAX_LEVEL_WEATHER, LOG_MAX_LEVEL_SETTINGS
+};
+
+static const char* const LOG_LEVEL_NAMES[] = { "none", "error", "warn", "info", "debug", "trace" };
+
+volatile uint8_t logRuntimeLevels[LOG_TAG_COUNT] = {
+    LOG_DEFAULT_LEVEL, LOG_DEFAULT_LEVEL, LOG_DEFAULT_LEVEL, LOG_DEFAULT_LEVEL,
+    LOG_DEFAULT_LEVEL, LOG_DEFAULT_LEVEL, LOG_DEFAULT_LEVEL, LOG_DEFAULT_LEVEL,
+    LOG_DEFAULT_LEVEL, LOG_DEFAULT_LEVEL, LOG_DEFAULT_LEVEL, LOG_DEFAULT_LEVEL
+};
+
+static_assert(LOG_TAG_COUNT == 12, "update LOG_TAG_NAMES and logRuntimeLevels with the tag list");
+
+const char* logTagName(LogTag tag)
+{
+    return (tag >= 0 && tag < LOG_TAG_COUNT) ? LOG_TAG_NAMES[tag] : "?";
+}
+
+uint8_t logTagMaxLevel(LogTag tag)
+{
+    return (tag >= 0 && tag < LOG_TAG_COUNT) ? LOG_TAG_MAX_LEVELS[tag] : LOG_LEVEL_NONE;
+}
+
+const char* logLevelName(uint8_t level)
+{
+    return level <= LOG_LEVEL_TRACE ? LOG_LEVEL_NAMES[level] : "?";
+}
+
+int logTagFromName(const char* name)
+{
+    if (name == nullptr) return -1;
+    for (int i = 0; i < LOG_TAG_COUNT; i++) {
+        if (strcasecmp(name, LOG_TAG_NAMES[i]) == 0) return i;
+    }
+    return -1;
+}
+
+int logLevelFromName(const char* name)
+{
+    if (name == nullptr || name[0] == '\0') return -1;
+    if (name[0] >= '0' && name[0] <= '9' && name[1] == '\0') {
+        int level = name[0] - '0';
+        return level <= LOG_LEVEL_TRACE ? level : -1;
+    }
+    for (int i = 0; i <= LOG_LEVEL_TRACE; i++) {
+        if (strcasecmp(name, LOG_LEVEL_NAMES[i]) == 0) return i;
+    }
+    return -1;
+}
+
+bool setLogLevel(LogTag tag, uint8_t level)
+{
+    if (tag < 0 || tag >= LOG_TAG_COUNT || level > LOG_LEVEL_TRACE) return false;
+    logRuntimeLevels[tag] = level;
+    return true;
+}
+
+void setAllLogLevels(uint8_t level)
+{
+    for (int i = 0; i < LOG_TAG_COUNT; i++) {
+        setLogLevel((LogTag)i, level);
+    }
+}
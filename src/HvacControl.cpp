@@ -0,0 +1,1070 @@
+/*
+ * HvacControl.cpp - HVAC relay control core and schedule evaluation
+ *
+ * Split out of Main-Thermostat.cpp so the same control code runs on the
+ * ESP32-S3 and in the host-native PlatformIO environment. Only Arduino.h,
+ * FreeRTOS semaphores and the hooks declared in HvacControl.h are used here.
+ */
+
+#include "HvacControl.h"
+
+// Settings
+float setTempHeat = 72.0; // Default set temperature for heating in Fahrenheit
+float setTempCool = 76.0; // Default set temperature for cooling in Fahrenheit
+float setTempAuto = 74.0; // Default set temperature for auto mode
+float tempSwing = 1.0;
+float autoTempSwing = 3.0;
+bool fanRelayNeeded = false;
+int fanMinutesPerHour = 15;                                                                     // Default to 15 minutes per hour
+unsigned long lastFanRunTime = 0;                                                               // Time when the fan last ran
+unsigned long fanRunDuration = 0;                                                               // Duration for which the fan has run in the current hour
+
+bool heatingOn = false;
+bool coolingOn = false;
+bool fanOn = false;
+String thermostatMode = "off"; // Default thermostat mode
+String fanMode = "auto"; // Default fan mode
+
+// Hybrid staging settings
+unsigned long stage1MinRuntime = 300; // Default minimum runtime for first stage in seconds (5 minutes)
+float stage2TempDelta = 2.0; // Default temperature delta for second stage activation
+unsigned long stage1StartTime = 0; // Time when stage 1 was activated
+unsigned long stage2StartTime = 0; // Time when stage 2 was activated (for min runtime tracking)
+bool stage1Active = false; // Flag to track if stage 1 is active
+bool stage2Active = false; // Flag to track if stage 2 is active
+bool stage2HeatingEnabled = false; // Enable/disable 2nd stage heating
+bool stage2CoolingEnabled = false; // Enable/disable 2nd stage cooling
+bool reversingValveEnabled = false; // Enable reversing valve (heat pump) - mutually exclusive with stage2HeatingEnabled
+
+// Backup heat settings
+// relay: 0=PUMP relay, 1=HEAT relay 2 (stage 2 heat), 2=COOL relay 2 (stage 2 cool output)
+bool backupHeatEnabled = false;
+int backupHeatRelaySelection = 0;
+int backupHeatDelayMinutes = 30;
+float backupHeatMinTempRise = 0.5f;
+float backupHeatMaxTempDrop = 1.5f;
+bool backupHeatActive = false;
+unsigned long backupHeatDemandStart = 0;
+unsigned long backupHeatLastTempRiseTime = 0;
+float backupHeatLastReferenceTemp = NAN;
+
+// US/EU Mode and Humidity Control Settings
+// region: "US" or "EU"
+String thermostatRegion = "US";
+// EU-specific humidity dehumidification settings
+// relay: 0=COOL relay 1 (default), 1=COOL relay 2 (stage 2 cool), 2=PUMP relay
+bool euHumidityControlEnabled = false;
+int euHumidityRelaySelection = 0;
+float euHumiditySetpoint = 60.0f;  // Target humidity % (activate dehumidification above this)
+float euHumidityDeadband = 5.0f;   // Hysteresis deadband for humidity control
+bool euHumidityDemandActive = false;
+
+// Hydronic system settings
+bool hydronicHeatingEnabled = false;
+float hydronicTempLow = 110.0; // Default low temperature for hydronic heating
+float hydronicTempHigh = 130.0; // Default high temperature for hydronic heating
+bool hydronicLockout = false; // Track hydronic safety lockout state
+
+// Shower Mode settings
+bool showerModeEnabled = false; // Master enable/disable for shower mode feature
+int showerModeDuration = 30; // Duration in minutes (default 30)
+bool showerModeActive = false;
+unsigned long showerModeStartTime = 0;
+
+// 7-Day Scheduling System
+DaySchedule weekSchedule[7] = {
+    // Sunday
+    {{6, 0, 72.0, 76.0, 74.0, true}, {22, 0, 68.0, 78.0, 73.0, true}, true},
+    // Monday
+    {{6, 0, 72.0, 76.0, 74.0, true}, {22, 0, 68.0, 78.0, 73.0, true}, true},
+    // Tuesday
+    {{6, 0, 72.0, 76.0, 74.0, true}, {22, 0, 68.0, 78.0, 73.0, true}, true},
+    // Wednesday
+    {{6, 0, 72.0, 76.0, 74.0, true}, {22, 0, 68.0, 78.0, 73.0, true}, true},
+    // Thursday
+    {{6, 0, 72.0, 76.0, 74.0, true}, {22, 0, 68.0, 78.0, 73.0, true}, true},
+    // Friday
+    {{6, 0, 72.0, 76.0, 74.0, true}, {22, 0, 68.0, 78.0, 73.0, true}, true},
+    // Saturday
+    {{6, 0, 72.0, 76.0, 74.0, true}, {22, 0, 68.0, 78.0, 73.0, true}, true}
+};
+
+bool scheduleEnabled = false;        // Master schedule enable/disable
+bool scheduleOverride = false;       // Temporary override active
+unsigned long overrideEndTime = 0;   // When override expires (0 = permanent)
+String activePeriod = "manual";      // Current active period: "day", "night", "manual"
+bool scheduleUpdatedFlag = false;    // Flag to indicate schedule needs to be saved
+
+SemaphoreHandle_t controlRelaysMutex = NULL; // Serialises controlRelays() between loop() and the sensor task
+
+// =============================================================================
+// SCHEDULING SYSTEM FUNCTIONS
+// =============================================================================
+
+// Get current day of week (0 = Sunday, 1 = Monday, ..., 6 = Saturday)
+int getCurrentDayOfWeek() {
+    time_t now;
+    struct tm timeinfo;
+    time(&now);
+    localtime_r(&now, &timeinfo);
+    return timeinfo.tm_wday;
+}
+
+// Get current period description
+String getCurrentPeriod() {
+    if (!scheduleEnabled) return "manual";
+    if (scheduleOverride) return "override";
+    return activePeriod;
+}
+
+// Check if we need to apply a scheduled temperature change
+void checkSchedule() {
+    if (!scheduleEnabled) return;
+    
+    // Ensure timezone is applied
+    tzset();
+    
+    // Get current time
+    time_t now;
+    struct tm timeinfo;
+    time(&now);
+    localtime_r(&now, &timeinfo);
+    
+    checkScheduleAt(timeinfo);
+}
+
+// Evaluate the schedule against a given local time (split out so the native
+// simulator can drive it from a virtual calendar instead of the host clock)
+void checkScheduleAt(const struct tm& timeinfo) {
+    if (!scheduleEnabled) return;
+    
+    int currentHour = timeinfo.tm_hour;
+    int currentMinute = timeinfo.tm_min;
+    int currentDayOfWeek = timeinfo.tm_wday;
+    
+    // Debug: Log current time and schedule status
+    static unsigned long lastDebugLog = 0;
+    if (millis() - lastDebugLog > 60000) { // Log every 60 seconds
+        LOG_DEBUG(SCHEDULE, "Current time: %02d:%02d (day %d), TZ: %s, Period: %s\n", 
+                 currentHour, currentMinute, currentDayOfWeek, timeZone.c_str(), activePeriod.c_str());
+        lastDebugLog = millis();
+    }
+    bool overrideExpired = false;
+    
+    // Check if override has expired
+    if (scheduleOverride && overrideEndTime > 0 && millis() >= overrideEndTime) {
+        scheduleOverride = false;
+        overrideEndTime = 0;
+        overrideExpired = true;
+        LOG_INFO(SCHEDULE, "Override expired, resuming schedule\n");
+    }
+    
+    // Skip if override is active
+    if (scheduleOverride) return;
+    
+    // Skip if this day is not enabled
+    if (!weekSchedule[currentDayOfWeek].enabled) return;
+    
+    DaySchedule& today = weekSchedule[currentDayOfWeek];
+    
+    // Convert current time to minutes for easier comparison
+    int currentMinutes = currentHour * 60 + currentMinute;
+    int dayMinutes = today.day.hour * 60 + today.day.minute;
+    int nightMinutes = today.night.hour * 60 + today.night.minute;
+    
+    // Determine which period we should be in
+    String newPeriod = "manual";
+    bool shouldApplyDaySchedule = false;
+    bool shouldApplyNightSchedule = false;
+    
+    if (dayMinutes <= nightMinutes) {
+        // Normal case: day < night (e.g., 6:00 AM - 10:00 PM)
+        if (currentMinutes >= dayMinutes && currentMinutes < nightMinutes) {
+            newPeriod = "day";
+            shouldApplyDaySchedule = true;
+        } else {
+            newPeriod = "night";
+            shouldApplyNightSchedule = true;
+        }
+    } else {
+        // Cross-midnight case: night < day (e.g., 10:00 PM - 6:00 AM next day)
+        if (currentMinutes >= dayMinutes || currentMinutes < nightMinutes) {
+            newPeriod = "day";
+            shouldApplyDaySchedule = true;
+        } else {
+            newPeriod = "night";
+            shouldApplyNightSchedule = true;
+        }
+    }
+    
+    // Apply schedule if period changed or an override just ended
+    bool shouldApplySchedule = overrideExpired || (newPeriod != activePeriod);
+    if (shouldApplySchedule) {
+        activePeriod = newPeriod;
+        if (shouldApplyDaySchedule && today.day.active) {
+            applySchedule(currentDayOfWeek, true);
+        } else if (shouldApplyNightSchedule && today.night.active) {
+            applySchedule(currentDayOfWeek, false);
+        }
+    }
+}
+
+// =============================================================================
+// HVAC RELAY CONTROL
+// =============================================================================
+
+void enforceBackupHeatRelayConflicts()
+{
+    if (!backupHeatEnabled) {
+        return;
+    }
+
+    if (backupHeatRelaySelection == 1) {
+        if (stage2HeatingEnabled) {
+            stage2HeatingEnabled = false;
+            LOG_INFO(HVAC, "Backup heat: Disabled stage2 heating (H2 relay reserved)\n");
+        }
+        if (reversingValveEnabled) {
+            reversingValveEnabled = false;
+            LOG_INFO(HVAC, "Backup heat: Disabled reversing valve (H2 relay reserved)\n");
+        }
+    }
+
+    if (backupHeatRelaySelection == 2 && stage2CoolingEnabled) {
+        stage2CoolingEnabled = false;
+        LOG_INFO(HVAC, "Backup heat: Disabled stage2 cooling (C2 relay reserved)\n");
+    }
+}
+
+void enforceEUHumidityRelayConflicts()
+{
+    if (!euHumidityControlEnabled) {
+        return;
+    }
+
+    if (euHumidityRelaySelection == 1 && stage2CoolingEnabled) {
+        stage2CoolingEnabled = false;
+        LOG_INFO(HVAC, "EU humidity: Disabled stage2 cooling (C2 relay reserved)\n");
+    }
+}
+
+int getBackupHeatRelayPin()
+{
+    if (backupHeatRelaySelection == 1) {
+        return HEAT_RELAY_2_PIN;
+    }
+    if (backupHeatRelaySelection == 2) {
+        return COOL_RELAY_2_PIN;
+    }
+    return PUMP_RELAY_PIN;
+}
+
+void setBackupHeatRelay(bool enabled)
+{
+    int pin = getBackupHeatRelayPin();
+    digitalWrite(pin, enabled ? HIGH : LOW);
+}
+
+void clearBackupHeatState(const char* reason)
+{
+    if (backupHeatActive || backupHeatDemandStart != 0) {
+        LOG_INFO(HVAC, "Backup heat: Cleared: %s\n", reason);
+    }
+    backupHeatActive = false;
+    backupHeatDemandStart = 0;
+    backupHeatLastTempRiseTime = 0;
+    backupHeatLastReferenceTemp = NAN;
+    setBackupHeatRelay(false);
+}
+
+void updateBackupHeatState(bool heatDemandActive, float currentTemp)
+{
+    if (!backupHeatEnabled) {
+        clearBackupHeatState("feature disabled");
+        return;
+    }
+
+    if (!heatDemandActive) {
+        clearBackupHeatState("no active heat demand");
+        return;
+    }
+
+    if (backupHeatDemandStart == 0) {
+        backupHeatDemandStart = millis();
+        backupHeatLastTempRiseTime = backupHeatDemandStart;
+        backupHeatLastReferenceTemp = currentTemp;
+        backupHeatActive = false;
+        setBackupHeatRelay(false);
+        LOG_DEBUG(HVAC, "Backup heat: Monitoring primary heat recovery (%d min window)\n", backupHeatDelayMinutes);
+        return;
+    }
+
+    unsigned long delayMs = (unsigned long)backupHeatDelayMinutes * 60000UL;
+    float tempRiseThreshold = backupHeatMinTempRise;
+    if (!isnan(backupHeatLastReferenceTemp) && currentTemp >= (backupHeatLastReferenceTemp + tempRiseThreshold)) {
+        backupHeatLastReferenceTemp = currentTemp;
+        backupHeatLastTempRiseTime = millis();
+    }
+
+    if (!backupHeatActive && !isnan(backupHeatLastReferenceTemp) && currentTemp <= (backupHeatLastReferenceTemp - backupHeatMaxTempDrop)) {
+        backupHeatActive = true;
+        setBackupHeatRelay(true);
+        LOG_INFO(HVAC, "Backup heat: Primary temperature dropped by %.2f - backup activated\n", backupHeatMaxTempDrop);
+        return;
+    }
+
+    if (!backupHeatActive && (millis() - backupHeatLastTempRiseTime >= delayMs)) {
+        backupHeatActive = true;
+        setBackupHeatRelay(true);
+        LOG_INFO(HVAC, "Backup heat: Primary heat failure detected - backup activated\n");
+    } else if (backupHeatActive) {
+        setBackupHeatRelay(true);
+    }
+}
+
+void controlRelays(float currentTemp)
+{
+    // Take mutex to prevent concurrent access from multiple cores
+    if (xSemaphoreTake(controlRelaysMutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        LOG_WARN(HVAC, "controlRelays: Failed to acquire mutex, skipping this call\n");
+        return;
+    }
+
+    enforceBackupHeatRelayConflicts();
+    enforceEUHumidityRelayConflicts();
+    euHumidityDemandActive = false;
+    
+    // Check if shower mode is active and has expired
+    if (showerModeActive) {
+        unsigned long elapsed = millis() - showerModeStartTime;
+        unsigned long remaining = (showerModeDuration * 60000UL) - elapsed;
+        
+        // Buzzer alert for last 5 seconds (one beep per second)
+        static unsigned long lastBuzzTime = 0;
+        if (remaining <= 5000 && remaining > 0) {
+            int secondsRemaining = (remaining / 1000) + 1;
+            unsigned long currentSecond = 5 - secondsRemaining;
+            if (currentSecond != lastBuzzTime) {
+                buzzerBeep(100);
+                lastBuzzTime = currentSecond;
+                LOG_INFO(HVAC, "Shower mode: Alert beep - %d seconds remaining\n", secondsRemaining);
+            }
+        } else if (remaining > 5000) {
+            lastBuzzTime = 0; // Reset for next countdown
+        }
+        
+        if (elapsed >= (showerModeDuration * 60000UL)) {
+            showerModeActive = false;
+            lastBuzzTime = 0; // Reset buzzer tracking
+            LOG_INFO(HVAC, "Shower mode: Timer expired, resuming normal operation\n");
+        }
+    }
+    
+    // Debug entry
+    LOG_TRACE(HVAC, "controlRelays ENTRY: mode=%s, temp=%.1f, heatingOn=%d, coolingOn=%d, showerMode=%d\n", 
+                 thermostatMode.c_str(), currentTemp, heatingOn, coolingOn, showerModeActive);
+    
+    // Track previous states to only print debug info on changes
+    static bool prevHeatingOn = false;
+    static bool prevCoolingOn = false;
+    static bool prevFanOn = false;
+    static String prevThermostatMode = "";
+    static float prevTemp = 0.0;
+    
+    // Check if temperature reading is valid
+    if (isnan(currentTemp)) {
+        LOG_WARN(HVAC, "Invalid temperature reading, skipping relay control\n");
+        clearBackupHeatState("invalid temperature");
+        xSemaphoreGive(controlRelaysMutex);
+        return;
+    }
+    
+    // Fan safety interlock: block fan when hydronic lockout conditions are active
+    bool fanBlockedByHydronicSafety = hydronicHeatingEnabled &&
+        (!ds18b20SensorPresent || isnan(hydronicTemp) || hydronicTemp < hydronicTempLow || hydronicLockout);
+
+    // Store current states before any changes
+    bool currentHeatingOn = heatingOn;
+    bool currentCoolingOn = coolingOn;
+    bool currentFanOn = fanOn;
+
+    if (thermostatMode == "off")
+    {
+        LOG_TRACE(HVAC, "In OFF mode - turning off heating and cooling relays\n");
+        // Turn off heating and cooling relays, but don't turn off fan
+        // This allows the fan to operate in "on" or "cycle" mode even when thermostat is off
+        digitalWrite(HEAT_RELAY_1_PIN, LOW);
+        digitalWrite(HEAT_RELAY_2_PIN, LOW);
+        digitalWrite(COOL_RELAY_1_PIN, LOW);
+        digitalWrite(COOL_RELAY_2_PIN, LOW);
+        heatingOn = false;
+        coolingOn = false;
+        stage1Active = false;
+        stage2Active = false;
+        
+        // Handle fan separately based on fanMode
+        if (fanMode == "on" && !fanBlockedByHydronicSafety) {
+            if (!fanOn) {
+                digitalWrite(FAN_RELAY_PIN, HIGH);
+                fanOn = true;
+                LOG_INFO(HVAC, "Fan on while thermostat is off\n");
+            }
+        }
+        else if (fanMode == "auto") {
+            digitalWrite(FAN_RELAY_PIN, LOW);
+            fanOn = false;
+        }
+        // Note: "cycle" fan mode is handled by controlFanSchedule()
+        clearBackupHeatState("thermostat mode off");
+        updateStatusLEDs(); // Update LED status
+        
+        xSemaphoreGive(controlRelaysMutex);
+        return;
+    }
+
+    // Rest of the thermostat logic for heat, cool, and auto modes
+    if (thermostatMode == "heat")
+    {
+        LOG_TRACE(HVAC, "In HEAT mode: temp=%.1f, setpoint=%.1f, swing=%.1f\n", 
+                     currentTemp, setTempHeat, tempSwing);
+        
+        // Turn off cooling relays when entering heat mode
+        if (coolingOn) {
+            LOG_TRACE(HVAC, "Turning off cooling relays in heat mode\n");
+            digitalWrite(COOL_RELAY_1_PIN, LOW);
+            digitalWrite(COOL_RELAY_2_PIN, LOW);
+            coolingOn = false;
+            // Reset staging flags to allow heating to start fresh
+            stage1Active = false;
+            stage2Active = false;
+        }
+        
+        // Block heating if shower mode is active
+        if (showerModeActive) {
+            if (heatingOn) {
+                LOG_INFO(HVAC, "Shower mode: Blocking heating - turning off\n");
+                digitalWrite(HEAT_RELAY_1_PIN, LOW);
+                digitalWrite(HEAT_RELAY_2_PIN, LOW);
+                heatingOn = false;
+                stage1Active = false;
+                stage2Active = false;
+            }
+        }
+        // Only activate heating if below setpoint - swing
+        else {
+            LOG_TRACE(HVAC, "Heat check: %.1f < %.1f? %s\n", 
+                         currentTemp, (setTempHeat - tempSwing), 
+                         (currentTemp < (setTempHeat - tempSwing)) ? "YES" : "NO");
+            if (currentTemp < (setTempHeat - tempSwing))
+            {
+                // Call activateHeating on every pass so stage 2 escalation can fire
+                // after stage1MinRuntime elapses (guarded internally by !stage1Active /
+                // !stage2Active checks inside activateHeating).
+                if (!heatingOn) {
+                    LOG_INFO(HVAC, "HEAT ACTIVATED: %.1f < %.1f (setpoint-swing)\n", 
+                             currentTemp, (setTempHeat - tempSwing));
+                }
+                activateHeating();
+            }
+            // Only turn off if above setpoint (hysteresis)
+            else if (currentTemp >= setTempHeat)
+            {
+                if (heatingOn || coolingOn || fanOn) {
+                    LOG_INFO(HVAC, "HEAT DEACTIVATED: %.1f >= %.1f (setpoint)\n", 
+                             currentTemp, setTempHeat);
+                }
+                // Called unconditionally even if already off — re-asserts relay pin states
+                // every cycle as a safety net to prevent relays from getting stuck ON
+                turnOffAllRelays();
+            }
+            // Otherwise maintain current state (hysteresis band)
+        }
+    }
+    else if (thermostatMode == "cool")
+    {
+        LOG_TRACE(HVAC, "In COOL mode: temp=%.1f, setpoint=%.1f, swing=%.1f\n", 
+                     currentTemp, setTempCool, tempSwing);
+        
+        // Turn off heating relays when entering cool mode
+        if (heatingOn) {
+            LOG_TRACE(HVAC, "Turning off heating relays in cool mode\n");
+            digitalWrite(HEAT_RELAY_1_PIN, LOW);
+            digitalWrite(HEAT_RELAY_2_PIN, LOW);
+            heatingOn = false;
+            // Reset staging flags to allow cooling to start fresh
+            stage1Active = false;
+            stage2Active = false;
+        }
+        
+        // Only activate cooling if above setpoint + swing
+        LOG_TRACE(HVAC, "Cool check: %.1f > %.1f? %s\n", 
+                     currentTemp, (setTempCool + tempSwing), 
+                     (currentTemp > (setTempCool + tempSwing)) ? "YES" : "NO");
+        
+        bool shouldCool = false;
+        bool humidityDrivenCooling = false;
+        
+        // Temperature-based cooling (primary)
+        if (currentTemp > (setTempCool + tempSwing)) {
+            shouldCool = true;
+            LOG_DEBUG(HVAC, "Temperature trigger: %.1f > %.1f\n", currentTemp, (setTempCool + tempSwing));
+        }
+        
+        // EU Humidity-based dehumidification (secondary, only in EU mode)
+        if (thermostatRegion == "EU" && euHumidityControlEnabled) {
+            if (currentHumidity > euHumiditySetpoint) {
+                shouldCool = true;
+                humidityDrivenCooling = true;
+                LOG_DEBUG(HVAC, "EU Humidity dehumidification trigger: %.1f%% > %.1f%%\n", 
+                         currentHumidity, euHumiditySetpoint);
+            }
+        }
+        euHumidityDemandActive = humidityDrivenCooling;
+        
+        if (shouldCool) {
+            // Call activateCooling every cycle (like HEAT and AUTO modes do)
+            // to ensure relay stays energized and as a safety net against relay getting stuck OFF
+            if (!coolingOn) {
+                LOG_INFO(HVAC, "COOL ACTIVATED: temperature or humidity override\n");
+            }
+            activateCooling();
+        }
+        // Only turn off if below setpoint (hysteresis) AND not in EU humidity dehumidification
+        else if ((currentTemp < setTempCool) && 
+                 !(thermostatRegion == "EU" && euHumidityControlEnabled && 
+                   currentHumidity > (euHumiditySetpoint - euHumidityDeadband)))
+        {
+            if (heatingOn || coolingOn || fanOn) {
+                LOG_INFO(HVAC, "COOL DEACTIVATED: %.1f < %.1f (setpoint)\n", 
+                         currentTemp, setTempCool);
+            }
+            // Called unconditionally even if already off — re-asserts relay pin states
+            // every cycle as a safety net to prevent relays from getting stuck ON
+            turnOffAllRelays();
+        }
+        // Otherwise maintain current state (hysteresis band between setpoint and setpoint+swing)
+    }
+    else if (thermostatMode == "auto")
+    {
+        LOG_TRACE(HVAC, "In AUTO mode: temp=%.1f, setpoint=%.1f, autoSwing=%.1f\n", 
+                     currentTemp, setTempAuto, autoTempSwing);
+
+        float autoHeatOnThreshold = setTempAuto - autoTempSwing;
+        float autoCoolOnThreshold = setTempAuto + autoTempSwing;
+
+        // Single-setpoint auto behavior:
+        // - Dead zone is hold-only (no transitions)
+        // - Start heat/cool only outside swing thresholds
+        // - Stop active heat/cool only at setpoint boundary
+        if (coolingOn) {
+            // EU humidity demand can keep cooling active even after reaching setpoint.
+            bool humidityDemand = (thermostatRegion == "EU" && euHumidityControlEnabled &&
+                                   currentHumidity > (euHumiditySetpoint - euHumidityDeadband));
+            euHumidityDemandActive = (thermostatRegion == "EU" && euHumidityControlEnabled &&
+                                      currentHumidity > euHumiditySetpoint);
+
+            if (currentTemp <= setTempAuto && !humidityDemand) {
+                LOG_DEBUG(HVAC, "Auto cooling OFF at setpoint: %.1f <= %.1f\n", currentTemp, setTempAuto);
+                turnOffAllRelays();
+            } else {
+                LOG_TRACE(HVAC, "Auto cooling HOLD: temp=%.1f, setpoint=%.1f, humidityDemand=%d\n",
+                         currentTemp, setTempAuto, humidityDemand ? 1 : 0);
+                activateCooling();
+            }
+        }
+        else if (heatingOn) {
+            euHumidityDemandActive = false;
+            if (currentTemp >= setTempAuto) {
+                LOG_DEBUG(HVAC, "Auto heating OFF at setpoint: %.1f >= %.1f\n", currentTemp, setTempAuto);
+                turnOffAllRelays();
+            } else {
+                LOG_TRACE(HVAC, "Auto heating HOLD: temp=%.1f, setpoint=%.1f\n", currentTemp, setTempAuto);
+                activateHeating();
+            }
+        }
+        else if (currentTemp > autoCoolOnThreshold) {
+            euHumidityDemandActive = false;
+            LOG_DEBUG(HVAC, "Auto cooling ON threshold crossed: %.1f > %.1f\n",
+                     currentTemp, autoCoolOnThreshold);
+            activateCooling();
+        }
+        else if (currentTemp < autoHeatOnThreshold) {
+            euHumidityDemandActive = false;
+            LOG_DEBUG(HVAC, "Auto heating ON threshold crossed: %.1f < %.1f\n",
+                     currentTemp, autoHeatOnThreshold);
+            activateHeating();
+        }
+        // EU Humidity-based dehumidification (supplementary in auto mode while idle)
+        else if (thermostatRegion == "EU" && euHumidityControlEnabled && currentHumidity > euHumiditySetpoint) {
+            euHumidityDemandActive = true;
+            LOG_DEBUG(HVAC, "Auto mode EU humidity dehumidification: %.1f%% > %.1f%%\n",
+                     currentHumidity, euHumiditySetpoint);
+            activateCooling();
+        }
+        else {
+            euHumidityDemandActive = false;
+            LOG_TRACE(HVAC, "Auto dead zone HOLD: %.1f between %.1f and %.1f\n",
+                     currentTemp, autoHeatOnThreshold, autoCoolOnThreshold);
+            // No transition in dead zone while idle.
+        }
+    }
+
+    bool heatDemandActive = false;
+    if (!showerModeActive && heatingOn && thermostatMode == "heat") {
+        heatDemandActive = currentTemp < (setTempHeat - tempSwing);
+    } else if (!showerModeActive && heatingOn && thermostatMode == "auto") {
+        heatDemandActive = currentTemp < (setTempAuto - autoTempSwing);
+    }
+    updateBackupHeatState(heatDemandActive, currentTemp);
+
+    // Emergency/backup mode behavior: once tripped, run backup relay and force primary heat outputs off.
+    if (backupHeatActive && heatDemandActive) {
+        int backupPin = getBackupHeatRelayPin();
+        if (backupPin != HEAT_RELAY_1_PIN) {
+            digitalWrite(HEAT_RELAY_1_PIN, LOW);
+        }
+        if (backupPin != HEAT_RELAY_2_PIN) {
+            digitalWrite(HEAT_RELAY_2_PIN, LOW);
+        }
+        if (backupPin != COOL_RELAY_2_PIN) {
+            digitalWrite(COOL_RELAY_2_PIN, LOW);
+        }
+        stage1Active = false;
+        if (backupPin != HEAT_RELAY_2_PIN && backupPin != COOL_RELAY_2_PIN) {
+            stage2Active = false;
+        }
+    }
+
+    // Make sure fan control is applied
+    handleFanControl();
+    
+    // Detect any state or mode changes to trigger display/LED updates
+    bool stateChanged = (heatingOn != prevHeatingOn || coolingOn != prevCoolingOn || fanOn != prevFanOn);
+    bool modeChanged = (thermostatMode != prevThermostatMode);
+    
+    // Only print debug info when there are changes
+    if (stateChanged || modeChanged || abs(currentTemp - prevTemp) > 0.5) {
+        LOG_TRACE(HVAC, "controlRelays: mode=%s, temp=%.1f, setHeat=%.1f, setCool=%.1f, setAuto=%.1f, swing=%.1f\n", 
+                     thermostatMode.c_str(), currentTemp, setTempHeat, setTempCool, setTempAuto, tempSwing);
+        LOG_TRACE(HVAC, "Relay states: heating=%d, cooling=%d, fan=%d\n", heatingOn, coolingOn, fanOn);
+        
+        // CONSOLIDATED UPDATE: Update LEDs and display when relay state or mode changes
+        updateStatusLEDs();
+        setDisplayUpdateFlag();
+        
+        // Update previous states
+        prevHeatingOn = heatingOn;
+        prevCoolingOn = coolingOn;
+        prevFanOn = fanOn;
+        prevThermostatMode = thermostatMode;
+        prevTemp = currentTemp;
+    }
+    
+    // Debug: Verify actual relay pin states
+    bool actualHeat1 = digitalRead(HEAT_RELAY_1_PIN) == HIGH;
+    bool actualHeat2 = digitalRead(HEAT_RELAY_2_PIN) == HIGH;
+    bool actualCool1 = digitalRead(COOL_RELAY_1_PIN) == HIGH;
+    bool actualCool2 = digitalRead(COOL_RELAY_2_PIN) == HIGH;
+    bool actualFan = digitalRead(FAN_RELAY_PIN) == HIGH;
+    
+    LOG_TRACE(HVAC, "controlRelays EXIT: RelayPins H1=%d H2=%d C1=%d C2=%d F=%d | Flags heat=%d cool=%d fan=%d stage1=%d stage2=%d\n", 
+                 actualHeat1, actualHeat2, actualCool1, actualCool2, actualFan, 
+                 heatingOn, coolingOn, fanOn, stage1Active, stage2Active);
+    
+    xSemaphoreGive(controlRelaysMutex);
+}
+
+void turnOffAllRelays()
+{
+    LOG_DEBUG(HVAC, "turnOffAllRelays() - Turning off heating/cooling relays\n");
+    bool fanBlockedByHydronicSafety = hydronicHeatingEnabled &&
+        (!ds18b20SensorPresent || isnan(hydronicTemp) || hydronicTemp < hydronicTempLow || hydronicLockout);
+
+    digitalWrite(HEAT_RELAY_1_PIN, LOW);
+    digitalWrite(HEAT_RELAY_2_PIN, LOW);
+    digitalWrite(COOL_RELAY_1_PIN, LOW);
+    digitalWrite(COOL_RELAY_2_PIN, LOW);
+    setBackupHeatRelay(false);
+    heatingOn = false;
+    coolingOn = false;
+    stage1Active = false; // Reset stage 1 active flag
+    stage2Active = false; // Reset stage 2 active flag
+    backupHeatActive = false;
+    backupHeatDemandStart = 0;
+    
+    // Handle fan based on fanMode setting
+    if (fanMode == "on" && !fanBlockedByHydronicSafety) {
+        // Keep fan running in "on" mode
+        if (!fanOn) {
+            digitalWrite(FAN_RELAY_PIN, HIGH);
+            fanOn = true;
+            LOG_DEBUG(HVAC, "turnOffAllRelays() - Keeping fan ON (fanMode=on)\n");
+        }
+    } else if (fanMode == "auto") {
+        // Turn off fan in auto mode when heating/cooling stops
+        if (fanRelayNeeded) {
+            // Only control fan if fanRelayNeeded is true
+            digitalWrite(FAN_RELAY_PIN, LOW);
+            fanOn = false;
+            LOG_DEBUG(HVAC, "turnOffAllRelays() - Turning fan OFF (fanMode=auto)\n");
+        }
+    }
+    // Note: "cycle" mode is handled by controlFanSchedule(), don't interfere
+    
+    LOG_DEBUG(HVAC, "turnOffAllRelays() COMPLETE: heatingOn=%d, coolingOn=%d, fanOn=%d, fanMode=%s\n", 
+                 heatingOn, coolingOn, fanOn, fanMode.c_str());
+    // Always update LEDs and display even if state didn't change — keeps display and
+    // hardware in sync and ensures any drift is corrected every control cycle
+    updateStatusLEDs();
+    setDisplayUpdateFlag();
+}
+
+void activateHeating() {
+    LOG_TRACE(HVAC, "activateHeating() ENTRY: stage1Active=%d, stage2Active=%d\n", stage1Active, stage2Active);
+    
+    // Hydronic boiler safety interlock - prevent heating if boiler water is too cold
+    if (hydronicHeatingEnabled && !isnan(hydronicTemp)) {
+        LOG_TRACE(HVAC, "Hydronic Safety Check: temp=%.1f, low=%.1f, high=%.1f, lockout=%d\n", 
+                     hydronicTemp, hydronicTempLow, hydronicTempHigh, hydronicLockout);
+        
+        // Manage lockout state with hysteresis
+        // Lockout activates at low threshold, clears at high threshold
+        if (hydronicTemp < hydronicTempLow && !hydronicLockout) {
+            hydronicLockout = true;
+            LOG_INFO(HVAC, "Hydronic lockout ACTIVATED - temp %.1f°F below %.1f°F\n", 
+                         hydronicTemp, hydronicTempLow);
+        } else if (hydronicTemp >= hydronicTempHigh && hydronicLockout) {
+            hydronicLockout = false;
+            LOG_INFO(HVAC, "Hydronic lockout CLEARED - temp %.1f°F reached %.1f°F\n", 
+                         hydronicTemp, hydronicTempHigh);
+        }
+        
+        // If in lockout state, prevent heating
+        if (hydronicLockout) {
+            LOG_DEBUG(HVAC, "Hydronic lockout active - waiting for temp to reach %.1f°F (currently %.1f°F)\n", 
+                         hydronicTempHigh, hydronicTemp);
+            
+            // Turn off heating relays
+            digitalWrite(HEAT_RELAY_1_PIN, LOW);
+            digitalWrite(HEAT_RELAY_2_PIN, LOW);
+            heatingOn = false;
+            stage1Active = false;
+            stage2Active = false;
+            
+            // Force fan off during hydronic lockout
+            if (fanOn) {
+                digitalWrite(FAN_RELAY_PIN, LOW);
+                fanOn = false;
+                LOG_DEBUG(HVAC, "Lockout: Fan forced OFF during hydronic lockout\n");
+            }
+            
+            updateStatusLEDs();
+            setDisplayUpdateFlag();
+            return; // Exit - no heating allowed
+        }
+        
+        LOG_TRACE(HVAC, "Lockout: Hydronic water temp %.1f°F OK - heating allowed\n", hydronicTemp);
+    }
+
+    // Default heating behavior with hybrid staging
+    heatingOn = true;
+    coolingOn = false;
+    
+    // Turn off cooling relays when activating heating
+    digitalWrite(COOL_RELAY_1_PIN, LOW);
+    digitalWrite(COOL_RELAY_2_PIN, LOW);
+    
+    // Check if stage 1 is not active yet
+    if (!stage1Active) {
+        LOG_INFO(HVAC, "Stage 1 HEATING activated\n");
+        digitalWrite(HEAT_RELAY_1_PIN, HIGH); // Activate stage 1
+        stage1Active = true;
+        stage1StartTime = millis(); // Record the start time
+        stage2Active = false; // Ensure stage 2 is off initially
+        
+        // Wake display when HVAC activates
+        if (displayIsAsleep) {
+            wakeDisplay();
+            LOG_INFO(DISPLAY, "Woke from sleep - heating activated\n");
+        }
+    }
+    
+    // Handle reversing valve or stage 2 heating (mutually exclusive)
+    if (reversingValveEnabled) {
+        // Reversing valve mode: energize valve immediately when heating
+        if (!stage2Active) {
+            LOG_INFO(HVAC, "Reversing valve energized for HEAT mode\n");
+            digitalWrite(HEAT_RELAY_2_PIN, HIGH);
+            stage2Active = true; // Use stage2Active flag to track valve state
+        }
+    }
+    // Check if it's time to activate stage 2 based on hybrid approach
+    else if (!stage2Active && 
+             ((millis() - stage1StartTime) / 1000 >= stage1MinRuntime) && // Minimum run time before stage 2 allowed
+             (currentTemp < setTempHeat - stage2TempDelta) && // Simplified: just use delta, no swing subtraction
+             stage2HeatingEnabled) { // Check if stage 2 heating is enabled
+        LOG_INFO(HVAC, "Stage 2 HEATING activated (temp %.1f < setpoint %.1f - delta %.1f)\n", 
+                 currentTemp, setTempHeat, stage2TempDelta);
+        digitalWrite(HEAT_RELAY_2_PIN, HIGH); // Activate stage 2
+        stage2Active = true;
+        stage2StartTime = millis(); // Record when stage 2 started
+    }
+    // Stage 2 DEACTIVATION: When temperature recovers sufficiently while stage 1 continues
+    else if (stage2Active && !reversingValveEnabled &&
+             ((millis() - stage2StartTime) >= STAGE2_MIN_RUNTIME) && // Must run minimum time before deactivation
+             (currentTemp >= setTempHeat - (stage2TempDelta * 0.5))) { // Deactivate at half-delta for hysteresis
+        LOG_INFO(HVAC, "Stage 2 HEATING deactivated (temp %.1f >= setpoint %.1f - half-delta %.1f, runtime %.1fs)\n", 
+                 currentTemp, setTempHeat, (stage2TempDelta * 0.5), (millis() - stage2StartTime) / 1000.0);
+        digitalWrite(HEAT_RELAY_2_PIN, LOW); // Deactivate stage 2
+        stage2Active = false;
+    }
+    
+    // Control fan based on fanRelayNeeded setting
+    // BUT: Never override manual "on" mode - user takes priority
+    if (fanMode == "on" && !(hydronicHeatingEnabled &&
+        (!ds18b20SensorPresent || isnan(hydronicTemp) || hydronicTemp < hydronicTempLow || hydronicLockout))) {
+        // User has manually set fan to always on - respect that
+        if (!fanOn) {
+            LOG_INFO(HVAC, "FAN turned ON (manual mode)\n");
+            digitalWrite(FAN_RELAY_PIN, HIGH);
+            fanOn = true;
+            LOG_DEBUG(HVAC, "Fan activated with heat (manual 'on' mode)\n");
+        }
+    } else if (fanRelayNeeded) {
+        if (!fanOn) {
+            digitalWrite(FAN_RELAY_PIN, HIGH);
+            fanOn = true;
+            LOG_DEBUG(HVAC, "Fan activated with heat\n");
+        }
+    } else {
+        // HVAC controls its own fan, turn ours off
+        if (fanOn) {
+            digitalWrite(FAN_RELAY_PIN, LOW);
+            fanOn = false;
+            LOG_DEBUG(HVAC, "Fan turned off during heat - HVAC controls fan\n");
+        }
+    }
+    updateStatusLEDs(); // Update LED status
+    setDisplayUpdateFlag(); // Option C: Request display update
+}
+
+void activateCooling()
+{
+    LOG_TRACE(HVAC, "activateCooling() ENTRY: stage1Active=%d, stage2Active=%d\n", stage1Active, stage2Active);
+    bool euHumidityRelayMode = (thermostatRegion == "EU" && euHumidityControlEnabled && euHumidityDemandActive);
+    int coolingRelayPin = COOL_RELAY_1_PIN;
+    if (euHumidityRelayMode) {
+        if (euHumidityRelaySelection == 1) {
+            coolingRelayPin = COOL_RELAY_2_PIN;
+        } else if (euHumidityRelaySelection == 2) {
+            coolingRelayPin = PUMP_RELAY_PIN;
+        }
+    }
+    
+    // Default cooling behavior with hybrid staging
+    coolingOn = true;
+    heatingOn = false;
+    
+    // Turn off heating relays when activating cooling
+    digitalWrite(HEAT_RELAY_1_PIN, LOW);
+    
+    // Handle reversing valve: de-energize for cooling mode
+    if (reversingValveEnabled) {
+        LOG_INFO(HVAC, "Reversing valve de-energized for COOL mode\n");
+        digitalWrite(HEAT_RELAY_2_PIN, LOW);
+        stage2Active = false;
+    } else {
+        digitalWrite(HEAT_RELAY_2_PIN, LOW);
+    }
+    
+    // Check if stage 1 is not active yet
+    if (!stage1Active) {
+        LOG_DEBUG(HVAC, "Activating cooling relay pin %d\n", coolingRelayPin);
+        if (euHumidityRelayMode) {
+            digitalWrite(COOL_RELAY_1_PIN, LOW);
+            digitalWrite(COOL_RELAY_2_PIN, LOW);
+            digitalWrite(PUMP_RELAY_PIN, LOW);
+        }
+        digitalWrite(coolingRelayPin, HIGH);
+        stage1Active = true;
+        stage1StartTime = millis(); // Record the start time
+        stage2Active = false; // Ensure stage 2 is off initially
+        LOG_DEBUG(HVAC, "Cooling activated - relay pin %d set HIGH\n", coolingRelayPin);
+        
+        // Wake display when HVAC activates
+        if (displayIsAsleep) {
+            wakeDisplay();
+            LOG_INFO(DISPLAY, "Woke from sleep - cooling activated\n");
+        }
+    } else {
+        LOG_TRACE(HVAC, "Cooling stage 1 already active (stage1Active=%d)\n", stage1Active);
+    }
+    
+    // Only activate stage 2 cooling if NOT using reversing valve and not in EU humidity relay mode
+    if (!euHumidityRelayMode && !reversingValveEnabled && !stage2Active && 
+            ((millis() - stage1StartTime) / 1000 >= stage1MinRuntime) && // Minimum run time before stage 2 allowed
+            (currentTemp > setTempCool + stage2TempDelta) && // Simplified: just use delta, no swing addition
+            stage2CoolingEnabled) { // Check if stage 2 cooling is enabled
+        LOG_INFO(HVAC, "Stage 2 COOLING activated (temp %.1f > setpoint %.1f + delta %.1f)\n", 
+                 currentTemp, setTempCool, stage2TempDelta);
+        digitalWrite(COOL_RELAY_2_PIN, HIGH); // Activate stage 2
+        stage2Active = true;
+        stage2StartTime = millis(); // Record when stage 2 started
+    }
+    // Stage 2 DEACTIVATION: When temperature recovers sufficiently while stage 1 continues
+    else if (stage2Active && !reversingValveEnabled &&
+             ((millis() - stage2StartTime) >= STAGE2_MIN_RUNTIME) && // Must run minimum time before deactivation
+             (currentTemp <= setTempCool + (stage2TempDelta * 0.5))) { // Deactivate at half-delta for hysteresis
+        LOG_INFO(HVAC, "Stage 2 COOLING deactivated (temp %.1f <= setpoint %.1f + half-delta %.1f, runtime %.1fs)\n", 
+                 currentTemp, setTempCool, (stage2TempDelta * 0.5), (millis() - stage2StartTime) / 1000.0);
+        digitalWrite(COOL_RELAY_2_PIN, LOW); // Deactivate stage 2
+        stage2Active = false;
+    }
+    
+    // Control fan based on fanRelayNeeded setting
+    // BUT: Never override manual "on" mode - user takes priority
+    if (fanMode == "on" && !(hydronicHeatingEnabled &&
+        (!ds18b20SensorPresent || isnan(hydronicTemp) || hydronicTemp < hydronicTempLow || hydronicLockout))) {
+        // User has manually set fan to always on - respect that
+        if (!fanOn) {
+            digitalWrite(FAN_RELAY_PIN, HIGH);
+            fanOn = true;
+            LOG_DEBUG(HVAC, "Fan activated with cooling (manual 'on' mode)\n");
+        }
+    } else if (fanRelayNeeded) {
+        if (!fanOn) {
+            digitalWrite(FAN_RELAY_PIN, HIGH);
+            fanOn = true;
+            LOG_DEBUG(HVAC, "Fan activated with cooling\n");
+        }
+    } else {
+        // HVAC controls its own fan, turn ours off
+        if (fanOn) {
+            digitalWrite(FAN_RELAY_PIN, LOW);
+            fanOn = false;
+            LOG_DEBUG(HVAC, "Fan turned off during cool - HVAC controls fan\n");
+        }
+    }
+    updateStatusLEDs(); // Update LED status
+    setDisplayUpdateFlag(); // Option C: Request display update
+}
+
+void handleFanControl()
+{
+    // Block fan when hydronic heating is enabled and sensor is missing/invalid or below cutoff
+    if (hydronicHeatingEnabled &&
+        (!ds18b20SensorPresent || isnan(hydronicTemp) || hydronicTemp < hydronicTempLow || hydronicLockout)) {
+        if (fanOn) {
+            digitalWrite(FAN_RELAY_PIN, LOW);
+            fanOn = false;
+            LOG_INFO(HVAC, "Fan: Forced OFF (hydronic lockout or sensor missing)\n");
+        }
+        setDisplayUpdateFlag(); // Option C: Request display update
+        return;
+    }
+
+    bool newFanState = fanOn;  // Default: keep current state
+    
+    if (fanMode == "on")
+    {
+        newFanState = true;  // Always on
+    }
+    else if (fanMode == "auto")
+    {
+        // Auto mode: fan only runs with heating/cooling if fanRelayNeeded is true
+        // If fanRelayNeeded is false, HVAC controls the fan
+        if (fanRelayNeeded) {
+            newFanState = (heatingOn || coolingOn);
+        } else {
+            newFanState = false;  // Don't control fan - HVAC system controls it
+        }
+    }
+    else if (fanMode == "cycle")
+    {
+        // Cycle mode: handled by controlFanSchedule(), don't override here
+        return;
+    }
+    
+    // Only write GPIO if state actually changed (state guard)
+    if (newFanState != fanOn) {
+        digitalWrite(FAN_RELAY_PIN, newFanState ? HIGH : LOW);
+        fanOn = newFanState;
+        LOG_DEBUG(HVAC, "Fan state changed via handleFanControl: %s\n", fanOn ? "ON" : "OFF");
+    }
+    
+    setDisplayUpdateFlag(); // Option C: Request display update
+}
+
+void controlFanSchedule()
+{
+    // Removed 1-hour boot delay - fan cycle starts immediately
+
+    if (fanMode == "cycle")
+    {
+        if (hydronicHeatingEnabled &&
+            (!ds18b20SensorPresent || isnan(hydronicTemp) || hydronicTemp < hydronicTempLow || hydronicLockout)) {
+            if (fanOn) {
+                digitalWrite(FAN_RELAY_PIN, LOW);
+                fanOn = false;
+                LOG_INFO(HVAC, "Fan schedule: Forced OFF (hydronic lockout or sensor missing)\n");
+            }
+            return;
+        }
+
+        // Don't run cycle schedule if heating or cooling is active
+        if (heatingOn || coolingOn) {
+            if (!fanRelayNeeded && fanOn) {
+                digitalWrite(FAN_RELAY_PIN, LOW);
+                fanOn = false;
+                LOG_INFO(HVAC, "Fan schedule: Stopping fan - heating/cooling active, fanRelayNeeded=false\n");
+            }
+            return;
+        }
+
+        unsigned long currentTime = millis();
+        unsigned long elapsedTime = (currentTime - lastFanRunTime) / 1000; // Convert to seconds
+        unsigned long hourElapsed = elapsedTime % SECONDS_PER_HOUR;
+
+        // If an hour has passed, reset the cycle
+        if (elapsedTime >= SECONDS_PER_HOUR)
+        {
+            LOG_INFO(HVAC, "Fan schedule: Hour elapsed, resetting fan cycle\n");
+            lastFanRunTime = currentTime;
+            hourElapsed = 0;
+        }
+
+        // Calculate which 5-minute increment we're in (0-11)
+        // fanMinutesPerHour determines how many 5-min increments to run
+        // Example: 15 minutes = 3 increments of 5 minutes
+        unsigned long totalIncrements = (fanMinutesPerHour / 5);
+        unsigned long currentIncrement = (hourElapsed / 300);  // 300 seconds = 5 minutes
+        
+        // Validate totalIncrements (max 12 for 60 minutes)
+        if (totalIncrements > 12) {
+            totalIncrements = 12;  // Cap at 60 minutes
+        }
+        if (totalIncrements == 0) {
+            totalIncrements = 1;  // Minimum 1 increment (5 minutes)
+        }
+
+        // Fan should run during first N increments, then off for remainder
+        bool shouldRun = (currentIncrement < totalIncrements);
+        
+        // Only write GPIO if state actually changed
+        if (shouldRun != fanOn) {
+            digitalWrite(FAN_RELAY_PIN, shouldRun ? HIGH : LOW);
+            fanOn = shouldRun;
+            LOG_TRACE(HVAC, "Fan schedule: Cycle mode: increment %lu/%lu (%lu/%lu min), fan %s\n", 
+                         currentIncrement, totalIncrements, 
+                         currentIncrement * 5, fanMinutesPerHour,
+                         fanOn ? "ON" : "OFF");
+        }
+        
+        updateStatusLEDs(); // Update LED status
+    }
+    // Retain auto mode for backward compatibility
+    else if (fanMode == "auto")
+    {
+        // No scheduled fan running in auto mode - handled by handleFanControl()
+    }
+}
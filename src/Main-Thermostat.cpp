@@ -41,6 +41,8 @@
 #include <esp_task_wdt.h> // Watchdog reset API used in main loop
 #include <time.h>
 #include <ArduinoJson.h> // Include the ArduinoJson library
+#include <AsyncJson.h> // JSON request bodies (POST /api/state)
+#include <memory> // shared_ptr state for chunked responses
 #include <OneWire.h>
 #include <MyLD2410.h> // LD2410 radar library
 #include "WebInterface.h"
@@ -56,6 +58,20 @@
 #include "soc/io_mux_reg.h" // IO MUX registers for pin function override
 #include "esp_rom_gpio.h" // ROM GPIO functions
 #include "HardwarePins.h" // Hardware pin definitions
+#include "HvacControl.h" // HVAC relay control core (shared with native build)
+#include "DebugLog.h" // Lock-free debug log ring (shared with native build)
+#include "Log.h" // Levelled per-subsystem LOG_* macros
+#include "PostMortem.h" // Last-events trace kept across resets in RTC memory
+#include "MqttTopics.h" // Interned <hostname>/... topic table
+#include "MqttQueue.h" // Outbound publish queue drained by the MQTT task
+#include "MqttState.h" // Consolidated <hostname>/state document with deadbands
+#include "MqttCommandParser.h" // Allocation-free schedule/set JSON parser
+#include "SettingsStore.h" // Write-behind, write-if-changed NVS persistence
+#include "ConfigBlob.h" // Settings and schedule as one A/B NVS blob
+#include "TelemetryBuffer.h" // Outage history replayed to <hostname>/history
+#include "MqttTlsClient.h" // TLS broker connection with session resumption
+#include "NvsWear.h" // NVS write accounting and wear estimate
+#include "SettingsRegistry.h" // SETTINGS[] descriptor table and perfect-hash lookup
 #include "SettingsUI.h"
 
 // Version control information
@@ -64,9 +80,6 @@ const String build_date = __DATE__;  // Compile date
 const String build_time = __TIME__;  // Compile time
 String version_info = sw_version + " (" + build_date + " " + build_time + ")";
 
-// Constants
-const int SECONDS_PER_HOUR = 3600;
-
 // Temperature/Humidity Sensor Configuration
 enum SensorType {
     SENSOR_NONE = 0,
@@ -111,16 +124,11 @@ bool ds18b20Address2Valid = false;
 
 float hydronicTemp = 0.0;
 float hydronicReturnTemp = 0.0;
-bool hydronicHeatingEnabled = false;
-
-// Hydronic system settings
-float hydronicTempLow = 110.0; // Default low temperature for hydronic heating
-float hydronicTempHigh = 130.0; // Default high temperature for hydronic heating
+// Hydronic interlock settings (hydronicHeatingEnabled, low/high, lockout) live in HvacControl.cpp
 
 // Hydronic alert tracking
 bool hydronicLowTempAlertSent = false; // Track if low temp alert has been sent
 unsigned long lastHydronicAlertTime = 0; // Track last alert time to prevent spam
-bool hydronicLockout = false; // Track hydronic safety lockout state
 
 // Light sensor and display dimming setup (PWM constants now in HardwarePins.h)
 // LIGHT_SENSOR_PIN and TFT_BACKLIGHT_PIN are defined in HardwarePins.h
@@ -166,46 +174,13 @@ String haEntityId = "";
 int weatherUpdateInterval = 5; // Update interval in minutes (default 5)
 Weather weather; // Weather object
 
-// Hybrid staging settings
-unsigned long stage1MinRuntime = 300; // Default minimum runtime for first stage in seconds (5 minutes)
-float stage2TempDelta = 2.0; // Default temperature delta for second stage activation
-unsigned long stage1StartTime = 0; // Time when stage 1 was activated
-unsigned long stage2StartTime = 0; // Time when stage 2 was activated (for min runtime tracking)
-const unsigned long STAGE2_MIN_RUNTIME = 60000; // Minimum 60 seconds before stage 2 can deactivate
-bool stage1Active = false; // Flag to track if stage 1 is active
-bool stage2Active = false; // Flag to track if stage 2 is active
-bool stage2HeatingEnabled = false; // Enable/disable 2nd stage heating
-bool stage2CoolingEnabled = false; // Enable/disable 2nd stage cooling
-bool reversingValveEnabled = false; // Enable reversing valve (heat pump) - mutually exclusive with stage2HeatingEnabled
-
-// Backup heat settings
-// relay: 0=PUMP relay, 1=HEAT relay 2 (stage 2 heat), 2=COOL relay 2 (stage 2 cool output)
-bool backupHeatEnabled = false;
-int backupHeatRelaySelection = 0;
-int backupHeatDelayMinutes = 30;
-float backupHeatMinTempRise = 0.5f;
-float backupHeatMaxTempDrop = 1.5f;
-bool backupHeatActive = false;
-unsigned long backupHeatDemandStart = 0;
-unsigned long backupHeatLastTempRiseTime = 0;
-float backupHeatLastReferenceTemp = NAN;
-
-// US/EU Mode and Humidity Control Settings
-// region: "US" or "EU"
-String thermostatRegion = "US";
-// EU-specific humidity dehumidification settings
-// relay: 0=COOL relay 1 (default), 1=COOL relay 2 (stage 2 cool), 2=PUMP relay
-bool euHumidityControlEnabled = false;
-int euHumidityRelaySelection = 0;
-float euHumiditySetpoint = 60.0f;  // Target humidity % (activate dehumidification above this)
-float euHumidityDeadband = 5.0f;   // Hysteresis deadband for humidity control
-bool euHumidityDemandActive = false;
-
 // Globals
 AsyncWebServer server(80);
 LGFX tft;
 DisplayVariant activeDisplay = DISPLAY_ILI9341;  // updated at boot by tft.initDisplay()
 WiFiClient espClient;
+MqttTlsClient mqttTlsClient; // Used instead of espClient when mqttTls is set
+static bool mqttTlsActive = false; // mqttTls as setupMQTT() applied it; a change waits for a restart
 PubSubClient mqttClient(espClient); // Initialize the MQTT client
 Preferences preferences; // Preferences instance
 String inputText = "";
@@ -257,19 +232,18 @@ TaskHandle_t sensorTask;
 // GPIO pin definitions moved to HardwarePins.h for centralized hardware abstraction
 
 // Settings
-float setTempHeat = 72.0; // Default set temperature for heating in Fahrenheit
-float setTempCool = 76.0; // Default set temperature for cooling in Fahrenheit
-float setTempAuto = 74.0; // Default set temperature for auto mode
-float tempSwing = 1.0;
-float autoTempSwing = 3.0;
-bool fanRelayNeeded = false;
 bool useFahrenheit = true; // Default to Fahrenheit
 bool mqttEnabled = false; // Default to MQTT disabled
+bool mqttDeviceDiscovery = false; // One device-based HA discovery message instead of one per entity
+bool mqttStateJson = false; // Publish <hostname>/state JSON instead of one topic per field
+float mqttTempDeadband = 0.2; // State JSON: temperature change that triggers a publish
+float mqttHumidityDeadband = 1.0; // State JSON: humidity change (%) that triggers a publish
+int mqttStateHeartbeatMin = 5; // State JSON: republish at least this often (minutes, 0 = never)
+bool mqttHistoryFlash = false; // Spill outage history beyond 6 hours to the spiffs partition
+bool mqttTls = false; // Connect to the broker over TLS (applied at boot)
+String mqttCaCert = ""; // PEM CA the broker certificate must chain to
 String wifiSSID = "";
 String wifiPassword = "";
-int fanMinutesPerHour = 15;                                                                     // Default to 15 minutes per hour
-unsigned long lastFanRunTime = 0;                                                               // Time when the fan last ran
-unsigned long fanRunDuration = 0;                                                               // Duration for which the fan has run in the current hour
 const float tempDifferential = 4.0; // Fixed differential between heat and cool for auto changeover
 bool use24HourClock = true; // Default to 24-hour clock
 
@@ -283,12 +257,6 @@ String timeZone = "CST6CDT,M3.2.0,M11.1.0"; // Default time zone (Central Standa
 // Add a preference for hostname
 String hostname = DEFAULT_HOSTNAME; // Default hostname via ProjectConfig
 
-// Shower Mode settings
-bool showerModeEnabled = false; // Master enable/disable for shower mode feature
-int showerModeDuration = 30; // Duration in minutes (default 30)
-bool showerModeActive = false;
-unsigned long showerModeStartTime = 0;
-
 // Modern Material Design Color Scheme
 #define COLOR_BACKGROUND   0x1082    // Dark Gray #121212
 #define COLOR_PRIMARY      0x1976    // Soft Blue #1976D2
@@ -301,37 +269,6 @@ unsigned long showerModeStartTime = 0;
 #define COLOR_SURFACE      0x2124    // Slightly lighter gray #212121
 
 
-bool heatingOn = false;
-bool coolingOn = false;
-bool fanOn = false;
-String thermostatMode = "off"; // Default thermostat mode
-String fanMode = "auto"; // Default fan mode
-
-// 7-Day Scheduling System (structures defined in WebPages.h)
-DaySchedule weekSchedule[7] = {
-    // Sunday
-    {{6, 0, 72.0, 76.0, 74.0, true}, {22, 0, 68.0, 78.0, 73.0, true}, true},
-    // Monday
-    {{6, 0, 72.0, 76.0, 74.0, true}, {22, 0, 68.0, 78.0, 73.0, true}, true},
-    // Tuesday
-    {{6, 0, 72.0, 76.0, 74.0, true}, {22, 0, 68.0, 78.0, 73.0, true}, true},
-    // Wednesday
-    {{6, 0, 72.0, 76.0, 74.0, true}, {22, 0, 68.0, 78.0, 73.0, true}, true},
-    // Thursday
-    {{6, 0, 72.0, 76.0, 74.0, true}, {22, 0, 68.0, 78.0, 73.0, true}, true},
-    // Friday
-    {{6, 0, 72.0, 76.0, 74.0, true}, {22, 0, 68.0, 78.0, 73.0, true}, true},
-    // Saturday
-    {{6, 0, 72.0, 76.0, 74.0, true}, {22, 0, 68.0, 78.0, 73.0, true}, true}
-};
-
-bool scheduleEnabled = false;        // Master schedule enable/disable
-bool scheduleOverride = false;       // Temporary override active
-const unsigned long scheduleOverrideDuration = 120; // Override duration in minutes (2 hours)
-unsigned long overrideEndTime = 0;   // When override expires (0 = permanent)
-String activePeriod = "manual";      // Current active period: "day", "night", "manual"
-bool scheduleUpdatedFlag = false;    // Flag to indicate schedule needs to be saved
-
 // AHT20 sensor calibration offsets
 float tempOffset = 0.0; // Temperature offset in degrees (add to reading)
 float humidityOffset = 0.0; // Humidity offset in % (add to reading)
@@ -364,16 +301,12 @@ bool ds18b20ReturnSensorPresent = false;
 
 // Function prototypes
 void setupWiFi();
-void controlRelays(float currentTemp);
 void handleWebRequests();
 void updateDisplay(float currentTemp, float currentHumidity);
-void saveSettings();
+bool saveSettings(uint8_t writers);
 void loadSettings();
 void setupMQTT();
-void reconnectMQTT();
 float convertCtoF(float celsius);
-void controlFanSchedule();
-void saveWiFiSettings();
 void drawKeyboard(bool isUpperCaseKeyboard);
 void handleKeyPress(int row, int col);
 void drawButtons();
@@ -390,17 +323,14 @@ void exitKeyboardToPreviousScreen();
 void restoreDefaultSettings();
 void mqttCallback(char* topic, byte* payload, unsigned int length);
 void sendMQTTData();
+void recordTelemetry(unsigned long now);
+void replayTelemetry(unsigned long now);
 void resetMQTTDataCache(); // Force republish all MQTT data on next sendMQTTData call
 void readLightSensor();
 void updateDisplayBrightness();
 
 // Schedule function prototypes
-void checkSchedule();
-void applySchedule(int dayOfWeek, bool isDayPeriod);
-void saveScheduleSettings();
-void loadScheduleSettings();
-String getCurrentPeriod();
-int getCurrentDayOfWeek();
+void flushSettings(bool force);
 void setBrightness(int brightness);
 float getCalibratedTemperature(float rawTemp);
 float getCalibratedHumidity(float rawHumidity);
@@ -414,19 +344,12 @@ void updateStatusLEDs();
 void setHeatLED(bool state);
 void setCoolLED(bool state);
 void setFanLED(bool state);
-void buzzerBeep(int duration = 125);
 void buzzerStartupTone();
-void publishHomeAssistantDiscovery();
-void turnOffAllRelays();
-void activateHeating();
-void activateCooling();
-void handleFanControl();
-void enforceBackupHeatRelayConflicts();
-void enforceEUHumidityRelayConflicts();
-int getBackupHeatRelayPin();
-void setBackupHeatRelay(bool enabled);
-void clearBackupHeatState(const char* reason);
-void updateBackupHeatState(bool heatDemandActive, float currentTemp);
+void publishHomeAssistantDiscovery(); // Start an incremental discovery pass (MQTT task)
+void publishHomeAssistantDiscoveryStep();
+void publishNvsWear();
+void invalidateHomeAssistantDiscovery();
+void removeHomeAssistantDiscovery();
 
 // Sensor abstraction function prototypes
 SensorType detectSensor();
@@ -441,11 +364,50 @@ TaskHandle_t displayUpdateTask = NULL;
 bool displayUpdateRequired = false;
 unsigned long displayUpdateInterval = 500; // Update every 500ms
 SemaphoreHandle_t displayUpdateMutex = NULL;
-SemaphoreHandle_t controlRelaysMutex = NULL;
 SemaphoreHandle_t radarSensorMutex = NULL;
 SemaphoreHandle_t i2cMutex = NULL; // Protect I2C bus access (AHT20 sensor)
 SemaphoreHandle_t nvsSaveMutex = NULL; // Protect NVS/preferences save operations (dual-core safety)
 
+// MQTT network task: the only code that touches mqttClient
+void mqttTaskFunction(void* parameter);
+void processMQTTCommands();
+bool publishStreamed(const char* topic, const uint8_t* payload, size_t length, bool retained);
+TaskHandle_t mqttTask = NULL;
+QueueHandle_t mqttCommandQueue = NULL; // Inbound commands, MQTT task -> loop()
+volatile bool mqttConnected = false; // Broker session is up (written by the MQTT task)
+volatile bool mqttSessionStarted = false; // New session: loop() republishes all state
+volatile bool mqttDiscoveryNeeded = false; // MQTT task republishes Home Assistant discovery
+volatile uint32_t mqttCommandsDropped = 0;
+
+// Connection settings as the MQTT task sees them. The web handlers reassign
+// the String settings on the AsyncTCP task, so the MQTT task never reads
+// them; mqttConfigPublish() copies them here under mqttConfigMutex after
+// every change and bumps the generation, and the task takes a copy.
+struct MqttConnConfig {
+    uint32_t generation;
+    bool enabled;
+    int port;
+    char hostname[sizeof(ConfigData::hostname)];
+    char server[sizeof(ConfigData::mqttServer)];
+    char username[sizeof(ConfigData::mqttUsername)];
+    char password[sizeof(ConfigData::mqttPassword)];
+};
+static MqttConnConfig mqttConfigShared;
+static SemaphoreHandle_t mqttConfigMutex = NULL;
+static String mqttHostname; // MQTT task: hostname of the current session (client id, discovery)
+void mqttConfigPublish();
+void reconnectMQTT(const MqttConnConfig& config);
+// Broker connection cost, written by the MQTT task
+uint32_t mqttConnectAttempts = 0;
+uint32_t mqttConnects = 0; // Every one after the first is a reconnect
+uint32_t mqttConnectLastMs = 0; // mqttClient.connect(): TCP, TLS and CONNACK
+uint32_t mqttConnectMaxMs = 0;
+const size_t MQTT_COMMAND_PAYLOAD = 256; // Same as the schedule/set JSON document
+struct MqttInbound {
+    MqttCommand command;
+    char payload[MQTT_COMMAND_PAYLOAD];
+};
+
 // Diagnostics
 void logRuntimeDiagnostics();
 
@@ -476,6 +438,7 @@ unsigned long showSetTempUntil = 0;
 const unsigned long SETPOINT_DISPLAY_TIMEOUT_MS = 15000;
 // bool firstHourAfterBoot = true; // Flag to track the first hour after bootup - DISABLED
 volatile bool mqttFeedbackNeeded = false; // Flag for immediate MQTT feedback on settings change
+volatile bool telemetrySpillChanged = false; // Web handler -> loop(): apply mqttHistoryFlash
 bool wifiWasConnected = false; // Track WiFi state transitions for reconnect handling
 bool timeSyncInitialized = false; // Track one-time NTP init after first WiFi connect
 
@@ -487,7 +450,21 @@ float mqttLastSetTempCool = 0.0;
 float mqttLastSetTempAuto = 0.0;
 String mqttLastThermostatMode = "";
 String mqttLastFanMode = "";
-String mqttLastAction = "";
+const char* mqttLastAction = "";
+float mqttLastHydronicTemp = -999.0;
+int mqttLastScheduleEnabled = -1;        // -1: not sent since the cache was reset
+int mqttLastScheduleOverride = -1;
+String mqttLastActivePeriod = "";
+uint32_t mqttLastScheduleVersion = 0;    // scheduleVersion the schedule/<day> documents were sent for
+int mqttLastScheduleDay = -1;
+bool mqttLastScheduleDocsEnabled = false;
+bool mqttLastAvailabilitySent = false;
+unsigned long mqttLastCacheReset = 0;
+const unsigned long MQTT_KEEPALIVE_REPUBLISH_MS = 3600000; // Resend unchanged state hourly
+
+// Bumped whenever weekSchedule[] changes (web, MQTT, NVS load) so the
+// schedule/<day> documents are only rebuilt and sent when there is news
+volatile uint32_t scheduleVersion = 0;
 
 // Temperature and humidity filtering (exponential moving average)
 float filteredTemp = 0.0;              // EMA-filtered temperature
@@ -522,16 +499,16 @@ void sensorTaskFunction(void *parameter) {
         bool readSuccess = readTemperatureHumidity(tempReading, humidityReading, pressureReading);
         
         if (!readSuccess) {
-            debugLog("[SENSOR] Read failed!\n");
+            LOG_WARN(SENSOR, "Read failed!\n");
             
             // Try to reinitialize if cooldown has passed
             unsigned long now = millis();
             if (now - lastSensorError > SENSOR_ERROR_COOLDOWN) {
-                debugLog("[SENSOR] Attempting %s reinit...\n", sensorName.c_str());
+                LOG_INFO(SENSOR, "Attempting %s reinit...\n", sensorName.c_str());
                 if (initializeSensor(activeSensor)) {
-                    debugLog("[SENSOR] %s reinitialized successfully\n", sensorName.c_str());
+                    LOG_INFO(SENSOR, "%s reinitialized successfully\n", sensorName.c_str());
                 } else {
-                    debugLog("[SENSOR] %s reinit failed\n", sensorName.c_str());
+                    LOG_WARN(SENSOR, "%s reinit failed\n", sensorName.c_str());
                 }
                 lastSensorError = now;
             }
@@ -580,7 +557,7 @@ void sensorTaskFunction(void *parameter) {
                     hydronicTemp = useFahrenheit ? (hydTempC * 9.0 / 5.0 + 32.0) : hydTempC;
                 } else {
                     // Invalid reading - keep last valid reading, don't update
-                    debugLog("[WARNING] DS18B20 supply sensor reading failed or disconnected\n");
+                    LOG_WARN(SENSOR, "DS18B20 supply sensor reading failed or disconnected\n");
                 }
             }
 
@@ -589,7 +566,7 @@ void sensorTaskFunction(void *parameter) {
                 if (returnTempC != DEVICE_DISCONNECTED_C && returnTempC != -127.0 && !isnan(returnTempC)) {
                     hydronicReturnTemp = useFahrenheit ? (returnTempC * 9.0 / 5.0 + 32.0) : returnTempC;
                 } else {
-                    debugLog("[WARNING] DS18B20 return sensor reading failed or disconnected\n");
+                    LOG_WARN(SENSOR, "DS18B20 return sensor reading failed or disconnected\n");
                 }
             }
         }
@@ -605,7 +582,7 @@ void sensorTaskFunction(void *parameter) {
 
 // Option C: Centralized Display Update Task
 void displayUpdateTaskFunction(void* parameter) {
-    debugLog("DISPLAY_TASK: Starting centralized display update task\n");
+    LOG_INFO(DISPLAY, "Starting centralized display update task\n");
     
     for (;;) {
         // Check if display update is required or if enough time has passed
@@ -618,9 +595,9 @@ void displayUpdateTaskFunction(void* parameter) {
             
             if (updateNeeded) {
                 if (displayUpdateRequired) {
-                    debugLog("[DISPLAY_TASK] Flag-triggered update\n");
+                    LOG_TRACE(DISPLAY, "Flag-triggered update\n");
                 } else {
-                    debugLog("[DISPLAY_TASK] Timer-triggered update\n");
+                    LOG_TRACE(DISPLAY, "Timer-triggered update\n");
                 }
                 displayUpdateRequired = false;  // Clear the flag
                 displayIndicators.lastUpdate = currentTime;
@@ -640,7 +617,7 @@ void displayUpdateTaskFunction(void* parameter) {
 
 // Update display indicators based on current system state
 void updateDisplayIndicators() {
-    debugLog("DISPLAY_UPDATE: Refreshing display indicators\n");
+    LOG_TRACE(DISPLAY, "Refreshing display indicators\n");
     
     // Take mutex to read system state safely
     if (xSemaphoreTake(displayUpdateMutex, pdMS_TO_TICKS(50)) == pdTRUE) {
@@ -662,7 +639,7 @@ void updateDisplayIndicators() {
         setCoolLED(coolingOn);  
         setFanLED(fanOn);
         
-        debugLog("DISPLAY_UPDATE: Heat=%s, Cool=%s, Fan=%s, Auto=%s, Stage1=%s, Stage2=%s\n",
+        LOG_TRACE(DISPLAY, "Heat=%s, Cool=%s, Fan=%s, Auto=%s, Stage1=%s, Stage2=%s\n",
              displayIndicators.heatIndicator ? "ON" : "OFF",
              displayIndicators.coolIndicator ? "ON" : "OFF",
              displayIndicators.fanIndicator ? "ON" : "OFF",
@@ -670,7 +647,7 @@ void updateDisplayIndicators() {
              displayIndicators.stage1Indicator ? "ON" : "OFF",
              displayIndicators.stage2Indicator ? "ON" : "OFF");
     } else {
-        debugLog("DISPLAY_UPDATE: Failed to take mutex, skipping update\n");
+        LOG_WARN(DISPLAY, "Failed to take mutex, skipping update\n");
     }
 }
 
@@ -679,9 +656,9 @@ void setDisplayUpdateFlag() {
     if (xSemaphoreTake(displayUpdateMutex, pdMS_TO_TICKS(10)) == pdTRUE) {
         displayUpdateRequired = true;
         xSemaphoreGive(displayUpdateMutex);
-        debugLog("[DISPLAY_FLAG_SET] Display update requested from controlRelays\n");
+        LOG_TRACE(DISPLAY, "Display update requested from controlRelays\n");
     } else {
-        debugLog("[DISPLAY_FLAG_FAILED] Could not acquire mutex\n");
+        LOG_WARN(DISPLAY, "Update flag: could not acquire mutex\n");
     }
 }
 
@@ -691,55 +668,55 @@ void setDisplayUpdateFlag() {
 
 // Auto-detect which sensor is connected
 SensorType detectSensor() {
-    debugLog("[SENSOR] Starting sensor auto-detection...\n");
+    LOG_INFO(SENSOR, "Starting sensor auto-detection...\n");
     
     // Initialize I2C bus first
     Wire.begin(I2C_SDA_PIN, I2C_SCL_PIN);
     delay(100);
     
     // Try BME680 first (has more features)
-    debugLog("[SENSOR] Checking for BME680 at I2C address 0x76...\n");
+    LOG_DEBUG(SENSOR, "Checking for BME680 at I2C address 0x76...\n");
     if (bme680.begin(0x76)) {
-        debugLog("[SENSOR] BME680 detected at address 0x76!\n");
+        LOG_INFO(SENSOR, "BME680 detected at address 0x76!\n");
         return SENSOR_BME680;
     }
     
-    debugLog("[SENSOR] Checking for BME680 at I2C address 0x77...\n");
+    LOG_DEBUG(SENSOR, "Checking for BME680 at I2C address 0x77...\n");
     if (bme680.begin(0x77)) {
-        debugLog("[SENSOR] BME680 detected at address 0x77!\n");
+        LOG_INFO(SENSOR, "BME680 detected at address 0x77!\n");
         return SENSOR_BME680;
     }
     
     // Try AHT20 (I2C address 0x38)
-    debugLog("[SENSOR] Checking for AHT20 at I2C address 0x38...\n");
+    LOG_DEBUG(SENSOR, "Checking for AHT20 at I2C address 0x38...\n");
     if (aht.begin()) {
-        debugLog("[SENSOR] AHT20 detected!\n");
+        LOG_INFO(SENSOR, "AHT20 detected!\n");
         return SENSOR_AHT20;
     }
     
     // Try SHT45 (I2C address 0x44)
-    debugLog("[SENSOR] Checking for SHT45 at I2C address 0x44...\n");
+    LOG_DEBUG(SENSOR, "Checking for SHT45 at I2C address 0x44...\n");
     if (sht45.begin(&Wire)) {
-        debugLog("[SENSOR] SHT45 detected!\n");
+        LOG_INFO(SENSOR, "SHT45 detected!\n");
         return SENSOR_SHT45;
     }
     
     // Try BME280 (I2C addresses 0x76 or 0x77)
-    debugLog("[SENSOR] Checking for BME280 at I2C address 0x76...\n");
+    LOG_DEBUG(SENSOR, "Checking for BME280 at I2C address 0x76...\n");
     if (bme.begin(0x76)) {
-        debugLog("[SENSOR] BME280 detected at address 0x76!\n");
+        LOG_INFO(SENSOR, "BME280 detected at address 0x76!\n");
         return SENSOR_BME280;
     }
     
-    debugLog("[SENSOR] Checking for BME280 at I2C address 0x77...\n");
+    LOG_DEBUG(SENSOR, "Checking for BME280 at I2C address 0x77...\n");
     if (bme.begin(0x77)) {
-        debugLog("[SENSOR] BME280 detected at address 0x77!\n");
+        LOG_INFO(SENSOR, "BME280 detected at address 0x77!\n");
         return SENSOR_BME280;
     }
     
     // No I2C sensor found, try DHT11 on GPIO35
-    debugLog("[SENSOR] No I2C sensors found, trying DHT11...\n");
-    debugLog("[SENSOR] Disabling I2C, switching GPIO35 to DHT11 mode...\n");
+    LOG_INFO(SENSOR, "No I2C sensors found, trying DHT11...\n");
+    LOG_INFO(SENSOR, "Disabling I2C, switching GPIO35 to DHT11 mode...\n");
     Wire.end();
     pinMode(I2C_SCL_PIN, INPUT_PULLUP); // Configure GPIO35 as regular GPIO
     dht.begin();
@@ -750,17 +727,17 @@ SensorType detectSensor() {
     float testHum = dht.readHumidity();
     
     if (!isnan(testTemp) && !isnan(testHum)) {
-        debugLog("[SENSOR] DHT11 detected!\n");
+        LOG_INFO(SENSOR, "DHT11 detected!\n");
         return SENSOR_DHT11;
     }
     
-    debugLog("[SENSOR] ERROR: No temperature/humidity sensor detected!\n");
+    LOG_ERROR(SENSOR, "No temperature/humidity sensor detected!\n");
     return SENSOR_NONE;
 }
 
 // Initialize the detected sensor
 bool initializeSensor(SensorType sensor) {
-    debugLog("[SENSOR] Initializing %s sensor...\n", 
+    LOG_INFO(SENSOR, "Initializing %s sensor...\n", 
                   sensor == SENSOR_AHT20 ? "AHT20" : 
                   sensor == SENSOR_DHT11 ? "DHT11" : 
                   sensor == SENSOR_BME280 ? "BME280" :
@@ -771,11 +748,11 @@ bool initializeSensor(SensorType sensor) {
         case SENSOR_AHT20:
             Wire.begin(I2C_SDA_PIN, I2C_SCL_PIN);
             if (aht.begin()) {
-                debugLog("[SENSOR] AHT20 initialized successfully\n");
+                LOG_INFO(SENSOR, "AHT20 initialized successfully\n");
                 sensorName = "AHT20";
                 return true;
             }
-            debugLog("[SENSOR] AHT20 initialization failed\n");
+            LOG_WARN(SENSOR, "AHT20 initialization failed\n");
             return false;
             
         case SENSOR_DHT11:
@@ -783,7 +760,7 @@ bool initializeSensor(SensorType sensor) {
             pinMode(I2C_SCL_PIN, INPUT_PULLUP);
             dht.begin();
             delay(2000);
-            debugLog("[SENSOR] DHT11 initialized successfully\n");
+            LOG_INFO(SENSOR, "DHT11 initialized successfully\n");
             sensorName = "DHT11";
             return true;
             
@@ -797,11 +774,11 @@ bool initializeSensor(SensorType sensor) {
                                Adafruit_BME280::SAMPLING_X1,  // humidity
                                Adafruit_BME280::FILTER_X16,
                                Adafruit_BME280::STANDBY_MS_500);
-                debugLog("[SENSOR] BME280 initialized successfully\n");
+                LOG_INFO(SENSOR, "BME280 initialized successfully\n");
                 sensorName = "BME280";
                 return true;
             }
-            debugLog("[SENSOR] BME280 initialization failed\n");
+            LOG_WARN(SENSOR, "BME280 initialization failed\n");
             return false;
             
         case SENSOR_BME680:
@@ -813,11 +790,11 @@ bool initializeSensor(SensorType sensor) {
                 bme680.setPressureOversampling(BME680_OS_4X);
                 bme680.setIIRFilterSize(BME680_FILTER_SIZE_3);
                 bme680.setGasHeater(320, 150); // 320°C heater temp, 150ms heating duration
-                debugLog("[SENSOR] BME680 initialized successfully\n");
+                LOG_INFO(SENSOR, "BME680 initialized successfully\n");
                 sensorName = "BME680";
                 return true;
             }
-            debugLog("[SENSOR] BME680 initialization failed\n");
+            LOG_WARN(SENSOR, "BME680 initialization failed\n");
             return false;
             
         case SENSOR_SHT45:
@@ -825,11 +802,11 @@ bool initializeSensor(SensorType sensor) {
             if (sht45.begin(&Wire)) {
                 sht45.setPrecision(SHT4X_HIGH_PRECISION);
                 sht45.setHeater(SHT4X_NO_HEATER);
-                debugLog("[SENSOR] SHT45 initialized successfully\n");
+                LOG_INFO(SENSOR, "SHT45 initialized successfully\n");
                 sensorName = "SHT45";
                 return true;
             }
-            debugLog("[SENSOR] SHT45 initialization failed\n");
+            LOG_WARN(SENSOR, "SHT45 initialization failed\n");
             return false;
     }
 }
@@ -937,106 +914,8 @@ bool readTemperatureHumidity(float &temp, float &humidity, float &pressure) {
 // =============================================================================
 // SCHEDULING SYSTEM FUNCTIONS
 // =============================================================================
-
-// Get current day of week (0 = Sunday, 1 = Monday, ..., 6 = Saturday)
-int getCurrentDayOfWeek() {
-    time_t now;
-    struct tm timeinfo;
-    time(&now);
-    localtime_r(&now, &timeinfo);
-    return timeinfo.tm_wday;
-}
-
-// Get current period description
-String getCurrentPeriod() {
-    if (!scheduleEnabled) return "manual";
-    if (scheduleOverride) return "override";
-    return activePeriod;
-}
-
-// Check if we need to apply a scheduled temperature change
-void checkSchedule() {
-    if (!scheduleEnabled) return;
-    
-    // Ensure timezone is applied
-    tzset();
-    
-    // Get current time
-    time_t now;
-    struct tm timeinfo;
-    time(&now);
-    localtime_r(&now, &timeinfo);
-    
-    int currentHour = timeinfo.tm_hour;
-    int currentMinute = timeinfo.tm_min;
-    int currentDayOfWeek = timeinfo.tm_wday;
-    
-    // Debug: Log current time and schedule status
-    static unsigned long lastDebugLog = 0;
-    if (millis() - lastDebugLog > 60000) { // Log every 60 seconds
-        debugLog("SCHEDULE DEBUG: Current time: %02d:%02d (day %d), TZ: %s, Period: %s\n", 
-                 currentHour, currentMinute, currentDayOfWeek, timeZone.c_str(), activePeriod.c_str());
-        lastDebugLog = millis();
-    }
-    bool overrideExpired = false;
-    
-    // Check if override has expired
-    if (scheduleOverride && overrideEndTime > 0 && millis() >= overrideEndTime) {
-        scheduleOverride = false;
-        overrideEndTime = 0;
-        overrideExpired = true;
-        debugLog("SCHEDULE: Override expired, resuming schedule\n");
-    }
-    
-    // Skip if override is active
-    if (scheduleOverride) return;
-    
-    // Skip if this day is not enabled
-    if (!weekSchedule[currentDayOfWeek].enabled) return;
-    
-    DaySchedule& today = weekSchedule[currentDayOfWeek];
-    
-    // Convert current time to minutes for easier comparison
-    int currentMinutes = currentHour * 60 + currentMinute;
-    int dayMinutes = today.day.hour * 60 + today.day.minute;
-    int nightMinutes = today.night.hour * 60 + today.night.minute;
-    
-    // Determine which period we should be in
-    String newPeriod = "manual";
-    bool shouldApplyDaySchedule = false;
-    bool shouldApplyNightSchedule = false;
-    
-    if (dayMinutes <= nightMinutes) {
-        // Normal case: day < night (e.g., 6:00 AM - 10:00 PM)
-        if (currentMinutes >= dayMinutes && currentMinutes < nightMinutes) {
-            newPeriod = "day";
-            shouldApplyDaySchedule = true;
-        } else {
-            newPeriod = "night";
-            shouldApplyNightSchedule = true;
-        }
-    } else {
-        // Cross-midnight case: night < day (e.g., 10:00 PM - 6:00 AM next day)
-        if (currentMinutes >= dayMinutes || currentMinutes < nightMinutes) {
-            newPeriod = "day";
-            shouldApplyDaySchedule = true;
-        } else {
-            newPeriod = "night";
-            shouldApplyNightSchedule = true;
-        }
-    }
-    
-    // Apply schedule if period changed or an override just ended
-    bool shouldApplySchedule = overrideExpired || (newPeriod != activePeriod);
-    if (shouldApplySchedule) {
-        activePeriod = newPeriod;
-        if (shouldApplyDaySchedule && today.day.active) {
-            applySchedule(currentDayOfWeek, true);
-        } else if (shouldApplyNightSchedule && today.night.active) {
-            applySchedule(currentDayOfWeek, false);
-        }
-    }
-}
+// Period evaluation (checkSchedule) lives in HvacControl.cpp; applying and
+// persisting the schedule needs NVS/MQTT/display and stays here.
 
 // Apply scheduled temperatures
 void applySchedule(int dayOfWeek, bool isDayPeriod) {
@@ -1050,15 +929,15 @@ void applySchedule(int dayOfWeek, bool isDayPeriod) {
     setTempCool = period.coolTemp;
     setTempAuto = period.autoTemp;
     
-    debugLog("SCHEDULE: Applied %s schedule for day %d - Heat: %.1f°F, Cool: %.1f°F, Auto: %.1f°F\n", 
+    LOG_INFO(SCHEDULE, "Applied %s schedule for day %d - Heat: %.1f°F, Cool: %.1f°F, Auto: %.1f°F\n", 
                   isDayPeriod ? "day" : "night", dayOfWeek, setTempHeat, setTempCool, setTempAuto);
     
     // Save settings and update MQTT
-    saveSettings();
-    if (mqttEnabled && mqttClient.connected()) {
-        mqttClient.publish("thermostat/setTempHeat", String(setTempHeat).c_str(), true);
-        mqttClient.publish("thermostat/setTempCool", String(setTempCool).c_str(), true);
-        mqttClient.publish("thermostat/activePeriod", activePeriod.c_str(), false);
+    settingsMarkDirty(SETTINGS_DIRTY_SETTINGS, NVS_WRITER_SCHEDULE);
+    if (mqttEnabled && mqttConnected) {
+        mqttQueuePublish(MQTT_TOPIC_LEGACY_SET_TEMP_HEAT, String(setTempHeat).c_str(), true);
+        mqttQueuePublish(MQTT_TOPIC_LEGACY_SET_TEMP_COOL, String(setTempCool).c_str(), true);
+        mqttQueuePublish(MQTT_TOPIC_LEGACY_ACTIVE_PERIOD, activePeriod.c_str(), false);
     }
     
     // Update TFT display to show new scheduled temperature
@@ -1068,217 +947,82 @@ void applySchedule(int dayOfWeek, bool isDayPeriod) {
     setDisplayUpdateFlag();
 }
 
-// Save schedule settings to preferences
-void saveScheduleSettings() {
-    // Acquire mutex for atomic save operation (dual-core safety)
-    if (nvsSaveMutex == NULL || xSemaphoreTake(nvsSaveMutex, pdMS_TO_TICKS(5000)) != pdTRUE) {
-        debugLog("ERROR: saveScheduleSettings() timed out waiting for NVS mutex\n");
-        return;
-    }
-    
-    debugLog("SCHEDULE: Starting atomic save operation...\n");
-    unsigned long saveStartTime = millis();
-    
-    preferences.putBool("schedEnabled", scheduleEnabled);
-    preferences.putBool("schedOverride", scheduleOverride);
-    preferences.putULong("overrideEnd", overrideEndTime);
-    preferences.putString("activePeriod", activePeriod);
-    
-    // Save each day's schedule
-    for (int day = 0; day < 7; day++) {
-        String dayPrefix = "day" + String(day) + "_";
-        
-        preferences.putBool((dayPrefix + "enabled").c_str(), weekSchedule[day].enabled);
-        
-        // Day period
-        preferences.putInt((dayPrefix + "d_hour").c_str(), weekSchedule[day].day.hour);
-        preferences.putInt((dayPrefix + "d_min").c_str(), weekSchedule[day].day.minute);
-        preferences.putFloat((dayPrefix + "d_heat").c_str(), weekSchedule[day].day.heatTemp);
-        preferences.putFloat((dayPrefix + "d_cool").c_str(), weekSchedule[day].day.coolTemp);
-        preferences.putFloat((dayPrefix + "d_auto").c_str(), weekSchedule[day].day.autoTemp);
-        preferences.putBool((dayPrefix + "d_active").c_str(), weekSchedule[day].day.active);
-        
-        // Night period
-        preferences.putInt((dayPrefix + "n_hour").c_str(), weekSchedule[day].night.hour);
-        preferences.putInt((dayPrefix + "n_min").c_str(), weekSchedule[day].night.minute);
-        preferences.putFloat((dayPrefix + "n_heat").c_str(), weekSchedule[day].night.heatTemp);
-        preferences.putFloat((dayPrefix + "n_cool").c_str(), weekSchedule[day].night.coolTemp);
-        preferences.putFloat((dayPrefix + "n_auto").c_str(), weekSchedule[day].night.autoTemp);
-        preferences.putBool((dayPrefix + "n_active").c_str(), weekSchedule[day].night.active);
-    }
-    
-    // Verify critical schedule settings were saved
-    bool verifySuccess = true;
-    bool verifySched = preferences.getBool("schedEnabled", !scheduleEnabled);
-    
-    if (verifySched != scheduleEnabled) {
-        verifySuccess = false;
-        debugLog("ERROR: Schedule verification FAILED—save may not have persisted!\n");
-    } else {
-        debugLog("SCHEDULE: Verification SUCCESS—schedule data confirmed in NVS\n");
-    }
-    
-    unsigned long saveDuration = millis() - saveStartTime;
-    debugLog("SCHEDULE: Atomic save completed in %lu ms (status=%s)\n", 
-             saveDuration, verifySuccess ? "OK" : "FAILED");
-    
-    // Release mutex
-    xSemaphoreGive(nvsSaveMutex);
-}
-
-// Load schedule settings from preferences
-void loadScheduleSettings() {
-    auto getOrInitBool = [&](const char* key, bool def) -> bool {
-        if (!preferences.isKey(key)) {
-            preferences.putBool(key, def);
-            return def;
-        }
-        return preferences.getBool(key, def);
-    };
-    auto getOrInitULong = [&](const char* key, unsigned long def) -> unsigned long {
-        if (!preferences.isKey(key)) {
-            preferences.putULong(key, def);
-            return def;
-        }
-        return preferences.getULong(key, def);
-    };
-    auto getOrInitString = [&](const char* key, const char* def) -> String {
-        if (!preferences.isKey(key)) {
-            preferences.putString(key, def);
-            return String(def);
-        }
-        return preferences.getString(key, def);
-    };
-
-    scheduleEnabled = getOrInitBool("schedEnabled", false);
-    scheduleOverride = getOrInitBool("schedOverride", false);
-    overrideEndTime = getOrInitULong("overrideEnd", 0);
-    activePeriod = getOrInitString("activePeriod", "manual");
-    
-    // If override was active before reboot, clear it since overrideEndTime is stale
-    // (millis() resets to 0 after each reboot, making the stored endTime unreliable)
-    if (scheduleOverride && overrideEndTime > 0) {
-        debugLog("SCHEDULE: Clearing stale override from previous boot\n");
-        scheduleOverride = false;
-        overrideEndTime = 0;
-    }
-    
-    // Check if schedule data exists, if not initialize defaults silently
-    bool scheduleExists = preferences.isKey("day0_d_heat");
-    if (!scheduleExists) {
-        debugLog("SCHEDULE: First boot detected, initializing default schedule data...\n");
-        saveScheduleSettings(); // Save the compiled-in defaults to NVS
-        return; // Skip the individual loading since we just saved defaults
-    }
-    
-    // Load each day's schedule with defaults
-    for (int day = 0; day < 7; day++) {
-        String dayPrefix = "day" + String(day) + "_";
-        
-        weekSchedule[day].enabled = preferences.getBool((dayPrefix + "enabled").c_str(), true);
-        
-        // Day period defaults (6:00 AM, 72°F heat, 76°F cool)
-        weekSchedule[day].day.hour = preferences.getInt((dayPrefix + "d_hour").c_str(), 6);
-        weekSchedule[day].day.minute = preferences.getInt((dayPrefix + "d_min").c_str(), 0);
-        weekSchedule[day].day.heatTemp = preferences.getFloat((dayPrefix + "d_heat").c_str(), 72.0);
-        weekSchedule[day].day.coolTemp = preferences.getFloat((dayPrefix + "d_cool").c_str(), 76.0);
-        weekSchedule[day].day.autoTemp = preferences.getFloat((dayPrefix + "d_auto").c_str(), 74.0);
-        weekSchedule[day].day.active = preferences.getBool((dayPrefix + "d_active").c_str(), true);
-        
-        // Night period defaults (10:00 PM, 68°F heat, 78°F cool)
-        weekSchedule[day].night.hour = preferences.getInt((dayPrefix + "n_hour").c_str(), 22);
-        weekSchedule[day].night.minute = preferences.getInt((dayPrefix + "n_min").c_str(), 0);
-        weekSchedule[day].night.heatTemp = preferences.getFloat((dayPrefix + "n_heat").c_str(), 68.0);
-        weekSchedule[day].night.coolTemp = preferences.getFloat((dayPrefix + "n_cool").c_str(), 78.0);
-        weekSchedule[day].night.autoTemp = preferences.getFloat((dayPrefix + "n_auto").c_str(), 73.0);
-        weekSchedule[day].night.active = preferences.getBool((dayPrefix + "n_active").c_str(), true);
+// Write deferred settings/schedule changes once they are due (loop()), or
+// everything pending right away before a restart
+void flushSettings(bool force)
+{
+    // Settings and schedule are one blob, so either bit means one save
+    if (settingsFlushDue(millis(), force) != 0) {
+        saveSettings(settingsDirtyWriters());
     }
-    
-    debugLog("SCHEDULE: Settings loaded - Enabled: %s, Override: %s, Active Period: %s\n",
-                  scheduleEnabled ? "YES" : "NO", 
-                  scheduleOverride ? "YES" : "NO",
-                  activePeriod.c_str());
 }
 
 // =============================================================================
-// DEBUG LOG BUFFER - For web-based serial output viewing
+// DEBUG LOG - ring buffer for web-based serial output viewing lives in DebugLog.cpp
 // =============================================================================
-const int DEBUG_BUFFER_SIZE = 65536;  // 64KB circular buffer for more history
-char debugBuffer[DEBUG_BUFFER_SIZE];
-int debugBufferIndex = 0;
-bool debugBufferWrapped = false;  // Track if buffer has wrapped around
-SemaphoreHandle_t debugBufferMutex = NULL;
 
-void addToDebugBuffer(const char* message) {
-    bool haveLock = false;
-    if (debugBufferMutex != NULL) {
-        haveLock = (xSemaphoreTake(debugBufferMutex, portMAX_DELAY) == pdTRUE);
-    }
-    
-    int len = strlen(message);
-    if (len > DEBUG_BUFFER_SIZE) len = DEBUG_BUFFER_SIZE;
-    
-    // Write to circular buffer
-    for (int i = 0; i < len; i++) {
-        debugBuffer[debugBufferIndex] = message[i];
-        debugBufferIndex = (debugBufferIndex + 1) % DEBUG_BUFFER_SIZE;
-        if (debugBufferIndex == 0) {
-            debugBufferWrapped = true;  // We've wrapped around
-        }
-    }
-    
-    if (haveLock) {
-        xSemaphoreGive(debugBufferMutex);
+// Unified logging function for both Serial and debug buffer. The ring copy
+// keeps the raw arguments; text is only produced when /debug or the serial
+// drain task reads it.
+void debugLog(const char* format, ...) {
+    char buffer[DEBUG_LINE_MAX];
+    bool formatted = false;
+    bool stored = false;
+    va_list args;
+    va_start(args, format);
+#if DEBUG_LOG_SERIAL_ECHO == 2
+    va_list serialArgs;
+    va_copy(serialArgs, args);
+    vsnprintf(buffer, sizeof(buffer), format, serialArgs);
+    va_end(serialArgs);
+    Serial.print(buffer);
+    formatted = true;
+#endif
+#if DEBUG_LOG_BINARY
+    va_list ringArgs;
+    va_copy(ringArgs, args);
+    stored = addFormatToDebugBuffer(format, ringArgs);
+    va_end(ringArgs);
+#endif
+    if (!stored) {
+        // Conversion the binary encoder can't capture: store the text
+        if (!formatted) vsnprintf(buffer, sizeof(buffer), format, args);
+        addToDebugBuffer(buffer);
     }
+    va_end(args);
 }
 
-String getDebugLog() {
-    String result = "";
-    bool haveLock = false;
-    if (debugBufferMutex != NULL) {
-        haveLock = (xSemaphoreTake(debugBufferMutex, portMAX_DELAY) == pdTRUE);
-    }
-    
-    // Return only valid bytes in chronological order.
-    int count = debugBufferWrapped ? DEBUG_BUFFER_SIZE : debugBufferIndex;
-    int startIdx = debugBufferWrapped ? debugBufferIndex : 0;
+#if DEBUG_LOG_SERIAL_ECHO == 1
+// Serial drain: copies new ring records to the UART from its own task, so a
+// full TX FIFO stalls this task instead of whoever called debugLog(). If it
+// falls more than a ring behind, the lost span is counted and marked.
+TaskHandle_t serialLogTask = NULL;
+static DebugLogCursor serialLogCursor; // ~1KB, kept off the task stack
+volatile uint32_t serialLogGaps = 0;
+volatile uint32_t serialLogLostBytes = 0;
 
-    // When the circular buffer has wrapped, the oldest byte may be in the middle
-    // of a log line. Advance to the next newline so the served log starts cleanly.
-    if (debugBufferWrapped && count > 0) {
-        int trim = 0;
-        while (trim < count && debugBuffer[(startIdx + trim) % DEBUG_BUFFER_SIZE] != '\n') {
-            trim++;
-        }
-        if (trim < count) {
-            trim++; // skip the newline itself
-            startIdx = (startIdx + trim) % DEBUG_BUFFER_SIZE;
-            count -= trim;
+void serialLogTaskFunction(void* parameter)
+{
+    uint32_t since = 0;
+    char chunk[128];
+    for (;;) {
+        debugLogCursorSeek(serialLogCursor, since);
+        bool announced = false;
+        size_t n;
+        while ((n = debugLogRead(serialLogCursor, chunk, sizeof(chunk))) > 0) {
+            if (serialLogCursor.lapped && !announced) {
+                Serial.print("\n[serial log fell behind, lines skipped]\n");
+                announced = true;
+            }
+            Serial.write((const uint8_t*)chunk, n);
         }
+        if (serialLogCursor.lapped) serialLogGaps++;
+        serialLogLostBytes += serialLogCursor.skipped;
+        since = serialLogCursor.pos;
+        vTaskDelay(pdMS_TO_TICKS(10));
     }
-
-    result.reserve(count + 16);
-    for (int i = 0; i < count; i++) {
-        int idx = (startIdx + i) % DEBUG_BUFFER_SIZE;
-        result += debugBuffer[idx];
-    }
-    
-    if (haveLock) {
-        xSemaphoreGive(debugBufferMutex);
-    }
-    return result;
-}
-
-// Unified logging function for both Serial and debug buffer
-void debugLog(const char* format, ...) {
-    char buffer[256];
-    va_list args;
-    va_start(args, format);
-    vsnprintf(buffer, sizeof(buffer), format, args);
-    va_end(args);
-    Serial.print(buffer);
-    addToDebugBuffer(buffer);
 }
+#endif
 
 void setup()
 {
@@ -1307,21 +1051,28 @@ void setup()
     
     Serial.begin(115200);
     delay(100);  // Allow serial and GPIO41 to stabilize after USB JTAG disable
+
+    // Take the previous boot's trace out of RTC memory before anything records
+    postMortemBegin();
+
+#if DEBUG_LOG_SERIAL_ECHO == 1
+    // Lowest application priority; starts from the oldest ring record, so
+    // nothing logged before this point is missed
+    xTaskCreatePinnedToCore(
+        serialLogTaskFunction,  // Task function
+        "SerialLogTask",       // Name
+        3072,                  // Stack size (records are decoded into a static cursor)
+        NULL,                  // Parameters
+        1,                     // Priority (lowest used by the firmware)
+        &serialLogTask,        // Task handle
+        0                      // Core 0 (keeps UART waits off the control core)
+    );
+#endif
     
-    // Initialize debug buffer with zeros and mutex
-    memset(debugBuffer, 0, DEBUG_BUFFER_SIZE);
-    debugBufferIndex = 0;
-    debugBufferWrapped = false;
-    
-    // Initialize debug buffer mutex
-    debugBufferMutex = xSemaphoreCreateMutex();
-    if (debugBufferMutex == NULL) {
-        debugLog("ERROR: Failed to create debug buffer mutex!\n");
-    } else {
-        debugLog("Debug buffer mutex created successfully\n");
-        // Add initial message to buffer
-        addToDebugBuffer("=== DEBUG BUFFER INITIALIZED ===\n");
-    }
+    // Debug log ring is lock-free and zero-initialised, nothing to create
+    addToDebugBuffer("=== DEBUG BUFFER INITIALIZED ===\n");
+    LOG_INFO(SYSTEM, "Reset reason: %s%s\n", postMortemResetReason(),
+             postMortemAvailable() ? " (previous boot trace at /api/postmortem)" : "");
 
     // Initialize Preferences
     preferences.begin("thermostat", false);
@@ -1329,11 +1080,16 @@ void setup()
     // Create NVS save semaphore for dual-core safety
     nvsSaveMutex = xSemaphoreCreateMutex();
     if (nvsSaveMutex == NULL) {
-        debugLog("ERROR: Failed to create NVS save mutex!\n");
+        LOG_ERROR(SYSTEM, "Failed to create NVS save mutex!\n");
     }
+    settingsStoreBegin(preferences);
+    nvsWearBegin();
+    settingsRegistryBegin();
     
     loadSettings();
-    loadScheduleSettings();
+    telemetrySetSpill(mqttHistoryFlash);
+    mqttConfigMutex = xSemaphoreCreateMutex();
+    mqttConfigPublish(); // Before the web server and the MQTT task start
 
     
     // Print version information at startup
@@ -1369,33 +1125,33 @@ void setup()
     // Test LD2410 connection
     ld2410Connected = testLD2410Connection();
     if (ld2410Connected) {
-        debugLog("LD2410: Motion sensor connected successfully\n");
+        LOG_INFO(MOTION, "Motion sensor connected successfully\n");
         // Configure with conservative settings matching original hardware
         configureLD2410Sensitivity();
     } else {
-        debugLog("LD2410: Motion sensor not detected - display control via touch only\n");
+        LOG_INFO(MOTION, "Motion sensor not detected - display control via touch only\n");
     }
     
     // Create I2C mutex BEFORE initializing I2C bus and devices
     i2cMutex = xSemaphoreCreateMutex();
     if (i2cMutex == NULL) {
-        debugLog("ERROR: Failed to create I2C mutex!\n");
+        LOG_ERROR(SENSOR, "Failed to create I2C mutex!\n");
     } else {
-        debugLog("I2C mutex created successfully\n");
+        LOG_DEBUG(SENSOR, "I2C mutex created successfully\n");
     }
     
     // Auto-detect and initialize temperature/humidity sensor
     activeSensor = detectSensor();
     if (activeSensor != SENSOR_NONE) {
         if (!initializeSensor(activeSensor)) {
-            debugLog("ERROR: Sensor initialization failed!\n");
+            LOG_ERROR(SENSOR, "Sensor initialization failed!\n");
             activeSensor = SENSOR_NONE;
             sensorName = "None";
         } else {
-            debugLog("SUCCESS: %s sensor ready\n", sensorName.c_str());
+            LOG_INFO(SENSOR, "%s sensor ready\n", sensorName.c_str());
         }
     } else {
-        debugLog("ERROR: No temperature/humidity sensor detected!\n");
+        LOG_ERROR(SENSOR, "No temperature/humidity sensor detected!\n");
     }
 
     // Initialize the TFT display
@@ -1459,18 +1215,14 @@ void setup()
     // This must be done before any WiFi operations (even WiFi.status() calls in loop)
     WiFi.mode(WIFI_STA);
     
-    // Load WiFi credentials but don't force connection
-    wifiSSID = preferences.getString("wifiSSID", "");
-    wifiPassword = preferences.getString("wifiPassword", "");
-    
     // Set hostname using ESP-IDF method (Arduino WiFi.setHostname has bugs)
     esp_netif_t* sta_netif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
     if (sta_netif != nullptr) {
         esp_err_t err = esp_netif_set_hostname(sta_netif, hostname.c_str());
         if (err != ESP_OK) {
-            debugLog("[WIFI] Failed to set hostname: %d\n", err);
+            LOG_WARN(WIFI, "Failed to set hostname: %d\n", err);
         } else {
-            debugLog("[WIFI] Hostname set to: %s\n", hostname.c_str());
+            LOG_INFO(WIFI, "Hostname set to: %s\n", hostname.c_str());
         }
     }
     WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE); // Force DHCP to send hostname
@@ -1483,11 +1235,11 @@ void setup()
     {
         WiFi.setAutoReconnect(true);
         WiFi.begin(wifiSSID.c_str(), wifiPassword.c_str());
-        debugLog("[WIFI] Connection attempt started (non-blocking)\n");
+        LOG_INFO(WIFI, "Connection attempt started (non-blocking)\n");
     }
     else
     {
-        debugLog("No WiFi credentials found. Operating in offline mode.\n");
+        LOG_INFO(WIFI, "No WiFi credentials found. Operating in offline mode.\n");
     }
 
     // Initialize web server/routes at boot so services are ready when WiFi appears later
@@ -1499,6 +1251,8 @@ void setup()
     {
         setupMQTT();
     }
+    mqttQueueBegin();
+    mqttCommandQueue = xQueueCreate(4, sizeof(MqttInbound));
 
     // Initialize weather module regardless of initial WiFi state
     weather.begin();
@@ -1507,15 +1261,15 @@ void setup()
     weather.setOpenWeatherMapConfig(owmApiKey, owmCity, owmState, owmCountry);
     weather.setHomeAssistantConfig(haUrl, haToken, haEntityId);
     weather.setUpdateInterval(weatherUpdateInterval * 60000); // Convert minutes to milliseconds
-    debugLog("Weather module initialized\n");
-    debugLog("Weather Source: %d (0=Disabled, 1=OpenWeatherMap, 2=HomeAssistant)\n", weatherSource);
-    debugLog("Weather Update Interval: %d minutes\n", weatherUpdateInterval);
+    LOG_INFO(WEATHER, "Weather module initialized\n");
+    LOG_DEBUG(WEATHER, "Weather Source: %d (0=Disabled, 1=OpenWeatherMap, 2=HomeAssistant)\n", weatherSource);
+    LOG_DEBUG(WEATHER, "Weather Update Interval: %d minutes\n", weatherUpdateInterval);
     if (weatherSource == 1) {
-        debugLog("OpenWeatherMap: City=%s, State=%s, Country=%s, API Key=%s\n",
+        LOG_DEBUG(WEATHER, "OpenWeatherMap: City=%s, State=%s, Country=%s, API Key=%s\n",
                      owmCity.c_str(), owmState.c_str(), owmCountry.c_str(),
                      owmApiKey.length() > 0 ? "[SET]" : "[NOT SET]");
     } else if (weatherSource == 2) {
-        debugLog("Home Assistant: URL=%s, Entity=%s, Token=%s\n",
+        LOG_DEBUG(WEATHER, "Home Assistant: URL=%s, Entity=%s, Token=%s\n",
                      haUrl.c_str(), haEntityId.c_str(),
                      haToken.length() > 0 ? "[SET]" : "[NOT SET]");
     }
@@ -1538,11 +1292,11 @@ void setup()
 
         // Fetch initial weather data when WiFi is already available at boot
         if (weatherSource != 0) {
-            debugLog("Fetching initial weather data...\n");
+            LOG_INFO(WEATHER, "Fetching initial weather data...\n");
             bool success = weather.update();
-            debugLog("Initial weather fetch: %s\n", success ? "SUCCESS" : "FAILED");
+            LOG_INFO(WEATHER, "Initial weather fetch: %s\n", success ? "SUCCESS" : "FAILED");
             if (!success) {
-                debugLog("Weather error: %s\n", weather.getLastError().c_str());
+                LOG_WARN(WEATHER, "Initial fetch error: %s\n", weather.getLastError().c_str());
             }
         }
     }
@@ -1560,12 +1314,12 @@ void setup()
         // Store pressure if BME280 detected
         if (activeSensor == SENSOR_BME280 && !isnan(pressureReading)) {
             currentPressure = pressureReading;
-            debugLog("Initial pressure reading: %.1f hPa\n", currentPressure);
+            LOG_INFO(SENSOR, "Initial pressure reading: %.1f hPa\n", currentPressure);
         }
         
-        debugLog("Initial readings - Temp: %.1f, Humidity: %.1f%%\n", currentTemp, currentHumidity);
+        LOG_INFO(SENSOR, "Initial readings - Temp: %.1f, Humidity: %.1f%%\n", currentTemp, currentHumidity);
     } else {
-        debugLog("WARNING: Failed to get initial sensor reading\n");
+        LOG_WARN(SENSOR, "Failed to get initial sensor reading\n");
         // Use fallback values
         currentTemp = 72.0;
         currentHumidity = 50.0;
@@ -1583,15 +1337,15 @@ void setup()
     lastInteractionTime = millis();
 
     // Initialize the DS18B20 sensor (GPIO41 USB JTAG already disabled at start of setup)
-    debugLog("Initializing DS18B20 sensors on GPIO%d...\n", ONEWIRE_PIN);
+    LOG_INFO(SENSOR, "Initializing DS18B20 sensors on GPIO%d...\n", ONEWIRE_PIN);
     
     // Verify GPIO41 is now high after USB JTAG disable
     int pinStateAfterConfig = gpio_get_level((gpio_num_t)ONEWIRE_PIN);
-    debugLog("GPIO%d level after USB JTAG disable: %d (should be 1 with pullup)\n", ONEWIRE_PIN, pinStateAfterConfig);
+    LOG_DEBUG(SENSOR, "GPIO%d level after USB JTAG disable: %d (should be 1 with pullup)\n", ONEWIRE_PIN, pinStateAfterConfig);
     
     if (pinStateAfterConfig == 0) {
-        debugLog("ERROR: GPIO%d still LOW after USB JTAG disable!\n", ONEWIRE_PIN);
-        debugLog("Hardware issue or USB peripheral still active.\n");
+        LOG_ERROR(SENSOR, "GPIO%d still LOW after USB JTAG disable!\n", ONEWIRE_PIN);
+        LOG_ERROR(SENSOR, "Hardware issue or USB peripheral still active.\n");
     }
     
     // Test OneWire bus by doing a manual reset pulse
@@ -1601,19 +1355,19 @@ void setup()
     gpio_set_direction((gpio_num_t)ONEWIRE_PIN, GPIO_MODE_INPUT);  // Release bus for presence pulse
     delayMicroseconds(70);
     int presence = gpio_get_level((gpio_num_t)ONEWIRE_PIN);
-    debugLog("OneWire bus reset test: presence = %d (0=device present, 1=no device)\n", presence);
+    LOG_DEBUG(SENSOR, "OneWire bus reset test: presence = %d (0=device present, 1=no device)\n", presence);
     gpio_set_direction((gpio_num_t)ONEWIRE_PIN, GPIO_MODE_INPUT_OUTPUT_OD);  // Restore open-drain mode
     delay(50);
     
     // NOW create OneWire and DallasTemperature objects AFTER GPIO configuration
     // This is critical - creating them before GPIO41 reconfiguration corrupts their state
-    debugLog("Creating OneWire objects AFTER GPIO41 configuration...\n");
+    LOG_DEBUG(SENSOR, "Creating OneWire objects AFTER GPIO41 configuration...\n");
     
     oneWire = new OneWire(ONEWIRE_PIN);
     
     // CRITICAL: OneWire's begin() method calls pinMode() which may re-enable USB JTAG!
     // Force GPIO41 back to open-drain mode AFTER OneWire initialization
-    debugLog("Re-forcing GPIO41 configuration after OneWire::begin()...\n");
+    LOG_DEBUG(SENSOR, "Re-forcing GPIO41 configuration after OneWire::begin()...\n");
     esp_rom_gpio_pad_select_gpio(ONEWIRE_PIN);
     PIN_FUNC_SELECT(GPIO_PIN_MUX_REG[ONEWIRE_PIN], PIN_FUNC_GPIO);
     gpio_set_direction((gpio_num_t)ONEWIRE_PIN, GPIO_MODE_INPUT_OUTPUT_OD);
@@ -1624,12 +1378,12 @@ void setup()
     
     // Verify GPIO41 is STILL high after OneWire initialization
     int pinStateAfterOneWire = gpio_get_level((gpio_num_t)ONEWIRE_PIN);
-    debugLog("GPIO41 level after OneWire init: %d (should be 1)\n", pinStateAfterOneWire);
+    LOG_DEBUG(SENSOR, "GPIO41 level after OneWire init: %d (should be 1)\n", pinStateAfterOneWire);
     
     delay(100);
     
     // Try manual OneWire device search
-    debugLog("Performing manual OneWire device search...\n");
+    LOG_DEBUG(SENSOR, "Performing manual OneWire device search...\n");
     uint8_t addr[8];
     int manualDeviceCount = 0;
     oneWire->reset_search();
@@ -1637,31 +1391,31 @@ void setup()
     
     // Try multiple search attempts
     for (int attempt = 0; attempt < 5; attempt++) {
-        debugLog("  Search attempt %d...\n", attempt + 1);
+        LOG_DEBUG(SENSOR, "  Search attempt %d...\n", attempt + 1);
         
         // Test reset before each search
         uint8_t resetResult = oneWire->reset();
-        debugLog("    Reset result: %d (should be 1 for device present)\n", resetResult);
+        LOG_DEBUG(SENSOR, "    Reset result: %d (should be 1 for device present)\n", resetResult);
         if (resetResult == 0) {
-            debugLog("    No devices detected on bus (reset failed)\n");
+            LOG_WARN(SENSOR, "No devices detected on bus (reset failed)\n");
             delay(100);
             continue;
         }
         
         if (oneWire->search(addr)) {
             manualDeviceCount++;
-            debugLog("  Device %d ROM: %02X %02X %02X %02X %02X %02X %02X %02X\n",
+            LOG_DEBUG(SENSOR, "  Device %d ROM: %02X %02X %02X %02X %02X %02X %02X %02X\n",
                      manualDeviceCount, addr[0], addr[1], addr[2], addr[3], addr[4], addr[5], addr[6], addr[7]);
             
             // Verify CRC
             if (OneWire::crc8(addr, 7) != addr[7]) {
-                debugLog("    WARNING: CRC invalid!\n");
+                LOG_WARN(SENSOR, "CRC invalid!\n");
             } else {
-                debugLog("    CRC valid\n");
+                LOG_DEBUG(SENSOR, "    CRC valid\n");
                 
                 // Check device family (0x28 = DS18B20)
                 if (addr[0] == 0x28) {
-                    debugLog("    Device is DS18B20\n");
+                    LOG_DEBUG(SENSOR, "    Device is DS18B20\n");
                     if (manualDeviceCount == 1 && !ds18b20Address1Valid) {
                         memcpy(ds18b20Address1, addr, 8);
                         ds18b20Address1Valid = true;
@@ -1670,7 +1424,7 @@ void setup()
                         ds18b20Address2Valid = true;
                     }
                 } else {
-                    debugLog("    Device family code: 0x%02X (not DS18B20)\n", addr[0]);
+                    LOG_DEBUG(SENSOR, "    Device family code: 0x%02X (not DS18B20)\n", addr[0]);
                 }
             }
             delay(10);  // Delay between device discoveries
@@ -1678,7 +1432,7 @@ void setup()
             break;  // No more devices
         }
     }
-    debugLog("Manual search found %d device(s)\n", manualDeviceCount);
+    LOG_INFO(SENSOR, "Manual search found %d device(s)\n", manualDeviceCount);
     
     // Now initialize DallasTemperature library
     ds18b20 = new DallasTemperature(oneWire);
@@ -1689,53 +1443,53 @@ void setup()
     ds18b20->requestTemperatures();
     delay(750);  // Wait for temperature conversion (750ms for 12-bit resolution)
     int ds18b20Count = ds18b20->getDeviceCount();
-    debugLog("DS18B20 device count: %d\n", ds18b20Count);
+    LOG_INFO(SENSOR, "DS18B20 device count: %d\n", ds18b20Count);
     float tempC = ds18b20->getTempCByIndex(0);
     float returnTempC = ds18b20->getTempCByIndex(1);
-    debugLog("DS18B20 readings: Supply=%.1f°C, Return=%.1f°C\n", tempC, returnTempC);
+    LOG_INFO(SENSOR, "DS18B20 readings: Supply=%.1f°C, Return=%.1f°C\n", tempC, returnTempC);
     ds18b20SensorPresent = (ds18b20Count >= 1) && (tempC != DEVICE_DISCONNECTED_C && tempC != -127.0);
     ds18b20ReturnSensorPresent = (ds18b20Count >= 2) && (returnTempC != DEVICE_DISCONNECTED_C && returnTempC != -127.0);
     
     if (ds18b20SensorPresent) {
-        debugLog("DS18B20 supply sensor detected\n");
+        LOG_INFO(SENSOR, "DS18B20 supply sensor detected\n");
     } else {
-        debugLog("DS18B20 supply sensor NOT detected\n");
+        LOG_WARN(SENSOR, "DS18B20 supply sensor NOT detected\n");
     }
     if (ds18b20ReturnSensorPresent) {
-        debugLog("DS18B20 return sensor detected\n");
+        LOG_INFO(SENSOR, "DS18B20 return sensor detected\n");
     } else {
-        debugLog("DS18B20 return sensor NOT detected\n");
+        LOG_WARN(SENSOR, "DS18B20 return sensor NOT detected\n");
     }
     
     // Republish MQTT discovery after DS18B20 initialization
     // (initial discovery happened before sensors were initialized)
-    if (mqttEnabled && mqttClient.connected()) {
-        debugLog("Republishing Home Assistant discovery with DS18B20 sensors...\n");
-        publishHomeAssistantDiscovery();
+    if (mqttEnabled && mqttConnected) {
+        LOG_INFO(SENSOR, "Republishing Home Assistant discovery with DS18B20 sensors...\n");
+        mqttDiscoveryNeeded = true;
     }
     
     // Create all mutexes BEFORE spawning any tasks that use them
     displayUpdateMutex = xSemaphoreCreateMutex();
     if (displayUpdateMutex == NULL) {
-        debugLog("ERROR: Failed to create display update mutex!\n");
+        LOG_ERROR(SYSTEM, "Failed to create display update mutex!\n");
     } else {
-        debugLog("Display update mutex created successfully\n");
+        LOG_DEBUG(SYSTEM, "Display update mutex created successfully\n");
     }
     
     // Create controlRelays mutex for thread-safe relay control
     controlRelaysMutex = xSemaphoreCreateMutex();
     if (controlRelaysMutex == NULL) {
-        debugLog("ERROR: Failed to create controlRelays mutex!\n");
+        LOG_ERROR(SYSTEM, "Failed to create controlRelays mutex!\n");
     } else {
-        debugLog("Control relays mutex created successfully\n");
+        LOG_DEBUG(SYSTEM, "Control relays mutex created successfully\n");
     }
     
     // Create radar sensor mutex for thread-safe sensor access
     radarSensorMutex = xSemaphoreCreateMutex();
     if (radarSensorMutex == NULL) {
-        debugLog("ERROR: Failed to create radar sensor mutex!\n");
+        LOG_ERROR(SENSOR, "Failed to create radar sensor mutex!\n");
     } else {
-        debugLog("Radar sensor mutex created successfully\n");
+        LOG_DEBUG(SENSOR, "Radar sensor mutex created successfully\n");
     }
 
     // Initialize sensor task watchdog timestamp before spawning the task
@@ -1762,12 +1516,24 @@ void setup()
         &displayUpdateTask,       // Task handle
         0                         // Core 0 (same as main display operations)
     );
+
+    // MQTT network task on core 0 next to the WiFi stack. Runs even with MQTT
+    // disabled (it just idles) so enabling it from the web UI takes effect.
+    xTaskCreatePinnedToCore(
+        mqttTaskFunction,  // Task function
+        "MqttTask",       // Name
+        8192,             // Stack size (discovery documents are built on the stack)
+        NULL,             // Parameters
+        1,                // Priority
+        &mqttTask,        // Task handle
+        0                 // Core 0
+    );
     
-    debugLog("Dual-core thermostat with centralized display updates setup complete\n");
-    debugLog("[BOOT] Setup complete - System ready\n");
-    debugLog("[BOOT] Debug console available at /debug\n");
-    debugLog("[BOOT] System Version %s\n", sw_version.c_str());
-    debugLog("[BOOT] Hostname: %s\n", hostname.c_str());
+    LOG_INFO(SYSTEM, "Dual-core thermostat with centralized display updates setup complete\n");
+    LOG_INFO(SYSTEM, "Setup complete - System ready\n");
+    LOG_INFO(SYSTEM, "Debug console available at /debug\n");
+    LOG_INFO(SYSTEM, "System Version %s\n", sw_version.c_str());
+    LOG_INFO(SYSTEM, "Hostname: %s\n", hostname.c_str());
     
     // Play startup tone to indicate setup is complete
     buzzerStartupTone();
@@ -1778,7 +1544,6 @@ void setup()
 void loop()
 {
     static unsigned long lastWiFiAttemptTime = 0;
-    static unsigned long lastMQTTAttemptTime = 0;
     static unsigned long lastDisplayUpdateTime = 0;
     static unsigned long lastSensorReadTime = 0;
     static unsigned long lastFanScheduleTime = 0;
@@ -1795,20 +1560,20 @@ void loop()
     {
         bootButtonPressed = true;
         bootButtonPressStart = millis();
-        debugLog("Boot button pressed, holding for factory reset...\n");
+        LOG_INFO(SYSTEM, "Boot button pressed, holding for factory reset...\n");
     }
     
     // Detect boot button release
     if (!currentBootButtonState && bootButtonPressed)
     {
         bootButtonPressed = false;
-        debugLog("Boot button released\n");
+        LOG_INFO(SYSTEM, "Boot button released\n");
     }
     
     // Check if boot button has been held long enough for factory reset
     if (bootButtonPressed && (millis() - bootButtonPressStart > FACTORY_RESET_PRESS_TIME))
     {
-        debugLog("Factory reset triggered by boot button!\n");
+        LOG_INFO(SYSTEM, "Factory reset triggered by boot button!\n");
         
         // Show reset message on display
         tft.fillScreen(COLOR_BACKGROUND);
@@ -1850,11 +1615,15 @@ void loop()
         coolingOn = false;
         fanOn = false;
         if (currentTime - lastSensorWatchdogLog > 5000) {
-            debugLog("[WATCHDOG] Sensor task stalled >30s - all relays forced OFF\n");
+            LOG_WARN(SYSTEM, "Watchdog: Sensor task stalled >30s - all relays forced OFF\n");
+            postMortemRecord(PM_SENSOR_STALL, currentTime - sensorTaskLastAlive);
             lastSensorWatchdogLog = currentTime;
         }
     }
 
+    // Deferred NVS saves (MQTT/web/touch bursts)
+    flushSettings(false);
+
     // Handle touch input with priority - check this first for responsiveness
     uint16_t x, y;
     static unsigned long lastTouchDebug = 0;
@@ -1869,9 +1638,7 @@ void loop()
         
         unsigned long currentTime = millis();
         if (currentTime - lastTouchDebug > 500) {
-            char touchMsg[64];
-            snprintf(touchMsg, sizeof(touchMsg), "[TOUCH] X=%u Y=%u DZ=%d\n", x, y, TOUCH_DEADZONE);
-            debugLog("%s", touchMsg);
+            LOG_DEBUG(DISPLAY, "Touch X=%u Y=%u DZ=%d\n", x, y, TOUCH_DEADZONE);
             lastTouchDebug = currentTime;
         }
         
@@ -1880,9 +1647,7 @@ void loop()
             // Touch is outside valid area - ignore it (but log it occasionally)
             static unsigned long lastDeadzoneLog = 0;
             if (currentTime - lastDeadzoneLog > 2000) {
-                char dzMsg[64];
-                snprintf(dzMsg, sizeof(dzMsg), "[FILTERED] X=%u Y=%u (deadzone)\n", x, y);
-                debugLog("%s", dzMsg);
+                LOG_DEBUG(DISPLAY, "Touch filtered X=%u Y=%u (deadzone)\n", x, y);
                 lastDeadzoneLog = currentTime;
             }
         } else {
@@ -1943,7 +1708,7 @@ void loop()
         
         // Debug weather status every 60 seconds
         if (millis() - lastWeatherDebug > 60000) {
-            debugLog("WEATHER: Source=%d, Valid=%d, Temp=%.1f, Condition=%s, Error=%s\n",
+            LOG_INFO(WEATHER, "Source=%d, Valid=%d, Temp=%.1f, Condition=%s, Error=%s\n",
                          weatherSource,
                          weather.isDataValid(),
                          weather.getData().temperature,
@@ -1968,12 +1733,12 @@ void loop()
     if (millis() - lastLD2410Status > 30000) {
         lastLD2410Status = millis();
         if (ld2410Connected) {
-            debugLog("LD2410: Status - Connected: %s, Motion: %s, Last motion: %lu ms ago\\n",
+            LOG_DEBUG(MOTION, "Status - Connected: %s, Motion: %s, Last motion: %lu ms ago\n",
                           ld2410Connected ? "YES" : "NO",
                           motionDetected ? "ACTIVE" : "INACTIVE",
                           millis() - lastMotionTime);
         } else {
-            debugLog("LD2410: Status - Sensor not detected, display control via touch only\n");
+            LOG_INFO(MOTION, "Status - Sensor not detected, display control via touch only\n");
         }
     }
 
@@ -1984,7 +1749,7 @@ void loop()
     static unsigned long lastDebugOutput = 0;
     if (currentTime - lastDebugOutput > 5000) {
         lastDebugOutput = currentTime;
-        debugLog("[DEBUG] Temp=%.1f H=%.1f Sleep=%d SleepTime=%lu\n",
+        LOG_DEBUG(SYSTEM, "Temp=%.1f H=%.1f Sleep=%d SleepTime=%lu\n",
                  currentTemp, currentHumidity, displayIsAsleep,
                  currentTime - lastInteractionTime);
     }
@@ -2007,17 +1772,22 @@ void loop()
     
     if (mqttEnabled)
     {
-        // Attempt to reconnect to MQTT if not connected and WiFi is connected - check every 15 seconds
-        if (WiFi.status() == WL_CONNECTED && !mqttClient.connected() && currentTime - lastMQTTAttemptTime > 15000)
-        {
-            reconnectMQTT();
-            lastMQTTAttemptTime = currentTime;
+        // The MQTT task owns the connection; loop() runs the commands it
+        // received and queues state, and never waits on the broker
+        processMQTTCommands();
+
+        if (mqttSessionStarted) {
+            mqttSessionStarted = false;
+            // Reset MQTT data cache so all values get republished and
+            // Home Assistant doesn't show "unknown"
+            resetMQTTDataCache();
+            sendMQTTData();
+            lastMQTTDataTime = currentTime;
         }
-        mqttClient.loop();
-        
+
         // Send MQTT feedback immediately if settings changed via MQTT
-        if (mqttFeedbackNeeded && mqttClient.connected()) {
-            debugLog("[MQTT] Sending immediate feedback for settings change\n");
+        if (mqttFeedbackNeeded && mqttConnected) {
+            LOG_INFO(MQTT, "Sending immediate feedback for settings change\n");
             sendMQTTData();
             mqttFeedbackNeeded = false;
             lastMQTTDataTime = currentTime;
@@ -2028,13 +1798,15 @@ void loop()
             sendMQTTData();
             lastMQTTDataTime = currentTime;
         }
-    }
-    else
-    {
-        if (mqttClient.connected())
-        {
-            mqttClient.disconnect();
+
+        // Buffer history while the broker is unreachable, replay it after.
+        // The buffer is loop()-only, so a spill change from the web lands here.
+        if (telemetrySpillChanged) {
+            telemetrySpillChanged = false;
+            telemetrySetSpill(mqttHistoryFlash);
         }
+        recordTelemetry(currentTime);
+        replayTelemetry(currentTime);
     }
 
     // Control relays more frequently for immediate response to setting changes
@@ -2042,6 +1814,22 @@ void loop()
     if (currentTime - lastRelayControlTime > 1000) { // Control relays every 1 second
         controlRelays(currentTemp);
         lastRelayControlTime = currentTime;
+
+        // Post-mortem trace: relay transitions and the first dip below the heap floor
+        static uint32_t lastRelayMask = 0;
+        uint32_t relayMask = postMortemRelayMask();
+        if (relayMask != lastRelayMask) {
+            postMortemRecord(PM_RELAYS, relayMask);
+            lastRelayMask = relayMask;
+        }
+        static bool heapLowRecorded = false;
+        size_t freeHeap = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+        if (!heapLowRecorded && freeHeap < POST_MORTEM_HEAP_LOW) {
+            postMortemRecord(PM_HEAP_LOW, heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+            heapLowRecorded = true;
+        } else if (heapLowRecorded && freeHeap > POST_MORTEM_HEAP_LOW + 8192) {
+            heapLowRecorded = false;
+        }
     }
 
     // Periodic diagnostics: heap and stack watermarks
@@ -2059,16 +1847,75 @@ void logRuntimeDiagnostics() {
     size_t largest8 = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
     size_t minFree8 = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
 
+    postMortemRecord(PM_HEARTBEAT, largest8);
+
     UBaseType_t mainWatermark = uxTaskGetStackHighWaterMark(NULL);
     UBaseType_t sensorWatermark = sensorTask ? uxTaskGetStackHighWaterMark(sensorTask) : 0;
     UBaseType_t displayWatermark = displayUpdateTask ? uxTaskGetStackHighWaterMark(displayUpdateTask) : 0;
+    UBaseType_t mqttWatermark = mqttTask ? uxTaskGetStackHighWaterMark(mqttTask) : 0;
 
-    debugLog("[DIAG] Heap: free=%uB, largest=%uB, min_free=%uB\n",
+    LOG_INFO(SYSTEM, "Heap: free=%uB, largest=%uB, min_free=%uB\n",
                   (unsigned)free8, (unsigned)largest8, (unsigned)minFree8);
-    debugLog("[DIAG] Stack HWM (words): main=%lu, sensor=%lu, display=%lu\n",
+    LOG_INFO(SYSTEM, "Stack HWM (words): main=%lu, sensor=%lu, display=%lu, mqtt=%lu\n",
                   (unsigned long)mainWatermark,
                   (unsigned long)sensorWatermark,
-                  (unsigned long)displayWatermark);
+                  (unsigned long)displayWatermark,
+                  (unsigned long)mqttWatermark);
+    MqttQueueStats mq;
+    mqttQueueGetStats(mq);
+    LOG_INFO(MQTT, "Queue: depth=%lu peak=%lu coalesced=%lu dropped=%lu failed=%lu latency avg=%lums max=%lums, commands dropped=%lu\n",
+                  (unsigned long)mq.depth, (unsigned long)mq.peak, (unsigned long)mq.coalesced,
+                  (unsigned long)mq.dropped, (unsigned long)mq.failed,
+                  (unsigned long)mq.latencyAvgMs, (unsigned long)mq.latencyMaxMs,
+                  (unsigned long)mqttCommandsDropped);
+    SettingsStoreStats ss;
+    settingsStoreGetStats(ss);
+    LOG_INFO(SETTINGS, "NVS: save requests=%lu coalesced=%lu flushes=%lu keys written=%lu unchanged=%lu latency last=%lums max=%lums, save max=%lums\n",
+                  (unsigned long)ss.requests, (unsigned long)ss.coalesced, (unsigned long)ss.flushes,
+                  (unsigned long)ss.keysWritten, (unsigned long)ss.keysUnchanged,
+                  (unsigned long)ss.latencyLastMs, (unsigned long)ss.latencyMaxMs, (unsigned long)ss.durationMaxMs);
+    LOG_INFO(MQTT, "Broker: connects=%lu reconnects=%lu attempts=%lu connect last=%lums max=%lums\n",
+                  (unsigned long)mqttConnects, (unsigned long)(mqttConnects > 0 ? mqttConnects - 1 : 0),
+                  (unsigned long)mqttConnectAttempts,
+                  (unsigned long)mqttConnectLastMs, (unsigned long)mqttConnectMaxMs);
+    if (mqttTlsActive) {
+        MqttTlsStats tls;
+        mqttTlsClient.getStats(tls);
+        LOG_INFO(MQTT, "TLS: handshakes=%lu resumed=%lu failed=%lu, last=%lums full=%lums resumed=%lums max=%lums, heap last=%luB peak=%luB held=%luB, error=-0x%04lx\n",
+                      (unsigned long)tls.handshakes, (unsigned long)tls.resumed, (unsigned long)tls.failures,
+                      (unsigned long)tls.lastMs, (unsigned long)tls.lastFullMs, (unsigned long)tls.lastResumedMs,
+                      (unsigned long)tls.maxMs, (unsigned long)tls.heapLastBytes, (unsigned long)tls.heapPeakBytes,
+                      (unsigned long)tls.heapHeldBytes, (unsigned long)-tls.lastError);
+    }
+    ConfigBlobStats cb;
+    configBlobGetStats(cb);
+    LOG_INFO(SETTINGS, "Config: generation=%lu slot=%c size=%luB saves=%lu unchanged=%lu failed=%lu, load=%luus save max=%lums%s\n",
+                  (unsigned long)cb.generation, cb.slot, (unsigned long)cb.bytes, (unsigned long)cb.saves,
+                  (unsigned long)cb.unchanged, (unsigned long)cb.failures,
+                  (unsigned long)cb.loadUs, (unsigned long)cb.saveMsMax, cb.readOnly ? ", READ-ONLY" : "");
+    NvsWearStats nw;
+    nvsWearGetStats(nw);
+    LOG_INFO(SETTINGS, "NVS wear: writes=%lu bytes=%lu entries=%lu, cycles boot=%.4f life(blob-only)=%.2f/%lu, years left=%.0f\n",
+                  (unsigned long)nw.total.writes, (unsigned long)nw.total.bytes, (unsigned long)nw.total.entries,
+                  nvsWearCyclesSinceBoot(nw), nvsWearCyclesLifetimeBlobOnly(nw), (unsigned long)NVS_WEAR_ENDURANCE_CYCLES,
+                  nvsWearYearsRemaining(nw));
+    TelemetryStats ts;
+    telemetryGetStats(ts);
+    if (ts.recorded > 0) {
+        LOG_INFO(MQTT, "History: pending ram=%lu flash=%lu/%lu, recorded=%lu replayed=%lu dropped=%lu erases=%lu\n",
+                      (unsigned long)ts.ramSamples, (unsigned long)ts.flashSamples, (unsigned long)ts.flashCapacity,
+                      (unsigned long)ts.recorded, (unsigned long)ts.replayed, (unsigned long)ts.dropped,
+                      (unsigned long)ts.sectorErases);
+    }
+#if DEBUG_LOG_SERIAL_ECHO == 1
+    LOG_INFO(SYSTEM, "Log: ring dropped=%lu, serial gaps=%lu lost=%luB, serial task HWM=%lu\n",
+                  (unsigned long)getDebugLogDropped(),
+                  (unsigned long)serialLogGaps,
+                  (unsigned long)serialLogLostBytes,
+                  (unsigned long)(serialLogTask ? uxTaskGetStackHighWaterMark(serialLogTask) : 0));
+#else
+    LOG_INFO(SYSTEM, "Log: ring dropped=%lu\n", (unsigned long)getDebugLogDropped());
+#endif
 }
 
 void setupWiFi()
@@ -2076,9 +1923,6 @@ void setupWiFi()
     // hostname already loaded by loadSettings() - don't override it with wrong key
     WiFi.setHostname(hostname.c_str()); // Set the WiFi device name
 
-    wifiSSID = preferences.getString("wifiSSID", "");
-    wifiPassword = preferences.getString("wifiPassword", "");
-
     if (wifiSSID != "" && wifiPassword != "")
     {
         WiFi.begin(wifiSSID.c_str(), wifiPassword.c_str());
@@ -2088,24 +1932,24 @@ void setupWiFi()
         while (WiFi.status() != WL_CONNECTED && millis() - startAttemptTime < 10000)
         {
             delay(1000);
-            debugLog("Connecting to WiFi...\n");
+            LOG_INFO(WIFI, "Connecting to WiFi...\n");
         }
 
         if (WiFi.status() == WL_CONNECTED)
         {
-            debugLog("Connected to WiFi\n");
-            debugLog("IP Address: %s\n", WiFi.localIP().toString().c_str());
+            LOG_INFO(WIFI, "Connected to WiFi\n");
+            LOG_INFO(WIFI, "IP Address: %s\n", WiFi.localIP().toString().c_str());
         }
         else
         {
-            debugLog("Failed to connect to WiFi\n");
+            LOG_WARN(WIFI, "Failed to connect to WiFi\n");
             enterWiFiCredentials();
         }
     }
     else
     {
         // No WiFi credentials found, prompt user to enter them via touch screen
-        debugLog("No WiFi credentials found. Please enter them via the touch screen.\n");
+        LOG_INFO(WIFI, "No WiFi credentials found. Please enter them via the touch screen.\n");
         enterWiFiCredentials();
     }
 }
@@ -2121,17 +1965,17 @@ void connectToWiFi()
 
         // If a previous begin() is still in progress, avoid restarting it.
         if (status == WL_IDLE_STATUS) {
-            debugLog("[WIFI] Connection already in progress\n");
+            LOG_INFO(WIFI, "Connection already in progress\n");
             return;
         }
 
-        debugLog("[WIFI] Starting reconnect attempt for SSID: %s\n", wifiSSID.c_str());
+        LOG_INFO(WIFI, "Starting reconnect attempt for SSID: %s\n", wifiSSID.c_str());
         WiFi.begin(wifiSSID.c_str(), wifiPassword.c_str());
     }
     else
     {
         // Having no credentials is fine - don't trigger WiFi setup automatically
-        debugLog("No WiFi credentials found. Device operating in offline mode.\n");
+        LOG_INFO(WIFI, "No WiFi credentials found. Device operating in offline mode.\n");
         // Note: User can press the WiFi button on the display to configure WiFi if desired
     }
 }
@@ -2142,36 +1986,34 @@ void handleWiFiConnectionState(unsigned long currentTime)
 
     if (wifiNowConnected && !wifiWasConnected)
     {
-        debugLog("[WIFI] Connected. IP Address: %s\n", WiFi.localIP().toString().c_str());
+        LOG_INFO(WIFI, "Connected. IP Address: %s\n", WiFi.localIP().toString().c_str());
+        postMortemRecord(PM_WIFI_UP, (uint32_t)WiFi.RSSI());
 
         if (!timeSyncInitialized) {
             configTime(0, 0, "pool.ntp.org", "time.nist.gov");
             setenv("TZ", timeZone.c_str(), 1);
             tzset();
             timeSyncInitialized = true;
-            debugLog("[WIFI] NTP time sync initialized\n");
-        }
-
-        if (mqttEnabled && !mqttClient.connected()) {
-            reconnectMQTT();
+            LOG_INFO(WIFI, "NTP time sync initialized\n");
         }
 
         // Trigger a weather refresh once after reconnection.
         if (weatherSource != 0) {
             bool success = weather.update();
-            debugLog("[WEATHER] Refresh after WiFi reconnect: %s\n", success ? "SUCCESS" : "FAILED");
+            LOG_INFO(WEATHER, "Refresh after WiFi reconnect: %s\n", success ? "SUCCESS" : "FAILED");
         }
     }
     else if (!wifiNowConnected && wifiWasConnected)
     {
-        debugLog("[WIFI] Disconnected\n");
+        LOG_INFO(WIFI, "Disconnected\n");
+        postMortemRecord(PM_WIFI_DOWN);
     }
 
     // Periodic heartbeat while disconnected (every 60s) helps diagnose field issues.
     static unsigned long lastDisconnectedLog = 0;
     if (!wifiNowConnected && currentTime - lastDisconnectedLog > 60000) {
         lastDisconnectedLog = currentTime;
-        debugLog("[WIFI] Offline, awaiting reconnect\n");
+        LOG_INFO(WIFI, "Offline, awaiting reconnect\n");
     }
 
     wifiWasConnected = wifiNowConnected;
@@ -2206,12 +2048,12 @@ void enterWiFiCredentials()
         static unsigned long lastStatusPrint = 0;
         unsigned long currentTime = millis();
         if (currentTime - lastStatusPrint > 5000) {
-            debugLog("Waiting for WiFi credentials...\n");
+            LOG_INFO(WIFI, "Waiting for WiFi credentials...\n");
             lastStatusPrint = currentTime;
         }
 
         if (currentTime - credentialsWaitStart > credentialsWaitTimeoutMs) {
-            debugLog("[WIFI] Credential entry timeout; returning to main UI\n");
+            LOG_INFO(WIFI, "Credential entry timeout; returning to main UI\n");
             tft.fillScreen(COLOR_BACKGROUND);
             tft.setTextColor(COLOR_WARNING, COLOR_BACKGROUND);
             tft.setTextSize(2);
@@ -2374,7 +2216,8 @@ void handleKeyPress(int row, int col)
         if (keyboardMode == 2) { // KB_HOSTNAME
             if (inputText.length() > 0) {
                 hostname = inputText;
-                saveSettings();
+                mqttConfigPublish();
+                saveSettings(NVS_WRITER_TOUCH);
                 exitKeyboardToPreviousScreen();
                 return;
             }
@@ -2402,7 +2245,7 @@ void handleKeyPress(int row, int col)
                 tft.setCursor(30, 130);
                 tft.println("Please wait");
                 
-                saveWiFiSettings();
+                saveSettings(NVS_WRITER_TOUCH);
                 WiFi.begin(wifiSSID.c_str(), wifiPassword.c_str());
                 unsigned long startAttemptTime = millis();
 
@@ -2414,7 +2257,7 @@ void handleKeyPress(int row, int col)
                     tft.setCursor(30 + (dots * 12), 160);
                     tft.print(".");
                     dots = (dots + 1) % 20;
-                    debugLog("Connecting to WiFi...\n");
+                    LOG_INFO(WIFI, "Connecting to WiFi...\n");
                 }
 
                 if (WiFi.status() == WL_CONNECTED)
@@ -2426,8 +2269,10 @@ void handleKeyPress(int row, int col)
                     tft.setTextColor(COLOR_TEXT, COLOR_BACKGROUND);
                     tft.setCursor(30, 130);
                     tft.println("Restarting...");
-                    debugLog("Connected to WiFi\n");
-                    debugLog("IP Address: %s\n", WiFi.localIP().toString().c_str());
+                    LOG_INFO(WIFI, "Connected to WiFi\n");
+                    LOG_INFO(WIFI, "IP Address: %s\n", WiFi.localIP().toString().c_str());
+                    postMortemRecord(PM_RESTART, PM_RESTART_WIFI_SETUP);
+                    flushSettings(true);
                     delay(2000);
                     ESP.restart();
                 }
@@ -2440,7 +2285,7 @@ void handleKeyPress(int row, int col)
                     tft.setTextColor(COLOR_TEXT, COLOR_BACKGROUND);
                     tft.setCursor(30, 130);
                     tft.println("Touch to retry");
-                    debugLog("Failed to connect to WiFi\n");
+                    LOG_WARN(WIFI, "Failed to connect to WiFi\n");
                     delay(3000);
                     // Reset and return to keyboard
                     inputText = "";
@@ -2574,14 +2419,14 @@ void handleButtonPress(uint16_t x, uint16_t y)
     }
     
     // Shower mode toggle - touch the set temp area (center display)
-    debugLog("[DEBUG] Touch: x=%d, y=%d, showerModeEnabled=%d\n", x, y, showerModeEnabled);
+    LOG_DEBUG(DISPLAY, "Touch: x=%d, y=%d, showerModeEnabled=%d\n", x, y, showerModeEnabled);
     if (showerModeEnabled && x > 60 && x < 260 && y > 100 && y < 140) {
         showerModeActive = !showerModeActive;
         if (showerModeActive) {
             showerModeStartTime = millis();
-            debugLog("[SHOWER MODE] Activated - duration %d minutes\n", showerModeDuration);
+            LOG_INFO(HVAC, "Shower mode: Activated - duration %d minutes\n", showerModeDuration);
         } else {
-            debugLog("[SHOWER MODE] Deactivated\n");
+            LOG_INFO(HVAC, "Shower mode: Deactivated\n");
         }
         updateDisplay(currentTemp, currentHumidity);
         sendMQTTData();
@@ -2613,7 +2458,7 @@ void handleButtonPress(uint16_t x, uint16_t y)
         if (scheduleEnabled && !scheduleOverride) {
             scheduleOverride = true;
             overrideEndTime = millis() + (scheduleOverrideDuration * 60000UL);
-            debugLog("SCHEDULE: Override enabled due to manual temperature adjustment\n");
+            LOG_INFO(SCHEDULE, "Override enabled due to manual temperature adjustment\n");
         }
         
         if (thermostatMode == "heat")
@@ -2624,9 +2469,9 @@ void handleButtonPress(uint16_t x, uint16_t y)
             if (thermostatMode == "auto" && setTempCool - setTempHeat < tempDifferential)
             {
                 setTempCool = setTempHeat + tempDifferential;
-                if (!handlingMQTTMessage) mqttClient.publish("thermostat/setTempCool", String(setTempCool).c_str(), true);
+                if (!handlingMQTTMessage) mqttQueuePublish(MQTT_TOPIC_LEGACY_SET_TEMP_COOL, String(setTempCool).c_str(), true);
             }
-            if (!handlingMQTTMessage) mqttClient.publish("thermostat/setTempHeat", String(setTempHeat).c_str(), true);
+            if (!handlingMQTTMessage) mqttQueuePublish(MQTT_TOPIC_LEGACY_SET_TEMP_HEAT, String(setTempHeat).c_str(), true);
         }
         else if (thermostatMode == "cool")
         {
@@ -2636,19 +2481,19 @@ void handleButtonPress(uint16_t x, uint16_t y)
             if (thermostatMode == "auto" && setTempCool - setTempHeat < tempDifferential)
             {
                 setTempHeat = setTempCool - tempDifferential;
-                if (!handlingMQTTMessage) mqttClient.publish("thermostat/setTempHeat", String(setTempHeat).c_str(), true);
+                if (!handlingMQTTMessage) mqttQueuePublish(MQTT_TOPIC_LEGACY_SET_TEMP_HEAT, String(setTempHeat).c_str(), true);
             }
-            if (!handlingMQTTMessage) mqttClient.publish("thermostat/setTempCool", String(setTempCool).c_str(), true);
+            if (!handlingMQTTMessage) mqttQueuePublish(MQTT_TOPIC_LEGACY_SET_TEMP_COOL, String(setTempCool).c_str(), true);
         }
         else if (thermostatMode == "auto")
         {
             setTempAuto += 0.5;
             if (setTempAuto > 95) setTempAuto = 95;
             if (setTempAuto < 50) setTempAuto = 50;
-            if (!handlingMQTTMessage) mqttClient.publish("thermostat/setTempAuto", String(setTempAuto).c_str(), true);
+            if (!handlingMQTTMessage) mqttQueuePublish(MQTT_TOPIC_LEGACY_SET_TEMP_AUTO, String(setTempAuto).c_str(), true);
         }
         // Single atomic save of all settings (including schedule override if set above)
-        saveSettings();
+        settingsMarkDirty(SETTINGS_DIRTY_SETTINGS, NVS_WRITER_TOUCH);
         sendMQTTData();
         // Update display immediately for better responsiveness
         updateDisplay(currentTemp, currentHumidity);
@@ -2668,7 +2513,7 @@ void handleButtonPress(uint16_t x, uint16_t y)
         if (scheduleEnabled && !scheduleOverride) {
             scheduleOverride = true;
             overrideEndTime = millis() + (scheduleOverrideDuration * 60000UL);
-            debugLog("SCHEDULE: Override enabled due to manual temperature adjustment\n");
+            LOG_INFO(SCHEDULE, "Override enabled due to manual temperature adjustment\n");
         }
         
         if (thermostatMode == "heat")
@@ -2679,9 +2524,9 @@ void handleButtonPress(uint16_t x, uint16_t y)
             if (thermostatMode == "auto" && setTempCool - setTempHeat < tempDifferential)
             {
                 setTempCool = setTempHeat + tempDifferential;
-                if (!handlingMQTTMessage) mqttClient.publish("thermostat/setTempCool", String(setTempCool).c_str(), true);
+                if (!handlingMQTTMessage) mqttQueuePublish(MQTT_TOPIC_LEGACY_SET_TEMP_COOL, String(setTempCool).c_str(), true);
             }
-            if (!handlingMQTTMessage) mqttClient.publish("thermostat/setTempHeat", String(setTempHeat).c_str(), true);
+            if (!handlingMQTTMessage) mqttQueuePublish(MQTT_TOPIC_LEGACY_SET_TEMP_HEAT, String(setTempHeat).c_str(), true);
         }
         else if (thermostatMode == "cool")
         {
@@ -2691,19 +2536,19 @@ void handleButtonPress(uint16_t x, uint16_t y)
             if (thermostatMode == "auto" && setTempCool - setTempHeat < tempDifferential)
             {
                 setTempHeat = setTempCool - tempDifferential;
-                if (!handlingMQTTMessage) mqttClient.publish("thermostat/setTempHeat", String(setTempHeat).c_str(), true);
+                if (!handlingMQTTMessage) mqttQueuePublish(MQTT_TOPIC_LEGACY_SET_TEMP_HEAT, String(setTempHeat).c_str(), true);
             }
-            if (!handlingMQTTMessage) mqttClient.publish("thermostat/setTempCool", String(setTempCool).c_str(), true);
+            if (!handlingMQTTMessage) mqttQueuePublish(MQTT_TOPIC_LEGACY_SET_TEMP_COOL, String(setTempCool).c_str(), true);
         }
         else if (thermostatMode == "auto")
         {
             setTempAuto -= 0.5;
             if (setTempAuto > 95) setTempAuto = 95;
             if (setTempAuto < 50) setTempAuto = 50;
-            if (!handlingMQTTMessage) mqttClient.publish("thermostat/setTempAuto", String(setTempAuto).c_str(), true);
+            if (!handlingMQTTMessage) mqttQueuePublish(MQTT_TOPIC_LEGACY_SET_TEMP_AUTO, String(setTempAuto).c_str(), true);
         }
         // Single atomic save of all settings (including schedule override if set above)
-        saveSettings();
+        settingsMarkDirty(SETTINGS_DIRTY_SETTINGS, NVS_WRITER_TOUCH);
         sendMQTTData();
         // Update display immediately for better responsiveness
         updateDisplay(currentTemp, currentHumidity);
@@ -2731,9 +2576,9 @@ void handleButtonPress(uint16_t x, uint16_t y)
         if (isSwitchingToOff || delayElapsed) {
             thermostatMode = newMode;
             lastModeSwitchTime = currentTime;
-            debugLog("[DEBUG] Mode switched: %s -> %s (delay_ok=%d)\n", oldMode.c_str(), thermostatMode.c_str(), (isSwitchingToOff || delayElapsed));
+            LOG_DEBUG(HVAC, "Mode switched: %s -> %s (delay_ok=%d)\n", oldMode.c_str(), thermostatMode.c_str(), (isSwitchingToOff || delayElapsed));
             
-            saveSettings();
+            settingsMarkDirty(SETTINGS_DIRTY_SETTINGS, NVS_WRITER_TOUCH);
             sendMQTTData();
             // Immediately update relays to reflect mode change
             controlRelays(currentTemp);
@@ -2741,7 +2586,7 @@ void handleButtonPress(uint16_t x, uint16_t y)
             updateDisplay(currentTemp, currentHumidity);
             setDisplayUpdateFlag(); // Option C: Request display update
         } else {
-            debugLog("[DEBUG] Mode switch blocked: %s (too soon, need to wait %lu ms)\n", newMode.c_str(), MODE_SWITCH_DELAY_MS - (currentTime - lastModeSwitchTime));
+            LOG_DEBUG(HVAC, "Mode switch blocked: %s (too soon, need to wait %lu ms)\n", newMode.c_str(), MODE_SWITCH_DELAY_MS - (currentTime - lastModeSwitchTime));
         }
     }
     else if (x > 195 && x < 265 && y > 195 && y < 245) // Fan button with slightly increased touch area
@@ -2755,8 +2600,8 @@ void handleButtonPress(uint16_t x, uint16_t y)
         else
             fanMode = "auto";
 
-        debugLog("[FAN] Fan mode changed: %s -> %s\n", oldMode.c_str(), fanMode.c_str());
-        saveSettings();
+        LOG_INFO(HVAC, "Fan mode changed: %s -> %s\n", oldMode.c_str(), fanMode.c_str());
+        settingsMarkDirty(SETTINGS_DIRTY_SETTINGS, NVS_WRITER_TOUCH);
         sendMQTTData();
         // Immediately update relays to reflect fan mode change
         controlRelays(currentTemp);
@@ -2769,483 +2614,817 @@ void setupMQTT()
 {
     // Keep network outages from stalling the main loop on socket operations.
     espClient.setTimeout(3000);
-    mqttClient.setServer(mqttServer.c_str(), mqttPort);
-    mqttClient.setBufferSize(1024); // Ensure buffer size is sufficient for large payloads
+    mqttTlsActive = mqttTls;
+    if (mqttTlsActive) {
+        mqttTlsClient.setIoTimeout(5000);
+        if (!mqttTlsClient.setCACert(mqttCaCert.c_str())) {
+            LOG_ERROR(MQTT, "TLS is on but the CA certificate is missing or invalid; not connecting\n");
+        }
+        mqttClient.setClient(mqttTlsClient);
+    } else {
+        mqttClient.setClient(espClient);
+    }
+    // The MQTT task sets the server from its copy of the settings
+    // Publishes are streamed (beginPublish/write/endPublish) and only need the
+    // topic to fit; the buffer is sized for inbound commands and CONNECT
+    mqttClient.setBufferSize(512);
     mqttClient.setCallback(mqttCallback);
 }
 
-void reconnectMQTT()
+// Writer side of MqttConnConfig: call after changing hostname or an MQTT
+// connection setting, from the task that changed it
+void mqttConfigPublish()
+{
+    MqttConnConfig config;
+    config.enabled = mqttEnabled;
+    config.port = mqttPort;
+    strlcpy(config.hostname, hostname.c_str(), sizeof(config.hostname));
+    strlcpy(config.server, mqttServer.c_str(), sizeof(config.server));
+    strlcpy(config.username, mqttUsername.c_str(), sizeof(config.username));
+    strlcpy(config.password, mqttPassword.c_str(), sizeof(config.password));
+
+    xSemaphoreTake(mqttConfigMutex, portMAX_DELAY);
+    config.generation = mqttConfigShared.generation + 1;
+    mqttConfigShared = config;
+    xSemaphoreGive(mqttConfigMutex);
+}
+
+// MQTT task: refresh `config` if settings were published since it was taken.
+// brokerChanged is set when the server, port or credentials differ.
+static bool mqttConfigTake(MqttConnConfig& config, bool& brokerChanged)
+{
+    bool changed = false;
+    xSemaphoreTake(mqttConfigMutex, portMAX_DELAY);
+    if (mqttConfigShared.generation != config.generation) {
+        brokerChanged = mqttConfigShared.port != config.port ||
+                        strcmp(mqttConfigShared.server, config.server) != 0 ||
+                        strcmp(mqttConfigShared.username, config.username) != 0 ||
+                        strcmp(mqttConfigShared.password, config.password) != 0;
+        config = mqttConfigShared;
+        changed = true;
+    }
+    xSemaphoreGive(mqttConfigMutex);
+    return changed;
+}
+
+// Owns mqttClient: connects, subscribes, runs PubSubClient and drains the
+// publish queue. Inbound commands are handed to loop() through
+// mqttCommandQueue, so settings, relays and the display are only changed there.
+void mqttTaskFunction(void* parameter)
+{
+    static MqttPublish record; // ~330 bytes, kept off the task stack
+    static MqttConnConfig config; // Generation 0: nothing taken yet
+    unsigned long lastAttemptTime = 0;
+    bool attempted = false;
+    bool nvsWearSent = false;
+    unsigned long lastNvsWearTime = 0;
+
+    for (;;) {
+        bool brokerChanged = false;
+        if (mqttConfigTake(config, brokerChanged)) {
+            mqttHostname = config.hostname;
+            // PubSubClient keeps the pointer; config lives as long as the task
+            mqttClient.setServer(config.server, config.port);
+            if (brokerChanged && mqttClient.connected()) {
+                LOG_INFO(MQTT, "Broker settings changed, reconnecting\n");
+                mqttClient.disconnect();
+                attempted = false;
+            }
+        }
+
+        if (!config.enabled || WiFi.status() != WL_CONNECTED) {
+            if (mqttClient.connected()) {
+                if (!config.enabled) removeHomeAssistantDiscovery();
+                mqttClient.disconnect();
+            }
+            mqttConnected = false;
+            attempted = false; // Try right away once WiFi is back
+            vTaskDelay(pdMS_TO_TICKS(100));
+            continue;
+        }
+
+        // Hostname changed (web or touch settings): the subscriptions and the
+        // client id belong to the old name, so start a fresh session
+        if (mqttTopicsUpdate(config.hostname) && mqttClient.connected()) {
+            LOG_INFO(MQTT, "Hostname changed to %s, reconnecting\n", config.hostname);
+            mqttClient.disconnect();
+            attempted = false;
+        }
+
+        // Reconnect every 15 seconds while the broker is down
+        if (!mqttClient.connected()) {
+            mqttConnected = false;
+            nvsWearSent = false;
+            if (!attempted || millis() - lastAttemptTime > 15000) {
+                reconnectMQTT(config);
+                attempted = true;
+                lastAttemptTime = millis();
+            }
+        }
+
+        if (mqttClient.connected()) {
+            mqttConnected = true;
+            mqttClient.loop();
+
+            if (mqttDiscoveryNeeded) {
+                mqttDiscoveryNeeded = false;
+                publishHomeAssistantDiscovery();
+            }
+
+            // A bounded batch per pass keeps mqttClient.loop() running
+            for (int i = 0; i < 8 && mqttQueuePop(record); i++) {
+                bool ok = publishStreamed(mqttTopic((MqttTopic)record.topic),
+                                          (const uint8_t*)record.payload, record.length, record.retained);
+                mqttQueueDone(record, ok);
+            }
+
+            // Discovery trickles out behind state updates
+            publishHomeAssistantDiscoveryStep();
+
+            // NVS wear report, once per session and then hourly
+            if (!nvsWearSent || millis() - lastNvsWearTime >= NVS_WEAR_REPORT_INTERVAL_MS) {
+                publishNvsWear();
+                nvsWearSent = true;
+                lastNvsWearTime = millis();
+            }
+        }
+
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
+
+// <hostname>/nvs (NvsWear.h), retained. Rendered first, then streamed:
+// it is larger than the PubSubClient buffer.
+void publishNvsWear()
+{
+    static char json[2048];
+    size_t len = nvsWearFormatJson(json, sizeof(json));
+    bool ok = len > 0 && mqttClient.beginPublish(mqttTopic(MQTT_TOPIC_NVS), len, true) &&
+              mqttClient.write((const uint8_t*)json, len) == len && mqttClient.endPublish() != 0;
+    if (!ok) LOG_WARN(MQTT, "NVS wear report (%u bytes) publish failed\n", (unsigned)len);
+}
+
+void reconnectMQTT(const MqttConnConfig& config)
 {
+    static bool lastAttemptFailed = false;
+    static bool postMortemPublished = false;
+
     // Non-blocking approach - only try once per function call
     if (!mqttClient.connected())
     {
-        debugLog("Attempting MQTT connection to server: %s port: %d username: %s\n",
-             mqttServer.c_str(), mqttPort, mqttUsername.c_str());
-        
-        if (mqttClient.connect(hostname.c_str(), mqttUsername.c_str(), mqttPassword.c_str())) {
-            debugLog(" - Connected successfully\n");
+        LOG_INFO(MQTT, "Attempting MQTT connection to server: %s port: %d username: %s%s\n",
+             config.server, config.port, config.username, mqttTlsActive ? " (TLS)" : "");
+
+        mqttConnectAttempts++;
+        unsigned long connectStart = millis();
+        bool connected = mqttClient.connect(config.hostname, config.username, config.password);
+        unsigned long connectMs = millis() - connectStart;
+
+        if (connected) {
+            mqttConnects++;
+            mqttConnectLastMs = connectMs;
+            if (connectMs > mqttConnectMaxMs) mqttConnectMaxMs = connectMs;
+            LOG_INFO(MQTT, "Connected successfully in %lums\n", connectMs);
+            postMortemRecord(PM_MQTT_UP);
+            lastAttemptFailed = false;
 
             // Subscribe to necessary topics
-            String tempSetTopic = hostname + "/target_temperature/set";
-            String modeSetTopic = hostname + "/mode/set";
-            String fanModeSetTopic = hostname + "/fan_mode/set";
-            String showerModeSetTopic = hostname + "/shower_mode/set";
-            String scheduleEnabledSetTopic = hostname + "/schedule_enabled/set";
-            String scheduleOverrideSetTopic = hostname + "/schedule_override/set";
-            String scheduleSetTopic = hostname + "/schedule/set";
-            mqttClient.subscribe(tempSetTopic.c_str());
-            mqttClient.subscribe(modeSetTopic.c_str());
-            mqttClient.subscribe(fanModeSetTopic.c_str());
-            mqttClient.subscribe(showerModeSetTopic.c_str());
-            mqttClient.subscribe(scheduleEnabledSetTopic.c_str());
-            mqttClient.subscribe(scheduleOverrideSetTopic.c_str());
-            mqttClient.subscribe(scheduleSetTopic.c_str());
-
-            // Publish Home Assistant discovery messages
+            for (int i = 0; i < MQTT_CMD_COUNT; i++) {
+                mqttClient.subscribe(mqttCommandTopic((MqttCommand)i));
+            }
+            mqttClient.subscribe(mqttTopic(MQTT_TOPIC_HA_STATUS));
+
+            // Publish Home Assistant discovery messages (incrementally, from mqttTaskFunction)
             publishHomeAssistantDiscovery();
-            
-            // Reset MQTT data cache so all values get republished
-            resetMQTTDataCache();
-            
-            // Immediately publish current state so Home Assistant doesn't show "unknown"
-            sendMQTTData();
+            mqttDiscoveryNeeded = false;
+
+            // loop() queues the full current state for the new session
+            mqttConnected = true;
+            mqttSessionStarted = true;
+
+            // Previous boot's reset reason and trace, once per boot. Streamed:
+            // the report is larger than the PubSubClient buffer.
+            if (!postMortemPublished) {
+                size_t len = postMortemJsonLength();
+                if (mqttClient.beginPublish(mqttTopic(MQTT_TOPIC_POSTMORTEM), len, true)) {
+                    postMortemWriteJson(mqttClient);
+                    postMortemPublished = mqttClient.endPublish() != 0;
+                }
+                LOG_INFO(MQTT, "Post-mortem report (%u bytes) %s\n", (unsigned)len,
+                         postMortemPublished ? "published" : "publish failed");
+            }
         }
         else
         {
             int mqttState = mqttClient.state();
-            debugLog(" - Connection failed, rc=%d (", mqttState);
-            
+            const char* reason;
+
             // Provide human-readable error messages
             switch(mqttState) {
-                case -4: debugLog("MQTT_CONNECTION_TIMEOUT"); break;
-                case -3: debugLog("MQTT_CONNECTION_LOST"); break;
-                case -2: debugLog("MQTT_CONNECT_FAILED"); break;
-                case -1: debugLog("MQTT_DISCONNECTED"); break;
-                case 1: debugLog("MQTT_CONNECT_BAD_PROTOCOL"); break;
-                case 2: debugLog("MQTT_CONNECT_BAD_CLIENT_ID"); break;
-                case 3: debugLog("MQTT_CONNECT_UNAVAILABLE"); break;
-                case 4: debugLog("MQTT_CONNECT_BAD_CREDENTIALS"); break;
-                case 5: debugLog("MQTT_CONNECT_UNAUTHORIZED"); break;
-                default: debugLog("UNKNOWN ERROR"); break;
+                case -4: reason = "MQTT_CONNECTION_TIMEOUT"; break;
+                case -3: reason = "MQTT_CONNECTION_LOST"; break;
+                case -2: reason = "MQTT_CONNECT_FAILED"; break;
+                case -1: reason = "MQTT_DISCONNECTED"; break;
+                case 1: reason = "MQTT_CONNECT_BAD_PROTOCOL"; break;
+                case 2: reason = "MQTT_CONNECT_BAD_CLIENT_ID"; break;
+                case 3: reason = "MQTT_CONNECT_UNAVAILABLE"; break;
+                case 4: reason = "MQTT_CONNECT_BAD_CREDENTIALS"; break;
+                case 5: reason = "MQTT_CONNECT_UNAUTHORIZED"; break;
+                default: reason = "UNKNOWN ERROR"; break;
             }
-            
-            debugLog(")\n");
-            debugLog("Server: %s, Port: %d\n", mqttServer.c_str(), mqttPort);
+
+            LOG_WARN(MQTT, "Connection failed, rc=%d (%s)\n", mqttState, reason);
+            if (!lastAttemptFailed) postMortemRecord(PM_MQTT_DOWN, (uint32_t)mqttState); // First failure of a streak only
+            lastAttemptFailed = true;
+            LOG_INFO(MQTT, "Server: %s, Port: %d\n", config.server, config.port);
         }
     }
 }
 
-void publishHomeAssistantDiscovery()
+// Home Assistant discovery, published a few entities at a time by the MQTT
+// task. Entities are numbered: the climate entity, six optional sensors and
+// switches, then DISCOVERY_PER_DAY per weekday. Each config's topic+payload
+// hash is kept after a successful publish and unchanged configs are skipped,
+// so a reconnect only resends what changed. HA's birth message
+// (homeassistant/status "online") clears the hashes: HA or the broker lost
+// the retained configs.
+//
+// With mqttDeviceDiscovery set, the same entities are sent instead as the
+// components of a single homeassistant/device/<hostname>/config message,
+// streamed to the broker and skipped when its hash is unchanged.
+enum DiscoveryResult { DISCOVERY_SKIP, DISCOVERY_PUBLISH, DISCOVERY_REMOVE };
+const int DISCOVERY_FIXED_ENTITIES = 7;
+const int DISCOVERY_PER_DAY = 12; // Sensor, day switch, then per period: 3 numbers, time, active
+const int DISCOVERY_ENTITY_COUNT = DISCOVERY_FIXED_ENTITIES + 7 * DISCOVERY_PER_DAY;
+const int DISCOVERY_ENTITIES_PER_PASS = 3;
+
+static uint32_t discoveryHashes[DISCOVERY_ENTITY_COUNT]; // 0 = not published
+static int discoveryNext = DISCOVERY_ENTITY_COUNT;       // Next entity; COUNT when idle
+static uint16_t discoveryPublished = 0;
+static uint16_t discoveryUnchanged = 0;
+static uint32_t deviceDiscoveryHash = 0;                 // 0 = not published
+static bool discoveryDeviceMode = false;                 // How the configs on the broker were published
+static bool discoveryModeKnown = false;
+
+static uint32_t discoveryHash(const char* data, size_t len, uint32_t hash)
 {
-    if (mqttEnabled)
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ (uint8_t)data[i]) * 16777619u; // FNV-1a
+    }
+    return hash;
+}
+
+// Device block shared by every entity except the motion sensor
+static void addDiscoveryDevice(JsonDocument& doc)
+{
+    JsonObject device = doc.createNestedObject("device");
+    device["identifiers"][0] = mqttHostname;
+    device["name"] = mqttHostname;
+    device["model"] = PROJECT_NAME_SHORT;
+    device["manufacturer"] = "TDC";
+    device["sw_version"] = sw_version;
+}
+
+// An entity's state source: its own topic, or its field of <hostname>/state
+static void addDiscoveryState(JsonDocument& doc, const char* topicKey, const char* templateKey,
+                              MqttTopic topic, MqttStateField field)
+{
+    if (!mqttStateJson) {
+        doc[topicKey] = mqttTopic(topic);
+        return;
+    }
+    doc[topicKey] = mqttTopic(MQTT_TOPIC_STATE);
+    doc[templateKey] = String("{{ value_json.") + mqttStateKey(field) + " }}";
+}
+
+// Print that measures and hashes what is written to it, forwarding to
+// `target` (if any) in buffered chunks instead of a TCP write per character
+class DiscoveryWriter : public Print
+{
+public:
+    explicit DiscoveryWriter(Print* target, uint32_t seed = 2166136261u) : hash(seed), target(target) {}
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* data, size_t len) override
     {
-        char buffer[1024];
-        StaticJsonDocument<1024> doc;
+        length += len;
+        hash = discoveryHash((const char*)data, len, hash);
+        if (target == NULL) return len;
+        for (size_t i = 0; i < len; i++) {
+            if (used == sizeof(chunk)) flush();
+            chunk[used++] = data[i];
+        }
+        return len;
+    }
+    void flush() override
+    {
+        if (target != NULL && used > 0) target->write(chunk, used);
+        used = 0;
+    }
 
-        // Get unique device ID from MAC address
-        String deviceId = String(ESP.getEfuseMac(), HEX);
-        
-        // Publish discovery message for the thermostat device
-        String configTopic = "homeassistant/climate/" + hostname + "/config";
-        doc["name"] = "";
-        doc["unique_id"] = deviceId;
-        doc["current_temperature_topic"] = hostname + "/current_temperature";
-        doc["current_humidity_topic"] = hostname + "/current_humidity";
-        doc["temperature_command_topic"] = hostname + "/target_temperature/set";
-        doc["temperature_state_topic"] = hostname + "/target_temperature";
-        doc["mode_command_topic"] = hostname + "/mode/set";
-        doc["mode_state_topic"] = hostname + "/mode";
-        doc["fan_mode_command_topic"] = hostname + "/fan_mode/set";
-        doc["fan_mode_state_topic"] = hostname + "/fan_mode";
-        doc["action_topic"] = hostname + "/action";
-        doc["availability_topic"] = hostname + "/availability";
-        doc["min_temp"] = 50; // Minimum temperature in Fahrenheit
-        doc["max_temp"] = 90; // Maximum temperature in Fahrenheit
-        doc["temp_step"] = 0.5; // Temperature step
-        doc["precision"] = 0.1; // Precision for temperature display (1 decimal place)
-
-        JsonArray modes = doc.createNestedArray("modes");
-        modes.add("off");
-        modes.add("heat");
-        modes.add("cool");
-        modes.add("auto");
-
-        JsonArray fanModes = doc.createNestedArray("fan_modes");
-        fanModes.add("auto");
-        fanModes.add("on");
-        fanModes.add("cycle");
-
-        JsonObject device = doc.createNestedObject("device");
-        JsonArray identifiers = device.createNestedArray("identifiers");
-        identifiers.add(hostname);
-        device["name"] = hostname;
-        device["manufacturer"] = "TDC";
-        device["model"] = PROJECT_NAME_SHORT;
-        device["sw_version"] = sw_version;
-
-        serializeJson(doc, buffer);
-        mqttClient.publish(configTopic.c_str(), buffer, true);
-
-        // Publish availability message
-        String availabilityTopic = hostname + "/availability";
-        mqttClient.publish(availabilityTopic.c_str(), "online", true);
-
-        // Debug log for payload
-        debugLog("Published Home Assistant discovery payload:\n%s\n", buffer);
-
-        // Publish motion sensor discovery if LD2410 is connected
-        if (ld2410Connected) {
-            StaticJsonDocument<512> motionDoc;
-            String motionConfigTopic = "homeassistant/binary_sensor/" + hostname + "_motion/config";
-            
-            motionDoc["name"] = hostname + " Motion";
-            motionDoc["device_class"] = "motion";
-            motionDoc["state_topic"] = hostname + "/motion_detected";
-            motionDoc["payload_on"] = "true";
-            motionDoc["payload_off"] = "false";
-            motionDoc["unique_id"] = hostname + "_motion";
-            
-            // Device information
-            JsonObject device = motionDoc.createNestedObject("device");
-            device["identifiers"][0] = hostname;
-            device["name"] = hostname;
-            device["model"] = PROJECT_NAME_SHORT;
-            device["manufacturer"] = "Custom";
-            
-            char motionBuffer[512];
-            serializeJson(motionDoc, motionBuffer);
-            mqttClient.publish(motionConfigTopic.c_str(), motionBuffer, true);
-            
-            debugLog("Published LD2410 motion sensor discovery to Home Assistant\n");
+    size_t length = 0;
+    uint32_t hash;
+
+private:
+    Print* target;
+    uint8_t chunk[256];
+    size_t used = 0;
+};
+
+static DiscoveryResult buildClimateDiscovery(String& configTopic, JsonDocument& doc)
+{
+    // Get unique device ID from MAC address
+    String deviceId = String(ESP.getEfuseMac(), HEX);
+
+    configTopic = "homeassistant/climate/" + mqttHostname + "/config";
+    doc["name"] = "";
+    doc["unique_id"] = deviceId;
+    addDiscoveryState(doc, "current_temperature_topic", "current_temperature_template",
+                      MQTT_TOPIC_CURRENT_TEMPERATURE, MQTT_STATE_TEMPERATURE);
+    addDiscoveryState(doc, "current_humidity_topic", "current_humidity_template",
+                      MQTT_TOPIC_CURRENT_HUMIDITY, MQTT_STATE_HUMIDITY);
+    doc["temperature_command_topic"] = mqttCommandTopic(MQTT_CMD_TARGET_TEMPERATURE);
+    addDiscoveryState(doc, "temperature_state_topic", "temperature_state_template",
+                      MQTT_TOPIC_TARGET_TEMPERATURE, MQTT_STATE_TARGET_TEMPERATURE);
+    doc["mode_command_topic"] = mqttCommandTopic(MQTT_CMD_MODE);
+    addDiscoveryState(doc, "mode_state_topic", "mode_state_template", MQTT_TOPIC_MODE, MQTT_STATE_MODE);
+    doc["fan_mode_command_topic"] = mqttCommandTopic(MQTT_CMD_FAN_MODE);
+    addDiscoveryState(doc, "fan_mode_state_topic", "fan_mode_state_template", MQTT_TOPIC_FAN_MODE, MQTT_STATE_FAN_MODE);
+    addDiscoveryState(doc, "action_topic", "action_template", MQTT_TOPIC_ACTION, MQTT_STATE_ACTION);
+    doc["availability_topic"] = mqttTopic(MQTT_TOPIC_AVAILABILITY);
+    doc["min_temp"] = 50; // Minimum temperature in Fahrenheit
+    doc["max_temp"] = 90; // Maximum temperature in Fahrenheit
+    doc["temp_step"] = 0.5; // Temperature step
+    doc["precision"] = 0.1; // Precision for temperature display (1 decimal place)
+
+    JsonArray modes = doc.createNestedArray("modes");
+    modes.add("off");
+    modes.add("heat");
+    modes.add("cool");
+    modes.add("auto");
+
+    JsonArray fanModes = doc.createNestedArray("fan_modes");
+    fanModes.add("auto");
+    fanModes.add("on");
+    fanModes.add("cycle");
+
+    addDiscoveryDevice(doc);
+    return DISCOVERY_PUBLISH;
+}
+
+static DiscoveryResult buildMotionDiscovery(String& configTopic, JsonDocument& doc)
+{
+    // Only while the LD2410 is connected
+    configTopic = "homeassistant/binary_sensor/" + mqttHostname + "_motion/config";
+    if (!ld2410Connected) return DISCOVERY_SKIP;
+
+    doc["name"] = mqttHostname + " Motion";
+    doc["device_class"] = "motion";
+    addDiscoveryState(doc, "state_topic", "value_template", MQTT_TOPIC_MOTION_DETECTED, MQTT_STATE_MOTION);
+    doc["payload_on"] = "true";
+    doc["payload_off"] = "false";
+    doc["unique_id"] = mqttHostname + "_motion";
+
+    JsonObject device = doc.createNestedObject("device");
+    device["identifiers"][0] = mqttHostname;
+    device["name"] = mqttHostname;
+    device["model"] = PROJECT_NAME_SHORT;
+    device["manufacturer"] = "Custom";
+    return DISCOVERY_PUBLISH;
+}
+
+static DiscoveryResult buildPressureDiscovery(String& configTopic, JsonDocument& doc)
+{
+    // Only while a BME280 is the active sensor
+    configTopic = "homeassistant/sensor/" + mqttHostname + "_pressure/config";
+    if (activeSensor != SENSOR_BME280) return DISCOVERY_SKIP;
+
+    doc["name"] = "Barometric Pressure";
+    doc["device_class"] = "pressure";
+    addDiscoveryState(doc, "state_topic", "value_template", MQTT_TOPIC_BAROMETRIC_PRESSURE, MQTT_STATE_PRESSURE);
+    doc["unit_of_measurement"] = "inHg";
+    doc["unique_id"] = mqttHostname + "_pressure";
+    doc["state_class"] = "measurement";
+    addDiscoveryDevice(doc);
+    return DISCOVERY_PUBLISH;
+}
+
+// DS18B20 supply (index 0) or return (index 1) probe; removed when absent
+static DiscoveryResult buildHydronicProbeDiscovery(int index, String& configTopic, JsonDocument& doc)
+{
+    const char* id = index == 0 ? "supply" : "return";
+    configTopic = "homeassistant/sensor/" + mqttHostname + "_ds18b20_" + id + "/config";
+    bool present = index == 0 ? ds18b20SensorPresent : ds18b20ReturnSensorPresent;
+    if (!present) return DISCOVERY_REMOVE;
+
+    doc["name"] = index == 0 ? "Hydronic Supply Temperature" : "Hydronic Return Temperature";
+    doc["device_class"] = "temperature";
+    addDiscoveryState(doc, "state_topic", "value_template",
+                      index == 0 ? MQTT_TOPIC_DS18B20_SUPPLY_TEMPERATURE : MQTT_TOPIC_DS18B20_RETURN_TEMPERATURE,
+                      index == 0 ? MQTT_STATE_SUPPLY_TEMPERATURE : MQTT_STATE_RETURN_TEMPERATURE);
+    doc["unit_of_measurement"] = "°F";
+    doc["unique_id"] = mqttHostname + "_ds18b20_" + id;
+    doc["state_class"] = "measurement";
+    doc["icon"] = "mdi:thermometer";
+    addDiscoveryDevice(doc);
+    return DISCOVERY_PUBLISH;
+}
+
+static DiscoveryResult buildShowerDiscovery(String& configTopic, JsonDocument& doc)
+{
+    // If the feature is disabled, remove the switch entity from HA
+    configTopic = "homeassistant/switch/" + mqttHostname + "_shower_mode/config";
+    if (!showerModeEnabled) return DISCOVERY_REMOVE;
+
+    doc["name"] = "Shower Mode";
+    addDiscoveryState(doc, "state_topic", "value_template", MQTT_TOPIC_SHOWER_MODE, MQTT_STATE_SHOWER_MODE);
+    doc["command_topic"] = mqttCommandTopic(MQTT_CMD_SHOWER_MODE);
+    doc["payload_on"] = "ON";
+    doc["payload_off"] = "OFF";
+    doc["state_on"] = "ON";
+    doc["state_off"] = "OFF";
+    doc["unique_id"] = mqttHostname + "_shower_mode";
+    doc["icon"] = "mdi:shower";
+    addDiscoveryDevice(doc);
+    return DISCOVERY_PUBLISH;
+}
+
+static DiscoveryResult buildScheduleEnabledDiscovery(String& configTopic, JsonDocument& doc)
+{
+    configTopic = "homeassistant/switch/" + mqttHostname + "_schedule_enabled/config";
+    doc["name"] = "Schedule Enabled";
+    addDiscoveryState(doc, "state_topic", "value_template", MQTT_TOPIC_SCHEDULE_ENABLED, MQTT_STATE_SCHEDULE_ENABLED);
+    doc["command_topic"] = mqttCommandTopic(MQTT_CMD_SCHEDULE_ENABLED);
+    doc["payload_on"] = "on";
+    doc["payload_off"] = "off";
+    doc["state_on"] = "on";
+    doc["state_off"] = "off";
+    doc["unique_id"] = mqttHostname + "_schedule_enabled";
+    doc["icon"] = "mdi:calendar-clock";
+    addDiscoveryDevice(doc);
+    return DISCOVERY_PUBLISH;
+}
+
+// One of the DISCOVERY_PER_DAY schedule entities for `day` (weekSchedule order)
+static DiscoveryResult buildScheduleDayDiscovery(int day, int item, String& configTopic, JsonDocument& doc)
+{
+    // dayNames order matches weekSchedule array: 0=Sunday, 1=Monday, ..., 6=Saturday
+    static const char* const dayNames[7] = {"Sunday", "Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday"};
+    static const char* const periodIds[2] = {"day", "night"};
+    static const char* const periodNames[2] = {"Day", "Night"};
+    static const char* const periodKeys[2] = {"day_period", "night_period"};
+    static const char* const tempKeys[3] = {"heat", "cool", "auto"};
+
+    String dayLower = String(dayNames[day]);
+    dayLower.toLowerCase();
+    const char* scheduleStateTopic = mqttTopic((MqttTopic)(MQTT_TOPIC_SCHEDULE_SUNDAY + day));
+    const char* scheduleSetTopic = mqttCommandTopic(MQTT_CMD_SCHEDULE);
+
+    if (item == 0) {
+        // Sensor with full JSON attributes
+        configTopic = "homeassistant/sensor/" + mqttHostname + "_schedule_" + dayLower + "/config";
+        doc["name"] = String("Schedule ") + dayNames[day];
+        doc["state_topic"] = scheduleStateTopic;
+        doc["value_template"] = "{{ value_json.day_name }}";
+        doc["json_attributes_topic"] = scheduleStateTopic;
+        doc["unique_id"] = mqttHostname + "_schedule_" + dayLower;
+        doc["icon"] = "mdi:calendar-clock";
+    } else if (item == 1) {
+        // Day enabled switch
+        configTopic = "homeassistant/switch/" + mqttHostname + "_schedule_" + dayLower + "_enabled/config";
+        doc["name"] = String("Schedule ") + dayNames[day] + " Enabled";
+        doc["state_topic"] = scheduleStateTopic;
+        doc["value_template"] = "{{ 'ON' if value_json.day_enabled else 'OFF' }}";
+        doc["command_topic"] = scheduleSetTopic;
+        doc["command_template"] = String("{\"day\":") + day + ",\"enabled\": {{ 'true' if value == 'ON' else 'false' }} }";
+        doc["payload_on"] = "ON";
+        doc["payload_off"] = "OFF";
+        doc["unique_id"] = mqttHostname + "_schedule_" + dayLower + "_enabled";
+        doc["icon"] = "mdi:toggle-switch";
+    } else {
+        // Per-period controls
+        int p = (item - 2) / 5;
+        int control = (item - 2) % 5;
+        const char* periodId = periodIds[p];
+        const char* periodName = periodNames[p];
+        const char* periodKey = periodKeys[p];
+
+        if (control < 3) {
+            // Temperature numbers (heat/cool/auto)
+            const char* tempKey = tempKeys[control];
+            configTopic = "homeassistant/number/" + mqttHostname + "_schedule_" + dayLower + "_" + periodId + "_" + tempKey + "/config";
+            char tempFirst = toupper(tempKey[0]);
+            doc["name"] = String("Schedule ") + dayNames[day] + " " + periodName + " " + String(tempFirst) + String(tempKey + 1);
+            doc["state_topic"] = scheduleStateTopic;
+            doc["value_template"] = String("{{ value_json.") + periodKey + "." + tempKey + " }}";
+            doc["command_topic"] = scheduleSetTopic;
+            doc["command_template"] = String("{\"day\":") + day + ",\"period\":\"" + periodId + "\",\"" + tempKey + "\":{{ value }}}";
+            doc["min"] = 45; // reasonable bounds
+            doc["max"] = 90;
+            doc["step"] = 0.5;
+            doc["unit_of_measurement"] = "°F";
+            doc["unique_id"] = mqttHostname + "_schedule_" + dayLower + "_" + periodId + "_" + tempKey;
+            doc["mode"] = "box";
+        } else if (control == 3) {
+            // Time text entity (HH:MM)
+            configTopic = "homeassistant/text/" + mqttHostname + "_schedule_" + dayLower + "_" + periodId + "_time/config";
+            doc["name"] = String("Schedule ") + dayNames[day] + " " + periodName + " Time";
+            doc["state_topic"] = scheduleStateTopic;
+            doc["value_template"] = String("{{ value_json.") + periodKey + ".time }}";
+            doc["command_topic"] = scheduleSetTopic;
+            doc["command_template"] = String("{\"day\":") + day + ",\"period\":\"" + periodId + "\",\"hour\": {{ value.split(':')[0] | int }},\"minute\": {{ value.split(':')[1] | int }} }";
+            doc["pattern"] = "^([01]\\d|2[0-3]):[0-5]\\d$";
+            doc["unique_id"] = mqttHostname + "_schedule_" + dayLower + "_" + periodId + "_time";
+            doc["icon"] = "mdi:clock-time-four-outline";
+        } else {
+            // Active switch
+            configTopic = "homeassistant/switch/" + mqttHostname + "_schedule_" + dayLower + "_" + periodId + "_active/config";
+            doc["name"] = String("Schedule ") + dayNames[day] + " " + periodName + " Active";
+            doc["state_topic"] = scheduleStateTopic;
+            doc["value_template"] = String("{{ 'ON' if value_json.") + periodKey + ".active else 'OFF' }}";
+            doc["command_topic"] = scheduleSetTopic;
+            doc["command_template"] = String("{\"day\":") + day + ",\"period\":\"" + periodId + "\",\"active\": {{ 'true' if value == 'ON' else 'false' }} }";
+            doc["payload_on"] = "ON";
+            doc["payload_off"] = "OFF";
+            doc["unique_id"] = mqttHostname + "_schedule_" + dayLower + "_" + periodId + "_active";
+            doc["icon"] = "mdi:power";
+        }
+    }
+    addDiscoveryDevice(doc);
+    return DISCOVERY_PUBLISH;
+}
+
+static DiscoveryResult buildDiscoveryEntity(int entity, String& configTopic, JsonDocument& doc)
+{
+    switch (entity) {
+        case 0: return buildClimateDiscovery(configTopic, doc);
+        case 1: return buildMotionDiscovery(configTopic, doc);
+        case 2: return buildPressureDiscovery(configTopic, doc);
+        case 3: return buildHydronicProbeDiscovery(0, configTopic, doc);
+        case 4: return buildHydronicProbeDiscovery(1, configTopic, doc);
+        case 5: return buildShowerDiscovery(configTopic, doc);
+        case 6: return buildScheduleEnabledDiscovery(configTopic, doc);
+        default: {
+            int index = entity - DISCOVERY_FIXED_ENTITIES;
+            return buildScheduleDayDiscovery(index / DISCOVERY_PER_DAY, index % DISCOVERY_PER_DAY, configTopic, doc);
         }
-        
-        // Publish barometric pressure sensor discovery if BME280 is active
-        if (activeSensor == SENSOR_BME280) {
-            StaticJsonDocument<512> pressureDoc;
-            String pressureConfigTopic = "homeassistant/sensor/" + hostname + "_pressure/config";
-            
-            pressureDoc["name"] = "Barometric Pressure";
-            pressureDoc["device_class"] = "pressure";
-            pressureDoc["state_topic"] = hostname + "/barometric_pressure";
-            pressureDoc["unit_of_measurement"] = "inHg";
-            pressureDoc["unique_id"] = hostname + "_pressure";
-            pressureDoc["state_class"] = "measurement";
-            
-            // Link to same device as main thermostat
-            JsonObject device = pressureDoc.createNestedObject("device");
-            device["identifiers"][0] = hostname;
-            device["name"] = hostname;
-            device["model"] = PROJECT_NAME_SHORT;
-            device["manufacturer"] = "TDC";
-            device["sw_version"] = sw_version;
-            
-            char pressureBuffer[512];
-            serializeJson(pressureDoc, pressureBuffer);
-            mqttClient.publish(pressureConfigTopic.c_str(), pressureBuffer, true);
-            
-            debugLog("Published BME280 pressure sensor discovery to Home Assistant\n");
-        }
-        
-        // Publish DS18B20 supply temperature sensor discovery if present
-        debugLog("DS18B20 Supply Sensor Present: %s\n", ds18b20SensorPresent ? "YES" : "NO");
-        if (ds18b20SensorPresent) {
-            StaticJsonDocument<512> ds18b20SupplyDoc;
-            String supplyConfigTopic = "homeassistant/sensor/" + hostname + "_ds18b20_supply/config";
-            
-            ds18b20SupplyDoc["name"] = "Hydronic Supply Temperature";
-            ds18b20SupplyDoc["device_class"] = "temperature";
-            ds18b20SupplyDoc["state_topic"] = hostname + "/ds18b20_supply_temperature";
-            ds18b20SupplyDoc["unit_of_measurement"] = "°F";
-            ds18b20SupplyDoc["unique_id"] = hostname + "_ds18b20_supply";
-            ds18b20SupplyDoc["state_class"] = "measurement";
-            ds18b20SupplyDoc["icon"] = "mdi:thermometer";
-            
-            // Link to same device as main thermostat
-            JsonObject device = ds18b20SupplyDoc.createNestedObject("device");
-            device["identifiers"][0] = hostname;
-            device["name"] = hostname;
-            device["model"] = PROJECT_NAME_SHORT;
-            device["manufacturer"] = "TDC";
-            device["sw_version"] = sw_version;
-            
-            char supplyBuffer[512];
-            serializeJson(ds18b20SupplyDoc, supplyBuffer);
-            mqttClient.publish(supplyConfigTopic.c_str(), supplyBuffer, true);
-            
-            debugLog("Published DS18B20 supply sensor discovery to Home Assistant\n");
-        } else {
-            // Remove sensor if not present
-            String supplyConfigTopic = "homeassistant/sensor/" + hostname + "_ds18b20_supply/config";
-            mqttClient.publish(supplyConfigTopic.c_str(), "", true);
-        }
-        
-        // Publish DS18B20 return temperature sensor discovery if present
-        debugLog("DS18B20 Return Sensor Present: %s\n", ds18b20ReturnSensorPresent ? "YES" : "NO");
-        if (ds18b20ReturnSensorPresent) {
-            StaticJsonDocument<512> ds18b20ReturnDoc;
-            String returnConfigTopic = "homeassistant/sensor/" + hostname + "_ds18b20_return/config";
-            
-            ds18b20ReturnDoc["name"] = "Hydronic Return Temperature";
-            ds18b20ReturnDoc["device_class"] = "temperature";
-            ds18b20ReturnDoc["state_topic"] = hostname + "/ds18b20_return_temperature";
-            ds18b20ReturnDoc["unit_of_measurement"] = "°F";
-            ds18b20ReturnDoc["unique_id"] = hostname + "_ds18b20_return";
-            ds18b20ReturnDoc["state_class"] = "measurement";
-            ds18b20ReturnDoc["icon"] = "mdi:thermometer";
-            
-            // Link to same device as main thermostat
-            JsonObject device = ds18b20ReturnDoc.createNestedObject("device");
-            device["identifiers"][0] = hostname;
-            device["name"] = hostname;
-            device["model"] = PROJECT_NAME_SHORT;
-            device["manufacturer"] = "TDC";
-            device["sw_version"] = sw_version;
-            
-            char returnBuffer[512];
-            serializeJson(ds18b20ReturnDoc, returnBuffer);
-            mqttClient.publish(returnConfigTopic.c_str(), returnBuffer, true);
-            
-            debugLog("Published DS18B20 return sensor discovery to Home Assistant\n");
-        } else {
-            // Remove sensor if not present
-            String returnConfigTopic = "homeassistant/sensor/" + hostname + "_ds18b20_return/config";
-            mqttClient.publish(returnConfigTopic.c_str(), "", true);
+    }
+}
+
+// "homeassistant/<platform>/<object id>/config" -> platform, object id
+static void splitDiscoveryTopic(const String& configTopic, String& platform, String& objectId)
+{
+    int first = configTopic.indexOf('/');
+    int second = configTopic.indexOf('/', first + 1);
+    int last = configTopic.lastIndexOf('/');
+    platform = configTopic.substring(first + 1, second);
+    objectId = configTopic.substring(second + 1, last);
+}
+
+// Device-based payload: the shared device block once, then every entity as a
+// component. Removed entities are sent as just their platform, which is how
+// HA is told to drop a component.
+static void writeDeviceDiscovery(Print& out, JsonDocument& doc)
+{
+    doc.clear();
+    addDiscoveryDevice(doc);
+    out.print("{\"device\":");
+    serializeJson(doc["device"], out);
+
+    doc.clear();
+    doc["name"] = PROJECT_NAME_SHORT;
+    doc["sw_version"] = sw_version;
+    out.print(",\"origin\":");
+    serializeJson(doc, out);
+
+    out.print(",\"components\":{");
+    bool first = true;
+    for (int entity = 0; entity < DISCOVERY_ENTITY_COUNT; entity++) {
+        String configTopic, platform, objectId;
+        doc.clear();
+        DiscoveryResult result = buildDiscoveryEntity(entity, configTopic, doc);
+        if (result == DISCOVERY_SKIP) continue;
+
+        splitDiscoveryTopic(configTopic, platform, objectId);
+        if (result == DISCOVERY_REMOVE) doc.clear();
+        doc.remove("device");
+        doc["platform"] = platform;
+
+        if (!first) out.print(',');
+        first = false;
+        out.print('"');
+        out.print(objectId);
+        out.print("\":");
+        serializeJson(doc, out);
+    }
+    out.print("}}");
+}
+
+// MQTT task: publish a payload straight from the caller's memory. Only the
+// topic goes through the PubSubClient buffer.
+bool publishStreamed(const char* topic, const uint8_t* payload, size_t length, bool retained)
+{
+    if (!mqttClient.beginPublish(topic, length, retained)) return false;
+    size_t written = mqttClient.write(payload, length);
+    if (written != length) {
+        // A short write leaves a corrupt packet; drop the connection
+        mqttClient.disconnect();
+        return false;
+    }
+    return mqttClient.endPublish() != 0;
+}
+
+// MQTT task: serialize `doc` into the packet. `length` is from a
+// DiscoveryWriter(NULL) pass over the same document.
+static bool publishJsonStreamed(const char* topic, JsonDocument& doc, size_t length, bool retained)
+{
+    if (!mqttClient.beginPublish(topic, length, retained)) return false;
+    DiscoveryWriter writer(&mqttClient);
+    serializeJson(doc, writer);
+    writer.flush();
+    if (writer.length != length) {
+        LOG_WARN(MQTT, "Streamed publish to %s wrote %u of %u bytes\n", topic,
+                 (unsigned)writer.length, (unsigned)length);
+        mqttClient.disconnect();
+        return false;
+    }
+    return mqttClient.endPublish() != 0;
+}
+
+static String deviceDiscoveryTopic()
+{
+    return "homeassistant/device/" + mqttHostname + "/config";
+}
+
+// MQTT task: publish the device payload if it changed. It is built twice,
+// once to get its length and hash, once streamed into the MQTT packet, so no
+// buffer for the whole ~30KB message is needed.
+static bool publishDeviceDiscovery(JsonDocument& doc)
+{
+    DiscoveryWriter meter(NULL);
+    writeDeviceDiscovery(meter, doc);
+    uint32_t hash = meter.hash == 0 ? 1 : meter.hash;
+    if (hash == deviceDiscoveryHash) {
+        LOG_DEBUG(MQTT, "Home Assistant device discovery unchanged\n");
+        return true;
+    }
+
+    String configTopic = deviceDiscoveryTopic();
+    if (!mqttClient.beginPublish(configTopic.c_str(), meter.length, true)) {
+        LOG_WARN(MQTT, "Device discovery publish failed\n");
+        return false;
+    }
+    DiscoveryWriter writer(&mqttClient);
+    writeDeviceDiscovery(writer, doc);
+    writer.flush();
+    if (!mqttClient.endPublish() || writer.length != meter.length) {
+        // A length mismatch leaves a corrupt packet; drop the connection
+        LOG_WARN(MQTT, "Device discovery publish failed (%u of %u bytes)\n",
+                 (unsigned)writer.length, (unsigned)meter.length);
+        if (writer.length != meter.length) mqttClient.disconnect();
+        return false;
+    }
+    deviceDiscoveryHash = hash;
+    LOG_INFO(MQTT, "Home Assistant device discovery published (%u bytes)\n", (unsigned)meter.length);
+    return true;
+}
+
+// MQTT task, after the discovery mode setting changed: remove the configs
+// published the old way before publishing the new ones, so HA never sees a
+// unique_id twice. Returns true once done.
+static bool clearDiscoveryModeStep(JsonDocument& doc)
+{
+    if (discoveryDeviceMode) {
+        if (!mqttClient.publish(deviceDiscoveryTopic().c_str(), "", true)) {
+            discoveryNext = DISCOVERY_ENTITY_COUNT;
+            return false;
         }
-        
-        // Publish shower mode switch discovery if feature is enabled
-        if (showerModeEnabled) {
-            StaticJsonDocument<512> showerDoc;
-            String showerConfigTopic = "homeassistant/switch/" + hostname + "_shower_mode/config";
-            
-            showerDoc["name"] = "Shower Mode";
-            showerDoc["state_topic"] = hostname + "/shower_mode";
-            showerDoc["command_topic"] = hostname + "/shower_mode/set";
-            showerDoc["payload_on"] = "ON";
-            showerDoc["payload_off"] = "OFF";
-            showerDoc["state_on"] = "ON";
-            showerDoc["state_off"] = "OFF";
-            showerDoc["unique_id"] = hostname + "_shower_mode";
-            showerDoc["icon"] = "mdi:shower";
-            
-            // Link to same device as main thermostat
-            JsonObject device = showerDoc.createNestedObject("device");
-            device["identifiers"][0] = hostname;
-            device["name"] = hostname;
-            device["model"] = PROJECT_NAME_SHORT;
-            device["manufacturer"] = "TDC";
-            device["sw_version"] = sw_version;
-            
-            char showerBuffer[512];
-            serializeJson(showerDoc, showerBuffer);
-            mqttClient.publish(showerConfigTopic.c_str(), showerBuffer, true);
-            
-            debugLog("Published Shower Mode switch discovery to Home Assistant\n");
-        } else {
-            // If disabled, remove the switch entity from HA by sending empty retained config
-            String showerConfigTopic = "homeassistant/switch/" + hostname + "_shower_mode/config";
-            mqttClient.publish(showerConfigTopic.c_str(), "", true);
-            debugLog("Removed Shower Mode switch discovery from Home Assistant (disabled)\n");
+    } else {
+        // Per-entity configs survive reboots, so clear every topic, not only
+        // the ones published this boot
+        int budget = DISCOVERY_ENTITIES_PER_PASS;
+        while (discoveryNext < DISCOVERY_ENTITY_COUNT && budget-- > 0) {
+            String configTopic;
+            doc.clear();
+            buildDiscoveryEntity(discoveryNext, configTopic, doc);
+            if (!mqttClient.publish(configTopic.c_str(), "", true)) {
+                discoveryNext = DISCOVERY_ENTITY_COUNT;
+                return false;
+            }
+            discoveryNext++;
         }
-        
-        // Publish schedule enabled switch discovery
-        StaticJsonDocument<512> scheduleDoc;
-        String scheduleConfigTopic = "homeassistant/switch/" + hostname + "_schedule_enabled/config";
-        
-        scheduleDoc["name"] = "Schedule Enabled";
-        scheduleDoc["state_topic"] = hostname + "/schedule_enabled";
-        scheduleDoc["command_topic"] = hostname + "/schedule_enabled/set";
-        scheduleDoc["payload_on"] = "on";
-        scheduleDoc["payload_off"] = "off";
-        scheduleDoc["state_on"] = "on";
-        scheduleDoc["state_off"] = "off";
-        scheduleDoc["unique_id"] = hostname + "_schedule_enabled";
-        scheduleDoc["icon"] = "mdi:calendar-clock";
-        
-        // Link to same device as main thermostat
-        JsonObject scheduleDevice = scheduleDoc.createNestedObject("device");
-        scheduleDevice["identifiers"][0] = hostname;
-        scheduleDevice["name"] = hostname;
-        scheduleDevice["model"] = PROJECT_NAME_SHORT;
-        scheduleDevice["manufacturer"] = "TDC";
-        scheduleDevice["sw_version"] = sw_version;
-        
-        char scheduleBuffer[512];
-        serializeJson(scheduleDoc, scheduleBuffer);
-        mqttClient.publish(scheduleConfigTopic.c_str(), scheduleBuffer, true);
-        
-        debugLog("Published Schedule Enabled switch discovery to Home Assistant\n");
-        
-        // Publish schedule data sensors and controls for each day/period
-        // dayNames order matches weekSchedule array: 0=Sunday, 1=Monday, ..., 6=Saturday
-        const char* dayNames[7] = {"Sunday", "Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday"};
-        const char* periodIds[2] = {"day", "night"};
-        const char* periodNames[2] = {"Day", "Night"};
-        const char* periodKeys[2] = {"day_period", "night_period"};
-        
-        for (int day = 0; day < 7; day++) {
-            String dayLower = String(dayNames[day]);
-            dayLower.toLowerCase();
-            String scheduleStateTopic = hostname + "/schedule/" + dayLower;
+        if (discoveryNext < DISCOVERY_ENTITY_COUNT) return false;
+    }
 
-            // Sensor with full JSON attributes
-            {
-                StaticJsonDocument<512> scheduleDataDoc;
-                String scheduleDataConfigTopic = "homeassistant/sensor/" + hostname + "_schedule_" + dayLower + "/config";
-                
-                scheduleDataDoc["name"] = String("Schedule ") + dayNames[day];
-                scheduleDataDoc["state_topic"] = scheduleStateTopic;
-                scheduleDataDoc["value_template"] = "{{ value_json.day_name }}";
-                scheduleDataDoc["json_attributes_topic"] = scheduleStateTopic;
-                scheduleDataDoc["unique_id"] = hostname + "_schedule_" + dayLower;
-                scheduleDataDoc["icon"] = "mdi:calendar-clock";
-                
-                JsonObject scheduleDataDevice = scheduleDataDoc.createNestedObject("device");
-                scheduleDataDevice["identifiers"][0] = hostname;
-                scheduleDataDevice["name"] = hostname;
-                scheduleDataDevice["model"] = PROJECT_NAME_SHORT;
-                scheduleDataDevice["manufacturer"] = "TDC";
-                scheduleDataDevice["sw_version"] = sw_version;
-                
-                char scheduleDataBuffer[512];
-                serializeJson(scheduleDataDoc, scheduleDataBuffer);
-                mqttClient.publish(scheduleDataConfigTopic.c_str(), scheduleDataBuffer, true);
-            }
+    LOG_INFO(MQTT, "Home Assistant discovery switched to %s configs\n", mqttDeviceDiscovery ? "device" : "per-entity");
+    discoveryDeviceMode = mqttDeviceDiscovery;
+    memset(discoveryHashes, 0, sizeof(discoveryHashes));
+    deviceDiscoveryHash = 0;
+    publishHomeAssistantDiscovery();
+    return true;
+}
 
-            // Day enabled switch
-            {
-                StaticJsonDocument<512> dayEnableDoc;
-                String configTopic = "homeassistant/switch/" + hostname + "_schedule_" + dayLower + "_enabled/config";
-                
-                dayEnableDoc["name"] = String("Schedule ") + dayNames[day] + " Enabled";
-                dayEnableDoc["state_topic"] = scheduleStateTopic;
-                dayEnableDoc["value_template"] = "{{ 'ON' if value_json.day_enabled else 'OFF' }}";
-                dayEnableDoc["command_topic"] = hostname + "/schedule/set";
-                dayEnableDoc["command_template"] = String("{\"day\":") + day + ",\"enabled\": {{ 'true' if value == 'ON' else 'false' }} }";
-                dayEnableDoc["payload_on"] = "ON";
-                dayEnableDoc["payload_off"] = "OFF";
-                dayEnableDoc["unique_id"] = hostname + "_schedule_" + dayLower + "_enabled";
-                dayEnableDoc["icon"] = "mdi:toggle-switch";
-                
-                JsonObject dev = dayEnableDoc.createNestedObject("device");
-                dev["identifiers"][0] = hostname;
-                dev["name"] = hostname;
-                dev["model"] = PROJECT_NAME_SHORT;
-                dev["manufacturer"] = "TDC";
-                dev["sw_version"] = sw_version;
-                
-                char buf[512];
-                serializeJson(dayEnableDoc, buf);
-                mqttClient.publish(configTopic.c_str(), buf, true);
-            }
+// MQTT task: start a discovery pass. Entities already published with the
+// same config are skipped, so this is cheap to call on every reconnect.
+void publishHomeAssistantDiscovery()
+{
+    discoveryNext = 0;
+    discoveryPublished = 0;
+    discoveryUnchanged = 0;
+}
 
-            // Per-period controls
-            for (int p = 0; p < 2; p++) {
-                const char* periodId = periodIds[p];
-                const char* periodName = periodNames[p];
-                const char* periodKey = periodKeys[p];
-
-                // Temperature numbers (heat/cool/auto)
-                const char* tempKeys[3] = {"heat", "cool", "auto"};
-                for (int t = 0; t < 3; t++) {
-                    StaticJsonDocument<512> numDoc;
-                    String configTopic = "homeassistant/number/" + hostname + "_schedule_" + dayLower + "_" + periodId + "_" + tempKeys[t] + "/config";
-                    
-                    char tempFirst = toupper(tempKeys[t][0]);
-                    numDoc["name"] = String("Schedule ") + dayNames[day] + " " + periodName + " " + String(tempFirst) + String(tempKeys[t] + 1);
-                    numDoc["state_topic"] = scheduleStateTopic;
-                    numDoc["value_template"] = String("{{ value_json.") + periodKey + "." + tempKeys[t] + " }}";
-                    numDoc["command_topic"] = hostname + "/schedule/set";
-                    numDoc["command_template"] = String("{\"day\":") + day + ",\"period\":\"" + periodId + "\",\"" + tempKeys[t] + "\":{{ value }}}";
-                    numDoc["min"] = 45; // reasonable bounds
-                    numDoc["max"] = 90;
-                    numDoc["step"] = 0.5;
-                    numDoc["unit_of_measurement"] = "°F";
-                    numDoc["unique_id"] = hostname + "_schedule_" + dayLower + "_" + periodId + "_" + tempKeys[t];
-                    numDoc["mode"] = "box";
-                    
-                    JsonObject dev = numDoc.createNestedObject("device");
-                    dev["identifiers"][0] = hostname;
-                    dev["name"] = hostname;
-                    dev["model"] = PROJECT_NAME_SHORT;
-                    dev["manufacturer"] = "TDC";
-                    dev["sw_version"] = sw_version;
-                    
-                    char buf[512];
-                    serializeJson(numDoc, buf);
-                    mqttClient.publish(configTopic.c_str(), buf, true);
-                }
+// MQTT task: forget what was published and start over
+void invalidateHomeAssistantDiscovery()
+{
+    memset(discoveryHashes, 0, sizeof(discoveryHashes));
+    deviceDiscoveryHash = 0;
+    publishHomeAssistantDiscovery();
+}
 
-                // Time text entity (HH:MM)
-                {
-                    StaticJsonDocument<512> timeDoc;
-                    String configTopic = "homeassistant/text/" + hostname + "_schedule_" + dayLower + "_" + periodId + "_time/config";
-                    
-                    timeDoc["name"] = String("Schedule ") + dayNames[day] + " " + periodName + " Time";
-                    timeDoc["state_topic"] = scheduleStateTopic;
-                    timeDoc["value_template"] = String("{{ value_json.") + periodKey + ".time }}";
-                    timeDoc["command_topic"] = hostname + "/schedule/set";
-                    timeDoc["command_template"] = String("{\"day\":") + day + ",\"period\":\"" + periodId + "\",\"hour\": {{ value.split(':')[0] | int }},\"minute\": {{ value.split(':')[1] | int }} }";
-                    timeDoc["pattern"] = "^([01]\\d|2[0-3]):[0-5]\\d$";
-                    timeDoc["unique_id"] = hostname + "_schedule_" + dayLower + "_" + periodId + "_time";
-                    timeDoc["icon"] = "mdi:clock-time-four-outline";
-                    
-                    JsonObject dev = timeDoc.createNestedObject("device");
-                    dev["identifiers"][0] = hostname;
-                    dev["name"] = hostname;
-                    dev["model"] = PROJECT_NAME_SHORT;
-                    dev["manufacturer"] = "TDC";
-                    dev["sw_version"] = sw_version;
-                    
-                    char buf[512];
-                    serializeJson(timeDoc, buf);
-                    mqttClient.publish(configTopic.c_str(), buf, true);
-                }
+// MQTT task: publish up to DISCOVERY_ENTITIES_PER_PASS changed entities
+void publishHomeAssistantDiscoveryStep()
+{
+    static StaticJsonDocument<1024> doc; // Static: keeps ~1KB off the task stack
 
-                // Active switch
-                {
-                    StaticJsonDocument<512> activeDoc;
-                    String configTopic = "homeassistant/switch/" + hostname + "_schedule_" + dayLower + "_" + periodId + "_active/config";
-                    
-                    activeDoc["name"] = String("Schedule ") + dayNames[day] + " " + periodName + " Active";
-                    activeDoc["state_topic"] = scheduleStateTopic;
-                    activeDoc["value_template"] = String("{{ 'ON' if value_json.") + periodKey + ".active else 'OFF' }}";
-                    activeDoc["command_topic"] = hostname + "/schedule/set";
-                    activeDoc["command_template"] = String("{\"day\":") + day + ",\"period\":\"" + periodId + "\",\"active\": {{ 'true' if value == 'ON' else 'false' }} }";
-                    activeDoc["payload_on"] = "ON";
-                    activeDoc["payload_off"] = "OFF";
-                    activeDoc["unique_id"] = hostname + "_schedule_" + dayLower + "_" + periodId + "_active";
-                    activeDoc["icon"] = "mdi:power";
-                    
-                    JsonObject dev = activeDoc.createNestedObject("device");
-                    dev["identifiers"][0] = hostname;
-                    dev["name"] = hostname;
-                    dev["model"] = PROJECT_NAME_SHORT;
-                    dev["manufacturer"] = "TDC";
-                    dev["sw_version"] = sw_version;
-                    
-                    char buf[512];
-                    serializeJson(activeDoc, buf);
-                    mqttClient.publish(configTopic.c_str(), buf, true);
-                }
-            }
+    if (discoveryNext >= DISCOVERY_ENTITY_COUNT) return;
+    if (!discoveryModeKnown) {
+        discoveryDeviceMode = mqttDeviceDiscovery;
+        discoveryModeKnown = true;
+    }
+    if (discoveryDeviceMode != mqttDeviceDiscovery) {
+        clearDiscoveryModeStep(doc); // The new mode starts on a later tick
+        return;
+    }
+    if (discoveryDeviceMode) {
+        publishDeviceDiscovery(doc);
+        discoveryNext = DISCOVERY_ENTITY_COUNT;
+        return;
+    }
+
+    int budget = DISCOVERY_ENTITIES_PER_PASS;
+    while (discoveryNext < DISCOVERY_ENTITY_COUNT && budget > 0) {
+        int entity = discoveryNext;
+        String configTopic;
+        doc.clear();
+        DiscoveryResult result = buildDiscoveryEntity(entity, configTopic, doc);
+        if (result == DISCOVERY_SKIP) {
+            discoveryNext++;
+            continue;
         }
-        
-        debugLog("Published Schedule Data sensors and controls (7 days) discovery to Home Assistant\n");
+
+        // Measure and hash the config without keeping it: it is serialized
+        // again straight into the packet if it has to go out
+        DiscoveryWriter meter(NULL, discoveryHash(configTopic.c_str(), configTopic.length(), 2166136261u));
+        if (result == DISCOVERY_PUBLISH) serializeJson(doc, meter);
+        size_t length = meter.length;
+        uint32_t hash = meter.hash == 0 ? 1 : meter.hash; // 0 marks "not published"
+
+        if (hash == discoveryHashes[entity]) {
+            discoveryUnchanged++;
+            discoveryNext++;
+            continue;
+        }
+        bool ok = length > 0 ? publishJsonStreamed(configTopic.c_str(), doc, length, true)
+                             : mqttClient.publish(configTopic.c_str(), "", true);
+        if (!ok) {
+            // Connection trouble: stop; the pass after the reconnect skips
+            // everything that already went out
+            LOG_WARN(MQTT, "Discovery publish failed at entity %d, pausing\n", entity);
+            discoveryNext = DISCOVERY_ENTITY_COUNT;
+            return;
+        }
+        LOG_TRACE(MQTT, "Discovery %s: %u bytes\n", configTopic.c_str(), (unsigned)length);
+        discoveryHashes[entity] = hash;
+        discoveryPublished++;
+        discoveryNext++;
+        budget--;
     }
-    else
-    {
-        // Remove all entities by publishing empty payloads
-        String configTopic = "homeassistant/climate/" + hostname + "/config";
-        String availabilityTopic = hostname + "/availability";
-        mqttClient.publish(configTopic.c_str(), "");
-        mqttClient.publish(availabilityTopic.c_str(), "offline", true);
+
+    if (discoveryNext == DISCOVERY_ENTITY_COUNT && (discoveryPublished || discoveryUnchanged)) {
+        LOG_INFO(MQTT, "Home Assistant discovery: %u published, %u unchanged\n",
+                 (unsigned)discoveryPublished, (unsigned)discoveryUnchanged);
+        discoveryPublished = 0;
+        discoveryUnchanged = 0;
     }
 }
 
+// MQTT task, when MQTT is being switched off: remove the climate entity (or
+// the whole device) and mark the device offline
+void removeHomeAssistantDiscovery()
+{
+    bool deviceMode = discoveryModeKnown ? discoveryDeviceMode : mqttDeviceDiscovery;
+    String configTopic = deviceMode ? deviceDiscoveryTopic() : "homeassistant/climate/" + mqttHostname + "/config";
+    mqttClient.publish(configTopic.c_str(), "");
+    mqttClient.publish(mqttTopic(MQTT_TOPIC_AVAILABILITY), "offline", true);
+    memset(discoveryHashes, 0, sizeof(discoveryHashes));
+    deviceDiscoveryHash = 0;
+    discoveryNext = DISCOVERY_ENTITY_COUNT;
+}
+
 // Reset MQTT data cache to force republish all values
 void resetMQTTDataCache()
 {
-    debugLog("[MQTT] Resetting data cache - all values will be republished\n");
+    LOG_DEBUG(MQTT, "Resetting data cache - all values will be republished\n");
     mqttLastTemp = 0.0;
     mqttLastHumidity = 0.0;
     mqttLastSetTempHeat = 0.0;
@@ -3254,451 +3433,672 @@ void resetMQTTDataCache()
     mqttLastThermostatMode = "";
     mqttLastFanMode = "";
     mqttLastAction = "";
+    mqttLastHydronicTemp = -999.0;
+    mqttLastScheduleEnabled = -1;
+    mqttLastScheduleOverride = -1;
+    mqttLastActivePeriod = "";
+    mqttLastScheduleDay = -1;
+    mqttLastAvailabilitySent = false;
+    mqttLastCacheReset = millis();
+    mqttStateInvalidate();
 }
 
-void mqttCallback(char* topic, byte* payload, unsigned int length)
-{
-    String message;
-    for (unsigned int i = 0; i < length; i++)
-    {
-        message += (char)payload[i];
-    }
-
-    debugLog("Message arrived [%s] %s\n", topic, message.c_str());
-
-    // Set flag to indicate we're handling an MQTT message to prevent publish loops
-    handlingMQTTMessage = true;
-    bool settingsNeedSaving = false;
-    bool scheduleNeedsSaving = false;
+// Per-command MQTT handlers. Each returns the MQTT_SAVE_* flags for what it
+// changed so mqttCallback() can persist once after the handler returns.
+static const uint8_t MQTT_SAVE_SETTINGS = 1;
+static const uint8_t MQTT_SAVE_SCHEDULE = 2;
 
-    // Declare all topic strings at the beginning
-    String modeSetTopic = hostname + "/mode/set";
-    String fanModeSetTopic = hostname + "/fan_mode/set";
-    String tempSetTopic = hostname + "/target_temperature/set";
-    String showerModeSetTopic = hostname + "/shower_mode/set";
-    String scheduleEnabledSetTopic = hostname + "/schedule_enabled/set";
-    String scheduleOverrideSetTopic = hostname + "/schedule_override/set";
-    String scheduleSetTopic = hostname + "/schedule/set";
+// <hostname>/target_temperature/set: setpoint for the current mode
+static uint8_t mqttHandleTargetTemperature(const char* message)
+{
+    uint8_t saves = 0;
+    const char* setpoint = thermostatMode == "heat" ? "setTempHeat" :
+                           thermostatMode == "cool" ? "setTempCool" :
+                           thermostatMode == "auto" ? "setTempAuto" : NULL;
+    // Parsed and clamped to the setpoint's range by the registry
+    bool tempChanged = setpoint != NULL && settingSetText(settingFind(setpoint), message) == SETTING_CHANGED;
+    if (tempChanged) {
+        LOG_INFO(MQTT, "Updated %s target temperature to: %.1f\n", thermostatMode.c_str(), settingFloat(setpoint));
+        saves |= MQTT_SAVE_SETTINGS;
+    }
+    
+    // If schedule is enabled and not overridden, trigger a temporary override and persist it
+    if (tempChanged && scheduleEnabled && !scheduleOverride) {
+        scheduleOverride = true;
+        overrideEndTime = millis() + (scheduleOverrideDuration * 60000UL);
+        LOG_INFO(SCHEDULE, "MQTT temperature change triggered override\n");
+        saves |= MQTT_SAVE_SCHEDULE;
+    }
+    controlRelays(currentTemp); // Apply changes to relays
+    return saves;
+}
 
-    if (String(topic) == modeSetTopic)
-    {
-        // Accept only supported HVAC modes from MQTT command topic.
-        bool validMode = (message == "off" || message == "heat" || message == "cool" || message == "auto");
-        if (!validMode) {
-            debugLog("Ignored invalid thermostat mode from MQTT: %s\n", message.c_str());
-        }
-        else if (message != thermostatMode)
-        {
-            thermostatMode = message;
-            debugLog("Updated thermostat mode to: %s\n", thermostatMode.c_str());
-            settingsNeedSaving = true;
-            controlRelays(currentTemp); // Apply changes to relays
-            setDisplayUpdateFlag(); // Option C: Request display update
-        }
-    }
-    else if (String(topic) == fanModeSetTopic)
+// <hostname>/mode/set: off, heat, cool or auto (anything else is rejected and logged)
+static uint8_t mqttHandleMode(const char* message)
+{
+    uint8_t saves = 0;
+    if (settingSetText(settingFind("thermostatMode"), message) == SETTING_CHANGED)
     {
-        if (message != fanMode)
-        {
-            fanMode = message;
-            debugLog("Updated fan mode to: %s\n", fanMode.c_str());
-            settingsNeedSaving = true;
-            controlRelays(currentTemp); // Apply changes to relays
-        }
+        LOG_INFO(MQTT, "Updated thermostat mode to: %s\n", thermostatMode.c_str());
+        saves |= MQTT_SAVE_SETTINGS;
+        controlRelays(currentTemp); // Apply changes to relays
+        setDisplayUpdateFlag(); // Option C: Request display update
     }
-    else if (String(topic) == tempSetTopic)
+    return saves;
+}
+
+// <hostname>/fan_mode/set: auto, on or cycle
+static uint8_t mqttHandleFanMode(const char* message)
+{
+    uint8_t saves = 0;
+    if (settingSetText(settingFind("fanMode"), message) == SETTING_CHANGED)
     {
-        float newTargetTemp = constrain(message.toFloat(), 50.0f, 95.0f);
-        bool tempChanged = false;
-        if (thermostatMode == "heat" && newTargetTemp != setTempHeat)
-        {
-            setTempHeat = newTargetTemp;
-            debugLog("Updated heating target temperature to: %.1f\n", setTempHeat);
-            settingsNeedSaving = true;
-            tempChanged = true;
-        }
-        else if (thermostatMode == "cool" && newTargetTemp != setTempCool)
-        {
-            setTempCool = newTargetTemp;
-            debugLog("Updated cooling target temperature to: %.1f\n", setTempCool);
-            settingsNeedSaving = true;
-            tempChanged = true;
-        }
-        else if (thermostatMode == "auto" && newTargetTemp != setTempAuto)
-        {
-            setTempAuto = newTargetTemp;
-            debugLog("Updated auto target temperature to: %.1f\n", setTempAuto);
-            settingsNeedSaving = true;
-            tempChanged = true;
-        }
-        
-        // If schedule is enabled and not overridden, trigger a temporary override and persist it
-        if (tempChanged && scheduleEnabled && !scheduleOverride) {
-            scheduleOverride = true;
-            overrideEndTime = millis() + (scheduleOverrideDuration * 60000UL);
-            debugLog("SCHEDULE: MQTT temperature change triggered override\n");
-            scheduleNeedsSaving = true;
-        }
+        LOG_INFO(MQTT, "Updated fan mode to: %s\n", fanMode.c_str());
+        saves |= MQTT_SAVE_SETTINGS;
         controlRelays(currentTemp); // Apply changes to relays
     }
-    else if (String(topic) == showerModeSetTopic)
-    {
-        if (showerModeEnabled) {
-            // Only allow toggle if shower mode is enabled
-            if (message == "ON" || message == "on") {
-                if (!showerModeActive) {
-                    showerModeActive = true;
-                    showerModeStartTime = millis();
-                    debugLog("[SHOWER MODE] Activated via MQTT\n");
-                    updateDisplay(currentTemp, currentHumidity);
-                    sendMQTTData(); // Publish state back to HA
-                }
-            } else if (message == "OFF" || message == "off") {
-                if (showerModeActive) {
-                    showerModeActive = false;
-                    debugLog("[SHOWER MODE] Deactivated via MQTT\n");
-                    updateDisplay(currentTemp, currentHumidity);
-                    sendMQTTData(); // Publish state back to HA
-                }
+    return saves;
+}
+
+// <hostname>/shower_mode/set: ON or OFF
+static uint8_t mqttHandleShowerMode(const char* message)
+{
+    uint8_t saves = 0;
+    if (showerModeEnabled) {
+        // Only allow toggle if shower mode is enabled
+        if (strcmp(message, "ON") == 0 || strcmp(message, "on") == 0) {
+            if (!showerModeActive) {
+                showerModeActive = true;
+                showerModeStartTime = millis();
+                LOG_INFO(HVAC, "Shower mode: Activated via MQTT\n");
+                updateDisplay(currentTemp, currentHumidity);
+                sendMQTTData(); // Publish state back to HA
+            }
+        } else if (strcmp(message, "OFF") == 0 || strcmp(message, "off") == 0) {
+            if (showerModeActive) {
+                showerModeActive = false;
+                LOG_INFO(HVAC, "Shower mode: Deactivated via MQTT\n");
+                updateDisplay(currentTemp, currentHumidity);
+                sendMQTTData(); // Publish state back to HA
             }
         }
     }
-    else if (String(topic) == scheduleEnabledSetTopic)
-    {
-        bool newScheduleEnabled = (message == "ON" || message == "on" || message == "1");
-        if (newScheduleEnabled != scheduleEnabled) {
-            scheduleEnabled = newScheduleEnabled;
-            debugLog("SCHEDULE: Via MQTT, enabled=%s\n", scheduleEnabled ? "true" : "false");
-            if (!scheduleEnabled) {
-                // Disable override when schedule is disabled
+    return saves;
+}
+
+// <hostname>/schedule_enabled/set: ON or OFF
+static uint8_t mqttHandleScheduleEnabled(const char* message)
+{
+    uint8_t saves = 0;
+    bool newScheduleEnabled = (strcmp(message, "ON") == 0 || strcmp(message, "on") == 0 ||
+                               strcmp(message, "1") == 0);
+    if (newScheduleEnabled != scheduleEnabled) {
+        scheduleEnabled = newScheduleEnabled;
+        LOG_INFO(SCHEDULE, "Via MQTT, enabled=%s\n", scheduleEnabled ? "true" : "false");
+        if (!scheduleEnabled) {
+            // Disable override when schedule is disabled
+            scheduleOverride = false;
+            overrideEndTime = 0;
+            activePeriod = "manual";
+        }
+        saves |= MQTT_SAVE_SCHEDULE;
+        sendMQTTData(); // Publish updated state back to HA
+    }
+    return saves;
+}
+
+// <hostname>/schedule_override/set: resume, temporary or permanent
+static uint8_t mqttHandleScheduleOverride(const char* message)
+{
+    uint8_t saves = 0;
+    if (scheduleEnabled) {
+        if (strcmp(message, "resume") == 0) {
+            if (scheduleOverride) {
                 scheduleOverride = false;
                 overrideEndTime = 0;
-                activePeriod = "manual";
+                LOG_INFO(SCHEDULE, "Via MQTT, override resumed (schedule active)\n");
+                saves |= MQTT_SAVE_SCHEDULE;
+                sendMQTTData();
             }
-            scheduleNeedsSaving = true;
-            sendMQTTData(); // Publish updated state back to HA
-        }
-    }
-    else if (String(topic) == scheduleOverrideSetTopic)
-    {
-        if (scheduleEnabled) {
-            if (message == "resume") {
-                if (scheduleOverride) {
-                    scheduleOverride = false;
-                    overrideEndTime = 0;
-                    debugLog("SCHEDULE: Via MQTT, override resumed (schedule active)\n");
-                    scheduleNeedsSaving = true;
-                    sendMQTTData();
-                }
-            } else if (message == "temporary") {
-                if (!scheduleOverride) {
-                    scheduleOverride = true;
-                    overrideEndTime = millis() + (scheduleOverrideDuration * 60000UL);
-                    debugLog("SCHEDULE: Via MQTT, override activated (temporary - 2 hours)\n");
-                    scheduleNeedsSaving = true;
-                    sendMQTTData();
-                }
-            } else if (message == "permanent") {
-                if (!scheduleOverride) {
-                    scheduleOverride = true;
-                    overrideEndTime = 0; // Permanent until manually disabled
-                    debugLog("SCHEDULE: Via MQTT, override activated (permanent)\n");
-                    scheduleNeedsSaving = true;
-                    sendMQTTData();
-                }
+        } else if (strcmp(message, "temporary") == 0) {
+            if (!scheduleOverride) {
+                scheduleOverride = true;
+                overrideEndTime = millis() + (scheduleOverrideDuration * 60000UL);
+                LOG_INFO(SCHEDULE, "Via MQTT, override activated (temporary - 2 hours)\n");
+                saves |= MQTT_SAVE_SCHEDULE;
+                sendMQTTData();
+            }
+        } else if (strcmp(message, "permanent") == 0) {
+            if (!scheduleOverride) {
+                scheduleOverride = true;
+                overrideEndTime = 0; // Permanent until manually disabled
+                LOG_INFO(SCHEDULE, "Via MQTT, override activated (permanent)\n");
+                saves |= MQTT_SAVE_SCHEDULE;
+                sendMQTTData();
             }
         }
     }
-    else if (String(topic) == scheduleSetTopic)
-    {
-        // Parse JSON schedule update
-        // Format: {"day": 0, "period": "day", "hour": 6, "minute": 30, "heat": 72.0, "cool": 78.0, "auto": 74.0, "active": true}
-        // Note: MQTT day format is 0=Monday through 6=Sunday
-        // Array format is 0=Sunday through 6=Saturday
-        // Convert MQTT day (Monday=0) to array index (Sunday=0): add 1 and mod 7
-        StaticJsonDocument<256> doc;
-        DeserializationError error = deserializeJson(doc, message);
-        
-        if (!error) {
-            int mqttDay = doc["day"] | -1;
-            String period = doc["period"] | "";
+    return saves;
+}
+
+// Schedule setpoints take the limits of the matching SETTINGS[] entry
+static float clampScheduleSetpoint(const char* setting, float value)
+{
+    const SettingDesc* desc = settingFind(setting);
+    if (desc == NULL || desc->min > desc->max) return value;
+    float clamped = constrain(value, desc->min, desc->max);
+    if (clamped != value) {
+        LOG_WARN(SCHEDULE, "Via MQTT, %s %.1f outside %.0f-%.0f, using %.1f\n",
+                 setting, value, desc->min, desc->max, clamped);
+    }
+    return clamped;
+}
+
+// <hostname>/schedule/set: JSON update of one day/night period
+static uint8_t mqttHandleSchedule(const char* message)
+{
+    uint8_t saves = 0;
+    // Parse JSON schedule update
+    // Format: {"day": 0, "period": "day", "hour": 6, "minute": 30, "heat": 72.0, "cool": 78.0, "auto": 74.0, "active": true}
+    // Note: MQTT day format is 0=Monday through 6=Sunday
+    // Array format is 0=Sunday through 6=Saturday
+    // Convert MQTT day (Monday=0) to array index (Sunday=0): add 1 and mod 7
+    MqttScheduleUpdate update;
+    if (mqttParseScheduleUpdate(message, strlen(message), update)) {
+        int mqttDay = update.day;
+        const char* period = update.period;
+        bool isDayPeriod = strcmp(period, "day") == 0;
+        
+        if (mqttDay >= 0 && mqttDay < 7 && (isDayPeriod || strcmp(period, "night") == 0)) {
+            // Convert MQTT day (0=Monday) to array index (0=Sunday)
+            int day = (mqttDay + 1) % 7;
+            SchedulePeriod* targetPeriod = isDayPeriod ? &weekSchedule[day].day : &weekSchedule[day].night;
             
-            if (mqttDay >= 0 && mqttDay < 7 && (period == "day" || period == "night")) {
-                // Convert MQTT day (0=Monday) to array index (0=Sunday)
-                int day = (mqttDay + 1) % 7;
-                SchedulePeriod* targetPeriod = (period == "day") ? &weekSchedule[day].day : &weekSchedule[day].night;
-                
-                bool changed = false;
-                
-                if (doc.containsKey("hour")) {
-                    int newHour = doc["hour"];
-                    if (newHour >= 0 && newHour <= 23 && newHour != targetPeriod->hour) {
-                        targetPeriod->hour = newHour;
-                        changed = true;
-                    }
-                }
-                
-                if (doc.containsKey("minute")) {
-                    int newMinute = doc["minute"];
-                    if (newMinute >= 0 && newMinute <= 59 && newMinute != targetPeriod->minute) {
-                        targetPeriod->minute = newMinute;
-                        changed = true;
-                    }
-                }
-                
-                if (doc.containsKey("heat")) {
-                    float newHeat = doc["heat"];
-                    if (newHeat != targetPeriod->heatTemp) {
-                        targetPeriod->heatTemp = newHeat;
-                        changed = true;
-                    }
-                }
-                
-                if (doc.containsKey("cool")) {
-                    float newCool = doc["cool"];
-                    if (newCool != targetPeriod->coolTemp) {
-                        targetPeriod->coolTemp = newCool;
-                        changed = true;
-                    }
-                }
-                
-                if (doc.containsKey("auto")) {
-                    float newAuto = doc["auto"];
-                    if (newAuto != targetPeriod->autoTemp) {
-                        targetPeriod->autoTemp = newAuto;
-                        changed = true;
-                    }
-                }
-                
-                if (doc.containsKey("active")) {
-                    bool newActive = doc["active"];
-                    if (newActive != targetPeriod->active) {
-                        targetPeriod->active = newActive;
-                        changed = true;
-                    }
+            bool changed = false;
+            // The parser only guarantees finite numbers
+            if (update.fields & MQTT_SCHEDULE_HEAT) update.heat = clampScheduleSetpoint("setTempHeat", update.heat);
+            if (update.fields & MQTT_SCHEDULE_COOL) update.cool = clampScheduleSetpoint("setTempCool", update.cool);
+            if (update.fields & MQTT_SCHEDULE_AUTO) update.autoTemp = clampScheduleSetpoint("setTempAuto", update.autoTemp);
+            
+            if (update.fields & MQTT_SCHEDULE_HOUR) {
+                if (update.hour >= 0 && update.hour <= 23 && update.hour != targetPeriod->hour) {
+                    targetPeriod->hour = update.hour;
+                    changed = true;
                 }
-                
-                if (doc.containsKey("enabled")) {
-                    bool newEnabled = doc["enabled"];
-                    if (newEnabled != weekSchedule[day].enabled) {
-                        weekSchedule[day].enabled = newEnabled;
-                        changed = true;
-                    }
+            }
+            
+            if (update.fields & MQTT_SCHEDULE_MINUTE) {
+                if (update.minute >= 0 && update.minute <= 59 && update.minute != targetPeriod->minute) {
+                    targetPeriod->minute = update.minute;
+                    changed = true;
                 }
+            }
+            
+            if ((update.fields & MQTT_SCHEDULE_HEAT) && update.heat != targetPeriod->heatTemp) {
+                targetPeriod->heatTemp = update.heat;
+                changed = true;
+            }
+            
+            if ((update.fields & MQTT_SCHEDULE_COOL) && update.cool != targetPeriod->coolTemp) {
+                targetPeriod->coolTemp = update.cool;
+                changed = true;
+            }
+            
+            if ((update.fields & MQTT_SCHEDULE_AUTO) && update.autoTemp != targetPeriod->autoTemp) {
+                targetPeriod->autoTemp = update.autoTemp;
+                changed = true;
+            }
+            
+            if ((update.fields & MQTT_SCHEDULE_ACTIVE) && update.active != targetPeriod->active) {
+                targetPeriod->active = update.active;
+                changed = true;
+            }
+            
+            if ((update.fields & MQTT_SCHEDULE_ENABLED) && update.enabled != weekSchedule[day].enabled) {
+                weekSchedule[day].enabled = update.enabled;
+                changed = true;
+            }
+            
+            if (changed) {
+                saves |= MQTT_SAVE_SCHEDULE;
+                scheduleVersion++;
+                LOG_INFO(SCHEDULE, "Via MQTT, updated day %d (array index %d) %s period\n", mqttDay, day, period);
                 
-                if (changed) {
-                    scheduleNeedsSaving = true;
-                    debugLog("SCHEDULE: Via MQTT, updated day %d (array index %d) %s period\n", mqttDay, day, period.c_str());
+                // If schedule is enabled and not overridden, reapply to take effect immediately
+                if (scheduleEnabled && !scheduleOverride) {
+                    time_t now;
+                    struct tm timeinfo;
+                    time(&now);
+                    localtime_r(&now, &timeinfo);
+                    int currentDay = (timeinfo.tm_wday + 6) % 7; // Convert Sunday=0 to Monday=0
                     
-                    // If schedule is enabled and not overridden, reapply to take effect immediately
-                    if (scheduleEnabled && !scheduleOverride) {
-                        time_t now;
-                        struct tm timeinfo;
-                        time(&now);
-                        localtime_r(&now, &timeinfo);
-                        int currentDay = (timeinfo.tm_wday + 6) % 7; // Convert Sunday=0 to Monday=0
-                        
-                        if (currentDay == day) {
-                            // Current day was modified, reapply schedule
-                            bool isDayPeriod = (period == "day");
-                            applySchedule(day, isDayPeriod);
-                            updateDisplay(currentTemp, currentHumidity);
-                        }
+                    if (currentDay == day) {
+                        // Current day was modified, reapply schedule
+                        applySchedule(day, isDayPeriod);
+                        updateDisplay(currentTemp, currentHumidity);
                     }
-                    
-                    sendMQTTData(); // Publish updated schedule state
                 }
-            } else {
-                debugLog("SCHEDULE: Invalid MQTT schedule update - day=%d, period=%s\n", mqttDay, period.c_str());
+                
+                sendMQTTData(); // Publish updated schedule state
             }
         } else {
-            debugLog("SCHEDULE: Failed to parse MQTT schedule JSON\n");
+            LOG_WARN(SCHEDULE, "Invalid MQTT schedule update - day=%d, period=%s\n", mqttDay, period);
         }
+    } else {
+        LOG_WARN(SCHEDULE, "Failed to parse MQTT schedule JSON\n");
     }
+    return saves;
+}
 
-    // Save settings to flash if they were changed
-    if (settingsNeedSaving) {
-        debugLog("Saving settings changed via MQTT\n");
-        saveSettings();
-        // Update display immediately when settings change via MQTT
-        updateDisplay(currentTemp, currentHumidity);
-        
-        // Set flag for immediate MQTT feedback to Home Assistant
-        mqttFeedbackNeeded = true;
+typedef uint8_t (*MqttCommandHandler)(const char* message);
+
+// Indexed by MqttCommand
+static const MqttCommandHandler MQTT_COMMAND_HANDLERS[MQTT_CMD_COUNT] = {
+    mqttHandleTargetTemperature,
+    mqttHandleMode,
+    mqttHandleFanMode,
+    mqttHandleShowerMode,
+    mqttHandleScheduleEnabled,
+    mqttHandleScheduleOverride,
+    mqttHandleSchedule
+};
+
+// Runs in the MQTT task (from mqttClient.loop()): only copies the command
+// for processMQTTCommands(), except HA's birth message which is handled here
+void mqttCallback(char* topic, byte* payload, unsigned int length)
+{
+    // Home Assistant (re)started: it needs every discovery config again
+    if (strcmp(topic, mqttTopic(MQTT_TOPIC_HA_STATUS)) == 0) {
+        if (length == 6 && memcmp(payload, "online", 6) == 0) {
+            LOG_INFO(MQTT, "Home Assistant online, republishing discovery\n");
+            invalidateHomeAssistantDiscovery();
+        }
+        return;
     }
 
-    if (scheduleNeedsSaving) {
-        debugLog("Saving schedule settings changed via MQTT\n");
-        saveScheduleSettings();
+    MqttCommand command = mqttCommandFromTopic(topic);
+    if (command == MQTT_CMD_UNKNOWN) {
+        LOG_DEBUG(MQTT, "No handler for topic %s\n", topic);
+        return;
     }
 
-    // Clear the handling flag
-    handlingMQTTMessage = false;
+    MqttInbound inbound;
+    if (length >= sizeof(inbound.payload)) {
+        LOG_WARN(MQTT, "Ignored %u byte message on %s\n", length, topic);
+        mqttCommandsDropped++;
+        return;
+    }
+    inbound.command = command;
+    memcpy(inbound.payload, payload, length);
+    inbound.payload[length] = '\0';
+    if (xQueueSend(mqttCommandQueue, &inbound, 0) != pdTRUE) {
+        LOG_WARN(MQTT, "Command queue full, dropped %s\n", topic);
+        mqttCommandsDropped++;
+    }
 }
 
-void sendMQTTData()
+// loop(): run the commands the MQTT task received
+void processMQTTCommands()
 {
-    if (mqttClient.connected())
+    static MqttInbound inbound; // Kept off the loop() stack
+    while (mqttCommandQueue != NULL && xQueueReceive(mqttCommandQueue, &inbound, 0) == pdTRUE)
     {
-        // Publish current temperature
-        if (!isnan(currentTemp) && currentTemp != mqttLastTemp)
-        {
-            String currentTempTopic = hostname + "/current_temperature";
-            char tempStr[10];
-            snprintf(tempStr, sizeof(tempStr), "%.1f", currentTemp);
-            mqttClient.publish(currentTempTopic.c_str(), tempStr, true);
-            mqttLastTemp = currentTemp;
+        LOG_DEBUG(MQTT, "Message arrived [%s] %s\n", mqttCommandName(inbound.command), inbound.payload);
+
+        // Set flag to indicate we're handling an MQTT message to prevent publish loops
+        handlingMQTTMessage = true;
+        uint8_t saves = MQTT_COMMAND_HANDLERS[inbound.command](inbound.payload);
+
+        // Persist what changed; loop() writes it once the burst is over
+        if (saves & MQTT_SAVE_SETTINGS) {
+            LOG_INFO(MQTT, "Settings changed via MQTT\n");
+            settingsMarkDirty(SETTINGS_DIRTY_SETTINGS, NVS_WRITER_MQTT);
+            // Update display immediately when settings change via MQTT
+            updateDisplay(currentTemp, currentHumidity);
+        
+            // Set flag for immediate MQTT feedback to Home Assistant
+            mqttFeedbackNeeded = true;
+        }
+
+        if (saves & MQTT_SAVE_SCHEDULE) {
+            LOG_INFO(MQTT, "Schedule settings changed via MQTT\n");
+            settingsMarkDirty(SETTINGS_DIRTY_SCHEDULE, NVS_WRITER_MQTT);
         }
 
-        // Publish current humidity
-        if (!isnan(currentHumidity) && currentHumidity != mqttLastHumidity)
+        // Clear the handling flag
+        handlingMQTTMessage = false;
+    }
+}
+
+// HVAC action as published to Home Assistant (heating, cooling, idle, off)
+static const char* currentHvacAction()
+{
+    if (thermostatMode == "off") return "off";
+    if (digitalRead(HEAT_RELAY_1_PIN) == HIGH || digitalRead(HEAT_RELAY_2_PIN) == HIGH) return "heating";
+    if (digitalRead(COOL_RELAY_1_PIN) == HIGH || digitalRead(COOL_RELAY_2_PIN) == HIGH ||
+        digitalRead(PUMP_RELAY_PIN) == HIGH) return "cooling";
+    return "idle";
+}
+
+// One retained topic per state field, each sent when its value changes
+static void sendMQTTStateTopics()
+{
+    // Publish current temperature
+    if (!isnan(currentTemp) && currentTemp != mqttLastTemp)
+    {
+        char tempStr[10];
+        snprintf(tempStr, sizeof(tempStr), "%.1f", currentTemp);
+        mqttQueuePublish(MQTT_TOPIC_CURRENT_TEMPERATURE, tempStr, true);
+        mqttLastTemp = currentTemp;
+    }
+
+    // Publish current humidity
+    if (!isnan(currentHumidity) && currentHumidity != mqttLastHumidity)
+    {
+        mqttQueuePublish(MQTT_TOPIC_CURRENT_HUMIDITY, String(currentHumidity, 1).c_str(), true);
+        mqttLastHumidity = currentHumidity;
+    }
+    
+    // Publish barometric pressure if BME280 sensor is active
+    if ((activeSensor == SENSOR_BME280 || activeSensor == SENSOR_BME680) && !isnan(currentPressure))
+    {
+        static float lastPressure = 0.0;
+        if (currentPressure != lastPressure)
         {
-            String currentHumidityTopic = hostname + "/current_humidity";
-            mqttClient.publish(currentHumidityTopic.c_str(), String(currentHumidity, 1).c_str(), true);
-            mqttLastHumidity = currentHumidity;
+            float pressureInHg = currentPressure / 33.8639; // Convert hPa to inHg
+            mqttQueuePublish(MQTT_TOPIC_BAROMETRIC_PRESSURE, String(pressureInHg, 2).c_str(), true);
+            lastPressure = currentPressure;
         }
+    }
+    
+    // Publish gas resistance and air quality if BME680 is active
+    if (activeSensor == SENSOR_BME680)
+    {
+        static float lastGasResistance = 0.0;
+        static float lastAirQuality = 0.0;
         
-        // Publish barometric pressure if BME280 sensor is active
-        if ((activeSensor == SENSOR_BME280 || activeSensor == SENSOR_BME680) && !isnan(currentPressure))
+        if (currentGasResistance != lastGasResistance)
         {
-            static float lastPressure = 0.0;
-            if (currentPressure != lastPressure)
-            {
-                String pressureTopic = hostname + "/barometric_pressure";
-                float pressureInHg = currentPressure / 33.8639; // Convert hPa to inHg
-                mqttClient.publish(pressureTopic.c_str(), String(pressureInHg, 2).c_str(), true);
-                lastPressure = currentPressure;
-            }
+            mqttQueuePublish(MQTT_TOPIC_GAS_RESISTANCE, String(currentGasResistance, 1).c_str(), true);
+            lastGasResistance = currentGasResistance;
         }
         
-        // Publish gas resistance and air quality if BME680 is active
-        if (activeSensor == SENSOR_BME680)
+        if (currentAirQuality != lastAirQuality)
         {
-            static float lastGasResistance = 0.0;
-            static float lastAirQuality = 0.0;
-            
-            if (currentGasResistance != lastGasResistance)
+            mqttQueuePublish(MQTT_TOPIC_AIR_QUALITY_INDEX, String((int)currentAirQuality).c_str(), true);
+            lastAirQuality = currentAirQuality;
+        }
+    }
+
+    // Publish target temperature (set temperature for heating, cooling, or auto)
+    bool modeChanged = (thermostatMode != mqttLastThermostatMode);
+    if (thermostatMode == "heat" && (modeChanged || setTempHeat != mqttLastSetTempHeat))
+    {
+        mqttQueuePublish(MQTT_TOPIC_TARGET_TEMPERATURE, String(setTempHeat, 1).c_str(), true);
+        mqttLastSetTempHeat = setTempHeat;
+    }
+    else if (thermostatMode == "cool" && (modeChanged || setTempCool != mqttLastSetTempCool))
+    {
+        mqttQueuePublish(MQTT_TOPIC_TARGET_TEMPERATURE, String(setTempCool, 1).c_str(), true);
+        mqttLastSetTempCool = setTempCool;
+    }
+    else if (thermostatMode == "auto" && (modeChanged || setTempAuto != mqttLastSetTempAuto))
+    {
+        mqttQueuePublish(MQTT_TOPIC_TARGET_TEMPERATURE, String(setTempAuto, 1).c_str(), true);
+        mqttLastSetTempAuto = setTempAuto;
+    }
+
+    // Publish thermostat mode
+    if (thermostatMode != mqttLastThermostatMode)
+    {
+        mqttQueuePublish(MQTT_TOPIC_MODE, thermostatMode.c_str(), true);
+        mqttLastThermostatMode = thermostatMode;
+    }
+
+    // Publish fan mode
+    if (fanMode != mqttLastFanMode)
+    {
+        mqttQueuePublish(MQTT_TOPIC_FAN_MODE, fanMode.c_str(), true);
+        mqttLastFanMode = fanMode;
+    }
+
+    // Publish HVAC action (heating, cooling, idle, off)
+    const char* currentAction = currentHvacAction();
+    if (strcmp(mqttLastAction, currentAction) != 0) {
+        mqttQueuePublish(MQTT_TOPIC_ACTION, currentAction, true);
+        mqttLastAction = currentAction;
+    }
+
+    // Publish hydronic temperature if hydronic heating is enabled
+    if (hydronicHeatingEnabled && fabs(hydronicTemp - mqttLastHydronicTemp) >= 0.1)
+    {
+        mqttQueuePublish(MQTT_TOPIC_HYDRONIC_TEMPERATURE, String(hydronicTemp, 1).c_str(), true);
+        mqttLastHydronicTemp = hydronicTemp;
+    }
+    
+    // Publish DS18B20 supply temperature if sensor is present
+    if (ds18b20SensorPresent && ds18b20 != nullptr)
+    {
+        static float lastDs18b20SupplyTemp = -999.0;
+        float supplyTempC = ds18b20->getTempCByIndex(0);
+        if (supplyTempC != DEVICE_DISCONNECTED_C && supplyTempC != -127.0)
+        {
+            float supplyTempF = supplyTempC * 9.0 / 5.0 + 32.0;
+            if (abs(supplyTempF - lastDs18b20SupplyTemp) > 0.1)
             {
-                String gasTopic = hostname + "/gas_resistance";
-                mqttClient.publish(gasTopic.c_str(), String(currentGasResistance, 1).c_str(), true);
-                lastGasResistance = currentGasResistance;
+                mqttQueuePublish(MQTT_TOPIC_DS18B20_SUPPLY_TEMPERATURE, String(supplyTempF, 1).c_str(), true);
+                lastDs18b20SupplyTemp = supplyTempF;
             }
-            
-            if (currentAirQuality != lastAirQuality)
+        }
+    }
+    
+    // Publish DS18B20 return temperature if sensor is present
+    if (ds18b20ReturnSensorPresent && ds18b20 != nullptr)
+    {
+        static float lastDs18b20ReturnTemp = -999.0;
+        float returnTempC = ds18b20->getTempCByIndex(1);
+        if (returnTempC != DEVICE_DISCONNECTED_C && returnTempC != -127.0)
+        {
+            float returnTempF = returnTempC * 9.0 / 5.0 + 32.0;
+            if (abs(returnTempF - lastDs18b20ReturnTemp) > 0.1)
             {
-                String aqTopic = hostname + "/air_quality_index";
-                mqttClient.publish(aqTopic.c_str(), String((int)currentAirQuality).c_str(), true);
-                lastAirQuality = currentAirQuality;
+                mqttQueuePublish(MQTT_TOPIC_DS18B20_RETURN_TEMPERATURE, String(returnTempF, 1).c_str(), true);
+                lastDs18b20ReturnTemp = returnTempF;
             }
         }
+    }
 
-        // Publish target temperature (set temperature for heating, cooling, or auto)
-        bool modeChanged = (thermostatMode != mqttLastThermostatMode);
-        if (thermostatMode == "heat" && (modeChanged || setTempHeat != mqttLastSetTempHeat))
-        {
-            String targetTempTopic = hostname + "/target_temperature";
-            mqttClient.publish(targetTempTopic.c_str(), String(setTempHeat, 1).c_str(), true);
-            mqttLastSetTempHeat = setTempHeat;
-        }
-        else if (thermostatMode == "cool" && (modeChanged || setTempCool != mqttLastSetTempCool))
-        {
-            String targetTempTopic = hostname + "/target_temperature";
-            mqttClient.publish(targetTempTopic.c_str(), String(setTempCool, 1).c_str(), true);
-            mqttLastSetTempCool = setTempCool;
+    // Publish motion sensor status if connected
+    if (ld2410Connected) {
+        static bool lastMotionDetected = false;
+        if (motionDetected != lastMotionDetected) {
+            mqttQueuePublish(MQTT_TOPIC_MOTION_DETECTED, motionDetected ? "true" : "false", false);
+            lastMotionDetected = motionDetected;
         }
-        else if (thermostatMode == "auto" && (modeChanged || setTempAuto != mqttLastSetTempAuto))
-        {
-            String targetTempTopic = hostname + "/target_temperature";
-            mqttClient.publish(targetTempTopic.c_str(), String(setTempAuto, 1).c_str(), true);
-            mqttLastSetTempAuto = setTempAuto;
+    }
+    
+    // Publish shower mode status (always publish state to clear retained values)
+    static bool lastShowerModeActive = false;
+    static int lastMinutesRemaining = -1;
+    if (showerModeActive != lastShowerModeActive) {
+        mqttQueuePublish(MQTT_TOPIC_SHOWER_MODE, showerModeActive ? "ON" : "OFF", true);
+        lastShowerModeActive = showerModeActive;
+    }
+    // Publish remaining time if active
+    if (showerModeActive) {
+        unsigned long elapsed = millis() - showerModeStartTime;
+        int minutesRemaining = showerModeDuration - (elapsed / 60000UL);
+        if (minutesRemaining < 0) minutesRemaining = 0;
+        if (minutesRemaining != lastMinutesRemaining) {
+            mqttQueuePublish(MQTT_TOPIC_SHOWER_TIME_REMAINING, String(minutesRemaining).c_str(), false);
+            lastMinutesRemaining = minutesRemaining;
         }
+    } else if (lastMinutesRemaining >= 0) {
+        // Reset when deactivated
+        lastMinutesRemaining = -1;
+    }
 
-        // Publish thermostat mode
-        if (thermostatMode != mqttLastThermostatMode)
-        {
-            String modeTopic = hostname + "/mode";
-            mqttClient.publish(modeTopic.c_str(), thermostatMode.c_str(), true);
-            mqttLastThermostatMode = thermostatMode;
-        }
+    // Publish schedule status
+    if ((int)scheduleEnabled != mqttLastScheduleEnabled) {
+        mqttQueuePublish(MQTT_TOPIC_SCHEDULE_ENABLED, scheduleEnabled ? "on" : "off", true);
+        mqttLastScheduleEnabled = scheduleEnabled;
+    }
 
-        // Publish fan mode
-        if (fanMode != mqttLastFanMode)
-        {
-            String fanModeTopic = hostname + "/fan_mode";
-            mqttClient.publish(fanModeTopic.c_str(), fanMode.c_str(), true);
-            mqttLastFanMode = fanMode;
-        }
-
-        // Publish HVAC action (heating, cooling, idle, off)
-        String currentAction = "off";
-        if (thermostatMode != "off") {
-            bool anyCoolingRelayOn = (digitalRead(COOL_RELAY_1_PIN) == HIGH ||
-                                      digitalRead(COOL_RELAY_2_PIN) == HIGH ||
-                                      digitalRead(PUMP_RELAY_PIN) == HIGH);
-            if (digitalRead(HEAT_RELAY_1_PIN) == HIGH || digitalRead(HEAT_RELAY_2_PIN) == HIGH) {
-                currentAction = "heating";
-            } else if (anyCoolingRelayOn) {
-                currentAction = "cooling";
-            } else {
-                currentAction = "idle";
-            }
-        }
-        if (currentAction != mqttLastAction) {
-            String actionTopic = hostname + "/action";
-            mqttClient.publish(actionTopic.c_str(), currentAction.c_str(), true);
-            mqttLastAction = currentAction;
+    if (activePeriod != mqttLastActivePeriod) {
+        mqttQueuePublish(MQTT_TOPIC_ACTIVE_PERIOD, activePeriod.c_str(), false);
+        mqttLastActivePeriod = activePeriod;
+    }
+
+    if ((int)scheduleOverride != mqttLastScheduleOverride) {
+        mqttQueuePublish(MQTT_TOPIC_SCHEDULE_OVERRIDE, scheduleOverride ? "active" : "inactive", false);
+        mqttLastScheduleOverride = scheduleOverride;
+    }
+}
+
+// <hostname>/state: every state field in one retained document, sent when a
+// field crosses its deadband or its heartbeat runs out
+static void sendMQTTStateDocument()
+{
+    // The web server can change these at any time; applying them here keeps
+    // MqttState on the loop task
+    const MqttStateField temperatures[] = {MQTT_STATE_TEMPERATURE, MQTT_STATE_HYDRONIC_TEMPERATURE,
+                                           MQTT_STATE_SUPPLY_TEMPERATURE, MQTT_STATE_RETURN_TEMPERATURE};
+    for (MqttStateField field : temperatures) mqttStateSetDeadband(field, mqttTempDeadband);
+    mqttStateSetDeadband(MQTT_STATE_HUMIDITY, mqttHumidityDeadband);
+    for (int i = 0; i < MQTT_STATE_FIELD_COUNT; i++) {
+        mqttStateSetMaxAge((MqttStateField)i, (uint32_t)mqttStateHeartbeatMin * 60);
+    }
+
+    bool pressureSensor = (activeSensor == SENSOR_BME280 || activeSensor == SENSOR_BME680);
+    // Off keeps the heat setpoint so the climate entity's template always resolves
+    float targetTemp = thermostatMode == "cool" ? setTempCool
+                     : thermostatMode == "auto" ? setTempAuto : setTempHeat;
+    // The DS18B20 probes are published in °F whatever the display unit
+    float supplyTempF = useFahrenheit ? hydronicTemp : hydronicTemp * 9.0 / 5.0 + 32.0;
+    float returnTempF = useFahrenheit ? hydronicReturnTemp : hydronicReturnTemp * 9.0 / 5.0 + 32.0;
+    float showerRemaining = NAN;
+    if (showerModeActive) {
+        int minutesRemaining = showerModeDuration - (int)((millis() - showerModeStartTime) / 60000UL);
+        showerRemaining = minutesRemaining < 0 ? 0 : minutesRemaining;
+    }
+
+    mqttStateSetNumber(MQTT_STATE_TEMPERATURE, currentTemp);
+    mqttStateSetNumber(MQTT_STATE_HUMIDITY, currentHumidity);
+    mqttStateSetNumber(MQTT_STATE_PRESSURE, pressureSensor ? currentPressure / 33.8639 : NAN);
+    mqttStateSetNumber(MQTT_STATE_GAS_RESISTANCE, activeSensor == SENSOR_BME680 ? currentGasResistance : NAN);
+    mqttStateSetNumber(MQTT_STATE_AIR_QUALITY, activeSensor == SENSOR_BME680 ? currentAirQuality : NAN);
+    mqttStateSetNumber(MQTT_STATE_TARGET_TEMPERATURE, targetTemp);
+    mqttStateSetNumber(MQTT_STATE_HYDRONIC_TEMPERATURE, hydronicHeatingEnabled ? hydronicTemp : NAN);
+    mqttStateSetNumber(MQTT_STATE_SUPPLY_TEMPERATURE, ds18b20SensorPresent ? supplyTempF : NAN);
+    mqttStateSetNumber(MQTT_STATE_RETURN_TEMPERATURE, ds18b20ReturnSensorPresent ? returnTempF : NAN);
+    mqttStateSetNumber(MQTT_STATE_SHOWER_REMAINING, showerRemaining);
+    mqttStateSetText(MQTT_STATE_MODE, thermostatMode.c_str());
+    mqttStateSetText(MQTT_STATE_FAN_MODE, fanMode.c_str());
+    mqttStateSetText(MQTT_STATE_ACTION, currentHvacAction());
+    mqttStateSetText(MQTT_STATE_MOTION, ld2410Connected ? (motionDetected ? "true" : "false") : NULL);
+    mqttStateSetText(MQTT_STATE_SHOWER_MODE, showerModeActive ? "ON" : "OFF");
+    mqttStateSetText(MQTT_STATE_SCHEDULE_ENABLED, scheduleEnabled ? "on" : "off");
+    mqttStateSetText(MQTT_STATE_ACTIVE_PERIOD, activePeriod.c_str());
+    mqttStateSetText(MQTT_STATE_SCHEDULE_OVERRIDE, scheduleOverride ? "active" : "inactive");
+
+    const char* document = mqttStateTake();
+    if (document != NULL && !mqttQueuePublish(MQTT_TOPIC_STATE, document, true)) {
+        mqttStateInvalidate(); // Dropped; send it next cycle
+    }
+}
+
+static const unsigned long TELEMETRY_SAMPLE_INTERVAL_MS = 60000;
+static const unsigned long TELEMETRY_REPLAY_INTERVAL_MS = 200;   // 5 samples/s
+static const char* const TELEMETRY_ACTIONS[] = {"off", "idle", "heating", "cooling"};
+static const char* const TELEMETRY_MODES[] = {"off", "heat", "cool", "auto"};
+
+static int16_t telemetryTenths(float value)
+{
+    return isnan(value) ? TELEMETRY_NO_VALUE : (int16_t)lroundf(value * 10.0f);
+}
+
+// Once a minute while MQTT is down: sendMQTTData() can't publish, so keep
+// a sample for replay. Needs the clock to have been set once.
+void recordTelemetry(unsigned long now)
+{
+    static unsigned long lastSample = 0;
+    if (mqttConnected || now - lastSample < TELEMETRY_SAMPLE_INTERVAL_MS) return;
+    time_t epoch = time(NULL);
+    if (epoch < 1577836800) return; // Before 2020: NTP never synced
+    lastSample = now;
+
+    TelemetrySample sample;
+    memset(&sample, 0, sizeof(sample));
+    sample.time = (uint32_t)epoch;
+    sample.temperature = telemetryTenths(currentTemp);
+    sample.humidity = telemetryTenths(currentHumidity);
+    sample.target = telemetryTenths(thermostatMode == "cool" ? setTempCool :
+                                    thermostatMode == "auto" ? setTempAuto : setTempHeat);
+    sample.hydronic = hydronicHeatingEnabled ? telemetryTenths(hydronicTemp) : TELEMETRY_NO_VALUE;
+    const char* action = currentHvacAction();
+    for (uint8_t i = 0; i < 4; i++) {
+        if (strcmp(action, TELEMETRY_ACTIONS[i]) == 0) sample.action = i;
+        if (thermostatMode == TELEMETRY_MODES[i]) sample.mode = i;
+    }
+    telemetryPush(sample);
+}
+
+static void appendTenths(char* json, size_t size, size_t& used, const char* key, int16_t value)
+{
+    if (value == TELEMETRY_NO_VALUE || used >= size) return;
+    int n = snprintf(json + used, size - used, ",\"%s\":%.1f", key, value / 10.0f);
+    if (n > 0) used += n;
+}
+
+// While connected: send buffered samples oldest first, paced and only while
+// the publish queue has room, so a long backlog doesn't crowd out live state
+void replayTelemetry(unsigned long now)
+{
+    static unsigned long lastReplay = 0;
+    if (!mqttConnected || now - lastReplay < TELEMETRY_REPLAY_INTERVAL_MS) return;
+    lastReplay = now;
+
+    TelemetrySample sample;
+    if (!telemetryPeek(sample)) return;
+    MqttQueueStats mq;
+    mqttQueueGetStats(mq);
+    if (mq.depth > MQTT_QUEUE_DEPTH / 2) return;
+
+    char json[192];
+    size_t used = snprintf(json, sizeof(json), "{\"time\":%lu", (unsigned long)sample.time);
+    appendTenths(json, sizeof(json), used, "temperature", sample.temperature);
+    appendTenths(json, sizeof(json), used, "humidity", sample.humidity);
+    appendTenths(json, sizeof(json), used, "target_temperature", sample.target);
+    appendTenths(json, sizeof(json), used, "hydronic_temperature", sample.hydronic);
+    snprintf(json + used, sizeof(json) - used, ",\"action\":\"%s\",\"mode\":\"%s\"}",
+             TELEMETRY_ACTIONS[sample.action & 3], TELEMETRY_MODES[sample.mode & 3]);
+    if (mqttQueuePublish(MQTT_TOPIC_HISTORY, json, false, false)) telemetryPop();
+}
+
+void sendMQTTData()
+{
+    if (mqttConnected)
+    {
+        // Hourly keep-alive: resend state even if nothing changed
+        if (millis() - mqttLastCacheReset >= MQTT_KEEPALIVE_REPUBLISH_MS) {
+            resetMQTTDataCache();
         }
 
-        // Publish hydronic temperature if hydronic heating is enabled
-        if (hydronicHeatingEnabled)
-        {
-            String hydronicTempTopic = hostname + "/hydronic_temperature";
-            mqttClient.publish(hydronicTempTopic.c_str(), String(hydronicTemp, 1).c_str(), true);
-        }
-        
-        // Publish DS18B20 supply temperature if sensor is present
-        if (ds18b20SensorPresent && ds18b20 != nullptr)
-        {
-            static float lastDs18b20SupplyTemp = -999.0;
-            float supplyTempC = ds18b20->getTempCByIndex(0);
-            if (supplyTempC != DEVICE_DISCONNECTED_C && supplyTempC != -127.0)
-            {
-                float supplyTempF = supplyTempC * 9.0 / 5.0 + 32.0;
-                if (abs(supplyTempF - lastDs18b20SupplyTemp) > 0.1)
-                {
-                    String supplyTempTopic = hostname + "/ds18b20_supply_temperature";
-                    mqttClient.publish(supplyTempTopic.c_str(), String(supplyTempF, 1).c_str(), true);
-                    lastDs18b20SupplyTemp = supplyTempF;
-                }
-            }
-        }
-        
-        // Publish DS18B20 return temperature if sensor is present
-        if (ds18b20ReturnSensorPresent && ds18b20 != nullptr)
-        {
-            static float lastDs18b20ReturnTemp = -999.0;
-            float returnTempC = ds18b20->getTempCByIndex(1);
-            if (returnTempC != DEVICE_DISCONNECTED_C && returnTempC != -127.0)
-            {
-                float returnTempF = returnTempC * 9.0 / 5.0 + 32.0;
-                if (abs(returnTempF - lastDs18b20ReturnTemp) > 0.1)
-                {
-                    String returnTempTopic = hostname + "/ds18b20_return_temperature";
-                    mqttClient.publish(returnTempTopic.c_str(), String(returnTempF, 1).c_str(), true);
-                    lastDs18b20ReturnTemp = returnTempF;
-                }
-            }
+        if (mqttStateJson) {
+            sendMQTTStateDocument();
+        } else {
+            sendMQTTStateTopics();
         }
 
         // Monitor hydronic boiler water temperature and send alerts
-        debugLog("[DEBUG] Hydronic Alert Check: enabled=%s, temp=%.1f, tempValid=%s\n",
+        LOG_TRACE(MQTT, "Hydronic Alert Check: enabled=%s, temp=%.1f, tempValid=%s\n",
                      hydronicHeatingEnabled ? "YES" : "NO", 
                      hydronicTemp,
                      !isnan(hydronicTemp) ? "YES" : "NO");
                      
         if (hydronicHeatingEnabled && !isnan(hydronicTemp))
         {
-            debugLog("[DEBUG] Hydronic Logic: temp=%.1f < threshold=%.1f? %s, alertSent=%s\n",
+            LOG_TRACE(MQTT, "Hydronic Logic: temp=%.1f < threshold=%.1f? %s, alertSent=%s\n",
                          hydronicTemp, hydronicTempLow,
                          (hydronicTemp < hydronicTempLow) ? "YES" : "NO",
                          hydronicLowTempAlertSent ? "YES" : "NO");
@@ -3707,1025 +4107,481 @@ void sendMQTTData()
             if (hydronicTemp < hydronicTempLow && !hydronicLowTempAlertSent)
             {
                 // Send alert to Home Assistant
-                String alertTopic = hostname + "/hydronic_alert";
                 String alertMessage = "ALERT: Boiler water temperature (" + String(hydronicTemp, 1) + "°F) is below setpoint (" + String(hydronicTempLow, 1) + "°F)";
-                mqttClient.publish(alertTopic.c_str(), alertMessage.c_str(), false);
+                mqttQueuePublish(MQTT_TOPIC_HYDRONIC_ALERT, alertMessage.c_str(), false, false);
                 
                 // Also send to Home Assistant notification service
-                String haTopic = "homeassistant/notify/thermostat_alerts";
                 String haMessage = "{\"title\":\"Boiler Alert\",\"message\":\"" + alertMessage + "\"}";
-                mqttClient.publish(haTopic.c_str(), haMessage.c_str(), false);
+                mqttQueuePublish(MQTT_TOPIC_HA_NOTIFY, haMessage.c_str(), false, false);
                 
                 // Set flag to prevent duplicate alerts
                 hydronicLowTempAlertSent = true;
-                preferences.putBool("hydAlertSent", hydronicLowTempAlertSent);
-                debugLog("MQTT: Hydronic low temperature alert sent\n");
+                settingsMarkDirty(SETTINGS_DIRTY_SETTINGS, NVS_WRITER_SYSTEM);
+                LOG_INFO(MQTT, "Hydronic low temperature alert sent\n");
             }
             // Reset alert flag only when temperature recovers above HIGH threshold (hysteresis)
             else if (hydronicTemp >= hydronicTempHigh && hydronicLowTempAlertSent)
             {
                 hydronicLowTempAlertSent = false;
-                preferences.putBool("hydAlertSent", hydronicLowTempAlertSent);
-                debugLog("MQTT: Hydronic temperature recovered to %.1f°F (above %.1f°F) - alert reset\n", 
+                settingsMarkDirty(SETTINGS_DIRTY_SETTINGS, NVS_WRITER_SYSTEM);
+                LOG_INFO(MQTT, "Hydronic temperature recovered to %.1f°F (above %.1f°F) - alert reset\n", 
                              hydronicTemp, hydronicTempHigh);
             }
         }
 
-        // Publish motion sensor status if connected
-        if (ld2410Connected) {
-            static bool lastMotionDetected = false;
-            if (motionDetected != lastMotionDetected) {
-                String motionTopic = hostname + "/motion_detected";
-                mqttClient.publish(motionTopic.c_str(), motionDetected ? "true" : "false", false);
-                lastMotionDetected = motionDetected;
-            }
-        }
-        
-        // Publish shower mode status (always publish state to clear retained values)
-        static bool lastShowerModeActive = false;
-        static int lastMinutesRemaining = -1;
-        if (showerModeActive != lastShowerModeActive) {
-            String showerModeTopic = hostname + "/shower_mode";
-            mqttClient.publish(showerModeTopic.c_str(), showerModeActive ? "ON" : "OFF", true);
-            lastShowerModeActive = showerModeActive;
-        }
-        // Publish remaining time if active
-        if (showerModeActive) {
-            unsigned long elapsed = millis() - showerModeStartTime;
-            int minutesRemaining = showerModeDuration - (elapsed / 60000UL);
-            if (minutesRemaining < 0) minutesRemaining = 0;
-            if (minutesRemaining != lastMinutesRemaining) {
-                String showerTimeRemainingTopic = hostname + "/shower_time_remaining";
-                mqttClient.publish(showerTimeRemainingTopic.c_str(), String(minutesRemaining).c_str(), false);
-                lastMinutesRemaining = minutesRemaining;
-            }
-        } else if (lastMinutesRemaining >= 0) {
-            // Reset when deactivated
-            lastMinutesRemaining = -1;
-        }
-
-        // Publish schedule status
-        String scheduleEnabledTopic = hostname + "/schedule_enabled";
-        mqttClient.publish(scheduleEnabledTopic.c_str(), scheduleEnabled ? "on" : "off", true);
-        
-        String activePeriodTopic = hostname + "/active_period";
-        mqttClient.publish(activePeriodTopic.c_str(), activePeriod.c_str(), false);
-
-        String overrideTopic = hostname + "/schedule_override";
-        mqttClient.publish(overrideTopic.c_str(), scheduleOverride ? "active" : "inactive", false);
-        
         // Publish detailed schedule data for all 7 days (for monitoring/debugging)
         // Format: JSON for each day of the week
-        // Always publish so schedule data is visible even when schedule is disabled
+        // Published even when the schedule is disabled, but only when a day
+        // document can have changed: the schedule was edited, the day rolled
+        // over (is_today), schedule_enabled flipped, or the hourly keep-alive
         time_t now;
         struct tm timeinfo;
         time(&now);
         localtime_r(&now, &timeinfo);
         int currentDay = (timeinfo.tm_wday + 6) % 7; // Convert Sunday=0 to Monday=0
+        bool scheduleDue = scheduleVersion != mqttLastScheduleVersion || currentDay != mqttLastScheduleDay ||
+                           scheduleEnabled != mqttLastScheduleDocsEnabled;
         
         // Publish schedule for each day of the week
         // dayNames order matches weekSchedule array: 0=Sunday, 1=Monday, ..., 6=Saturday
-        // But we also publish to topics with lowercase day names (monday, tuesday, etc.)
+        // and the <hostname>/schedule/<day> topics in MqttTopics.h
         const char* dayNames[7] = {"Sunday", "Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday"};
-        const char* topicDayNames[7] = {"sunday", "monday", "tuesday", "wednesday", "thursday", "friday", "saturday"};
         
-        for (int day = 0; day < 7; day++) {
-            StaticJsonDocument<512> schedDoc;
-            // day_index follows MQTT protocol: 0=Monday through 6=Sunday
-            // Convert array index to MQTT index for compatibility
-            int mqttDayIndex = (day - 1 + 7) % 7;  // Convert 0=Sunday to 0=Monday format
-            schedDoc["day_index"] = mqttDayIndex;
-            schedDoc["day_name"] = dayNames[day];
-            schedDoc["is_today"] = (day == currentDay);
-            schedDoc["schedule_enabled"] = scheduleEnabled;
-            schedDoc["day_enabled"] = weekSchedule[day].enabled;
+        if (scheduleDue) {
+            mqttLastScheduleVersion = scheduleVersion;
+            mqttLastScheduleDay = currentDay;
+            mqttLastScheduleDocsEnabled = scheduleEnabled;
+            for (int day = 0; day < 7; day++) {
+                StaticJsonDocument<512> schedDoc;
+                // day_index follows MQTT protocol: 0=Monday through 6=Sunday
+                // Convert array index to MQTT index for compatibility
+                int mqttDayIndex = (day - 1 + 7) % 7;  // Convert 0=Sunday to 0=Monday format
+                schedDoc["day_index"] = mqttDayIndex;
+                schedDoc["day_name"] = dayNames[day];
+                schedDoc["is_today"] = (day == currentDay);
+                schedDoc["schedule_enabled"] = scheduleEnabled;
+                schedDoc["day_enabled"] = weekSchedule[day].enabled;
             
-            JsonObject dayPeriod = schedDoc.createNestedObject("day_period");
-            dayPeriod["time"] = String(weekSchedule[day].day.hour) + ":" + 
-                               (weekSchedule[day].day.minute < 10 ? "0" : "") + 
-                               String(weekSchedule[day].day.minute);
-            dayPeriod["heat"] = weekSchedule[day].day.heatTemp;
-            dayPeriod["cool"] = weekSchedule[day].day.coolTemp;
-            dayPeriod["auto"] = weekSchedule[day].day.autoTemp;
-            dayPeriod["active"] = weekSchedule[day].day.active;
+                JsonObject dayPeriod = schedDoc.createNestedObject("day_period");
+                dayPeriod["time"] = String(weekSchedule[day].day.hour) + ":" + 
+                                   (weekSchedule[day].day.minute < 10 ? "0" : "") + 
+                                   String(weekSchedule[day].day.minute);
+                dayPeriod["heat"] = weekSchedule[day].day.heatTemp;
+                dayPeriod["cool"] = weekSchedule[day].day.coolTemp;
+                dayPeriod["auto"] = weekSchedule[day].day.autoTemp;
+                dayPeriod["active"] = weekSchedule[day].day.active;
             
-            JsonObject nightPeriod = schedDoc.createNestedObject("night_period");
-            nightPeriod["time"] = String(weekSchedule[day].night.hour) + ":" + 
-                                 (weekSchedule[day].night.minute < 10 ? "0" : "") + 
-                                 String(weekSchedule[day].night.minute);
-            nightPeriod["heat"] = weekSchedule[day].night.heatTemp;
-            nightPeriod["cool"] = weekSchedule[day].night.coolTemp;
-            nightPeriod["auto"] = weekSchedule[day].night.autoTemp;
-            nightPeriod["active"] = weekSchedule[day].night.active;
+                JsonObject nightPeriod = schedDoc.createNestedObject("night_period");
+                nightPeriod["time"] = String(weekSchedule[day].night.hour) + ":" + 
+                                     (weekSchedule[day].night.minute < 10 ? "0" : "") + 
+                                     String(weekSchedule[day].night.minute);
+                nightPeriod["heat"] = weekSchedule[day].night.heatTemp;
+                nightPeriod["cool"] = weekSchedule[day].night.coolTemp;
+                nightPeriod["auto"] = weekSchedule[day].night.autoTemp;
+                nightPeriod["active"] = weekSchedule[day].night.active;
             
-            char schedBuffer[512];
-            serializeJson(schedDoc, schedBuffer);
-            String scheduleDataTopic = hostname + "/schedule/" + String(topicDayNames[day]);
-            mqttClient.publish(scheduleDataTopic.c_str(), schedBuffer, false);
+                static char schedBuffer[MQTT_QUEUE_PAYLOAD]; // Copied by the queue
+                if (measureJson(schedDoc) >= sizeof(schedBuffer)) {
+                    LOG_WARN(MQTT, "Schedule state for day %d does not fit %u bytes\n", day, (unsigned)sizeof(schedBuffer));
+                    continue;
+                }
+                serializeJson(schedDoc, schedBuffer, sizeof(schedBuffer));
+                mqttQueuePublish((MqttTopic)(MQTT_TOPIC_SCHEDULE_SUNDAY + day), schedBuffer, false);
+            }
         }
 
-        // Publish availability
-        String availabilityTopic = hostname + "/availability";
-        mqttClient.publish(availabilityTopic.c_str(), "online", true);
+        // Publish availability (retained: once per connection and keep-alive)
+        if (!mqttLastAvailabilitySent) {
+            mqttLastAvailabilitySent = mqttQueuePublish(MQTT_TOPIC_AVAILABILITY, "online", true);
+        }
     }
 }
 
-void enforceBackupHeatRelayConflicts()
+// After a /set or POST /api/state settings pass: what a changed setting
+// implies beyond its own value, then save and republish
+static void applySettingsForm(const SettingsForm& form)
 {
-    if (!backupHeatEnabled) {
-        return;
+    // If schedule is enabled and not overridden, trigger and persist a temporary override
+    if (settingsFormChangedFlag(form, SETTING_SETPOINT) && scheduleEnabled && !scheduleOverride) {
+        scheduleOverride = true;
+        overrideEndTime = millis() + (scheduleOverrideDuration * 60000UL);
+        LOG_INFO(SCHEDULE, "Web temperature change triggered override\n");
+        settingsMarkDirty(SETTINGS_DIRTY_SCHEDULE, NVS_WRITER_WEB);
+    }
+    // Mutual exclusion: cannot have both stage2 heating and reversing valve
+    if (stage2HeatingEnabled && reversingValveEnabled) {
+        LOG_WARN(WEB, "Both stage2HeatingEnabled and reversingValveEnabled set - disabling stage2HeatingEnabled\n");
+        stage2HeatingEnabled = false;
+    }
+    enforceBackupHeatRelayConflicts();
+    enforceEUHumidityRelayConflicts();
+    if (settingsFormChanged(form, "timeZone")) {
+        setenv("TZ", timeZone.c_str(), 1);
+        tzset();
+    }
+    if (settingsFormChanged(form, "currentBrightness")) {
+        setBrightness(currentBrightness); // Apply brightness immediately
+    }
+    if (settingsFormChanged(form, "mqttHistoryFlash")) {
+        telemetrySpillChanged = true; // Applied by loop(), which owns the history buffer
     }
 
-    if (backupHeatRelaySelection == 1) {
-        if (stage2HeatingEnabled) {
-            stage2HeatingEnabled = false;
-            debugLog("[BACKUP HEAT] Disabled stage2 heating (H2 relay reserved)\n");
-        }
-        if (reversingValveEnabled) {
-            reversingValveEnabled = false;
-            debugLog("[BACKUP HEAT] Disabled reversing valve (H2 relay reserved)\n");
+    settingsMarkDirty(SETTINGS_DIRTY_SETTINGS, NVS_WRITER_WEB);
+
+    // Reconfigure weather module if weather settings were provided
+    if (settingsFormPosted(form, SETTING_GROUP_WEATHER)) {
+        LOG_INFO(WEATHER, "Config: Reconfiguring weather module from web interface\n");
+        LOG_DEBUG(WEATHER, "  Source: %d\n", weatherSource);
+        LOG_DEBUG(WEATHER, "  Update Interval: %d minutes\n", weatherUpdateInterval);
+
+        weather.setUseFahrenheit(useFahrenheit);
+        weather.setSource((WeatherSource)weatherSource);
+        weather.setOpenWeatherMapConfig(owmApiKey, owmCity, owmState, owmCountry);
+        weather.setHomeAssistantConfig(haUrl, haToken, haEntityId);
+        weather.setUpdateInterval(weatherUpdateInterval * 60000);
+
+        bool success = weather.update(); // Force immediate update
+        LOG_INFO(WEATHER, "Config: Immediate update %s\n", success ? "SUCCESS" : "FAILED");
+        if (!success) {
+            LOG_WARN(WEATHER, "Config: Error: %s\n", weather.getLastError().c_str());
         }
     }
 
-    if (backupHeatRelaySelection == 2 && stage2CoolingEnabled) {
-        stage2CoolingEnabled = false;
-        debugLog("[BACKUP HEAT] Disabled stage2 cooling (C2 relay reserved)\n");
-    }
+    mqttConfigPublish();
+    mqttFeedbackNeeded = true;
+    mqttDiscoveryNeeded = true; // Republished by the MQTT task
 }
 
-void enforceEUHumidityRelayConflicts()
+// Schedule master switch from the web; false if it was already so
+static bool setScheduleEnabled(bool enabled)
 {
-    if (!euHumidityControlEnabled) {
-        return;
-    }
-
-    if (euHumidityRelaySelection == 1 && stage2CoolingEnabled) {
-        stage2CoolingEnabled = false;
-        debugLog("[EU HUMIDITY] Disabled stage2 cooling (C2 relay reserved)\n");
+    if (enabled == scheduleEnabled) return false;
+    scheduleEnabled = enabled;
+    if (!scheduleEnabled) {
+        activePeriod = "manual";
+        scheduleOverride = false;
+        overrideEndTime = 0;
     }
+    return true;
 }
 
-int getBackupHeatRelayPin()
+// "temporary" (2 hours), "permanent" or "resume"; false for anything else
+static bool setScheduleOverride(const char* action)
 {
-    if (backupHeatRelaySelection == 1) {
-        return HEAT_RELAY_2_PIN;
-    }
-    if (backupHeatRelaySelection == 2) {
-        return COOL_RELAY_2_PIN;
+    if (strcmp(action, "temporary") == 0) {
+        scheduleOverride = true;
+        overrideEndTime = millis() + (2 * 60 * 60 * 1000); // 2 hours
+    } else if (strcmp(action, "permanent") == 0) {
+        scheduleOverride = true;
+        overrideEndTime = 0; // Permanent until manually disabled
+    } else if (strcmp(action, "resume") == 0) {
+        scheduleOverride = false;
+        overrideEndTime = 0;
+    } else {
+        return false;
     }
-    return PUMP_RELAY_PIN;
+    return true;
 }
 
-void setBackupHeatRelay(bool enabled)
+// {"hour":6,"minute":30,"heat":70,"cool":76,"auto":72}, any subset
+static bool applySchedulePeriodJson(SchedulePeriod& period, JsonObjectConst json)
 {
-    int pin = getBackupHeatRelayPin();
-    digitalWrite(pin, enabled ? HIGH : LOW);
+    bool changed = false;
+    if (json["hour"].is<int>()) {
+        int hour = json["hour"];
+        if (hour >= 0 && hour <= 23 && hour != period.hour) { period.hour = hour; changed = true; }
+    }
+    if (json["minute"].is<int>()) {
+        int minute = json["minute"];
+        if (minute >= 0 && minute <= 59 && minute != period.minute) { period.minute = minute; changed = true; }
+    }
+    if (json["heat"].is<float>() && json["heat"] != period.heatTemp) { period.heatTemp = json["heat"]; changed = true; }
+    if (json["cool"].is<float>() && json["cool"] != period.coolTemp) { period.coolTemp = json["cool"]; changed = true; }
+    if (json["auto"].is<float>() && json["auto"] != period.autoTemp) { period.autoTemp = json["auto"]; changed = true; }
+    return changed;
 }
 
-void clearBackupHeatState(const char* reason)
+// Members of a period applySchedulePeriodJson() would skip as invalid
+static unsigned checkSchedulePeriodJson(JsonVariantConst json)
 {
-    if (backupHeatActive || backupHeatDemandStart != 0) {
-        debugLog("[BACKUP HEAT] Cleared: %s\n", reason);
-    }
-    backupHeatActive = false;
-    backupHeatDemandStart = 0;
-    backupHeatLastTempRiseTime = 0;
-    backupHeatLastReferenceTemp = NAN;
-    setBackupHeatRelay(false);
+    if (json.isNull()) return 0;
+    JsonObjectConst period = json.as<JsonObjectConst>();
+    if (period.isNull()) return 1;
+    unsigned bad = 0;
+    if (!period["hour"].isNull() && !(period["hour"].is<int>() && period["hour"] >= 0 && period["hour"] <= 23)) bad++;
+    if (!period["minute"].isNull() && !(period["minute"].is<int>() && period["minute"] >= 0 && period["minute"] <= 59)) bad++;
+    static const char* const TEMPS[] = { "heat", "cool", "auto" };
+    for (const char* key : TEMPS) {
+        if (!period[key].isNull() && !period[key].is<float>()) bad++;
+    }
+    return bad;
 }
 
-void updateBackupHeatState(bool heatDemandActive, float currentTemp)
+static void printJsonNumber(Print& out, const char* key, float value, int decimals)
 {
-    if (!backupHeatEnabled) {
-        clearBackupHeatState("feature disabled");
-        return;
-    }
+    out.printf("\"%s\":", key);
+    if (isfinite(value)) out.printf("%.*f", decimals, value);
+    else out.print("null");
+}
 
-    if (!heatDemandActive) {
-        clearBackupHeatState("no active heat demand");
-        return;
-    }
+static void writeSchedulePeriodJson(Print& out, const SchedulePeriod& period)
+{
+    out.printf("{\"hour\":%d,\"minute\":%d,", period.hour, period.minute);
+    printJsonNumber(out, "heat", period.heatTemp, 1);
+    out.print(',');
+    printJsonNumber(out, "cool", period.coolTemp, 1);
+    out.print(',');
+    printJsonNumber(out, "auto", period.autoTemp, 1);
+    out.print('}');
+}
 
-    if (backupHeatDemandStart == 0) {
-        backupHeatDemandStart = millis();
-        backupHeatLastTempRiseTime = backupHeatDemandStart;
-        backupHeatLastReferenceTemp = currentTemp;
-        backupHeatActive = false;
-        setBackupHeatRelay(false);
-        debugLog("[BACKUP HEAT] Monitoring primary heat recovery (%d min window)\n", backupHeatDelayMinutes);
+// GET /api/state: everything the web UI renders (about 3 KB), streamed.
+// With liveOnly just the "live" object (a few hundred bytes), which is what
+// the status tab polls.
+static void writeWebState(Print& out, bool liveOnly)
+{
+    const WeatherData& weatherData = weather.getData();
+    out.print("{\"live\":{");
+    printJsonNumber(out, "temp", currentTemp, 1);
+    out.print(',');
+    printJsonNumber(out, "humidity", currentHumidity, 1);
+    out.print(',');
+    printJsonNumber(out, "supply", hydronicTemp, 1);
+    out.print(',');
+    printJsonNumber(out, "return", hydronicReturnTemp, 1);
+    out.printf(",\"relays\":{\"heat1\":%d,\"heat2\":%d,\"cool1\":%d,\"cool2\":%d,\"fan\":%d}",
+               digitalRead(HEAT_RELAY_1_PIN), digitalRead(HEAT_RELAY_2_PIN), digitalRead(COOL_RELAY_1_PIN),
+               digitalRead(COOL_RELAY_2_PIN), digitalRead(FAN_RELAY_PIN));
+    out.printf(",\"euDemand\":%s,\"mode\":", euHumidityDemandActive ? "true" : "false");
+    printJsonString(out, thermostatMode.c_str());
+    out.print(",\"fanMode\":");
+    printJsonString(out, fanMode.c_str());
+    out.print(",\"period\":");
+    printJsonString(out, activePeriod.c_str());
+    out.printf(",\"override\":%s,\"weather\":{\"valid\":%s,", scheduleOverride ? "true" : "false",
+               weatherData.valid ? "true" : "false");
+    printJsonNumber(out, "temp", weatherData.temperature, 1);
+    out.print(',');
+    printJsonNumber(out, "high", weatherData.tempHigh, 0);
+    out.print(',');
+    printJsonNumber(out, "low", weatherData.tempLow, 0);
+    out.print(",\"desc\":");
+    printJsonString(out, weatherData.description.c_str());
+    out.print("}}");
+    if (liveOnly) {
+        out.print('}');
         return;
     }
 
-    unsigned long delayMs = (unsigned long)backupHeatDelayMinutes * 60000UL;
-    float tempRiseThreshold = backupHeatMinTempRise;
-    if (!isnan(backupHeatLastReferenceTemp) && currentTemp >= (backupHeatLastReferenceTemp + tempRiseThreshold)) {
-        backupHeatLastReferenceTemp = currentTemp;
-        backupHeatLastTempRiseTime = millis();
-    }
+    out.print(",\"system\":{\"version\":");
+    printJsonString(out, version_info.c_str());
+    out.print(",\"ip\":");
+    printJsonString(out, WiFi.localIP().toString().c_str());
+    out.print(",\"mac\":");
+    printJsonString(out, WiFi.macAddress().c_str());
+    out.printf(",\"heap\":%lu,\"uptime\":%lu,\"flashMB\":%lu,\"chip\":", (unsigned long)ESP.getFreeHeap(),
+               (unsigned long)millis(), (unsigned long)(ESP.getFlashChipSize() / 1024 / 1024));
+    printJsonString(out, ESP.getChipModel());
+    out.printf(",\"cpuMHz\":%lu,\"configReadOnly\":%s}", (unsigned long)ESP.getCpuFreqMHz(),
+               configBlobReadOnly() ? "true" : "false");
 
-    if (!backupHeatActive && !isnan(backupHeatLastReferenceTemp) && currentTemp <= (backupHeatLastReferenceTemp - backupHeatMaxTempDrop)) {
-        backupHeatActive = true;
-        setBackupHeatRelay(true);
-        debugLog("[BACKUP HEAT] Primary temperature dropped by %.2f - backup activated\n", backupHeatMaxTempDrop);
-        return;
-    }
+    out.print(",\"settings\":");
+    settingsWriteJson(out);
 
-    if (!backupHeatActive && (millis() - backupHeatLastTempRiseTime >= delayMs)) {
-        backupHeatActive = true;
-        setBackupHeatRelay(true);
-        debugLog("[BACKUP HEAT] Primary heat failure detected - backup activated\n");
-    } else if (backupHeatActive) {
-        setBackupHeatRelay(true);
-    }
+    // Index 0 = Sunday, as weekSchedule
+    out.print(",\"schedule\":[");
+    for (int day = 0; day < 7; day++) {
+        const DaySchedule& schedule = weekSchedule[day];
+        out.printf("%s{\"enabled\":%s,\"day\":", day ? "," : "", schedule.enabled ? "true" : "false");
+        writeSchedulePeriodJson(out, schedule.day);
+        out.print(",\"night\":");
+        writeSchedulePeriodJson(out, schedule.night);
+        out.print('}');
+    }
+    out.print("]}");
 }
 
-void controlRelays(float currentTemp)
+// While the stored config is from newer firmware (ConfigBlob.h) nothing can
+// be saved, so /set and POST /api/state refuse rather than report success
+static bool refuseWhileConfigReadOnly(AsyncWebServerRequest *request)
 {
-    // Take mutex to prevent concurrent access from multiple cores
-    if (xSemaphoreTake(controlRelaysMutex, pdMS_TO_TICKS(100)) != pdTRUE) {
-        debugLog("[WARNING] controlRelays: Failed to acquire mutex, skipping this call\n");
-        return;
-    }
-
-    enforceBackupHeatRelayConflicts();
-    enforceEUHumidityRelayConflicts();
-    euHumidityDemandActive = false;
-    
-    // Check if shower mode is active and has expired
-    if (showerModeActive) {
-        unsigned long elapsed = millis() - showerModeStartTime;
-        unsigned long remaining = (showerModeDuration * 60000UL) - elapsed;
-        
-        // Buzzer alert for last 5 seconds (one beep per second)
-        static unsigned long lastBuzzTime = 0;
-        if (remaining <= 5000 && remaining > 0) {
-            int secondsRemaining = (remaining / 1000) + 1;
-            unsigned long currentSecond = 5 - secondsRemaining;
-            if (currentSecond != lastBuzzTime) {
-                buzzerBeep(100);
-                lastBuzzTime = currentSecond;
-                debugLog("[SHOWER MODE] Alert beep - %d seconds remaining\n", secondsRemaining);
-            }
-        } else if (remaining > 5000) {
-            lastBuzzTime = 0; // Reset for next countdown
-        }
-        
-        if (elapsed >= (showerModeDuration * 60000UL)) {
-            showerModeActive = false;
-            lastBuzzTime = 0; // Reset buzzer tracking
-            debugLog("[SHOWER MODE] Timer expired, resuming normal operation\n");
-        }
-    }
-    
-    // Debug entry
-    debugLog("[DEBUG] controlRelays ENTRY: mode=%s, temp=%.1f, heatingOn=%d, coolingOn=%d, showerMode=%d\n", 
-                 thermostatMode.c_str(), currentTemp, heatingOn, coolingOn, showerModeActive);
-    
-    // Track previous states to only print debug info on changes
-    static bool prevHeatingOn = false;
-    static bool prevCoolingOn = false;
-    static bool prevFanOn = false;
-    static String prevThermostatMode = "";
-    static float prevTemp = 0.0;
-    
-    // Check if temperature reading is valid
-    if (isnan(currentTemp)) {
-        debugLog("WARNING: Invalid temperature reading, skipping relay control\n");
-        clearBackupHeatState("invalid temperature");
-        xSemaphoreGive(controlRelaysMutex);
-        return;
-    }
-    
-    // Fan safety interlock: block fan when hydronic lockout conditions are active
-    bool fanBlockedByHydronicSafety = hydronicHeatingEnabled &&
-        (!ds18b20SensorPresent || isnan(hydronicTemp) || hydronicTemp < hydronicTempLow || hydronicLockout);
+    if (!configBlobReadOnly()) return false;
+    request->send(409, "application/json",
+                  "{\"status\":\"error\",\"message\":\"Settings are read-only: the stored configuration is from newer firmware. Reinstall it, or factory reset to replace it.\"}");
+    return true;
+}
 
-    // Store current states before any changes
-    bool currentHeatingOn = heatingOn;
-    bool currentCoolingOn = coolingOn;
-    bool currentFanOn = fanOn;
+// A settings member as form text; NULL for null, objects and arrays, which
+// no setting takes ("null" would be stored as text or read as false)
+static const char* stateSettingText(JsonVariantConst value, char* number, size_t size)
+{
+    if (value.is<const char*>()) return value.as<const char*>();
+    if (value.isNull() || value.is<JsonObjectConst>() || value.is<JsonArrayConst>()) return NULL;
+    serializeJson(value, number, size); // true, false or the number
+    return number;
+}
 
-    if (thermostatMode == "off")
-    {
-        debugLog("[DEBUG] In OFF mode - turning off heating and cooling relays\n");
-        // Turn off heating and cooling relays, but don't turn off fan
-        // This allows the fan to operate in "on" or "cycle" mode even when thermostat is off
-        digitalWrite(HEAT_RELAY_1_PIN, LOW);
-        digitalWrite(HEAT_RELAY_2_PIN, LOW);
-        digitalWrite(COOL_RELAY_1_PIN, LOW);
-        digitalWrite(COOL_RELAY_2_PIN, LOW);
-        heatingOn = false;
-        coolingOn = false;
-        stage1Active = false;
-        stage2Active = false;
-        
-        // Handle fan separately based on fanMode
-        if (fanMode == "on" && !fanBlockedByHydronicSafety) {
-            if (!fanOn) {
-                digitalWrite(FAN_RELAY_PIN, HIGH);
-                fanOn = true;
-                debugLog("Fan on while thermostat is off\n");
-            }
-        }
-        else if (fanMode == "auto") {
-            digitalWrite(FAN_RELAY_PIN, LOW);
-            fanOn = false;
+// Members handleStatePost() would reject or not recognise; logs each
+static void checkStatePost(JsonObjectConst body, unsigned& rejected, unsigned& unknown)
+{
+    rejected = unknown = 0;
+    JsonVariantConst settings = body["settings"];
+    if (!settings.isNull() && !settings.is<JsonObjectConst>()) rejected++;
+    for (JsonPairConst field : settings.as<JsonObjectConst>()) {
+        const SettingDesc* setting = settingFind(field.key().c_str());
+        if (setting == NULL || setting->group == SETTING_GROUP_NONE) {
+            LOG_WARN(WEB, "POST /api/state: unknown setting \"%s\"\n", field.key().c_str());
+            unknown++;
+            continue;
         }
-        // Note: "cycle" fan mode is handled by controlFanSchedule()
-        clearBackupHeatState("thermostat mode off");
-        updateStatusLEDs(); // Update LED status
-        
-        xSemaphoreGive(controlRelaysMutex);
-        return;
+        char number[24];
+        const char* text = stateSettingText(field.value(), number, sizeof(number));
+        if (text == NULL || !settingCheckText(setting, text)) rejected++;
     }
 
-    // Rest of the thermostat logic for heat, cool, and auto modes
-    if (thermostatMode == "heat")
-    {
-        debugLog("[DEBUG] In HEAT mode: temp=%.1f, setpoint=%.1f, swing=%.1f\n", 
-                     currentTemp, setTempHeat, tempSwing);
-        
-        // Turn off cooling relays when entering heat mode
-        if (coolingOn) {
-            debugLog("[DEBUG] Turning off cooling relays in heat mode\n");
-            digitalWrite(COOL_RELAY_1_PIN, LOW);
-            digitalWrite(COOL_RELAY_2_PIN, LOW);
-            coolingOn = false;
-            // Reset staging flags to allow heating to start fresh
-            stage1Active = false;
-            stage2Active = false;
-        }
-        
-        // Block heating if shower mode is active
-        if (showerModeActive) {
-            if (heatingOn) {
-                debugLog("[SHOWER MODE] Blocking heating - turning off\n");
-                digitalWrite(HEAT_RELAY_1_PIN, LOW);
-                digitalWrite(HEAT_RELAY_2_PIN, LOW);
-                heatingOn = false;
-                stage1Active = false;
-                stage2Active = false;
-            }
-        }
-        // Only activate heating if below setpoint - swing
-        else {
-            debugLog("[DEBUG] Heat check: %.1f < %.1f? %s\n", 
-                         currentTemp, (setTempHeat - tempSwing), 
-                         (currentTemp < (setTempHeat - tempSwing)) ? "YES" : "NO");
-            if (currentTemp < (setTempHeat - tempSwing))
-            {
-                // Call activateHeating on every pass so stage 2 escalation can fire
-                // after stage1MinRuntime elapses (guarded internally by !stage1Active /
-                // !stage2Active checks inside activateHeating).
-                if (!heatingOn) {
-                    debugLog("[HVAC] HEAT ACTIVATED: %.1f < %.1f (setpoint-swing)\n", 
-                             currentTemp, (setTempHeat - tempSwing));
-                }
-                activateHeating();
-            }
-            // Only turn off if above setpoint (hysteresis)
-            else if (currentTemp >= setTempHeat)
-            {
-                if (heatingOn || coolingOn || fanOn) {
-                    debugLog("[HVAC] HEAT DEACTIVATED: %.1f >= %.1f (setpoint)\n", 
-                             currentTemp, setTempHeat);
-                }
-                // Called unconditionally even if already off — re-asserts relay pin states
-                // every cycle as a safety net to prevent relays from getting stuck ON
-                turnOffAllRelays();
-            }
-            // Otherwise maintain current state (hysteresis band)
-        }
-    }
-    else if (thermostatMode == "cool")
-    {
-        debugLog("[DEBUG] In COOL mode: temp=%.1f, setpoint=%.1f, swing=%.1f\n", 
-                     currentTemp, setTempCool, tempSwing);
-        
-        // Turn off heating relays when entering cool mode
-        if (heatingOn) {
-            debugLog("[DEBUG] Turning off heating relays in cool mode\n");
-            digitalWrite(HEAT_RELAY_1_PIN, LOW);
-            digitalWrite(HEAT_RELAY_2_PIN, LOW);
-            heatingOn = false;
-            // Reset staging flags to allow cooling to start fresh
-            stage1Active = false;
-            stage2Active = false;
-        }
-        
-        // Only activate cooling if above setpoint + swing
-        debugLog("[DEBUG] Cool check: %.1f > %.1f? %s\n", 
-                     currentTemp, (setTempCool + tempSwing), 
-                     (currentTemp > (setTempCool + tempSwing)) ? "YES" : "NO");
-        
-        bool shouldCool = false;
-        bool humidityDrivenCooling = false;
-        
-        // Temperature-based cooling (primary)
-        if (currentTemp > (setTempCool + tempSwing)) {
-            shouldCool = true;
-            debugLog("[DEBUG] Temperature trigger: %.1f > %.1f\n", currentTemp, (setTempCool + tempSwing));
-        }
-        
-        // EU Humidity-based dehumidification (secondary, only in EU mode)
-        if (thermostatRegion == "EU" && euHumidityControlEnabled) {
-            if (currentHumidity > euHumiditySetpoint) {
-                shouldCool = true;
-                humidityDrivenCooling = true;
-                debugLog("[DEBUG] EU Humidity dehumidification trigger: %.1f%% > %.1f%%\n", 
-                         currentHumidity, euHumiditySetpoint);
-            }
-        }
-        euHumidityDemandActive = humidityDrivenCooling;
-        
-        if (shouldCool) {
-            // Call activateCooling every cycle (like HEAT and AUTO modes do)
-            // to ensure relay stays energized and as a safety net against relay getting stuck OFF
-            if (!coolingOn) {
-                debugLog("[HVAC] COOL ACTIVATED: temperature or humidity override\n");
-            }
-            activateCooling();
-        }
-        // Only turn off if below setpoint (hysteresis) AND not in EU humidity dehumidification
-        else if ((currentTemp < setTempCool) && 
-                 !(thermostatRegion == "EU" && euHumidityControlEnabled && 
-                   currentHumidity > (euHumiditySetpoint - euHumidityDeadband)))
-        {
-            if (heatingOn || coolingOn || fanOn) {
-                debugLog("[HVAC] COOL DEACTIVATED: %.1f < %.1f (setpoint)\n", 
-                         currentTemp, setTempCool);
-            }
-            // Called unconditionally even if already off — re-asserts relay pin states
-            // every cycle as a safety net to prevent relays from getting stuck ON
-            turnOffAllRelays();
-        }
-        // Otherwise maintain current state (hysteresis band between setpoint and setpoint+swing)
-    }
-    else if (thermostatMode == "auto")
-    {
-        debugLog("[DEBUG] In AUTO mode: temp=%.1f, setpoint=%.1f, autoSwing=%.1f\n", 
-                     currentTemp, setTempAuto, autoTempSwing);
-
-        float autoHeatOnThreshold = setTempAuto - autoTempSwing;
-        float autoCoolOnThreshold = setTempAuto + autoTempSwing;
-
-        // Single-setpoint auto behavior:
-        // - Dead zone is hold-only (no transitions)
-        // - Start heat/cool only outside swing thresholds
-        // - Stop active heat/cool only at setpoint boundary
-        if (coolingOn) {
-            // EU humidity demand can keep cooling active even after reaching setpoint.
-            bool humidityDemand = (thermostatRegion == "EU" && euHumidityControlEnabled &&
-                                   currentHumidity > (euHumiditySetpoint - euHumidityDeadband));
-            euHumidityDemandActive = (thermostatRegion == "EU" && euHumidityControlEnabled &&
-                                      currentHumidity > euHumiditySetpoint);
-
-            if (currentTemp <= setTempAuto && !humidityDemand) {
-                debugLog("[DEBUG] Auto cooling OFF at setpoint: %.1f <= %.1f\n", currentTemp, setTempAuto);
-                turnOffAllRelays();
-            } else {
-                debugLog("[DEBUG] Auto cooling HOLD: temp=%.1f, setpoint=%.1f, humidityDemand=%d\n",
-                         currentTemp, setTempAuto, humidityDemand ? 1 : 0);
-                activateCooling();
-            }
-        }
-        else if (heatingOn) {
-            euHumidityDemandActive = false;
-            if (currentTemp >= setTempAuto) {
-                debugLog("[DEBUG] Auto heating OFF at setpoint: %.1f >= %.1f\n", currentTemp, setTempAuto);
-                turnOffAllRelays();
-            } else {
-                debugLog("[DEBUG] Auto heating HOLD: temp=%.1f, setpoint=%.1f\n", currentTemp, setTempAuto);
-                activateHeating();
-            }
-        }
-        else if (currentTemp > autoCoolOnThreshold) {
-            euHumidityDemandActive = false;
-            debugLog("[DEBUG] Auto cooling ON threshold crossed: %.1f > %.1f\n",
-                     currentTemp, autoCoolOnThreshold);
-            activateCooling();
-        }
-        else if (currentTemp < autoHeatOnThreshold) {
-            euHumidityDemandActive = false;
-            debugLog("[DEBUG] Auto heating ON threshold crossed: %.1f < %.1f\n",
-                     currentTemp, autoHeatOnThreshold);
-            activateHeating();
-        }
-        // EU Humidity-based dehumidification (supplementary in auto mode while idle)
-        else if (thermostatRegion == "EU" && euHumidityControlEnabled && currentHumidity > euHumiditySetpoint) {
-            euHumidityDemandActive = true;
-            debugLog("[DEBUG] Auto mode EU humidity dehumidification: %.1f%% > %.1f%%\n",
-                     currentHumidity, euHumiditySetpoint);
-            activateCooling();
-        }
-        else {
-            euHumidityDemandActive = false;
-            debugLog("[DEBUG] Auto dead zone HOLD: %.1f between %.1f and %.1f\n",
-                     currentTemp, autoHeatOnThreshold, autoCoolOnThreshold);
-            // No transition in dead zone while idle.
+    if (!body["scheduleEnabled"].isNull() && !body["scheduleEnabled"].is<bool>()) rejected++;
+    JsonVariantConst overrideAction = body["scheduleOverride"];
+    if (!overrideAction.isNull()) {
+        const char* action = overrideAction.is<const char*>() ? overrideAction.as<const char*>() : "";
+        if (strcmp(action, "temporary") != 0 && strcmp(action, "permanent") != 0 && strcmp(action, "resume") != 0) {
+            rejected++;
         }
     }
 
-    bool heatDemandActive = false;
-    if (!showerModeActive && heatingOn && thermostatMode == "heat") {
-        heatDemandActive = currentTemp < (setTempHeat - tempSwing);
-    } else if (!showerModeActive && heatingOn && thermostatMode == "auto") {
-        heatDemandActive = currentTemp < (setTempAuto - autoTempSwing);
+    JsonVariantConst schedule = body["schedule"];
+    if (schedule.isNull()) return;
+    JsonArrayConst days = schedule.as<JsonArrayConst>();
+    if (days.isNull() || days.size() > 7) {
+        rejected++;
+        return;
     }
-    updateBackupHeatState(heatDemandActive, currentTemp);
-
-    // Emergency/backup mode behavior: once tripped, run backup relay and force primary heat outputs off.
-    if (backupHeatActive && heatDemandActive) {
-        int backupPin = getBackupHeatRelayPin();
-        if (backupPin != HEAT_RELAY_1_PIN) {
-            digitalWrite(HEAT_RELAY_1_PIN, LOW);
-        }
-        if (backupPin != HEAT_RELAY_2_PIN) {
-            digitalWrite(HEAT_RELAY_2_PIN, LOW);
-        }
-        if (backupPin != COOL_RELAY_2_PIN) {
-            digitalWrite(COOL_RELAY_2_PIN, LOW);
-        }
-        stage1Active = false;
-        if (backupPin != HEAT_RELAY_2_PIN && backupPin != COOL_RELAY_2_PIN) {
-            stage2Active = false;
+    for (JsonVariantConst entry : days) {
+        if (entry.isNull()) continue;
+        if (!entry.is<JsonObjectConst>()) {
+            rejected++;
+            continue;
         }
+        if (!entry["enabled"].isNull() && !entry["enabled"].is<bool>()) rejected++;
+        rejected += checkSchedulePeriodJson(entry["day"]) + checkSchedulePeriodJson(entry["night"]);
     }
-
-    // Make sure fan control is applied
-    handleFanControl();
-    
-    // Detect any state or mode changes to trigger display/LED updates
-    bool stateChanged = (heatingOn != prevHeatingOn || coolingOn != prevCoolingOn || fanOn != prevFanOn);
-    bool modeChanged = (thermostatMode != prevThermostatMode);
-    
-    // Only print debug info when there are changes
-    if (stateChanged || modeChanged || abs(currentTemp - prevTemp) > 0.5) {
-        debugLog("controlRelays: mode=%s, temp=%.1f, setHeat=%.1f, setCool=%.1f, setAuto=%.1f, swing=%.1f\n", 
-                     thermostatMode.c_str(), currentTemp, setTempHeat, setTempCool, setTempAuto, tempSwing);
-        debugLog("Relay states: heating=%d, cooling=%d, fan=%d\n", heatingOn, coolingOn, fanOn);
-        
-        // CONSOLIDATED UPDATE: Update LEDs and display when relay state or mode changes
-        updateStatusLEDs();
-        setDisplayUpdateFlag();
-        
-        // Update previous states
-        prevHeatingOn = heatingOn;
-        prevCoolingOn = coolingOn;
-        prevFanOn = fanOn;
-        prevThermostatMode = thermostatMode;
-        prevTemp = currentTemp;
-    }
-    
-    // Debug: Verify actual relay pin states
-    bool actualHeat1 = digitalRead(HEAT_RELAY_1_PIN) == HIGH;
-    bool actualHeat2 = digitalRead(HEAT_RELAY_2_PIN) == HIGH;
-    bool actualCool1 = digitalRead(COOL_RELAY_1_PIN) == HIGH;
-    bool actualCool2 = digitalRead(COOL_RELAY_2_PIN) == HIGH;
-    bool actualFan = digitalRead(FAN_RELAY_PIN) == HIGH;
-    
-    debugLog("[DEBUG] controlRelays EXIT: RelayPins H1=%d H2=%d C1=%d C2=%d F=%d | Flags heat=%d cool=%d fan=%d stage1=%d stage2=%d\n", 
-                 actualHeat1, actualHeat2, actualCool1, actualCool2, actualFan, 
-                 heatingOn, coolingOn, fanOn, stage1Active, stage2Active);
-    
-    xSemaphoreGive(controlRelaysMutex);
 }
 
-void turnOffAllRelays()
+// POST /api/state body, every member optional:
+//   {"settings": {"<SETTINGS[] name>": value, ...},
+//    "scheduleEnabled": true, "scheduleOverride": "temporary|permanent|resume",
+//    "schedule": [{"enabled": true, "day": {...}, "night": {...}}, ...]}
+// Booleans that are not sent are left alone, unlike unchecked boxes on /set.
+// The whole body is checked first: if anything is invalid, nothing is applied.
+static void handleStatePost(AsyncWebServerRequest *request, JsonVariant &json)
 {
-    debugLog("[DEBUG] turnOffAllRelays() - Turning off heating/cooling relays\n");
-    bool fanBlockedByHydronicSafety = hydronicHeatingEnabled &&
-        (!ds18b20SensorPresent || isnan(hydronicTemp) || hydronicTemp < hydronicTempLow || hydronicLockout);
-
-    digitalWrite(HEAT_RELAY_1_PIN, LOW);
-    digitalWrite(HEAT_RELAY_2_PIN, LOW);
-    digitalWrite(COOL_RELAY_1_PIN, LOW);
-    digitalWrite(COOL_RELAY_2_PIN, LOW);
-    setBackupHeatRelay(false);
-    heatingOn = false;
-    coolingOn = false;
-    stage1Active = false; // Reset stage 1 active flag
-    stage2Active = false; // Reset stage 2 active flag
-    backupHeatActive = false;
-    backupHeatDemandStart = 0;
-    
-    // Handle fan based on fanMode setting
-    if (fanMode == "on" && !fanBlockedByHydronicSafety) {
-        // Keep fan running in "on" mode
-        if (!fanOn) {
-            digitalWrite(FAN_RELAY_PIN, HIGH);
-            fanOn = true;
-            debugLog("[DEBUG] turnOffAllRelays() - Keeping fan ON (fanMode=on)\n");
-        }
-    } else if (fanMode == "auto") {
-        // Turn off fan in auto mode when heating/cooling stops
-        if (fanRelayNeeded) {
-            // Only control fan if fanRelayNeeded is true
-            digitalWrite(FAN_RELAY_PIN, LOW);
-            fanOn = false;
-            debugLog("[DEBUG] turnOffAllRelays() - Turning fan OFF (fanMode=auto)\n");
-        }
+    JsonObjectConst body = json.as<JsonObjectConst>();
+    if (body.isNull()) {
+        request->send(400, "application/json", "{\"status\":\"error\",\"message\":\"Expected a JSON object\"}");
+        return;
     }
-    // Note: "cycle" mode is handled by controlFanSchedule(), don't interfere
-    
-    debugLog("[DEBUG] turnOffAllRelays() COMPLETE: heatingOn=%d, coolingOn=%d, fanOn=%d, fanMode=%s\n", 
-                 heatingOn, coolingOn, fanOn, fanMode.c_str());
-    // Always update LEDs and display even if state didn't change — keeps display and
-    // hardware in sync and ensures any drift is corrected every control cycle
-    updateStatusLEDs();
-    setDisplayUpdateFlag();
-}
+    if (refuseWhileConfigReadOnly(request)) return;
 
-void activateHeating() {
-    debugLog("[DEBUG] activateHeating() ENTRY: stage1Active=%d, stage2Active=%d\n", stage1Active, stage2Active);
-    
-    // Hydronic boiler safety interlock - prevent heating if boiler water is too cold
-    if (hydronicHeatingEnabled && !isnan(hydronicTemp)) {
-        debugLog("[DEBUG] Hydronic Safety Check: temp=%.1f, low=%.1f, high=%.1f, lockout=%d\n", 
-                     hydronicTemp, hydronicTempLow, hydronicTempHigh, hydronicLockout);
-        
-        // Manage lockout state with hysteresis
-        // Lockout activates at low threshold, clears at high threshold
-        if (hydronicTemp < hydronicTempLow && !hydronicLockout) {
-            hydronicLockout = true;
-            debugLog("[LOCKOUT] Hydronic lockout ACTIVATED - temp %.1f°F below %.1f°F\n", 
-                         hydronicTemp, hydronicTempLow);
-        } else if (hydronicTemp >= hydronicTempHigh && hydronicLockout) {
-            hydronicLockout = false;
-            debugLog("[LOCKOUT] Hydronic lockout CLEARED - temp %.1f°F reached %.1f°F\n", 
-                         hydronicTemp, hydronicTempHigh);
-        }
-        
-        // If in lockout state, prevent heating
-        if (hydronicLockout) {
-            debugLog("[LOCKOUT] Hydronic lockout active - waiting for temp to reach %.1f°F (currently %.1f°F)\n", 
-                         hydronicTempHigh, hydronicTemp);
-            
-            // Turn off heating relays
-            digitalWrite(HEAT_RELAY_1_PIN, LOW);
-            digitalWrite(HEAT_RELAY_2_PIN, LOW);
-            heatingOn = false;
-            stage1Active = false;
-            stage2Active = false;
-            
-            // Force fan off during hydronic lockout
-            if (fanOn) {
-                digitalWrite(FAN_RELAY_PIN, LOW);
-                fanOn = false;
-                debugLog("[LOCKOUT] Fan forced OFF during hydronic lockout\n");
-            }
-            
-            updateStatusLEDs();
-            setDisplayUpdateFlag();
-            return; // Exit - no heating allowed
-        }
-        
-        debugLog("[LOCKOUT] Hydronic water temp %.1f°F OK - heating allowed\n", hydronicTemp);
+    unsigned rejected, unknown;
+    checkStatePost(body, rejected, unknown);
+    if (rejected || unknown) {
+        char reply[112];
+        snprintf(reply, sizeof(reply),
+                 "{\"status\":\"error\",\"message\":\"%u value(s) rejected, %u unknown; nothing saved\"}",
+                 rejected, unknown);
+        request->send(400, "application/json", reply);
+        return;
     }
 
-    // Default heating behavior with hybrid staging
-    heatingOn = true;
-    coolingOn = false;
-    
-    // Turn off cooling relays when activating heating
-    digitalWrite(COOL_RELAY_1_PIN, LOW);
-    digitalWrite(COOL_RELAY_2_PIN, LOW);
-    
-    // Check if stage 1 is not active yet
-    if (!stage1Active) {
-        debugLog("[HVAC] Stage 1 HEATING activated\n");
-        digitalWrite(HEAT_RELAY_1_PIN, HIGH); // Activate stage 1
-        stage1Active = true;
-        stage1StartTime = millis(); // Record the start time
-        stage2Active = false; // Ensure stage 2 is off initially
-        
-        // Wake display when HVAC activates
-        if (displayIsAsleep) {
-            wakeDisplay();
-            debugLog("[DISPLAY] Woke from sleep - heating activated\n");
-        }
-    }
-    
-    // Handle reversing valve or stage 2 heating (mutually exclusive)
-    if (reversingValveEnabled) {
-        // Reversing valve mode: energize valve immediately when heating
-        if (!stage2Active) {
-            debugLog("[HVAC] Reversing valve energized for HEAT mode\n");
-            digitalWrite(HEAT_RELAY_2_PIN, HIGH);
-            stage2Active = true; // Use stage2Active flag to track valve state
-        }
-    }
-    // Check if it's time to activate stage 2 based on hybrid approach
-    else if (!stage2Active && 
-             ((millis() - stage1StartTime) / 1000 >= stage1MinRuntime) && // Minimum run time before stage 2 allowed
-             (currentTemp < setTempHeat - stage2TempDelta) && // Simplified: just use delta, no swing subtraction
-             stage2HeatingEnabled) { // Check if stage 2 heating is enabled
-        debugLog("[HVAC] Stage 2 HEATING activated (temp %.1f < setpoint %.1f - delta %.1f)\n", 
-                 currentTemp, setTempHeat, stage2TempDelta);
-        digitalWrite(HEAT_RELAY_2_PIN, HIGH); // Activate stage 2
-        stage2Active = true;
-        stage2StartTime = millis(); // Record when stage 2 started
-    }
-    // Stage 2 DEACTIVATION: When temperature recovers sufficiently while stage 1 continues
-    else if (stage2Active && !reversingValveEnabled &&
-             ((millis() - stage2StartTime) >= STAGE2_MIN_RUNTIME) && // Must run minimum time before deactivation
-             (currentTemp >= setTempHeat - (stage2TempDelta * 0.5))) { // Deactivate at half-delta for hysteresis
-        debugLog("[HVAC] Stage 2 HEATING deactivated (temp %.1f >= setpoint %.1f - half-delta %.1f, runtime %.1fs)\n", 
-                 currentTemp, setTempHeat, (stage2TempDelta * 0.5), (millis() - stage2StartTime) / 1000.0);
-        digitalWrite(HEAT_RELAY_2_PIN, LOW); // Deactivate stage 2
-        stage2Active = false;
-    }
-    
-    // Control fan based on fanRelayNeeded setting
-    // BUT: Never override manual "on" mode - user takes priority
-    if (fanMode == "on" && !(hydronicHeatingEnabled &&
-        (!ds18b20SensorPresent || isnan(hydronicTemp) || hydronicTemp < hydronicTempLow || hydronicLockout))) {
-        // User has manually set fan to always on - respect that
-        if (!fanOn) {
-            debugLog("[HVAC] FAN turned ON (manual mode)\n");
-            digitalWrite(FAN_RELAY_PIN, HIGH);
-            fanOn = true;
-            debugLog("Fan activated with heat (manual 'on' mode)\n");
-        }
-    } else if (fanRelayNeeded) {
-        if (!fanOn) {
-            digitalWrite(FAN_RELAY_PIN, HIGH);
-            fanOn = true;
-            debugLog("Fan activated with heat\n");
-        }
-    } else {
-        // HVAC controls its own fan, turn ours off
-        if (fanOn) {
-            digitalWrite(FAN_RELAY_PIN, LOW);
-            fanOn = false;
-            debugLog("Fan turned off during heat - HVAC controls fan\n");
-        }
+    SettingsForm form;
+    settingsFormBegin(form);
+    for (JsonPairConst field : body["settings"].as<JsonObjectConst>()) {
+        char number[24];
+        settingsFormField(form, field.key().c_str(), stateSettingText(field.value(), number, sizeof(number)));
     }
-    updateStatusLEDs(); // Update LED status
-    setDisplayUpdateFlag(); // Option C: Request display update
-}
+    if (form.groups != 0) applySettingsForm(form);
 
-void activateCooling()
-{
-    debugLog("[DEBUG] activateCooling() ENTRY: stage1Active=%d, stage2Active=%d\n", stage1Active, stage2Active);
-    bool euHumidityRelayMode = (thermostatRegion == "EU" && euHumidityControlEnabled && euHumidityDemandActive);
-    int coolingRelayPin = COOL_RELAY_1_PIN;
-    if (euHumidityRelayMode) {
-        if (euHumidityRelaySelection == 1) {
-            coolingRelayPin = COOL_RELAY_2_PIN;
-        } else if (euHumidityRelaySelection == 2) {
-            coolingRelayPin = PUMP_RELAY_PIN;
-        }
+    bool scheduleChanged = false;
+    if (body["scheduleEnabled"].is<bool>()) {
+        scheduleChanged |= setScheduleEnabled(body["scheduleEnabled"].as<bool>());
     }
-    
-    // Default cooling behavior with hybrid staging
-    coolingOn = true;
-    heatingOn = false;
-    
-    // Turn off heating relays when activating cooling
-    digitalWrite(HEAT_RELAY_1_PIN, LOW);
-    
-    // Handle reversing valve: de-energize for cooling mode
-    if (reversingValveEnabled) {
-        debugLog("[HVAC] Reversing valve de-energized for COOL mode\n");
-        digitalWrite(HEAT_RELAY_2_PIN, LOW);
-        stage2Active = false;
-    } else {
-        digitalWrite(HEAT_RELAY_2_PIN, LOW);
+    if (body["scheduleOverride"].is<const char*>()) {
+        scheduleChanged |= setScheduleOverride(body["scheduleOverride"].as<const char*>());
     }
-    
-    // Check if stage 1 is not active yet
-    if (!stage1Active) {
-        debugLog("[DEBUG] Activating cooling relay pin %d\n", coolingRelayPin);
-        if (euHumidityRelayMode) {
-            digitalWrite(COOL_RELAY_1_PIN, LOW);
-            digitalWrite(COOL_RELAY_2_PIN, LOW);
-            digitalWrite(PUMP_RELAY_PIN, LOW);
-        }
-        digitalWrite(coolingRelayPin, HIGH);
-        stage1Active = true;
-        stage1StartTime = millis(); // Record the start time
-        stage2Active = false; // Ensure stage 2 is off initially
-        debugLog("[DEBUG] Cooling activated - relay pin %d set HIGH\n", coolingRelayPin);
-        
-        // Wake display when HVAC activates
-        if (displayIsAsleep) {
-            wakeDisplay();
-            debugLog("[DISPLAY] Woke from sleep - cooling activated\n");
-        }
-    } else {
-        debugLog("[DEBUG] Cooling stage 1 already active (stage1Active=%d)\n", stage1Active);
-    }
-    
-    // Only activate stage 2 cooling if NOT using reversing valve and not in EU humidity relay mode
-    if (!euHumidityRelayMode && !reversingValveEnabled && !stage2Active && 
-            ((millis() - stage1StartTime) / 1000 >= stage1MinRuntime) && // Minimum run time before stage 2 allowed
-            (currentTemp > setTempCool + stage2TempDelta) && // Simplified: just use delta, no swing addition
-            stage2CoolingEnabled) { // Check if stage 2 cooling is enabled
-        debugLog("[HVAC] Stage 2 COOLING activated (temp %.1f > setpoint %.1f + delta %.1f)\n", 
-                 currentTemp, setTempCool, stage2TempDelta);
-        digitalWrite(COOL_RELAY_2_PIN, HIGH); // Activate stage 2
-        stage2Active = true;
-        stage2StartTime = millis(); // Record when stage 2 started
-    }
-    // Stage 2 DEACTIVATION: When temperature recovers sufficiently while stage 1 continues
-    else if (stage2Active && !reversingValveEnabled &&
-             ((millis() - stage2StartTime) >= STAGE2_MIN_RUNTIME) && // Must run minimum time before deactivation
-             (currentTemp <= setTempCool + (stage2TempDelta * 0.5))) { // Deactivate at half-delta for hysteresis
-        debugLog("[HVAC] Stage 2 COOLING deactivated (temp %.1f <= setpoint %.1f + half-delta %.1f, runtime %.1fs)\n", 
-                 currentTemp, setTempCool, (stage2TempDelta * 0.5), (millis() - stage2StartTime) / 1000.0);
-        digitalWrite(COOL_RELAY_2_PIN, LOW); // Deactivate stage 2
-        stage2Active = false;
-    }
-    
-    // Control fan based on fanRelayNeeded setting
-    // BUT: Never override manual "on" mode - user takes priority
-    if (fanMode == "on" && !(hydronicHeatingEnabled &&
-        (!ds18b20SensorPresent || isnan(hydronicTemp) || hydronicTemp < hydronicTempLow || hydronicLockout))) {
-        // User has manually set fan to always on - respect that
-        if (!fanOn) {
-            digitalWrite(FAN_RELAY_PIN, HIGH);
-            fanOn = true;
-            debugLog("Fan activated with cooling (manual 'on' mode)\n");
-        }
-    } else if (fanRelayNeeded) {
-        if (!fanOn) {
-            digitalWrite(FAN_RELAY_PIN, HIGH);
-            fanOn = true;
-            debugLog("Fan activated with cooling\n");
-        }
-    } else {
-        // HVAC controls its own fan, turn ours off
-        if (fanOn) {
-            digitalWrite(FAN_RELAY_PIN, LOW);
-            fanOn = false;
-            debugLog("Fan turned off during cool - HVAC controls fan\n");
+    JsonArrayConst days = body["schedule"].as<JsonArrayConst>();
+    for (int day = 0; day < 7 && day < (int)days.size(); day++) {
+        JsonObjectConst entry = days[day];
+        if (entry.isNull()) continue;
+        if (entry["enabled"].is<bool>() && entry["enabled"].as<bool>() != weekSchedule[day].enabled) {
+            weekSchedule[day].enabled = entry["enabled"].as<bool>();
+            scheduleChanged = true;
         }
+        scheduleChanged |= applySchedulePeriodJson(weekSchedule[day].day, entry["day"]);
+        scheduleChanged |= applySchedulePeriodJson(weekSchedule[day].night, entry["night"]);
     }
-    updateStatusLEDs(); // Update LED status
-    setDisplayUpdateFlag(); // Option C: Request display update
+    if (scheduleChanged) {
+        scheduleVersion++;
+        settingsMarkDirty(SETTINGS_DIRTY_SCHEDULE, NVS_WRITER_WEB);
+        LOG_INFO(SCHEDULE, "Settings updated via web interface\n");
+    }
+    request->send(200, "application/json", "{\"status\":\"success\",\"message\":\"Settings saved successfully!\"}");
 }
 
-void handleFanControl()
+// Gzipped asset from flash (WebAssets.h). Hashed asset URLs change with
+// the content, so browsers may keep them forever; a revalidation that still
+// matches gets a bodyless 304.
+static void serveWebAsset(AsyncWebServerRequest *request, const uint8_t *data, size_t length,
+                          const char *type, const char *etag,
+                          const char *cacheControl = "public, max-age=31536000, immutable")
 {
-    // Block fan when hydronic heating is enabled and sensor is missing/invalid or below cutoff
-    if (hydronicHeatingEnabled &&
-        (!ds18b20SensorPresent || isnan(hydronicTemp) || hydronicTemp < hydronicTempLow || hydronicLockout)) {
-        if (fanOn) {
-            digitalWrite(FAN_RELAY_PIN, LOW);
-            fanOn = false;
-            debugLog("[FAN] Forced OFF (hydronic lockout or sensor missing)\n");
-        }
-        setDisplayUpdateFlag(); // Option C: Request display update
-        return;
-    }
-
-    bool newFanState = fanOn;  // Default: keep current state
-    
-    if (fanMode == "on")
-    {
-        newFanState = true;  // Always on
-    }
-    else if (fanMode == "auto")
-    {
-        // Auto mode: fan only runs with heating/cooling if fanRelayNeeded is true
-        // If fanRelayNeeded is false, HVAC controls the fan
-        if (fanRelayNeeded) {
-            newFanState = (heatingOn || coolingOn);
-        } else {
-            newFanState = false;  // Don't control fan - HVAC system controls it
-        }
-    }
-    else if (fanMode == "cycle")
-    {
-        // Cycle mode: handled by controlFanSchedule(), don't override here
+    const AsyncWebHeader *match = request->getHeader("If-None-Match");
+    if (match && match->value().indexOf(etag) >= 0) {
+        AsyncWebServerResponse *response = request->beginResponse(304);
+        response->addHeader("ETag", etag);
+        response->addHeader("Cache-Control", cacheControl);
+        request->send(response);
         return;
     }
-    
-    // Only write GPIO if state actually changed (state guard)
-    if (newFanState != fanOn) {
-        digitalWrite(FAN_RELAY_PIN, newFanState ? HIGH : LOW);
-        fanOn = newFanState;
-        debugLog("[FAN] Fan state changed via handleFanControl: %s\n", fanOn ? "ON" : "OFF");
-    }
-    
-    setDisplayUpdateFlag(); // Option C: Request display update
+    AsyncWebServerResponse *response = request->beginResponse(200, type, data, length);
+    response->addHeader("Content-Encoding", "gzip");
+    response->addHeader("ETag", etag);
+    response->addHeader("Cache-Control", cacheControl);
+    request->send(response);
 }
 
-void controlFanSchedule()
+void handleWebRequests()
 {
-    // Removed 1-hour boot delay - fan cycle starts immediately
-
-    if (fanMode == "cycle")
+    server.on(WEB_APP_CSS_PATH, HTTP_GET, [](AsyncWebServerRequest *request)
     {
-        if (hydronicHeatingEnabled &&
-            (!ds18b20SensorPresent || isnan(hydronicTemp) || hydronicTemp < hydronicTempLow || hydronicLockout)) {
-            if (fanOn) {
-                digitalWrite(FAN_RELAY_PIN, LOW);
-                fanOn = false;
-                debugLog("[FAN SCHEDULE] Forced OFF (hydronic lockout or sensor missing)\n");
-            }
-            return;
-        }
-
-        // Don't run cycle schedule if heating or cooling is active
-        if (heatingOn || coolingOn) {
-            if (!fanRelayNeeded && fanOn) {
-                digitalWrite(FAN_RELAY_PIN, LOW);
-                fanOn = false;
-                debugLog("[FAN SCHEDULE] Stopping fan - heating/cooling active, fanRelayNeeded=false\n");
-            }
-            return;
-        }
-
-        unsigned long currentTime = millis();
-        unsigned long elapsedTime = (currentTime - lastFanRunTime) / 1000; // Convert to seconds
-        unsigned long hourElapsed = elapsedTime % SECONDS_PER_HOUR;
-
-        // If an hour has passed, reset the cycle
-        if (elapsedTime >= SECONDS_PER_HOUR)
-        {
-            debugLog("[FAN SCHEDULE] Hour elapsed, resetting fan cycle\n");
-            lastFanRunTime = currentTime;
-            hourElapsed = 0;
-        }
-
-        // Calculate which 5-minute increment we're in (0-11)
-        // fanMinutesPerHour determines how many 5-min increments to run
-        // Example: 15 minutes = 3 increments of 5 minutes
-        unsigned long totalIncrements = (fanMinutesPerHour / 5);
-        unsigned long currentIncrement = (hourElapsed / 300);  // 300 seconds = 5 minutes
-        
-        // Validate totalIncrements (max 12 for 60 minutes)
-        if (totalIncrements > 12) {
-            totalIncrements = 12;  // Cap at 60 minutes
-        }
-        if (totalIncrements == 0) {
-            totalIncrements = 1;  // Minimum 1 increment (5 minutes)
-        }
+        serveWebAsset(request, WEB_APP_CSS_GZ, WEB_APP_CSS_GZ_LEN, WEB_APP_CSS_TYPE, WEB_APP_CSS_ETAG);
+    });
 
-        // Fan should run during first N increments, then off for remainder
-        bool shouldRun = (currentIncrement < totalIncrements);
-        
-        // Only write GPIO if state actually changed
-        if (shouldRun != fanOn) {
-            digitalWrite(FAN_RELAY_PIN, shouldRun ? HIGH : LOW);
-            fanOn = shouldRun;
-            debugLog("[FAN SCHEDULE] Cycle mode: increment %lu/%lu (%lu/%lu min), fan %s\n", 
-                         currentIncrement, totalIncrements, 
-                         currentIncrement * 5, fanMinutesPerHour,
-                         fanOn ? "ON" : "OFF");
-        }
-        
-        updateStatusLEDs(); // Update LED status
-    }
-    // Retain auto mode for backward compatibility
-    else if (fanMode == "auto")
+    server.on(WEB_APP_JS_PATH, HTTP_GET, [](AsyncWebServerRequest *request)
     {
-        // No scheduled fan running in auto mode - handled by handleFanControl()
-    }
-}
+        serveWebAsset(request, WEB_APP_JS_GZ, WEB_APP_JS_GZ_LEN, WEB_APP_JS_TYPE, WEB_APP_JS_ETAG);
+    });
 
-void handleWebRequests()
-{
+    // The UI is a static shell (web/index.html) that renders from
+    // /api/state. Its URL is fixed, so it is revalidated on every load; the
+    // ETag changes with each firmware that changes it.
     server.on("/", HTTP_GET, [](AsyncWebServerRequest *request)
     {
-        String html = generateStatusPage(currentTemp, currentHumidity, hydronicTemp, hydronicReturnTemp,
-                                       thermostatMode, fanMode, version_info, hostname, 
-                                       useFahrenheit, hydronicHeatingEnabled,
-                                       HEAT_RELAY_1_PIN, HEAT_RELAY_2_PIN, COOL_RELAY_1_PIN, 
-                                       COOL_RELAY_2_PIN, FAN_RELAY_PIN,
-                                       setTempHeat, setTempCool, setTempAuto,
-                                       tempSwing, autoTempSwing,
-                                       fanRelayNeeded, stage1MinRuntime, 
-                                       stage2TempDelta, fanMinutesPerHour,
-                                       showerModeEnabled, showerModeDuration,
-                                       stage2HeatingEnabled, stage2CoolingEnabled,
-                                       reversingValveEnabled,
-                                       backupHeatEnabled, backupHeatRelaySelection, backupHeatDelayMinutes,
-                                       backupHeatMinTempRise, backupHeatMaxTempDrop,
-                                       thermostatRegion,
-                                       euHumidityControlEnabled, euHumidityRelaySelection,
-                                       euHumiditySetpoint, euHumidityDeadband,
-                                       euHumidityDemandActive,
-                                       hydronicTempLow, hydronicTempHigh,
-                                       wifiSSID, wifiPassword, timeZone,
-                                       use24HourClock, mqttEnabled, mqttServer,
-                                       mqttPort, mqttUsername, mqttPassword,
-                                       tempOffset, humidityOffset, currentBrightness, ldrDimmingEnabled,
-                                       displaySleepEnabled, displaySleepTimeout,
-                                       weekSchedule, scheduleEnabled, activePeriod,
-                                       scheduleOverride,
-                                       weatherSource, owmApiKey, owmCity, owmState, owmCountry,
-                                       haUrl, haToken, haEntityId, weatherUpdateInterval,
-                                       weather.getData());
-        AsyncWebServerResponse *response = request->beginResponse(200, "text/html", html);
+        serveWebAsset(request, WEB_INDEX_GZ, WEB_INDEX_GZ_LEN, WEB_INDEX_TYPE, WEB_INDEX_ETAG, "no-cache");
+    });
+
+    // ?live=1: only the values the status tab refreshes. AsyncResponseStream
+    // buffers the document (about 3 KB in full) in a heap cbuf until sent.
+    server.on("/api/state", HTTP_GET, [](AsyncWebServerRequest *request)
+    {
+        AsyncResponseStream *response = request->beginResponseStream("application/json");
         response->addHeader("Cache-Control", "no-store, no-cache, must-revalidate, max-age=0");
-        response->addHeader("Pragma", "no-cache");
-        response->addHeader("Expires", "0");
+        writeWebState(*response, request->hasParam("live"));
         request->send(response);
     });
 
+    AsyncCallbackJsonWebHandler *statePost = new AsyncCallbackJsonWebHandler("/api/state", handleStatePost);
+    statePost->setMethod(HTTP_POST);
+    server.addHandler(statePost);
+
     server.on("/settings", HTTP_GET, [](AsyncWebServerRequest *request)
     {
         AsyncWebServerResponse *response = request->beginResponse(302, "text/plain", "Redirecting to embedded settings page...");
@@ -4749,293 +4605,17 @@ void handleWebRequests()
 
     server.on("/set", HTTP_POST, [](AsyncWebServerRequest *request)
               {
-        bool tempChanged = false;
-        if (request->hasParam("setTempHeat", true)) {
-            setTempHeat = request->getParam("setTempHeat", true)->value().toFloat();
-            if (setTempHeat < 50) setTempHeat = 50;
-            if (setTempHeat > 95) setTempHeat = 95;
-            tempChanged = true;
-        }
-        if (request->hasParam("setTempCool", true)) {
-            setTempCool = request->getParam("setTempCool", true)->value().toFloat();
-            if (setTempCool < 50) setTempCool = 50;
-            if (setTempCool > 95) setTempCool = 95;
-            tempChanged = true;
-        }
-        if (request->hasParam("setTempAuto", true)) {
-            setTempAuto = request->getParam("setTempAuto", true)->value().toFloat();
-            if (setTempAuto < 50) setTempAuto = 50;
-            if (setTempAuto > 95) setTempAuto = 95;
-            tempChanged = true;
-        }
-        
-        // If schedule is enabled and not overridden, trigger and persist a temporary override
-        if (tempChanged && scheduleEnabled && !scheduleOverride) {
-            scheduleOverride = true;
-            overrideEndTime = millis() + (scheduleOverrideDuration * 60000UL);
-            debugLog("SCHEDULE: Web /set temperature change triggered override\n");
-            saveScheduleSettings();
-        }
-        if (request->hasParam("tempSwing", true)) {
-            tempSwing = request->getParam("tempSwing", true)->value().toFloat();
-        }
-        if (request->hasParam("autoTempSwing", true)) {
-            autoTempSwing = request->getParam("autoTempSwing", true)->value().toFloat();
-        }
-        if (request->hasParam("fanRelayNeeded", true)) {
-            fanRelayNeeded = request->getParam("fanRelayNeeded", true)->value() == "on";
-        } else {
-            fanRelayNeeded = false; // Ensure fanRelayNeeded is set to false if not present in the form
-        }
-        if (request->hasParam("useFahrenheit", true)) {
-            useFahrenheit = request->getParam("useFahrenheit", true)->value() == "on";
-        }
-        if (request->hasParam("mqttEnabled", true)) {
-            mqttEnabled = request->getParam("mqttEnabled", true)->value() == "on";
-        } else {
-            mqttEnabled = false; // Ensure mqttEnabled is set to false if not present in the form
-        }
-        if (request->hasParam("hydronicHeatingEnabled", true)) {
-            hydronicHeatingEnabled = request->getParam("hydronicHeatingEnabled", true)->value() == "on"; // Handle hydronic heating option
-        } else {
-            hydronicHeatingEnabled = false; // Ensure hydronicHeatingEnabled is set to false if not present in the form
-        }
-        if (request->hasParam("hydronicTempLow", true)) {
-            hydronicTempLow = request->getParam("hydronicTempLow", true)->value().toFloat(); // Handle hydronic temp low
-        }
-        if (request->hasParam("hydronicTempHigh", true)) {
-            hydronicTempHigh = request->getParam("hydronicTempHigh", true)->value().toFloat(); // Handle hydronic temp high
-        }
-        if (request->hasParam("fanMinutesPerHour", true)) {
-            fanMinutesPerHour = request->getParam("fanMinutesPerHour", true)->value().toInt();
-        }
-        if (request->hasParam("showerModeEnabled", true)) {
-            showerModeEnabled = request->getParam("showerModeEnabled", true)->value() == "on";
-        } else {
-            showerModeEnabled = false;
-        }
-        if (request->hasParam("showerModeDuration", true)) {
-            showerModeDuration = request->getParam("showerModeDuration", true)->value().toInt();
-            if (showerModeDuration < 5) showerModeDuration = 5;
-            if (showerModeDuration > 120) showerModeDuration = 120;
-        }
-        if (request->hasParam("mqttServer", true)) {
-            mqttServer = request->getParam("mqttServer", true)->value(); // Ensure mqttServer is updated correctly
-        }
-        if (request->hasParam("mqttPort", true)) {
-            mqttPort = request->getParam("mqttPort", true)->value().toInt(); // Ensure mqttPort is updated correctly
-        }
-        if (request->hasParam("mqttUsername", true)) {
-            mqttUsername = request->getParam("mqttUsername", true)->value(); // Ensure mqttUsername is updated correctly
-        }
-        if (request->hasParam("mqttPassword", true)) {
-            mqttPassword = request->getParam("mqttPassword", true)->value(); // Ensure mqttPassword is updated correctly
-        }
-        if (request->hasParam("wifiSSID", true)) {
-            wifiSSID = request->getParam("wifiSSID", true)->value(); // Ensure wifiSSID is updated correctly
-        }
-        if (request->hasParam("wifiPassword", true)) {
-            String newWifiPassword = request->getParam("wifiPassword", true)->value();
-            if (!newWifiPassword.isEmpty()) {
-                wifiPassword = newWifiPassword; // Update wifiPassword only if a new one is provided
-            }
-        }
-        if (request->hasParam("hostname", true)) {
-            hostname = request->getParam("hostname", true)->value(); // Ensure hostname is updated correctly
-        }
-        if (request->hasParam("clockFormat", true)) {
-            use24HourClock = request->getParam("clockFormat", true)->value() == "24";
-        }
-        if (request->hasParam("timeZone", true)) {
-            timeZone = request->getParam("timeZone", true)->value();
-            setenv("TZ", timeZone.c_str(), 1);
-            tzset();
-        }
-        if (request->hasParam("thermostatMode", true)) {
-            thermostatMode = request->getParam("thermostatMode", true)->value();
-        }
-        if (request->hasParam("fanMode", true)) {
-            fanMode = request->getParam("fanMode", true)->value();
-        }
-        if (request->hasParam("stage1MinRuntime", true)) {
-            stage1MinRuntime = request->getParam("stage1MinRuntime", true)->value().toInt();
-        }
-        if (request->hasParam("stage2TempDelta", true)) {
-            stage2TempDelta = request->getParam("stage2TempDelta", true)->value().toFloat();
-        }
-        if (request->hasParam("stage2HeatingEnabled", true)) {
-            stage2HeatingEnabled = request->getParam("stage2HeatingEnabled", true)->value() == "on";
-        } else {
-            stage2HeatingEnabled = false; // Ensure stage2HeatingEnabled is set to false if not present in the form
-        }
-        if (request->hasParam("reversingValveEnabled", true)) {
-            reversingValveEnabled = request->getParam("reversingValveEnabled", true)->value() == "on";
-        } else {
-            reversingValveEnabled = false;
-        }
-        // Mutual exclusion: cannot have both stage2 heating and reversing valve
-        if (stage2HeatingEnabled && reversingValveEnabled) {
-            debugLog("[WARNING] Both stage2HeatingEnabled and reversingValveEnabled set - disabling stage2HeatingEnabled\n");
-            stage2HeatingEnabled = false;
-        }
-        if (request->hasParam("stage2CoolingEnabled", true)) {
-            stage2CoolingEnabled = request->getParam("stage2CoolingEnabled", true)->value() == "on";
-        } else {
-            stage2CoolingEnabled = false; // Ensure stage2CoolingEnabled is set to false if not present in the form
-        }
-        if (request->hasParam("backupHeatEnabled", true)) {
-            backupHeatEnabled = request->getParam("backupHeatEnabled", true)->value() == "on";
-        } else {
-            backupHeatEnabled = false;
-        }
-        if (request->hasParam("backupHeatRelay", true)) {
-            backupHeatRelaySelection = request->getParam("backupHeatRelay", true)->value().toInt();
-            backupHeatRelaySelection = constrain(backupHeatRelaySelection, 0, 2);
-        }
-        if (request->hasParam("backupHeatDelayMinutes", true)) {
-            backupHeatDelayMinutes = request->getParam("backupHeatDelayMinutes", true)->value().toInt();
-            backupHeatDelayMinutes = constrain(backupHeatDelayMinutes, 5, 180);
-        }
-        if (request->hasParam("backupHeatMinTempRise", true)) {
-            backupHeatMinTempRise = request->getParam("backupHeatMinTempRise", true)->value().toFloat();
-            backupHeatMinTempRise = constrain(backupHeatMinTempRise, 0.1f, 5.0f);
-        }
-        if (request->hasParam("backupHeatMaxTempDrop", true)) {
-            backupHeatMaxTempDrop = request->getParam("backupHeatMaxTempDrop", true)->value().toFloat();
-            backupHeatMaxTempDrop = constrain(backupHeatMaxTempDrop, 0.1f, 10.0f);
-        }
-        enforceBackupHeatRelayConflicts();
-        
-        // US/EU Mode settings
-        if (request->hasParam("thermostatRegion", true)) {
-            String region = request->getParam("thermostatRegion", true)->value();
-            if (region == "EU" || region == "US") {
-                thermostatRegion = region;
-            }
-        }
-        
-        // EU Humidity Control settings
-        if (request->hasParam("euHumidityControlEnabled", true)) {
-            euHumidityControlEnabled = request->getParam("euHumidityControlEnabled", true)->value() == "on";
-        } else {
-            euHumidityControlEnabled = false;
-        }
-        if (request->hasParam("euHumidityRelay", true)) {
-            euHumidityRelaySelection = request->getParam("euHumidityRelay", true)->value().toInt();
-            euHumidityRelaySelection = constrain(euHumidityRelaySelection, 0, 2);
-        }
-        if (request->hasParam("euHumiditySetpoint", true)) {
-            euHumiditySetpoint = request->getParam("euHumiditySetpoint", true)->value().toFloat();
-            euHumiditySetpoint = constrain(euHumiditySetpoint, 30.0f, 90.0f);
-        }
-        if (request->hasParam("euHumidityDeadband", true)) {
-            euHumidityDeadband = request->getParam("euHumidityDeadband", true)->value().toFloat();
-            euHumidityDeadband = constrain(euHumidityDeadband, 1.0f, 20.0f);
-        }
-        enforceEUHumidityRelayConflicts();
-        
-        if (request->hasParam("tempOffset", true)) {
-            tempOffset = request->getParam("tempOffset", true)->value().toFloat();
-            // Constrain to reasonable range (-10°C to +10°C)
-            tempOffset = constrain(tempOffset, -10.0, 10.0);
-        }
-        if (request->hasParam("humidityOffset", true)) {
-            humidityOffset = request->getParam("humidityOffset", true)->value().toFloat();
-            // Constrain to reasonable range (-50% to +50%)
-            humidityOffset = constrain(humidityOffset, -50.0, 50.0);
-        }
-        bool hasDisplaySettings = request->hasParam("displaySleepEnabled", true) ||
-                      request->hasParam("displaySleepTimeout", true) ||
-                      request->hasParam("currentBrightness", true) ||
-                      request->hasParam("ldrDimmingEnabled", true) ||
-                      request->hasParam("tempOffset", true) ||
-                      request->hasParam("humidityOffset", true);
-        if (hasDisplaySettings) {
-            if (request->hasParam("displaySleepEnabled", true)) {
-                displaySleepEnabled = request->getParam("displaySleepEnabled", true)->value() == "on";
-            } else {
-                displaySleepEnabled = false; // Unchecked checkbox won't send parameter
-            }
-        }
-        if (request->hasParam("displaySleepTimeout", true)) {
-            unsigned long timeoutMinutes = request->getParam("displaySleepTimeout", true)->value().toInt();
-            // Constrain to reasonable range (1 minute to 60 minutes)
-            timeoutMinutes = constrain(timeoutMinutes, 1UL, 60UL);
-            displaySleepTimeout = timeoutMinutes * 60000; // Convert to milliseconds
-        }
-        if (request->hasParam("currentBrightness", true)) {
-            currentBrightness = request->getParam("currentBrightness", true)->value().toInt();
-            // Constrain to reasonable range (30 to 255)
-            currentBrightness = constrain(currentBrightness, 30, 255);
-            setBrightness(currentBrightness); // Apply brightness immediately
-        }
-        if (hasDisplaySettings) {
-            if (request->hasParam("ldrDimmingEnabled", true)) {
-                ldrDimmingEnabled = request->getParam("ldrDimmingEnabled", true)->value() == "on";
-            } else {
-                ldrDimmingEnabled = false; // Unchecked checkbox won't send parameter
-            }
-        }
-        if (request->hasParam("use24HourClock", true)) {
-            use24HourClock = request->getParam("use24HourClock", true)->value() == "on";
-        } else {
-            use24HourClock = false;
-        }
-        
-        // Weather settings
-        if (request->hasParam("weatherSource", true)) {
-            weatherSource = request->getParam("weatherSource", true)->value().toInt();
-        }
-        if (request->hasParam("owmApiKey", true)) {
-            owmApiKey = request->getParam("owmApiKey", true)->value();
-        }
-        if (request->hasParam("owmCity", true)) {
-            owmCity = request->getParam("owmCity", true)->value();
-        }
-        if (request->hasParam("owmState", true)) {
-            owmState = request->getParam("owmState", true)->value();
-        }
-        if (request->hasParam("owmCountry", true)) {
-            owmCountry = request->getParam("owmCountry", true)->value();
-        }
-        if (request->hasParam("haUrl", true)) {
-            haUrl = request->getParam("haUrl", true)->value();
-        }
-        if (request->hasParam("haToken", true)) {
-            haToken = request->getParam("haToken", true)->value();
-        }
-        if (request->hasParam("haEntityId", true)) {
-            haEntityId = request->getParam("haEntityId", true)->value();
-        }
-        if (request->hasParam("weatherUpdateInterval", true)) {
-            weatherUpdateInterval = request->getParam("weatherUpdateInterval", true)->value().toInt();
-            if (weatherUpdateInterval < 5) weatherUpdateInterval = 5;
-            if (weatherUpdateInterval > 60) weatherUpdateInterval = 60;
-        }
-
-        saveSettings();
-        
-        // Reconfigure weather module if weather settings were provided
-        if (request->hasParam("weatherSource", true)) {
-            debugLog("WEATHER CONFIG: Reconfiguring weather module from web interface\n");
-            debugLog("  Source: %d\n", weatherSource);
-            debugLog("  Update Interval: %d minutes\n", weatherUpdateInterval);
-            
-            weather.setUseFahrenheit(useFahrenheit);
-            weather.setSource((WeatherSource)weatherSource);
-            weather.setOpenWeatherMapConfig(owmApiKey, owmCity, owmState, owmCountry);
-            weather.setHomeAssistantConfig(haUrl, haToken, haEntityId);
-            weather.setUpdateInterval(weatherUpdateInterval * 60000);
-            
-            bool success = weather.update(); // Force immediate update
-            debugLog("WEATHER CONFIG: Immediate update %s\n", success ? "SUCCESS" : "FAILED");
-            if (!success) {
-                debugLog("WEATHER CONFIG: Error: %s\n", weather.getLastError().c_str());
-            }
-        }
-        
-        sendMQTTData();
-        publishHomeAssistantDiscovery(); // Publish discovery messages after saving settings
+        if (refuseWhileConfigReadOnly(request)) return;
+        // One pass over the posted fields (SETTINGS[] in the registry)
+        SettingsForm form;
+        settingsFormBegin(form);
+        size_t fields = request->params();
+        for (size_t i = 0; i < fields; i++) {
+            const AsyncWebParameter* param = request->getParam(i);
+            if (param->isPost() && !param->isFile()) settingsFormField(form, param->name(), param->value());
+        }
+        settingsFormEnd(form);
+        applySettingsForm(form);
         request->send(200, "application/json", "{\"status\":\"success\",\"message\":\"Settings saved successfully!\"}"); });
 
     server.on("/set_heating", HTTP_POST, [](AsyncWebServerRequest *request)
@@ -5146,8 +4726,8 @@ void handleWebRequests()
         if (tempChanged && scheduleEnabled && !scheduleOverride) {
             scheduleOverride = true;
             overrideEndTime = millis() + (scheduleOverrideDuration * 60000UL);
-            debugLog("SCHEDULE: Web /control temperature change triggered override\n");
-            saveScheduleSettings();
+            LOG_INFO(SCHEDULE, "Web /control temperature change triggered override\n");
+            settingsMarkDirty(SETTINGS_DIRTY_SCHEDULE, NVS_WRITER_WEB);
         }
         if (request->hasParam("tempSwing", true)) {
             tempSwing = request->getParam("tempSwing", true)->value().toFloat();
@@ -5159,8 +4739,8 @@ void handleWebRequests()
             fanMode = request->getParam("fanMode", true)->value();
         }
 
-        saveSettings();
-        sendMQTTData();
+        settingsMarkDirty(SETTINGS_DIRTY_SETTINGS, NVS_WRITER_WEB);
+        mqttFeedbackNeeded = true; // loop() queues the new state
         request->send(200, "application/json", "{\"status\": \"success\"}");
     });
 
@@ -5173,7 +4753,9 @@ void handleWebRequests()
         }
         
         systemRebootInProgress = true;
-        debugLog("[REBOOT] Reboot requested via web interface\n");
+        LOG_INFO(SYSTEM, "Reboot requested via web interface\n");
+        postMortemRecord(PM_RESTART, PM_RESTART_WEB);
+        flushSettings(true);
         
         // Send simple JSON response and close connection
         AsyncWebServerResponse *response = request->beginResponse(200, "application/json", 
@@ -5212,14 +4794,16 @@ void handleWebRequests()
             otaInProgress = false;
             if (updateSuccess) {
                 otaRebooting = true;
-                debugLog("[OTA] Update SUCCESS - sending response and scheduling reboot...\n");
+                LOG_INFO(OTA, "Update SUCCESS - sending response and scheduling reboot...\n");
                 // Send response immediately so client gets it before connection drops
                 AsyncWebServerResponse *response = request->beginResponse(200, "text/plain", "Update successful! Rebooting...");
                 response->addHeader("Connection", "close");
                 request->send(response);
                 // Longer delay to ensure response is fully transmitted before reboot
                 delay(1500);
-                debugLog("[OTA] Rebooting now...\n");
+                LOG_INFO(OTA, "Rebooting now...\n");
+                postMortemRecord(PM_RESTART, PM_RESTART_OTA);
+                flushSettings(true);
                 ESP.restart();
             } else {
                 otaRebooting = false;
@@ -5229,24 +4813,25 @@ void handleWebRequests()
                 else if (Update.getError() == UPDATE_ERROR_MD5) error += "MD5 check failed";
                 else if (Update.getError() == UPDATE_ERROR_MAGIC_BYTE) error += "Invalid firmware file";
                 else error += "Error code " + String(Update.getError());
-                debugLog("[OTA] Update FAILED: %s\n", error.c_str());
+                LOG_WARN(OTA, "Update FAILED: %s\n", error.c_str());
                 request->send(500, "text/plain", error);
             }
         },
         [](AsyncWebServerRequest *request, String filename, size_t index, uint8_t *data, size_t len, bool final) {
             if (!index) {
-                debugLog("\n[OTA] Starting firmware update...\n");
-                debugLog("[OTA] Filename: %s\n", filename.c_str());
-                debugLog("[OTA] Free space: %u bytes\n", ESP.getFreeSketchSpace());
+                LOG_INFO(OTA, "Starting firmware update...\n");
+                LOG_DEBUG(OTA, "Filename: %s\n", filename.c_str());
+                LOG_DEBUG(OTA, "Free space: %u bytes\n", ESP.getFreeSketchSpace());
                 otaBytesWritten = 0;
                 otaTotalSize = request->contentLength(); // Capture total upload size
-                debugLog("[OTA] Total size: %u bytes\n", (unsigned)otaTotalSize);
+                LOG_DEBUG(OTA, "Total size: %u bytes\n", (unsigned)otaTotalSize);
                 otaInProgress = true;
                 otaRebooting = false;
                 otaStartTime = millis();
                 otaLastUpdateLog = otaStartTime;
+                postMortemRecord(PM_OTA_START, (uint32_t)otaTotalSize);
                 if (!Update.begin(UPDATE_SIZE_UNKNOWN)) {
-                    debugLog("[OTA] Update.begin() failed: %s\n", Update.errorString());
+                    LOG_WARN(OTA, "Update.begin() failed: %s\n", Update.errorString());
                     otaInProgress = false;
                     return;
                 }
@@ -5255,7 +4840,7 @@ void handleWebRequests()
             if (len) {
                 size_t written = Update.write(data, len);
                 if (written != len) {
-                    debugLog("[OTA] Write error: expected %u bytes, wrote %u bytes\n", len, written);
+                    LOG_ERROR(OTA, "Write error: expected %u bytes, wrote %u bytes\n", len, written);
                     otaInProgress = false;
                     return;
                 }
@@ -5263,16 +4848,18 @@ void handleWebRequests()
                 unsigned long now = millis();
                 if (now - otaLastUpdateLog > 1000) { // Update every second for smoother progress
                     int pct = otaTotalSize > 0 ? (otaBytesWritten * 100) / otaTotalSize : 0;
-                    debugLog("[OTA] Flash write: %u / %u bytes (%d%%)\n", 
+                    LOG_DEBUG(OTA, "Flash write: %u / %u bytes (%d%%)\n", 
                                   (unsigned)otaBytesWritten, (unsigned)otaTotalSize, pct);
                     otaLastUpdateLog = now;
                 }
             }
             if (final) {
                 if (Update.end(true)) {
-                    debugLog("[OTA] Update complete! Total bytes: %u\n", (unsigned)(index + len));
+                    LOG_INFO(OTA, "Update complete! Total bytes: %u\n", (unsigned)(index + len));
+                    postMortemRecord(PM_OTA_END, 1);
                 } else {
-                    debugLog("[OTA] Update.end() failed: %s\n", Update.errorString());
+                    LOG_WARN(OTA, "Update.end() failed: %s\n", Update.errorString());
+                    postMortemRecord(PM_OTA_END, 0);
                 }
             }
         }
@@ -5284,44 +4871,15 @@ void handleWebRequests()
     {
         bool settingsChanged = false;
         
-        // Master enable/disable
-        if (request->hasParam("scheduleEnabled", true)) {
-            bool newEnabled = request->getParam("scheduleEnabled", true)->value() == "on";
-            if (newEnabled != scheduleEnabled) {
-                scheduleEnabled = newEnabled;
-                settingsChanged = true;
-                if (!scheduleEnabled) {
-                    activePeriod = "manual";
-                    scheduleOverride = false;
-                    overrideEndTime = 0;
-                }
-            }
-        } else {
-            if (scheduleEnabled) {
-                scheduleEnabled = false;
-                activePeriod = "manual";
-                scheduleOverride = false;
-                overrideEndTime = 0;
-                settingsChanged = true;
-            }
-        }
+        // Master enable/disable (an unchecked box is not posted)
+        bool newEnabled = request->hasParam("scheduleEnabled", true) &&
+                          request->getParam("scheduleEnabled", true)->value() == "on";
+        if (setScheduleEnabled(newEnabled)) settingsChanged = true;
         
         // Schedule override control
-        if (request->hasParam("scheduleOverride", true)) {
-            String action = request->getParam("scheduleOverride", true)->value();
-            if (action == "temporary") {
-                scheduleOverride = true;
-                overrideEndTime = millis() + (2 * 60 * 60 * 1000); // 2 hours
-                settingsChanged = true;
-            } else if (action == "permanent") {
-                scheduleOverride = true;
-                overrideEndTime = 0; // Permanent until manually disabled
-                settingsChanged = true;
-            } else if (action == "resume") {
-                scheduleOverride = false;
-                overrideEndTime = 0;
-                settingsChanged = true;
-            }
+        if (request->hasParam("scheduleOverride", true) &&
+            setScheduleOverride(request->getParam("scheduleOverride", true)->value().c_str())) {
+            settingsChanged = true;
         }
         
         // Process schedule updates for each day
@@ -5385,9 +4943,9 @@ void handleWebRequests()
         }
         
         if (settingsChanged) {
-            // Call saveScheduleSettings() directly—no need for flag since new saveSettings() consolidates schedule saves
-            saveScheduleSettings();
-            debugLog("SCHEDULE: Settings updated via web interface (atomic save)\n");
+            scheduleVersion++;
+            settingsMarkDirty(SETTINGS_DIRTY_SCHEDULE, NVS_WRITER_WEB);
+            LOG_INFO(SCHEDULE, "Settings updated via web interface\n");
             request->send(200, "application/json", "{\"status\":\"success\",\"message\":\"Schedule settings saved successfully!\"}");
         } else {
             request->send(200, "application/json", "{\"status\":\"success\",\"message\":\"No changes detected\"}");
@@ -5400,54 +4958,163 @@ void handleWebRequests()
         request->send(200, "text/plain", "Weather update forced");
     });
     
-    // Debug log endpoint - returns JSON with recent serial output
+    // Debug log endpoint - returns JSON with recent serial output. Streamed
+    // straight from the log ring and escaped per chunk:
+    //   /api/debug              newest ~8KB of ring
+    //   /api/debug?since=<seq>  only records from <seq> on (the "next" value of
+    //                           the previous reply); "overwritten" is true when
+    //                           some of them were lost before this read
+    // {"log":"...","next":<seq>,"overwritten":false}
     server.on("/api/debug", HTTP_GET, [](AsyncWebServerRequest *request) {
-        String logOutput = getDebugLog();
-            const size_t MAX_JSON_DEBUG_BYTES = 8192;
-            if ((size_t)logOutput.length() > MAX_JSON_DEBUG_BYTES) {
-                logOutput.remove(0, logOutput.length() - MAX_JSON_DEBUG_BYTES);
-                int firstNewline = logOutput.indexOf('\n');
-                if (firstNewline >= 0 && firstNewline + 1 < logOutput.length()) {
-                    logOutput.remove(0, firstNewline + 1);
+        struct DebugJsonStream {
+            DebugLogCursor cursor;
+            uint8_t phase;  // 0 = prefix, 1 = log text, 2 = suffix, 3 = done
+            uint8_t suffixLen;
+            uint8_t suffixOff;
+            char suffix[64];
+        };
+        std::shared_ptr<DebugJsonStream> stream = std::make_shared<DebugJsonStream>();
+        if (request->hasParam("since")) {
+            const String &since = request->getParam("since")->value();
+            debugLogCursorSeek(stream->cursor, (uint32_t)strtoul(since.c_str(), nullptr, 10));
+        } else {
+            debugLogCursorBegin(stream->cursor, 8192);
+        }
+        stream->phase = 0;
+
+        AsyncWebServerResponse *response = request->beginChunkedResponse("application/json",
+            [stream](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+                size_t n = 0;
+                if (stream->phase == 0) {
+                    if (maxLen < 8) return RESPONSE_TRY_AGAIN;
+                    memcpy(buffer, "{\"log\":\"", 8);
+                    n = 8;
+                    stream->phase = 1;
                 }
-            }
-        
-            // Keep the legacy JSON endpoint lightweight so stale clients cannot force
-            // a large escaped response allocation and crash the web task.
-        AsyncResponseStream *response = request->beginResponseStream("application/json");
+                DebugLogCursor &cursor = stream->cursor;
+                while (stream->phase == 1) {
+                    if (cursor.off >= cursor.len && !debugLogCursorNext(cursor)) {
+                        // Cursor position is final only once the text is done
+                        stream->suffixLen = (uint8_t)snprintf(stream->suffix, sizeof(stream->suffix),
+                            "\",\"next\":%lu,\"overwritten\":%s}", (unsigned long)cursor.pos,
+                            cursor.lapped ? "true" : "false");
+                        stream->suffixOff = 0;
+                        stream->phase = 2;
+                        break;
+                    }
+                    // Worst case escape is \u00XX; leave the rest for the next chunk
+                    if (maxLen - n < 6) break;
+                    char c = cursor.text[cursor.off++];
+                    if      (c == '"')  { buffer[n++] = '\\'; buffer[n++] = '"'; }
+                    else if (c == '\\') { buffer[n++] = '\\'; buffer[n++] = '\\'; }
+                    else if (c == '\n') { buffer[n++] = '\\'; buffer[n++] = 'n'; }
+                    else if (c == '\r') { buffer[n++] = '\\'; buffer[n++] = 'r'; }
+                    else if (c == '\t') { buffer[n++] = '\\'; buffer[n++] = 't'; }
+                    else if ((unsigned char)c < 0x20) {
+                        static const char hex[] = "0123456789ABCDEF";
+                        memcpy(buffer + n, "\\u00", 4);
+                        buffer[n + 4] = hex[(unsigned char)c >> 4];
+                        buffer[n + 5] = hex[c & 0x0F];
+                        n += 6;
+                    } else {
+                        buffer[n++] = (uint8_t)c;
+                    }
+                }
+                if (stream->phase == 2) {
+                    size_t chunk = stream->suffixLen - stream->suffixOff;
+                    if (chunk > maxLen - n) chunk = maxLen - n;
+                    memcpy(buffer + n, stream->suffix + stream->suffixOff, chunk);
+                    stream->suffixOff += (uint8_t)chunk;
+                    n += chunk;
+                    if (stream->suffixOff >= stream->suffixLen) stream->phase = 3;
+                }
+                // 0 ends the response, so only return it once the suffix is out
+                if (n == 0 && stream->phase != 3) return RESPONSE_TRY_AGAIN;
+                return n;
+            });
         response->addHeader("Cache-Control", "no-store, no-cache, must-revalidate, max-age=0");
         response->addHeader("Pragma", "no-cache");
         response->addHeader("Expires", "0");
-        response->print("{\"log\":\"");
-        for (size_t i = 0; i < (size_t)logOutput.length(); i++) {
-            char c = logOutput.charAt(i);
-            if      (c == '"')  response->print("\\\"");
-            else if (c == '\\') response->print("\\\\");
-            else if (c == '\n') response->print("\\n");
-            else if (c == '\r') response->print("\\r");
-            else if (c == '\t') response->print("\\t");
-            else if ((unsigned char)c < 0x20) {
-                char esc[7];
-                snprintf(esc, sizeof(esc), "\\u%04X", (unsigned char)c);
-                response->print(esc);
-            } else {
-                response->write((const uint8_t*)&c, 1);
-            }
-        }
-        response->print("\"}");
         request->send(response);
     });
     
-    // Debug plain text endpoint (simpler, easier to debug)
+    // Debug plain text endpoint (simpler, easier to debug). Streamed from the
+    // ring one chunk at a time, so it never needs a 64KB copy of the log.
     server.on("/api/debug/plain", HTTP_GET, [](AsyncWebServerRequest *request) {
-        String logOutput = getDebugLog();
-        AsyncWebServerResponse *response = request->beginResponse(200, "text/plain", logOutput);
+        std::shared_ptr<DebugLogCursor> cursor = std::make_shared<DebugLogCursor>();
+        debugLogCursorBegin(*cursor, DEBUG_BUFFER_SIZE);
+        AsyncWebServerResponse *response = request->beginChunkedResponse("text/plain",
+            [cursor](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+                return debugLogRead(*cursor, (char*)buffer, maxLen);
+            });
         response->addHeader("Cache-Control", "no-store, no-cache, must-revalidate, max-age=0");
         response->addHeader("Pragma", "no-cache");
         response->addHeader("Expires", "0");
         request->send(response);
     });
     
+    // Previous boot's reset reason and last-events trace (see PostMortem.h)
+    server.on("/api/postmortem", HTTP_GET, [](AsyncWebServerRequest *request) {
+        AsyncResponseStream *response = request->beginResponseStream("application/json");
+        response->addHeader("Cache-Control", "no-store, no-cache, must-revalidate, max-age=0");
+        postMortemWriteJson(*response);
+        request->send(response);
+    });
+
+    // NVS write counters and flash wear estimate (see NvsWear.h)
+    server.on("/api/metrics", HTTP_GET, [](AsyncWebServerRequest *request) {
+        AsyncResponseStream *response = request->beginResponseStream("application/json");
+        response->addHeader("Cache-Control", "no-store, no-cache, must-revalidate, max-age=0");
+        response->print("{\"nvs\":");
+        nvsWearWriteJson(*response);
+        response->print("}");
+        request->send(response);
+    });
+
+    // Runtime log levels per subsystem tag (levels above a tag's build-time
+    // ceiling are accepted but have no effect until the firmware is rebuilt)
+    server.on("/api/debug/levels", HTTP_GET, [](AsyncWebServerRequest *request) {
+        StaticJsonDocument<1024> doc;
+        JsonArray tags = doc.createNestedArray("tags");
+        for (int i = 0; i < LOG_TAG_COUNT; i++) {
+            JsonObject entry = tags.createNestedObject();
+            entry["tag"] = logTagName((LogTag)i);
+            entry["level"] = logLevelName(logRuntimeLevels[i]);
+            entry["max"] = logLevelName(logTagMaxLevel((LogTag)i));
+        }
+        String json;
+        serializeJson(doc, json);
+        AsyncWebServerResponse *response = request->beginResponse(200, "application/json", json);
+        response->addHeader("Cache-Control", "no-store, no-cache, must-revalidate, max-age=0");
+        request->send(response);
+    });
+
+    // POST tag=<TAG|all>&level=<none|error|warn|info|debug|trace>
+    server.on("/api/debug/levels", HTTP_POST, [](AsyncWebServerRequest *request) {
+        if (!request->hasParam("tag", true) || !request->hasParam("level", true)) {
+            request->send(400, "text/plain", "tag and level required");
+            return;
+        }
+        String tagName = request->getParam("tag", true)->value();
+        int level = logLevelFromName(request->getParam("level", true)->value().c_str());
+        if (level < 0) {
+            request->send(400, "text/plain", "Unknown level");
+            return;
+        }
+        if (tagName.equalsIgnoreCase("all")) {
+            setAllLogLevels((uint8_t)level);
+        } else {
+            int tag = logTagFromName(tagName.c_str());
+            if (tag < 0) {
+                request->send(400, "text/plain", "Unknown tag");
+                return;
+            }
+            setLogLevel((LogTag)tag, (uint8_t)level);
+        }
+        debugLog("[SYSTEM] Log level %s -> %s\n", tagName.c_str(), logLevelName((uint8_t)level));
+        request->send(200, "text/plain", "OK");
+    });
+
     // Debug HTML page
     server.on("/debug", HTTP_GET, [](AsyncWebServerRequest *request) {
         String html = "<!DOCTYPE html><html><head>";
@@ -5462,6 +5129,8 @@ void handleWebRequests()
         html += "button { padding: 8px 16px; background: #0099ff; color: #000; border: none; cursor: pointer; border-radius: 4px; margin-right: 10px; }";
         html += "button:hover { background: #00cc00; }";
         html += ".refresh-rate { margin-left: 20px; }";
+        html += "#levels { display: flex; flex-wrap: wrap; gap: 6px 14px; margin: 10px 0; font-size: 12px; }";
+        html += "#levels select { background: #000; color: #00ff00; border: 1px solid #333; }";
         html += "</style></head><body>";
         html += "<div class=\"container\"><h1>Debug Console</h1>";
         html += "<div class=\"controls\">";
@@ -5469,6 +5138,7 @@ void handleWebRequests()
         html += "<button onclick=\"toggleAutoRefresh()\">Auto Refresh: ON</button>";
         html += "<span class=\"refresh-rate\">Refresh every <input type=\"number\" id=\"refreshInterval\" value=\"1\" min=\"0.5\" max=\"10\" step=\"0.5\" style=\"width: 50px;\"> sec</span>";
         html += "</div>";
+        html += "<div id=\"levels\"></div>";
         html += "<pre id=\"log\">Waiting for data...</pre></div>";
         html += "<script>";
         html += "let autoRefresh = true;";
@@ -5478,46 +5148,45 @@ void handleWebRequests()
         html += "  event.target.textContent = 'Auto Refresh: ' + (autoRefresh ? 'ON' : 'OFF');";
         html += "  if (autoRefresh) startAutoRefresh();";
         html += "}";
-        html += "function normalizeLogPayload(text) {";
-        html += "  if (!text) return '';";
-        html += "  const trimmed = text.trim();";
-        html += "  if (trimmed.startsWith('{') && trimmed.endsWith('}')) {";
-        html += "    try {";
-        html += "      const parsed = JSON.parse(trimmed);";
-        html += "      if (parsed && typeof parsed.log === 'string') return parsed.log;";
-        html += "    } catch (e) {}";
-        html += "  }";
-        html += "  if (trimmed.startsWith('\\\"') && trimmed.endsWith('\\\"')) {";
-        html += "    try { return JSON.parse(trimmed); } catch (e) {}";
-        html += "  }";
-        html += "  if (text.indexOf('\\\\n') !== -1 || text.indexOf('\\\\r') !== -1 || text.indexOf('\\\\t') !== -1) {";
-        html += "    return text.replace(/\\\\r\\\\n/g, '\\n').replace(/\\\\n/g, '\\n').replace(/\\\\r/g, '\\r').replace(/\\\\t/g, '\\t');";
-        html += "  }";
-        html += "  return text;";
-        html += "}";
+        html += "let logCursor = null;";
+        html += "let logText = '';";
+        html += "let logBusy = false;";
+        html += "const LOG_KEEP_CHARS = 65536;";
         html += "function refreshLog() {";
-        html += "  fetch('/api/debug/plain?ts=' + Date.now(), { cache: 'no-store' })";
+        html += "  if (logBusy) return;";
+        html += "  logBusy = true;";
+        html += "  const since = logCursor === null ? 0 : logCursor;";
+        html += "  fetch('/api/debug?since=' + since + '&ts=' + Date.now(), { cache: 'no-store' })";
         html += "    .then(r => {";
         html += "      if (!r.ok) throw new Error('HTTP ' + r.status);";
-        html += "      return r.text();";
+        html += "      return r.json();";
         html += "    })";
-        html += "    .then(text => {";
+        html += "    .then(data => {";
         html += "      const logDiv = document.getElementById('log');";
-        html += "      const normalized = normalizeLogPayload(text);";
-        html += "      if (!normalized || normalized.length === 0) {";
+        html += "      const atBottom = logDiv.scrollTop + logDiv.clientHeight >= logDiv.scrollHeight - 20;";
+        html += "      if (logCursor !== null && data.overwritten) logText += '[... older entries were overwritten before they could be fetched ...]\\n';";
+        html += "      logText += data.log;";
+        html += "      if (logText.length > LOG_KEEP_CHARS) {";
+        html += "        const cut = logText.indexOf('\\n', logText.length - LOG_KEEP_CHARS);";
+        html += "        logText = logText.substring(cut >= 0 ? cut + 1 : logText.length - LOG_KEEP_CHARS);";
+        html += "      }";
+        html += "      if (logText.length === 0 && logCursor === null) {";
         html += "        logDiv.textContent = '[WAITING] No debug output yet. System just started?';";
-        html += "      } else {";
-        html += "        logDiv.textContent = normalized;";
+        html += "      } else if (logText.length > 0 && (data.log.length > 0 || logCursor === null)) {";
+        html += "        logDiv.textContent = logText;";
         html += "      }";
-        html += "      logDiv.scrollTop = logDiv.scrollHeight;";
+        html += "      logCursor = data.next;";
+        html += "      if (atBottom) logDiv.scrollTop = logDiv.scrollHeight;";
         html += "    })";
         html += "    .catch(err => {";
         html += "      document.getElementById('log').textContent = '[ERROR] Failed to fetch: ' + err.message;";
         html += "      console.error('Debug fetch error:', err);";
-        html += "    });";
+        html += "    })";
+        html += "    .finally(() => { logBusy = false; });";
         html += "}";
         html += "function clearLog() {";
         html += "  if (confirm('Clear debug log?')) {";
+        html += "    logText = '';";
         html += "    document.getElementById('log').textContent = 'Log cleared.';";
         html += "  }";
         html += "}";
@@ -5530,6 +5199,31 @@ void handleWebRequests()
         html += "document.getElementById('refreshInterval').addEventListener('change', () => {";
         html += "  refreshInterval = document.getElementById('refreshInterval').value * 1000;";
         html += "});";
+        html += "const LEVELS = ['none', 'error', 'warn', 'info', 'debug', 'trace'];";
+        html += "function loadLevels() {";
+        html += "  fetch('/api/debug/levels', { cache: 'no-store' }).then(r => r.json()).then(data => {";
+        html += "    const box = document.getElementById('levels');";
+        html += "    box.innerHTML = '';";
+        html += "    data.tags.forEach(t => {";
+        html += "      const label = document.createElement('label');";
+        html += "      label.textContent = t.tag + ' ';";
+        html += "      const sel = document.createElement('select');";
+        html += "      const max = LEVELS.indexOf(t.max);";
+        html += "      LEVELS.forEach((name, i) => {";
+        html += "        const opt = new Option(name + (i > max ? ' (not built)' : ''), name, false, name === t.level);";
+        html += "        sel.add(opt);";
+        html += "      });";
+        html += "      sel.onchange = () => setLevel(t.tag, sel.value);";
+        html += "      label.appendChild(sel);";
+        html += "      box.appendChild(label);";
+        html += "    });";
+        html += "  }).catch(err => console.error('Level fetch error:', err));";
+        html += "}";
+        html += "function setLevel(tag, level) {";
+        html += "  const body = new URLSearchParams({ tag: tag, level: level });";
+        html += "  fetch('/api/debug/levels', { method: 'POST', body: body }).then(loadLevels);";
+        html += "}";
+        html += "loadLevels();";
         html += "refreshLog();";
         html += "startAutoRefresh();";
         html += "</script>";
@@ -5577,16 +5271,16 @@ void updateDisplay(float currentTemp, float currentHumidity)
     }
     
     unsigned long displayStart = millis();
-    debugLog("[DEBUG] updateDisplay start at %lu\n", displayStart);
+    LOG_TRACE(DISPLAY, "updateDisplay start at %lu\n", displayStart);
     
     // Get current time - skip if no WiFi to avoid 5-second delay
     unsigned long beforeTime = millis();
-    debugLog("[DEBUG] About to call getLocalTime\n");
+    LOG_TRACE(DISPLAY, "About to call getLocalTime\n");
     struct tm timeinfo;
     if (WiFi.status() == WL_CONNECTED && getLocalTime(&timeinfo))
     {
         unsigned long afterTime = millis();
-        debugLog("[DEBUG] getLocalTime took %lu ms\n", afterTime - beforeTime);
+        LOG_TRACE(DISPLAY, "getLocalTime took %lu ms\n", afterTime - beforeTime);
         // Build formatted time string: "10:40 Mon Dec 1 2025"
         char timePart[8];
         if (use24HourClock) {
@@ -5628,10 +5322,10 @@ void updateDisplay(float currentTemp, float currentHumidity)
         }
         
         unsigned long afterTimeOps = millis();
-        debugLog("[DEBUG] Time operations took %lu ms\n", afterTimeOps - beforeTime);
+        LOG_TRACE(DISPLAY, "Time operations took %lu ms\n", afterTimeOps - beforeTime);
     } else {
         unsigned long afterFailedTime = millis();
-        debugLog("[DEBUG] getLocalTime failed, took %lu ms\n", afterFailedTime - beforeTime);
+        LOG_WARN(DISPLAY, "getLocalTime failed, took %lu ms\n", afterFailedTime - beforeTime);
     }
     
     // Display weather if enabled and data is valid
@@ -5641,22 +5335,22 @@ void updateDisplay(float currentTemp, float currentHumidity)
     }
     if (weatherSource != 0 && weather.isDataValid()) {
         if (!lastWeatherDisplayState) {
-            debugLog("WEATHER DISPLAY: Showing weather on TFT\n");
+            LOG_TRACE(WEATHER, "Display: Showing weather on TFT\n");
             WeatherData data = weather.getData();
-            debugLog("  Temp: %.1f, Condition: %s\n", data.temperature, data.condition.c_str());
+            LOG_TRACE(WEATHER, "  Temp: %.1f, Condition: %s\n", data.temperature, data.condition.c_str());
             lastWeatherDisplayState = true;
         }
         weather.displayOnTFT(tft, 5, 25, useFahrenheit);
     } else if (weatherSource != 0) {
         if (lastWeatherDisplayState) {
-            debugLog("WEATHER DISPLAY: Clearing (source=%d, valid=%d)\n", 
+            LOG_INFO(WEATHER, "Display: Clearing (source=%d, valid=%d)\n", 
                          weatherSource, weather.isDataValid());
             lastWeatherDisplayState = false;
         }
         // Clear weather area if weather is enabled but data invalid
         tft.fillRect(5, 25, 110, 40, COLOR_BACKGROUND);
     } else if (lastWeatherDisplayState) {
-        debugLog("WEATHER DISPLAY: Weather disabled, clearing display\n");
+        LOG_INFO(WEATHER, "Display: Weather disabled, clearing display\n");
         tft.fillRect(5, 25, 110, 40, COLOR_BACKGROUND);
         lastWeatherDisplayState = false;
     }
@@ -6035,299 +5729,283 @@ void updateDisplay(float currentTemp, float currentHumidity)
     drawButtons();
 }
 
-void saveSettings()
+// Shared by saveSettings() (under nvsSaveMutex) and loadSettings() (setup)
+static ConfigData configData;
+
+// Every persisted setting (SettingsRegistry.h). Bounds are what /set and
+// MQTT accept, in form units; 1, 0 means any value.
+constexpr SettingDesc SETTINGS[] = {
+    SETTING_FLOAT(setTempHeat, "setTempHeat", "setHeat", 72.0f, 50, 95, SETTING_GROUP_MAIN, SETTING_SETPOINT),
+    SETTING_FLOAT(setTempCool, "setTempCool", "setCool", 76.0f, 50, 95, SETTING_GROUP_MAIN, SETTING_SETPOINT),
+    SETTING_FLOAT(setTempAuto, "setTempAuto", "setAuto", 74.0f, 50, 95, SETTING_GROUP_MAIN, SETTING_SETPOINT),
+    SETTING_FLOAT(tempSwing, "tempSwing", "swing", 1.0f, 1, 0, SETTING_GROUP_MAIN, 0),
+    SETTING_FLOAT(autoTempSwing, "autoTempSwing", "autoSwing", 1.5f, 1, 0, SETTING_GROUP_MAIN, 0),
+    SETTING_STRING(thermostatMode, "thermostatMode", "thermoMd", "off", "off|heat|cool|auto", SETTING_GROUP_MAIN, 0),
+    SETTING_STRING(fanMode, "fanMode", "fanMd", "auto", "auto|on|cycle", SETTING_GROUP_MAIN, 0),
+    SETTING_BOOL(fanRelayNeeded, "fanRelayNeeded", "fanRelay", false, SETTING_GROUP_MAIN, SETTING_CHECKBOX),
+    SETTING_INT(fanMinutesPerHour, "fanMinutesPerHour", "fanMinHr", 15, 0, 60, SETTING_GROUP_MAIN, 0),
+    SETTING_BOOL(useFahrenheit, "useFahrenheit", "useF", true, SETTING_GROUP_MAIN, SETTING_CHECKBOX),
+    SETTING_BOOL(use24HourClock, "use24HourClock", "use24Clk", true, SETTING_GROUP_MAIN, SETTING_CHECKBOX),
+    SETTING_STRING(timeZone, "timeZone", "tz", "CST6CDT,M3.2.0,M11.1.0", NULL, SETTING_GROUP_MAIN, 0),
+    SETTING_STRING(hostname, "hostname", "host", DEFAULT_HOSTNAME, NULL, SETTING_GROUP_MAIN, 0),
+    SETTING_STRING(wifiSSID, "wifiSSID", "wifiSSID", "", NULL, SETTING_GROUP_MAIN, 0),
+    SETTING_STRING(wifiPassword, "wifiPassword", "wifiPassword", "", NULL, SETTING_GROUP_MAIN,
+                   SETTING_KEEP_IF_EMPTY | SETTING_SECRET),
+
+    SETTING_ULONG(stage1MinRuntime, "stage1MinRuntime", "stg1MnRun", 300, 1, 0, 1, SETTING_GROUP_MAIN, 0),
+    SETTING_FLOAT(stage2TempDelta, "stage2TempDelta", "stg2Delta", 2.0f, 1, 0, SETTING_GROUP_MAIN, 0),
+    SETTING_BOOL(stage2HeatingEnabled, "stage2HeatingEnabled", "stg2HeatEn", false, SETTING_GROUP_MAIN, SETTING_CHECKBOX),
+    SETTING_BOOL(stage2CoolingEnabled, "stage2CoolingEnabled", "stg2CoolEn", false, SETTING_GROUP_MAIN, SETTING_CHECKBOX),
+    SETTING_BOOL(reversingValveEnabled, "reversingValveEnabled", "revValve", false, SETTING_GROUP_MAIN, SETTING_CHECKBOX),
+    SETTING_BOOL(backupHeatEnabled, "backupHeatEnabled", "bkHeatEn", false, SETTING_GROUP_MAIN, SETTING_CHECKBOX),
+    SETTING_INT(backupHeatRelaySelection, "backupHeatRelay", "bkHeatRl", 0, 0, 2, SETTING_GROUP_MAIN, 0),
+    SETTING_INT(backupHeatDelayMinutes, "backupHeatDelayMinutes", "bkHeatDly", 30, 5, 180, SETTING_GROUP_MAIN, 0),
+    SETTING_FLOAT(backupHeatMinTempRise, "backupHeatMinTempRise", "bkHeatRise", 0.5f, 0.1f, 5, SETTING_GROUP_MAIN, 0),
+    SETTING_FLOAT(backupHeatMaxTempDrop, "backupHeatMaxTempDrop", "bkHeatDrop", 1.5f, 0.1f, 10, SETTING_GROUP_MAIN, 0),
+    SETTING_STRING(thermostatRegion, "thermostatRegion", "thermoRgn", "US", "US|EU", SETTING_GROUP_MAIN, 0),
+    SETTING_BOOL(euHumidityControlEnabled, "euHumidityControlEnabled", "euHumCtrlEn", false, SETTING_GROUP_MAIN,
+                 SETTING_CHECKBOX),
+    SETTING_INT(euHumidityRelaySelection, "euHumidityRelay", "euHumRl", 0, 0, 2, SETTING_GROUP_MAIN, 0),
+    SETTING_FLOAT(euHumiditySetpoint, "euHumiditySetpoint", "euHumSet", 60.0f, 30, 90, SETTING_GROUP_MAIN, 0),
+    SETTING_FLOAT(euHumidityDeadband, "euHumidityDeadband", "euHumDb", 5.0f, 1, 20, SETTING_GROUP_MAIN, 0),
+    SETTING_BOOL(hydronicHeatingEnabled, "hydronicHeatingEnabled", "hydHeat", false, SETTING_GROUP_MAIN, SETTING_CHECKBOX),
+    SETTING_FLOAT(hydronicTempLow, "hydronicTempLow", "hydLow", 110.0f, 1, 0, SETTING_GROUP_MAIN, 0),
+    SETTING_FLOAT(hydronicTempHigh, "hydronicTempHigh", "hydHigh", 130.0f, 1, 0, SETTING_GROUP_MAIN, 0),
+    SETTING_BOOL(hydronicLowTempAlertSent, "hydronicLowTempAlertSent", "hydAlertSent", false, SETTING_GROUP_NONE, 0),
+    SETTING_BOOL(showerModeEnabled, "showerModeEnabled", "showerEn", false, SETTING_GROUP_MAIN, SETTING_CHECKBOX),
+    SETTING_INT(showerModeDuration, "showerModeDuration", "showerDur", 30, 5, 120, SETTING_GROUP_MAIN, 0),
+
+    SETTING_BOOL(mqttEnabled, "mqttEnabled", "mqttEn", false, SETTING_GROUP_MAIN, SETTING_CHECKBOX),
+    SETTING_STRING(mqttServer, "mqttServer", "mqttSrv", "0.0.0.0", NULL, SETTING_GROUP_MAIN, 0),
+    SETTING_INT(mqttPort, "mqttPort", "mqttPrt", 1883, 1, 65535, SETTING_GROUP_MAIN, 0),
+    SETTING_STRING(mqttUsername, "mqttUsername", "mqttUsr", "mqtt", NULL, SETTING_GROUP_MAIN, 0),
+    SETTING_STRING(mqttPassword, "mqttPassword", "mqttPwd", "password", NULL, SETTING_GROUP_MAIN, SETTING_SECRET),
+    SETTING_BOOL(mqttDeviceDiscovery, "mqttDeviceDiscovery", "mqttDevDisc", false, SETTING_GROUP_MAIN, SETTING_CHECKBOX),
+    SETTING_BOOL(mqttStateJson, "mqttStateJson", "mqttStateJs", false, SETTING_GROUP_MAIN, SETTING_CHECKBOX),
+    SETTING_FLOAT(mqttTempDeadband, "mqttTempDeadband", "mqttTempDb", 0.2f, 0, 5, SETTING_GROUP_MAIN, 0),
+    SETTING_FLOAT(mqttHumidityDeadband, "mqttHumidityDeadband", "mqttHumDb", 1.0f, 0, 10, SETTING_GROUP_MAIN, 0),
+    SETTING_INT(mqttStateHeartbeatMin, "mqttStateHeartbeat", "mqttStateHb", 5, 0, 1440, SETTING_GROUP_MAIN, 0),
+    SETTING_BOOL(mqttHistoryFlash, "mqttHistoryFlash", "mqttHistFl", false, SETTING_GROUP_MAIN, SETTING_CHECKBOX),
+    SETTING_BOOL(mqttTls, "mqttTls", "mqttTls", false, SETTING_GROUP_MAIN, SETTING_CHECKBOX),
+    // Own NVS key, not in the blob: up to a few KB and changed about never.
+    // saveSettings() writes it through settingsPutString(), which skips it
+    // when unchanged.
+    SETTING_STRING_KEY(mqttCaCert, "mqttCaCert", "", SETTING_GROUP_MAIN, SETTING_TRIM),
+
+    SETTING_FLOAT(tempOffset, "tempOffset", "tempOffset", -4.0f, -10, 10, SETTING_GROUP_DISPLAY, 0),
+    SETTING_FLOAT(humidityOffset, "humidityOffset", "humOffset", 0.0f, -50, 50, SETTING_GROUP_DISPLAY, 0),
+    SETTING_BOOL(displaySleepEnabled, "displaySleepEnabled", "dispSleepEn", false, SETTING_GROUP_DISPLAY, SETTING_CHECKBOX),
+    SETTING_ULONG(displaySleepTimeout, "displaySleepTimeout", "dispTimeout", 300000, 1, 60, 60000, SETTING_GROUP_DISPLAY, 0),
+    SETTING_INT(currentBrightness, "currentBrightness", "brightness", 130, 30, 255, SETTING_GROUP_DISPLAY, 0),
+    SETTING_BOOL(ldrDimmingEnabled, "ldrDimmingEnabled", "ldrDimEn", false, SETTING_GROUP_DISPLAY, SETTING_CHECKBOX),
+
+    SETTING_INT(weatherSource, "weatherSource", "weatherSrc", 0, 0, 2, SETTING_GROUP_WEATHER, 0),
+    SETTING_STRING(owmApiKey, "owmApiKey", "owmApiKey", "", NULL, SETTING_GROUP_WEATHER, SETTING_SECRET),
+    SETTING_STRING(owmCity, "owmCity", "owmCity", "", NULL, SETTING_GROUP_WEATHER, 0),
+    SETTING_STRING(owmState, "owmState", "owmState", "", NULL, SETTING_GROUP_WEATHER, 0),
+    SETTING_STRING(owmCountry, "owmCountry", "owmCountry", "", NULL, SETTING_GROUP_WEATHER, 0),
+    SETTING_STRING(haUrl, "haUrl", "haUrl", "", NULL, SETTING_GROUP_WEATHER, 0),
+    SETTING_STRING(haToken, "haToken", "haToken", "", NULL, SETTING_GROUP_WEATHER, SETTING_SECRET),
+    SETTING_STRING(haEntityId, "haEntityId", "haEntityId", "", NULL, SETTING_GROUP_WEATHER, 0),
+    SETTING_INT(weatherUpdateInterval, "weatherUpdateInterval", "weatherInt", 10, 5, 60, SETTING_GROUP_WEATHER, 0),
+
+    SETTING_BOOL(scheduleEnabled, "scheduleEnabled", "schedEnabled", false, SETTING_GROUP_NONE, SETTING_KEEP_ON_RESET),
+    SETTING_BOOL(scheduleOverride, "scheduleOverride", "schedOverride", false, SETTING_GROUP_NONE, SETTING_KEEP_ON_RESET),
+    SETTING_ULONG(overrideEndTime, "overrideEndTime", "overrideEnd", 0, 1, 0, 1, SETTING_GROUP_NONE, SETTING_KEEP_ON_RESET),
+    SETTING_STRING(activePeriod, "activePeriod", "activePeriod", "manual", NULL, SETTING_GROUP_NONE, SETTING_KEEP_ON_RESET),
+};
+constexpr size_t SETTINGS_COUNT = sizeof(SETTINGS) / sizeof(SETTINGS[0]);
+
+static_assert(SETTINGS_COUNT <= SETTINGS_MAX, "raise SETTINGS_MAX");
+static_assert(settingsNamesUnique(SETTINGS, SETTINGS_COUNT), "two SETTINGS entries share a name");
+// The entries plus the schedule must cover ConfigData up to its last field
+static_assert(settingsBlobBytes(SETTINGS, SETTINGS_COUNT) + sizeof(ConfigData::schedule) ==
+              offsetof(ConfigData, haEntityId) + sizeof(ConfigData::haEntityId),
+              "a ConfigData field has no SETTINGS entry");
+
+static void packPeriod(ConfigPeriod& dst, const SchedulePeriod& src)
+{
+    dst.heatTemp = src.heatTemp;
+    dst.coolTemp = src.coolTemp;
+    dst.autoTemp = src.autoTemp;
+    dst.hour = src.hour;
+    dst.minute = src.minute;
+    dst.active = src.active;
+}
+
+static void unpackPeriod(SchedulePeriod& dst, const ConfigPeriod& src)
+{
+    dst.heatTemp = src.heatTemp;
+    dst.coolTemp = src.coolTemp;
+    dst.autoTemp = src.autoTemp;
+    dst.hour = src.hour;
+    dst.minute = src.minute;
+    dst.active = src.active;
+}
+
+static void packConfig(ConfigData& c)
+{
+    // Padding and reserved bytes must be zero: the CRC covers them
+    memset(&c, 0, sizeof(c));
+    settingsPack(c);
+    for (int day = 0; day < 7; day++) {
+        packPeriod(c.schedule[day].day, weekSchedule[day].day);
+        packPeriod(c.schedule[day].night, weekSchedule[day].night);
+        c.schedule[day].enabled = weekSchedule[day].enabled;
+    }
+}
+
+static void unpackConfig(const ConfigData& c)
+{
+    settingsUnpack(c);
+    for (int day = 0; day < 7; day++) {
+        unpackPeriod(weekSchedule[day].day, c.schedule[day].day);
+        unpackPeriod(weekSchedule[day].night, c.schedule[day].night);
+        weekSchedule[day].enabled = c.schedule[day].enabled;
+    }
+}
+
+// Settings, schedule and Wi-Fi credentials in one write (ConfigBlob.h).
+// `writers` (NVS_WRITER_*) is who asked, for the wear accounting.
+bool saveSettings(uint8_t writers)
 {
     // Acquire mutex for atomic save operation (dual-core safety)
     if (nvsSaveMutex == NULL || xSemaphoreTake(nvsSaveMutex, pdMS_TO_TICKS(5000)) != pdTRUE) {
-        debugLog("ERROR: saveSettings() timed out waiting for NVS mutex\n");
-        return;
+        LOG_ERROR(SETTINGS, "saveSettings() timed out waiting for NVS mutex\n");
+        return false;
     }
     
-    debugLog("SETTINGS: Starting atomic save operation...\n");
     unsigned long saveStartTime = millis();
-    
-    // Save all settings to NVS
-    preferences.putFloat("setHeat", setTempHeat);
-    preferences.putFloat("setCool", setTempCool);
-    preferences.putFloat("setAuto", setTempAuto);
-    preferences.putFloat("swing", tempSwing);
-    preferences.putFloat("autoSwing", autoTempSwing);
-    preferences.putBool("fanRelay", fanRelayNeeded);
-    preferences.putBool("useF", useFahrenheit);
-    preferences.putBool("mqttEn", mqttEnabled);
-    preferences.putInt("fanMinHr", fanMinutesPerHour);
-    preferences.putString("mqttSrv", mqttServer);
-    preferences.putInt("mqttPrt", mqttPort);
-    preferences.putString("mqttUsr", mqttUsername);
-    preferences.putString("mqttPwd", mqttPassword);
-    preferences.putString("wifiSSID", wifiSSID);
-    preferences.putString("wifiPassword", wifiPassword);
-    preferences.putString("thermoMd", thermostatMode);
-    preferences.putString("fanMd", fanMode);
-    preferences.putString("tz", timeZone);
-    preferences.putBool("use24Clk", use24HourClock);
-    preferences.putBool("hydHeat", hydronicHeatingEnabled);
-    preferences.putFloat("hydLow", hydronicTempLow);
-    preferences.putFloat("hydHigh", hydronicTempHigh);
-    preferences.putBool("hydAlertSent", hydronicLowTempAlertSent);
-    preferences.putString("host", hostname);
-    preferences.putUInt("stg1MnRun", stage1MinRuntime);
-    preferences.putFloat("stg2Delta", stage2TempDelta);
-    preferences.putBool("stg2HeatEn", stage2HeatingEnabled);
-    preferences.putBool("stg2CoolEn", stage2CoolingEnabled);
-    preferences.putBool("revValve", reversingValveEnabled);
-    preferences.putBool("bkHeatEn", backupHeatEnabled);
-    preferences.putInt("bkHeatRl", backupHeatRelaySelection);
-    preferences.putInt("bkHeatDly", backupHeatDelayMinutes);
-    preferences.putFloat("bkHeatRise", backupHeatMinTempRise);
-    preferences.putFloat("bkHeatDrop", backupHeatMaxTempDrop);
-    preferences.putFloat("tempOffset", tempOffset);
-    preferences.putFloat("humOffset", humidityOffset);
-    preferences.putBool("dispSleepEn", displaySleepEnabled);
-    preferences.putULong("dispTimeout", displaySleepTimeout);
-    preferences.putInt("brightness", currentBrightness);
-    preferences.putBool("ldrDimEn", ldrDimmingEnabled);
-    
-    // Save US/EU and humidity control settings
-    preferences.putString("thermoRgn", thermostatRegion);
-    preferences.putBool("euHumCtrlEn", euHumidityControlEnabled);
-    preferences.putInt("euHumRl", euHumidityRelaySelection);
-    preferences.putFloat("euHumSet", euHumiditySetpoint);
-    preferences.putFloat("euHumDb", euHumidityDeadband);
-    
-    // Save weather settings
-    preferences.putInt("weatherSrc", weatherSource);
-    preferences.putString("owmApiKey", owmApiKey);
-    preferences.putString("owmCity", owmCity);
-    preferences.putString("owmState", owmState);
-    preferences.putString("owmCountry", owmCountry);
-    preferences.putString("haUrl", haUrl);
-    preferences.putString("haToken", haToken);
-    preferences.putString("haEntityId", haEntityId);
-    preferences.putInt("weatherInt", weatherUpdateInterval);
-    preferences.putBool("showerEn", showerModeEnabled);
-    preferences.putInt("showerDur", showerModeDuration);
-    
-    // Consolidate schedule saves into main save (atomic)
-    preferences.putBool("schedEnabled", scheduleEnabled);
-    preferences.putBool("schedOverride", scheduleOverride);
-    preferences.putULong("overrideEnd", overrideEndTime);
-    preferences.putString("activePeriod", activePeriod);
-    
-    // Save each day's schedule
-    for (int day = 0; day < 7; day++) {
-        String dayPrefix = "day" + String(day) + "_";
-        
-        preferences.putBool((dayPrefix + "enabled").c_str(), weekSchedule[day].enabled);
-        
-        // Day period
-        preferences.putInt((dayPrefix + "d_hour").c_str(), weekSchedule[day].day.hour);
-        preferences.putInt((dayPrefix + "d_min").c_str(), weekSchedule[day].day.minute);
-        preferences.putFloat((dayPrefix + "d_heat").c_str(), weekSchedule[day].day.heatTemp);
-        preferences.putFloat((dayPrefix + "d_cool").c_str(), weekSchedule[day].day.coolTemp);
-        preferences.putFloat((dayPrefix + "d_auto").c_str(), weekSchedule[day].day.autoTemp);
-        preferences.putBool((dayPrefix + "d_active").c_str(), weekSchedule[day].day.active);
-        
-        // Night period
-        preferences.putInt((dayPrefix + "n_hour").c_str(), weekSchedule[day].night.hour);
-        preferences.putInt((dayPrefix + "n_min").c_str(), weekSchedule[day].night.minute);
-        preferences.putFloat((dayPrefix + "n_heat").c_str(), weekSchedule[day].night.heatTemp);
-        preferences.putFloat((dayPrefix + "n_cool").c_str(), weekSchedule[day].night.coolTemp);
-        preferences.putFloat((dayPrefix + "n_auto").c_str(), weekSchedule[day].night.autoTemp);
-        preferences.putBool((dayPrefix + "n_active").c_str(), weekSchedule[day].night.active);
-    }
+    // Pending deferred changes go out with this save too
+    nvsWearSaveBegin(writers | settingsDirtyWriters());
+    packConfig(configData);
+    bool ok = configBlobSave(preferences, configData);
+    settingsPutString("mqttCaCert", mqttCaCert);
     
     // Clear flag since we're saving schedule here
     scheduleUpdatedFlag = false;
     
-    // Verify critical settings were saved (spot check)
-    bool verifySuccess = true;
-    float verifySetHeat = preferences.getFloat("setHeat", -999.0);
-    float verifySetCool = preferences.getFloat("setCool", -999.0);
-    bool verifySched = preferences.getBool("schedEnabled", !scheduleEnabled);
-    
-    if (verifySetHeat != setTempHeat || verifySetCool != setTempCool || verifySched != scheduleEnabled) {
-        verifySuccess = false;
-        debugLog("ERROR: Settings verification FAILED—save may not have persisted!\n");
-        debugLog("  setHeat: saved=%.1f, verify=%.1f\n", setTempHeat, verifySetHeat);
-        debugLog("  setCool: saved=%.1f, verify=%.1f\n", setTempCool, verifySetCool);
-        debugLog("  schedEnabled: saved=%d, verify=%d\n", scheduleEnabled, verifySched);
-    } else {
-        debugLog("SETTINGS: Verification SUCCESS—all critical values confirmed in NVS\n");
-    }
-    
     unsigned long saveDuration = millis() - saveStartTime;
-    debugLog("SETTINGS: Atomic save completed in %lu ms (status=%s)\n", 
-             saveDuration, verifySuccess ? "OK" : "FAILED");
+    nvsWearSaveDone(saveDuration);
+    LOG_DEBUG(SETTINGS, "Save completed in %lu ms (status=%s)\n", saveDuration, ok ? "OK" : "FAILED");
+    // Read-only: the changes live in RAM until restart; retrying won't help
+    if (ok || configBlobReadOnly()) {
+        settingsFlushDone(SETTINGS_DIRTY_SETTINGS | SETTINGS_DIRTY_SCHEDULE, saveStartTime);
+    }
     
     // Release mutex
     xSemaphoreGive(nvsSaveMutex);
+    return ok;
 }
 
-
-void loadSettings()
+// Firmware before the config blob stored one NVS key per value. Read them
+// once, save them as a blob and remove them. On a new device none exist and
+// this yields the defaults.
+static void migrateLegacySettings()
 {
-    auto getOrInitFloat = [&](const char* key, float def) -> float {
-        if (!preferences.isKey(key)) {
-            preferences.putFloat(key, def);
-            return def;
-        }
-        return preferences.getFloat(key, def);
-    };
-    auto getOrInitBool = [&](const char* key, bool def) -> bool {
-        if (!preferences.isKey(key)) {
-            preferences.putBool(key, def);
-            return def;
-        }
-        return preferences.getBool(key, def);
-    };
-    auto getOrInitInt = [&](const char* key, int def) -> int {
-        if (!preferences.isKey(key)) {
-            preferences.putInt(key, def);
-            return def;
-        }
-        return preferences.getInt(key, def);
-    };
-    auto getOrInitUInt = [&](const char* key, unsigned int def) -> unsigned int {
-        if (!preferences.isKey(key)) {
-            preferences.putUInt(key, def);
-            return def;
-        }
-        return preferences.getUInt(key, def);
-    };
-    auto getOrInitULong = [&](const char* key, unsigned long def) -> unsigned long {
-        if (!preferences.isKey(key)) {
-            preferences.putULong(key, def);
-            return def;
-        }
-        return preferences.getULong(key, def);
+    bool legacy = preferences.isKey("setHeat");
+    LOG_INFO(SETTINGS, "No config blob, %s\n", legacy ? "migrating per-key settings" : "using defaults");
+    settingsReadLegacy(preferences);
+
+    // Without day0_d_heat the schedule was never saved: keep the compiled-in one
+    static const char* const DAY_KEYS[] = { "enabled", "d_hour", "d_min", "d_heat", "d_cool", "d_auto", "d_active",
+                                            "n_hour", "n_min", "n_heat", "n_cool", "n_auto", "n_active" };
+    char key[16];
+    auto dayKey = [&](int day, const char* suffix) -> const char* {
+        snprintf(key, sizeof(key), "day%d_%s", day, suffix);
+        return key;
     };
-    auto getOrInitString = [&](const char* key, const char* def) -> String {
-        if (!preferences.isKey(key)) {
-            preferences.putString(key, def);
-            return String(def);
+    if (preferences.isKey("day0_d_heat")) {
+        for (int day = 0; day < 7; day++) {
+            DaySchedule& d = weekSchedule[day];
+            d.enabled = preferences.getBool(dayKey(day, "enabled"), true);
+            d.day.hour = preferences.getInt(dayKey(day, "d_hour"), 6);
+            d.day.minute = preferences.getInt(dayKey(day, "d_min"), 0);
+            d.day.heatTemp = preferences.getFloat(dayKey(day, "d_heat"), 72.0);
+            d.day.coolTemp = preferences.getFloat(dayKey(day, "d_cool"), 76.0);
+            d.day.autoTemp = preferences.getFloat(dayKey(day, "d_auto"), 74.0);
+            d.day.active = preferences.getBool(dayKey(day, "d_active"), true);
+            d.night.hour = preferences.getInt(dayKey(day, "n_hour"), 22);
+            d.night.minute = preferences.getInt(dayKey(day, "n_min"), 0);
+            d.night.heatTemp = preferences.getFloat(dayKey(day, "n_heat"), 68.0);
+            d.night.coolTemp = preferences.getFloat(dayKey(day, "n_cool"), 78.0);
+            d.night.autoTemp = preferences.getFloat(dayKey(day, "n_auto"), 73.0);
+            d.night.active = preferences.getBool(dayKey(day, "n_active"), true);
+        }
+    }
+
+    if (!saveSettings(NVS_WRITER_SYSTEM)) {
+        LOG_ERROR(SETTINGS, "Config blob not written, per-key settings kept\n");
+        return;
+    }
+    if (!legacy) return;
+    // The blob is written and verified: the per-key copies can go
+    size_t removed = settingsRemoveLegacy(preferences);
+    for (int day = 0; day < 7; day++) {
+        for (size_t i = 0; i < sizeof(DAY_KEYS) / sizeof(DAY_KEYS[0]); i++) {
+            if (preferences.remove(dayKey(day, DAY_KEYS[i]))) removed++;
         }
-        return preferences.getString(key, def);
-    };
+    }
+    LOG_INFO(SETTINGS, "Migrated to config blob, removed %u per-key settings\n", (unsigned)removed);
+}
 
-    setTempHeat = getOrInitFloat("setHeat", 72.0);
-    setTempCool = getOrInitFloat("setCool", 76.0);
-    setTempAuto = getOrInitFloat("setAuto", 74.0);
-    tempSwing = getOrInitFloat("swing", 1.0);
-    autoTempSwing = getOrInitFloat("autoSwing", 1.5);
-    fanRelayNeeded = getOrInitBool("fanRelay", false);
-    useFahrenheit = getOrInitBool("useF", true);
-    mqttEnabled = getOrInitBool("mqttEn", false);
-    fanMinutesPerHour = getOrInitInt("fanMinHr", 15);
-    mqttServer = getOrInitString("mqttSrv", "0.0.0.0");
-    mqttPort = getOrInitInt("mqttPrt", 1883);
-    mqttUsername = getOrInitString("mqttUsr", "mqtt");
-    mqttPassword = getOrInitString("mqttPwd", "password");
-    wifiSSID = getOrInitString("wifiSSID", "");
-    wifiPassword = getOrInitString("wifiPassword", "");
-    thermostatMode = getOrInitString("thermoMd", "off");
-    fanMode = getOrInitString("fanMd", "auto");
+void loadSettings()
+{
+    // Globals still hold their compiled-in defaults: fields an older blob
+    // doesn't have keep them
+    packConfig(configData);
+    switch (configBlobLoad(preferences, configData)) {
+    case CONFIG_BLOB_LOADED:
+        unpackConfig(configData);
+        break;
+    case CONFIG_BLOB_ABSENT:
+        migrateLegacySettings();
+        break;
+    case CONFIG_BLOB_CORRUPT:
+        // Defaults, not the per-key keys: those are older than the blob.
+        // The next save overwrites the corrupt slots.
+        break;
+    case CONFIG_BLOB_UNKNOWN_VERSION:
+        LOG_ERROR(SETTINGS, "Settings not loaded: stored config is from newer firmware, changes will not be saved\n");
+        break;
+    }
+    mqttCaCert = preferences.isKey("mqttCaCert") ? preferences.getString("mqttCaCert", "") : String("");
     
     // Initialize lastFanRunTime to skip the first fan cycle on boot
     // Set it as if the fan already ran its cycle (fanMinutesPerHour minutes ago)
     lastFanRunTime = millis() - (fanMinutesPerHour * 60UL * 1000UL);
     
-    timeZone = getOrInitString("tz", "CST6CDT,M3.2.0,M11.1.0");
-    use24HourClock = getOrInitBool("use24Clk", true);
-    hydronicHeatingEnabled = getOrInitBool("hydHeat", false);
-    hydronicTempLow = getOrInitFloat("hydLow", 110.0);
-    hydronicTempHigh = getOrInitFloat("hydHigh", 130.0);
-    hydronicLowTempAlertSent = getOrInitBool("hydAlertSent", false);
-    hostname = getOrInitString("host", DEFAULT_HOSTNAME);
-    stage1MinRuntime = getOrInitUInt("stg1MnRun", 300);
-    stage2TempDelta = getOrInitFloat("stg2Delta", 2.0);
-    stage2HeatingEnabled = getOrInitBool("stg2HeatEn", false);
-    stage2CoolingEnabled = getOrInitBool("stg2CoolEn", false);
-    reversingValveEnabled = getOrInitBool("revValve", false);
-    backupHeatEnabled = getOrInitBool("bkHeatEn", false);
-    backupHeatRelaySelection = constrain(getOrInitInt("bkHeatRl", 0), 0, 2);
-    backupHeatDelayMinutes = constrain(getOrInitInt("bkHeatDly", 30), 5, 180);
-    backupHeatMinTempRise = constrain(getOrInitFloat("bkHeatRise", 0.5f), 0.1f, 5.0f);
-    backupHeatMaxTempDrop = constrain(getOrInitFloat("bkHeatDrop", 1.5f), 0.1f, 10.0f);
+    backupHeatRelaySelection = constrain(backupHeatRelaySelection, 0, 2);
+    backupHeatDelayMinutes = constrain(backupHeatDelayMinutes, 5, 180);
+    backupHeatMinTempRise = constrain(backupHeatMinTempRise, 0.1f, 5.0f);
+    backupHeatMaxTempDrop = constrain(backupHeatMaxTempDrop, 0.1f, 10.0f);
     enforceBackupHeatRelayConflicts();
-    
-    // Load US/EU and humidity control settings
-    thermostatRegion = getOrInitString("thermoRgn", "US");
-    euHumidityControlEnabled = getOrInitBool("euHumCtrlEn", false);
-    euHumidityRelaySelection = constrain(getOrInitInt("euHumRl", 0), 0, 2);
-    euHumiditySetpoint = constrain(getOrInitFloat("euHumSet", 60.0f), 30.0f, 90.0f);
-    euHumidityDeadband = constrain(getOrInitFloat("euHumDb", 5.0f), 1.0f, 20.0f);
+    euHumidityRelaySelection = constrain(euHumidityRelaySelection, 0, 2);
+    euHumiditySetpoint = constrain(euHumiditySetpoint, 30.0f, 90.0f);
+    euHumidityDeadband = constrain(euHumidityDeadband, 1.0f, 20.0f);
     enforceEUHumidityRelayConflicts();
-    tempOffset = getOrInitFloat("tempOffset", -4.0);
-    humidityOffset = getOrInitFloat("humOffset", 0.0);
-    displaySleepEnabled = getOrInitBool("dispSleepEn", false);
-    displaySleepTimeout = getOrInitULong("dispTimeout", 300000); // Default 5 minutes
-    currentBrightness = getOrInitInt("brightness", 130);
     currentBrightness = constrain(currentBrightness, MIN_BRIGHTNESS, MAX_BRIGHTNESS);
-    ldrDimmingEnabled = getOrInitBool("ldrDimEn", false);
-    
-    // Load weather settings
-    weatherSource = getOrInitInt("weatherSrc", 0);
-    owmApiKey = getOrInitString("owmApiKey", "");
-    owmCity = getOrInitString("owmCity", "");
-    owmState = getOrInitString("owmState", "");
-    owmCountry = getOrInitString("owmCountry", "");
-    haUrl = getOrInitString("haUrl", "");
-    haToken = getOrInitString("haToken", "");
-    haEntityId = getOrInitString("haEntityId", "");
-    weatherUpdateInterval = getOrInitInt("weatherInt", 10);
-    showerModeEnabled = getOrInitBool("showerEn", false);
-    showerModeDuration = getOrInitInt("showerDur", 30);
+    
+    // If override was active before reboot, clear it since overrideEndTime is stale
+    // (millis() resets to 0 after each reboot, making the stored endTime unreliable)
+    if (scheduleOverride && overrideEndTime > 0) {
+        LOG_INFO(SCHEDULE, "Clearing stale override from previous boot\n");
+        scheduleOverride = false;
+        overrideEndTime = 0;
+    }
+    scheduleVersion++;
     
     // Debug print to confirm settings are loaded
-    debugLog("Loading settings:\n");
-    debugLog("setTempHeat: %.2f\n", setTempHeat);
-    debugLog("setTempCool: %.2f\n", setTempCool);
-    debugLog("setTempAuto: %.2f\n", setTempAuto);
-    debugLog("tempSwing: %.2f\n", tempSwing);
-    debugLog("autoTempSwing: %.2f\n", autoTempSwing);
-    debugLog("fanRelayNeeded: %d\n", fanRelayNeeded);
-    debugLog("useFahrenheit: %d\n", useFahrenheit);
-    debugLog("mqttEnabled: %d\n", mqttEnabled);
-    debugLog("fanMinutesPerHour: %d\n", fanMinutesPerHour);
-    debugLog("mqttServer: %s\n", mqttServer.c_str());
-    debugLog("mqttPort: %d\n", mqttPort);
-    debugLog("mqttUsername: %s\n", mqttUsername.c_str());
-    debugLog("mqttPassword: %s\n", mqttPassword.c_str());
-    debugLog("wifiSSID: %s\n", wifiSSID.c_str());
-    debugLog("wifiPassword: %s\n", wifiPassword.c_str());
-    debugLog("thermostatMode: %s\n", thermostatMode.c_str());
-    debugLog("fanMode: %s\n", fanMode.c_str());
-    debugLog("timeZone: %s\n", timeZone.c_str());
-    debugLog("use24HourClock: %d\n", use24HourClock);
-    debugLog("hydronicHeatingEnabled: %d\n", hydronicHeatingEnabled);
-    debugLog("hydronicTempLow: %.2f\n", hydronicTempLow);
-    debugLog("hydronicTempHigh: %.2f\n", hydronicTempHigh);
-    debugLog("hydronicLowTempAlertSent: %d\n", hydronicLowTempAlertSent);
-    debugLog("hostname: %s\n", hostname.c_str());
-    debugLog("stage1MinRuntime: %u\n", stage1MinRuntime);
-    debugLog("stage2TempDelta: %.2f\n", stage2TempDelta);
-    debugLog("stage2HeatingEnabled: %d\n", stage2HeatingEnabled);
-    debugLog("stage2CoolingEnabled: %d\n", stage2CoolingEnabled);
-    debugLog("backupHeatEnabled: %d\n", backupHeatEnabled);
-    debugLog("backupHeatRelaySelection: %d\n", backupHeatRelaySelection);
-    debugLog("backupHeatDelayMinutes: %d\n", backupHeatDelayMinutes);
-    debugLog("tempOffset: %.2f\n", tempOffset);
-    debugLog("humidityOffset: %.2f\n", humidityOffset);
-    debugLog("displaySleepEnabled: %d\n", displaySleepEnabled);
-    debugLog("displaySleepTimeout: %lu\n", displaySleepTimeout);
-    debugLog("weatherSource: %d\n", weatherSource);
-    debugLog("owmApiKey: %s\n", owmApiKey.length() > 0 ? "[SET]" : "[NOT SET]");
-    debugLog("owmCity: %s\n", owmCity.c_str());
-    debugLog("owmState: %s\n", owmState.c_str());
-    debugLog("owmCountry: %s\n", owmCountry.c_str());
-    debugLog("haUrl: %s\n", haUrl.c_str());
-    debugLog("haToken: %s\n", haToken.length() > 0 ? "[SET]" : "[NOT SET]");
-    debugLog("haEntityId: %s\n", haEntityId.c_str());
-    debugLog("weatherUpdateInterval: %d\n", weatherUpdateInterval);
+    LOG_DEBUG(SETTINGS, "Loading settings:\n");
+    settingsLog();
+
+    LOG_INFO(SCHEDULE, "Settings loaded - Enabled: %s, Override: %s, Active Period: %s\n",
+                  scheduleEnabled ? "YES" : "NO", 
+                  scheduleOverride ? "YES" : "NO",
+                  activePeriod.c_str());
 
     // Debug print to confirm settings are loaded
-    debugLog("Settings loaded.\n");
+    LOG_INFO(SETTINGS, "Settings loaded.\n");
 }
 
 float convertCtoF(float celsius)
@@ -6335,12 +6013,6 @@ float convertCtoF(float celsius)
     return celsius * 9.0 / 5.0 + 32.0;
 }
 
-void saveWiFiSettings()
-{
-    preferences.putString("wifiSSID", wifiSSID);
-    preferences.putString("wifiPassword", wifiPassword);
-}
-
 void calibrateTouchScreen()
 {
     uint16_t calData[8];
@@ -6354,11 +6026,11 @@ void calibrateTouchScreen()
         preferences.getBytes(calKey, calData, sizeof(calData));
         // LGFX touch calibration stores 4 raw touch points (x,y pairs) = 8 values.
         tft.setTouchCalibrate(calData);
-        debugLog("Touch screen calibration data loaded from Preferences key: %s\n", calKey);
-        debugLog("  P0: (%d, %d)\n", calData[0], calData[1]);
-        debugLog("  P1: (%d, %d)\n", calData[2], calData[3]);
-        debugLog("  P2: (%d, %d)\n", calData[4], calData[5]);
-        debugLog("  P3: (%d, %d)\n", calData[6], calData[7]);
+        LOG_INFO(DISPLAY, "Touch screen calibration data loaded from Preferences key: %s\n", calKey);
+        LOG_DEBUG(DISPLAY, "  P0: (%d, %d)\n", calData[0], calData[1]);
+        LOG_DEBUG(DISPLAY, "  P1: (%d, %d)\n", calData[2], calData[3]);
+        LOG_DEBUG(DISPLAY, "  P2: (%d, %d)\n", calData[4], calData[5]);
+        LOG_DEBUG(DISPLAY, "  P3: (%d, %d)\n", calData[6], calData[7]);
     }
     else
     {
@@ -6378,11 +6050,11 @@ void calibrateTouchScreen()
             calData[6] = 212;  calData[7] = 3794;
         }
         tft.setTouchCalibrate(calData);
-        debugLog("Touch screen using default calibration for key: %s (no stored data found)\n", calKey);
-        debugLog("  P0: (%d, %d)\n", calData[0], calData[1]);
-        debugLog("  P1: (%d, %d)\n", calData[2], calData[3]);
-        debugLog("  P2: (%d, %d)\n", calData[4], calData[5]);
-        debugLog("  P3: (%d, %d)\n", calData[6], calData[7]);
+        LOG_INFO(DISPLAY, "Touch screen using default calibration for key: %s (no stored data found)\n", calKey);
+        LOG_DEBUG(DISPLAY, "  P0: (%d, %d)\n", calData[0], calData[1]);
+        LOG_DEBUG(DISPLAY, "  P1: (%d, %d)\n", calData[2], calData[3]);
+        LOG_DEBUG(DISPLAY, "  P2: (%d, %d)\n", calData[4], calData[5]);
+        LOG_DEBUG(DISPLAY, "  P3: (%d, %d)\n", calData[6], calData[7]);
     }
 }
 
@@ -6405,14 +6077,24 @@ void runInteractiveCalibration()
     tft.calibrateTouch(calData, TFT_WHITE, TFT_BLACK, 15);
     
     // Save calibration data to NVS
-    preferences.putBytes(calKey, calData, sizeof(calData));
+    if (nvsSaveMutex != NULL && xSemaphoreTake(nvsSaveMutex, pdMS_TO_TICKS(5000)) == pdTRUE) {
+        unsigned long saveStartTime = millis();
+        nvsWearSaveBegin(NVS_WRITER_CALIBRATION);
+        if (preferences.putBytes(calKey, calData, sizeof(calData)) == sizeof(calData)) {
+            nvsWearRecord(calKey, NVS_TYPE_BLOB, sizeof(calData));
+        }
+        nvsWearSaveDone(millis() - saveStartTime);
+        xSemaphoreGive(nvsSaveMutex);
+    } else {
+        LOG_ERROR(DISPLAY, "Touch calibration not saved: NVS mutex timeout\n");
+    }
     tft.setTouchCalibrate(calData);
     
-    debugLog("Touch calibration completed and saved to key: %s\n", calKey);
-    debugLog("  P0: (%d, %d)\n", calData[0], calData[1]);
-    debugLog("  P1: (%d, %d)\n", calData[2], calData[3]);
-    debugLog("  P2: (%d, %d)\n", calData[4], calData[5]);
-    debugLog("  P3: (%d, %d)\n", calData[6], calData[7]);
+    LOG_INFO(DISPLAY, "Touch calibration completed and saved to key: %s\n", calKey);
+    LOG_DEBUG(DISPLAY, "  P0: (%d, %d)\n", calData[0], calData[1]);
+    LOG_DEBUG(DISPLAY, "  P1: (%d, %d)\n", calData[2], calData[3]);
+    LOG_DEBUG(DISPLAY, "  P2: (%d, %d)\n", calData[4], calData[5]);
+    LOG_DEBUG(DISPLAY, "  P3: (%d, %d)\n", calData[6], calData[7]);
     
     tft.fillScreen(TFT_BLACK);
     tft.setCursor(20, 100);
@@ -6424,7 +6106,7 @@ void runInteractiveCalibration()
 
 void clearTouchCalibration()
 {
-    debugLog("Clearing touch calibration data...\n");
+    LOG_INFO(DISPLAY, "Clearing touch calibration data...\n");
     preferences.remove("calData");
     // Show message before reboot
     tft.fillScreen(COLOR_BACKGROUND);
@@ -6434,6 +6116,8 @@ void clearTouchCalibration()
     tft.println("Calibration Cleared");
     tft.setCursor(20, 130);
     tft.println("Rebooting...");
+    postMortemRecord(PM_RESTART, PM_RESTART_TOUCH_CAL);
+    flushSettings(true);
     delay(2000);
     ESP.restart();
 }
@@ -6496,7 +6180,7 @@ void handleKeyboardTouch(uint16_t x, uint16_t y, bool isUpperCaseKeyboard)
             if (correctedX >= keyLeft && correctedX <= keyRight &&
                 y >= keyTop && y <= keyBottom)
             {
-                debugLog("Touch at (%u,%u) corrX=%d -> Key[%d,%d] KeyArea(%d,%d %dx%d)\n",
+                LOG_DEBUG(DISPLAY, "Touch at (%u,%u) corrX=%d -> Key[%d,%d] KeyArea(%d,%d %dx%d)\n",
                          x, y, correctedX, row, col, keyX, keyY, keyW, keyH);
                 
                 // Process the key press
@@ -6514,65 +6198,15 @@ void handleKeyboardTouch(uint16_t x, uint16_t y, bool isUpperCaseKeyboard)
 
 void restoreDefaultSettings()
 {
-    setTempHeat = 72.0;
-    setTempCool = 76.0;
-    setTempAuto = 74.0;
-    tempSwing = 1.0;
-    autoTempSwing = 1.5;
-    fanRelayNeeded = false;
-    useFahrenheit = true;
-    mqttEnabled = false;
-    wifiSSID = "";
-    wifiPassword = "";
-    fanMinutesPerHour = 15;
-    mqttServer = "0.0.0.0";
-    mqttUsername = "mqtt";
-    mqttPassword = "password";
-    thermostatMode = "off";
-    fanMode = "auto";
-    timeZone = "CST6CDT,M3.2.0,M11.1.0"; // Reset time zone to default
-    use24HourClock = true; // Reset clock format to default
-    hydronicHeatingEnabled = false; // Reset hydronic heating setting to default
-    hostname = DEFAULT_HOSTNAME; // Reset hostname to default
-
-    mqttPort = 1883; // Reset MQTT port default
-    hydronicTempLow = 110.0; // Reset hydronic low temp
-    hydronicTempHigh = 130.0; // Reset hydronic high temp
-    hydronicLowTempAlertSent = false; // Reset hydronic alert state
-    stage2HeatingEnabled = false; // Reset stage 2 heating enabled to default
-    stage2CoolingEnabled = false; // Reset stage 2 cooling enabled to default
-    backupHeatEnabled = false;
-    backupHeatRelaySelection = 0;
-    backupHeatDelayMinutes = 30;
-    backupHeatMinTempRise = 0.5f;
-    backupHeatMaxTempDrop = 1.5f;
-    thermostatRegion = "US";
-    euHumidityControlEnabled = false;
-    euHumidityRelaySelection = 0;
-    euHumiditySetpoint = 60.0f;
-    euHumidityDeadband = 5.0f;
+    // Everything in SETTINGS[] but the schedule state; the schedule stays too
+    settingsRestoreDefaults();
     euHumidityDemandActive = false;
-    tempOffset = -4.0; // Reset temperature calibration offset to default
-    humidityOffset = 0.0; // Reset humidity calibration offset to default
-    displaySleepEnabled = false; // Reset display sleep enabled to default
-    displaySleepTimeout = 300000; // Reset display sleep timeout to default (5 minutes)
-    currentBrightness = 130; // Reset display brightness to default
-    ldrDimmingEnabled = false; // Reset LDR dimming to default
-    
-    // Reset weather settings to defaults
-    weatherSource = 0; // Disabled
-    owmApiKey = "";
-    owmCity = "";
-    owmState = "";
-    owmCountry = "";
-    haUrl = "";
-    haToken = "";
-    haEntityId = "";
-    weatherUpdateInterval = 10; // 10 minutes
-
-    saveSettings();
+
+    configBlobAllowOverwrite();
+    saveSettings(NVS_WRITER_SYSTEM);
 
     // Reset the ESP32
+    postMortemRecord(PM_RESTART, PM_RESTART_FACTORY);
     ESP.restart();
 }
 
@@ -6650,7 +6284,7 @@ void checkDisplaySleep() {
     static unsigned long lastFilterLog = 0;
     
     if (currentTime - lastDebugTime > 30000) {
-        debugLog("[SLEEP_DEBUG] Enabled: %s, Time: %lu / Timeout: %lu, Asleep: %d\n",
+        LOG_TRACE(DISPLAY, "Enabled: %s, Time: %lu / Timeout: %lu, Asleep: %d\n",
                       displaySleepEnabled ? "YES" : "NO",
                       currentTime - lastInteractionTime, displaySleepTimeout, displayIsAsleep);
         lastDebugTime = currentTime;
@@ -6675,7 +6309,7 @@ void checkDisplaySleep() {
         if (dataAge > RADAR_DATA_MAX_AGE) {
             // Data is stale, skip this check
             if (firstMotionTime > 0) {
-                debugLog("[MOTION_WAKE] Data too old (%lums), resetting tracker\n", dataAge);
+                LOG_DEBUG(MOTION, "Data too old (%lums), resetting tracker\n", dataAge);
                 firstMotionTime = 0;
             }
             return;
@@ -6702,12 +6336,12 @@ void checkDisplaySleep() {
                 // Start or continue tracking
                 if (firstMotionTime == 0) {
                     firstMotionTime = currentTime;
-                    debugLog("[MOTION_WAKE] Started tracking: %lucm, signal %d\n", distance, signal);
+                    LOG_DEBUG(MOTION, "Started tracking: %lucm, signal %d\n", distance, signal);
                 } else {
                     // Check if sustained long enough
                     unsigned long duration = currentTime - firstMotionTime;
                     if (duration >= MOTION_WAKE_DEBOUNCE) {
-                        debugLog("[MOTION_WAKE] Sustained %lums: %lucm, signal %d - WAKING\n", 
+                        LOG_DEBUG(MOTION, "Sustained %lums: %lucm, signal %d - WAKING\n", 
                                       duration, distance, signal);
                         firstMotionTime = 0;
                         wakeDisplay();
@@ -6717,7 +6351,7 @@ void checkDisplaySleep() {
             } else {
                 // Log why motion was filtered
                 if (currentTime - lastFilterLog > 2000) {
-                    debugLog("[MOTION_WAKE] Filtered: %lucm (max %d), signal %d (range %d-%d)\n",
+                    LOG_DEBUG(MOTION, "Filtered: %lucm (max %d), signal %d (range %d-%d)\n",
                                   distance, MOTION_WAKE_MAX_DISTANCE, signal, 
                                   MOTION_WAKE_MIN_SIGNAL, MOTION_WAKE_MAX_SIGNAL);
                     lastFilterLog = currentTime;
@@ -6729,7 +6363,7 @@ void checkDisplaySleep() {
         
         // Reset if motion stopped or invalid
         if (!validMotion && firstMotionTime > 0) {
-            debugLog("[MOTION_WAKE] Motion lost - resetting tracker\n");
+            LOG_DEBUG(MOTION, "Motion lost - resetting tracker\n");
             firstMotionTime = 0;
         }
     } else {
@@ -6743,7 +6377,7 @@ void checkDisplaySleep() {
     
     // Check if display should go to sleep
     if (!displayIsAsleep && (timeSinceInteraction > displaySleepTimeout)) {
-        debugLog("[SLEEP] Display going to sleep after %lu ms\n", timeSinceInteraction);
+        LOG_INFO(DISPLAY, "Display going to sleep after %lu ms\n", timeSinceInteraction);
         sleepDisplay();
     }
 }
@@ -6753,7 +6387,7 @@ void wakeDisplay() {
         displayIsAsleep = false;
         lastWakeTime = millis();
         lastInteractionTime = millis();
-        debugLog("[DISPLAY] Woke from sleep\n");
+        LOG_INFO(DISPLAY, "Woke from sleep\n");
 
         // Restore the backlight immediately to last saved value
         setBrightness(currentBrightness);
@@ -6766,7 +6400,7 @@ void sleepDisplay() {
     if (!displayIsAsleep) {
         displayIsAsleep = true;
         lastSleepTime = millis(); // Record sleep time for motion wake cooldown
-        debugLog("[DISPLAY] Going to sleep (inactive for %lu ms)\n", millis() - lastInteractionTime);
+        LOG_INFO(DISPLAY, "Going to sleep (inactive for %lu ms)\n", millis() - lastInteractionTime);
         // Turn off backlight completely (bypass MIN_BRIGHTNESS constraint)
         ledcWrite(PWM_CHANNEL, 0);
     }
@@ -6788,14 +6422,14 @@ bool waitForLD2410Response(unsigned long timeoutMs) {
 
 // Configure LD2410 using raw UART commands (bypasses library initialization)
 bool configureLD2410ViaRawUART() {
-    debugLog("LD2410: Configuring via raw UART commands...\n");
+    LOG_INFO(MOTION, "Configuring via raw UART commands...\n");
     
     // Clear buffer
     while (Serial2.available()) Serial2.read();
     delay(100);
     
     // Enter config mode
-    debugLog("  Entering config mode...\n");
+    LOG_DEBUG(MOTION, "  Entering config mode...\n");
     uint8_t enableConfig[] = {0xFD, 0xFC, 0xFB, 0xFA, 0x04, 0x00, 
                                0xFF, 0x00, 0x01, 0x00, 
                                0x04, 0x03, 0x02, 0x01};
@@ -6803,16 +6437,16 @@ bool configureLD2410ViaRawUART() {
     delay(200);
     
     if (waitForLD2410Response(200)) {
-        debugLog("    ✓ Config mode enabled\n");
+        LOG_DEBUG(MOTION, "    ✓ Config mode enabled\n");
         // Clear the response
         while (Serial2.available()) Serial2.read();
     } else {
-        debugLog("    ✗ No config mode response\n");
+        LOG_WARN(MOTION, "✗ No config mode response\n");
         return false;
     }
     
     // Set max distance: 4 gates = 3 meters, 5 second timeout
-    debugLog("  Setting max distance (4 gates = 3m, 5s timeout)...\n");
+    LOG_DEBUG(MOTION, "  Setting max distance (4 gates = 3m, 5s timeout)...\n");
     uint8_t setMaxDist[] = {0xFD, 0xFC, 0xFB, 0xFA, 0x14, 0x00, 
                              0x60, 0x00, 0x00, 0x00, 
                              0x04, 0x00, 0x00, 0x00, // Max motion gate
@@ -6823,14 +6457,14 @@ bool configureLD2410ViaRawUART() {
     delay(200);
     
     if (waitForLD2410Response(200)) {
-        debugLog("    ✓ Max distance set\n");
+        LOG_DEBUG(MOTION, "    ✓ Max distance set\n");
         while (Serial2.available()) Serial2.read();
     } else {
-        debugLog("    ✗ No max distance response\n");
+        LOG_WARN(MOTION, "✗ No max distance response\n");
     }
     
     // Set sensitivity for each gate (reduce false positives)
-    debugLog("  Setting sensitivity per gate (Motion=30, Static=20)...\n");
+    LOG_DEBUG(MOTION, "  Setting sensitivity per gate (Motion=30, Static=20)...\n");
     for (uint8_t gate = 0; gate <= 4; gate++) {
         uint8_t setSensitivity[] = {0xFD, 0xFC, 0xFB, 0xFA, 0x14, 0x00,
                                      0x64, 0x00, 0x00, 0x00,
@@ -6842,37 +6476,37 @@ bool configureLD2410ViaRawUART() {
         delay(100);
         
         if (waitForLD2410Response(100)) {
-            debugLog("    ✓ Gate %d configured\n", gate);
+            LOG_DEBUG(MOTION, "    ✓ Gate %d configured\n", gate);
             while (Serial2.available()) Serial2.read();
         }
     }
     
     // Exit config mode
-    debugLog("  Exiting config mode...\n");
+    LOG_DEBUG(MOTION, "  Exiting config mode...\n");
     uint8_t endConfig[] = {0xFD, 0xFC, 0xFB, 0xFA, 0x02, 0x00, 
                             0xFE, 0x00, 
                             0x04, 0x03, 0x02, 0x01};
     Serial2.write(endConfig, sizeof(endConfig));
     delay(500);
     
-    debugLog("LD2410: Raw UART configuration complete\n");
+    LOG_INFO(MOTION, "Raw UART configuration complete\n");
     return true;
 }
 
 bool configureLD2410Sensitivity() {
-    debugLog("LD2410: Configuring sensor sensitivity...\n");
+    LOG_INFO(MOTION, "Configuring sensor sensitivity...\n");
     
     // Enter configuration mode
     if (!radar.configMode()) {
-        debugLog("  ✗ Failed to enter config mode\n");
+        LOG_WARN(MOTION, "✗ Failed to enter config mode\n");
         return false;
     }
     
     // Read current configuration
     radar.requestParameters();
-    debugLog("  Current configuration:\n");
-    debugLog("    Max range: %lu cm\n", radar.getRange_cm());
-    debugLog("    No-one window: %d seconds\n", radar.getNoOneWindow());
+    LOG_DEBUG(MOTION, "  Current configuration:\n");
+    LOG_DEBUG(MOTION, "    Max range: %lu cm\n", radar.getRange_cm());
+    LOG_DEBUG(MOTION, "    No-one window: %d seconds\n", radar.getNoOneWindow());
     
     // Set conservative parameters to reduce false positives:
     // - Max gate 4 (~3 meters)
@@ -6890,52 +6524,52 @@ bool configureLD2410Sensitivity() {
         stationaryThresholds.values[i] = (i <= 4) ? 20 : 10;  // Gates 0-4: 20, 5-8: 10
     }
     
-    debugLog("  Setting gate parameters...\n");
+    LOG_DEBUG(MOTION, "  Setting gate parameters...\n");
     if (!radar.setGateParameters(movingThresholds, stationaryThresholds, 5)) {
-        debugLog("  ✗ Failed to set gate parameters\n");
+        LOG_WARN(MOTION, "✗ Failed to set gate parameters\n");
         radar.configMode(false);
         return false;
     }
-    debugLog("    ✓ Gate parameters set\n");
+    LOG_DEBUG(MOTION, "    ✓ Gate parameters set\n");
     
     // Exit configuration mode
     radar.configMode(false);
     
-    debugLog("LD2410: Configuration complete\n");
+    LOG_INFO(MOTION, "Configuration complete\n");
     return true;
 }
 
 bool testLD2410Connection() {
-    debugLog("LD2410: Testing motion sensor with MyLD2410 library...\n");
-    debugLog("LD2410: UART Debug Info:\n");
-    debugLog("  RX Pin: %d, TX Pin: %d, Baud: 256000\n", LD2410_RX_PIN, LD2410_TX_PIN);
-    debugLog("  Serial2 available: %d bytes\n", Serial2.available());
+    LOG_INFO(MOTION, "Testing motion sensor with MyLD2410 library...\n");
+    LOG_DEBUG(MOTION, "UART Debug Info:\n");
+    LOG_DEBUG(MOTION, "  RX Pin: %d, TX Pin: %d, Baud: 256000\n", LD2410_RX_PIN, LD2410_TX_PIN);
+    LOG_DEBUG(MOTION, "  Serial2 available: %d bytes\n", Serial2.available());
     
     // MyLD2410 library handles continuous stream naturally via check() method
-    debugLog("  Initializing with MyLD2410 library...\n");
+    LOG_DEBUG(MOTION, "  Initializing with MyLD2410 library...\n");
     
     if (radar.begin()) {
-        debugLog("LD2410: ✓ Library initialized!\n");
+        LOG_INFO(MOTION, "✓ Library initialized!\n");
         
         // Request configuration mode to read firmware
         radar.configMode();
-        debugLog("  Firmware: %s\n", radar.getFirmware().c_str());
-        debugLog("  Protocol version: %lu\n", radar.getVersion());
+        LOG_DEBUG(MOTION, "  Firmware: %s\n", radar.getFirmware().c_str());
+        LOG_DEBUG(MOTION, "  Protocol version: %lu\n", radar.getVersion());
         radar.configMode(false);
         
         // Configure sensor to reduce false positives
         if (configureLD2410Sensitivity()) {
-            debugLog("LD2410: ✓ Sensor configured successfully\n");
+            LOG_INFO(MOTION, "✓ Sensor configured successfully\n");
         } else {
-            debugLog("LD2410: ✗ Warning - configuration may have failed\n");
+            LOG_WARN(MOTION, "✗ configuration may have failed\n");
         }
         
         return true;
     } else {
-        debugLog("LD2410: ✗ Library initialization failed\n");
+        LOG_WARN(MOTION, "✗ Library initialization failed\n");
         
         // Check digital pin as fallback
-        debugLog("  Checking digital OUT pin as fallback...\n");
+        LOG_DEBUG(MOTION, "  Checking digital OUT pin as fallback...\n");
         pinMode(LD2410_MOTION_PIN, INPUT_PULLDOWN);
         delay(100);
         
@@ -6945,10 +6579,10 @@ bool testLD2410Connection() {
             delay(10);
         }
         
-        debugLog("  Digital pin readings: %d %d %d %d %d\n", 
+        LOG_DEBUG(MOTION, "  Digital pin readings: %d %d %d %d %d\n", 
                       readings[0], readings[1], readings[2], readings[3], readings[4]);
         
-        debugLog("  WARNING: Using digital OUT pin only\n");
+        LOG_WARN(MOTION, "Using digital OUT pin only\n");
         return false;
     }
 }
@@ -7006,19 +6640,19 @@ void readMotionSensor() {
     
     if (currentPresence != lastPresenceState) {
         unsigned long now = millis();
-        debugLog("LD2410: Presence %s after %lu ms\n", 
+        LOG_INFO(MOTION, "Presence %s after %lu ms\n", 
                       currentPresence ? "DETECTED" : "CLEARED",
                       now - lastPresenceChangeTime);
         
         // Show what type of target was detected
         if (currentPresence) {
             if (radar.movingTargetDetected()) {
-                debugLog("  Moving target at %lu cm (signal: %d)\n",
+                LOG_DEBUG(MOTION, "  Moving target at %lu cm (signal: %d)\n",
                               radar.movingTargetDistance(),
                               radar.movingTargetSignal());
             }
             if (radar.stationaryTargetDetected()) {
-                debugLog("  Stationary target at %lu cm (signal: %d)\n",
+                LOG_DEBUG(MOTION, "  Stationary target at %lu cm (signal: %d)\n",
                               radar.stationaryTargetDistance(),
                               radar.stationaryTargetSignal());
             }
@@ -7033,10 +6667,10 @@ void readMotionSensor() {
                 // Apply same filters as sustained motion wake
                 if (distance > 0 && distance < MOTION_WAKE_MAX_DISTANCE && 
                     signal >= MOTION_WAKE_MIN_SIGNAL && signal <= MOTION_WAKE_MAX_SIGNAL) {
-                    debugLog("LD2410: Waking display - NEW moving target: %lucm, signal %d\n", distance, signal);
+                    LOG_INFO(MOTION, "Waking display - NEW moving target: %lucm, signal %d\n", distance, signal);
                     wakeDisplay();
                 } else {
-                    debugLog("LD2410: Filtered NEW moving target: %lucm (max %d), signal %d (range %d-%d)\n",
+                    LOG_DEBUG(MOTION, "Filtered NEW moving target: %lucm (max %d), signal %d (range %d-%d)\n",
                                   distance, MOTION_WAKE_MAX_DISTANCE, signal, 
                                   MOTION_WAKE_MIN_SIGNAL, MOTION_WAKE_MAX_SIGNAL);
                 }
@@ -7049,14 +6683,14 @@ void readMotionSensor() {
     
     if (currentPresence) {
         if (!motionDetected) {
-            debugLog("LD2410: Presence activated - starting presence timer\n");
+            LOG_DEBUG(MOTION, "Presence activated - starting presence timer\n");
         }
         motionDetected = true;
         lastMotionTime = millis();
     } else {
         // Presence cleared by sensor's internal timeout (configured in no-one window parameter)
         if (motionDetected) {
-            debugLog("LD2410: Presence timeout - clearing motion flag\n");
+            LOG_DEBUG(MOTION, "Presence timeout - clearing motion flag\n");
             motionDetected = false;
         }
     }
@@ -7065,7 +6699,7 @@ void readMotionSensor() {
     static unsigned long lastDebugTime = 0;
     if (millis() - lastDebugTime > 10000) {
         lastDebugTime = millis();
-        debugLog("LD2410: Presence=%s, Motion Flag=%s, Age=%lu ms\n",
+        LOG_DEBUG(MOTION, "Presence=%s, Motion Flag=%s, Age=%lu ms\n",
                       currentPresence ? "YES" : "NO",
                       motionDetected ? "ACTIVE" : "INACTIVE",
                       millis() - lastMotionTime);
@@ -7073,12 +6707,12 @@ void readMotionSensor() {
         // Show target details if present
         if (currentPresence) {
             if (radar.movingTargetDetected()) {
-                debugLog("  Moving: %lucm @ signal %d\n",
+                LOG_DEBUG(MOTION, "  Moving: %lucm @ signal %d\n",
                               radar.movingTargetDistance(),
                               radar.movingTargetSignal());
             }
             if (radar.stationaryTargetDetected()) {
-                debugLog("  Stationary: %lucm @ signal %d\n",
+                LOG_DEBUG(MOTION, "  Stationary: %lucm @ signal %d\n",
                               radar.stationaryTargetDistance(),
                               radar.stationaryTargetSignal());
             }
@@ -0,0 +1,213 @@
+/*
+ * MqttCommandParser.cpp - In-place parser for the schedule/set command
+ *
+ * A cursor over the payload; keys and string values are copied into small
+ * stack buffers and numbers are converted from a bounded copy of the token,
+ * because the payload is not guaranteed to be NUL-terminated.
+ */
+
+#include "MqttCommandParser.h"
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+const size_t TOKEN_MAX = 24;    // Longest key, string value or number we keep
+const int SKIP_DEPTH_MAX = 8;   // Nesting allowed inside ignored members
+
+struct Cursor {
+    const char* p;
+    const char* end;
+
+    bool atEnd() const { return p >= end; }
+    char peek() const { return p < end ? *p : '\0'; }
+
+    void skipSpace()
+    {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) p++;
+    }
+
+    bool consume(char c)
+    {
+        skipSpace();
+        if (peek() != c) return false;
+        p++;
+        return true;
+    }
+};
+
+enum ValueType { VALUE_NONE, VALUE_NUMBER, VALUE_STRING, VALUE_TRUE, VALUE_FALSE, VALUE_NULL };
+
+// Reads a string at the cursor into `out`. Longer strings are truncated
+// (they can't match anything we look for); escapes are kept as-is.
+bool readString(Cursor& c, char* out, size_t size)
+{
+    if (!c.consume('"')) return false;
+    size_t used = 0;
+    while (!c.atEnd() && *c.p != '"') {
+        if (*c.p == '\\') {
+            if (++c.p >= c.end) return false;
+        }
+        if (used + 1 < size) out[used++] = *c.p;
+        c.p++;
+    }
+    out[used] = '\0';
+    return c.consume('"');
+}
+
+bool isDigit(char ch)
+{
+    return ch >= '0' && ch <= '9';
+}
+
+// JSON number grammar only: -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+// strtod() would also take nan, inf, hex and a leading '+'.
+bool isJsonNumber(const char* s)
+{
+    if (*s == '-') s++;
+    if (*s == '0') {
+        s++;
+    } else if (isDigit(*s)) {
+        while (isDigit(*s)) s++;
+    } else {
+        return false;
+    }
+    if (*s == '.') {
+        if (!isDigit(*++s)) return false;
+        while (isDigit(*s)) s++;
+    }
+    if (*s == 'e' || *s == 'E') {
+        s++;
+        if (*s == '+' || *s == '-') s++;
+        if (!isDigit(*s)) return false;
+        while (isDigit(*s)) s++;
+    }
+    return *s == '\0';
+}
+
+// Skips the object or array at the cursor, and anything nested in it
+bool skipContainer(Cursor& c)
+{
+    int depth = 0;
+    while (!c.atEnd()) {
+        char ch = *c.p;
+        if (ch == '"') {
+            char ignored[1];
+            if (!readString(c, ignored, sizeof(ignored))) return false;
+            continue;
+        }
+        c.p++;
+        if (ch == '{' || ch == '[') {
+            if (++depth > SKIP_DEPTH_MAX) return false;
+        } else if (ch == '}' || ch == ']') {
+            if (--depth == 0) return true;
+        }
+    }
+    return false;
+}
+
+ValueType readValue(Cursor& c, char* token, size_t size)
+{
+    c.skipSpace();
+    char ch = c.peek();
+    if (ch == '"') return readString(c, token, size) ? VALUE_STRING : VALUE_NONE;
+    if (ch == '{' || ch == '[') return skipContainer(c) ? VALUE_NULL : VALUE_NONE;
+
+    // Bare token: number, true, false or null
+    size_t used = 0;
+    while (!c.atEnd() && *c.p != ',' && *c.p != '}' && *c.p != ' ' && *c.p != '\t' &&
+           *c.p != '\r' && *c.p != '\n') {
+        if (used + 1 >= size) return VALUE_NONE;
+        token[used++] = *c.p++;
+    }
+    token[used] = '\0';
+    if (used == 0) return VALUE_NONE;
+    if (strcmp(token, "true") == 0) return VALUE_TRUE;
+    if (strcmp(token, "false") == 0) return VALUE_FALSE;
+    if (strcmp(token, "null") == 0) return VALUE_NULL;
+
+    // 1e999 is valid JSON but overflows to inf
+    return isJsonNumber(token) && isfinite(strtod(token, NULL)) ? VALUE_NUMBER : VALUE_NONE;
+}
+
+// Integer members: a number outside int's range is not one
+bool toInt(const char* token, int& out)
+{
+    double v = strtod(token, NULL);
+    if (v < INT_MIN || v > INT_MAX) return false;
+    out = (int)v;
+    return true;
+}
+
+// Float members: finite as a double may still overflow a float
+bool toFloat(const char* token, float& out)
+{
+    out = strtof(token, NULL);
+    return isfinite(out);
+}
+
+} // namespace
+
+bool mqttParseScheduleUpdate(const char* json, size_t length, MqttScheduleUpdate& out)
+{
+    memset(&out, 0, sizeof(out));
+    out.day = -1;
+
+    Cursor c = {json, json + length};
+    if (!c.consume('{')) return false;
+    if (c.consume('}')) return true;
+
+    char key[TOKEN_MAX];
+    char token[TOKEN_MAX];
+    do {
+        if (!readString(c, key, sizeof(key)) || !c.consume(':')) return false;
+        ValueType type = readValue(c, token, sizeof(token));
+        if (type == VALUE_NONE) return false;
+
+        bool number = type == VALUE_NUMBER;
+        bool boolean = type == VALUE_TRUE || type == VALUE_FALSE || number;
+        bool truth = type == VALUE_TRUE || (number && strtod(token, NULL) != 0);
+
+        if (strcmp(key, "day") == 0) {
+            if (number && !toInt(token, out.day)) return false;
+        } else if (strcmp(key, "period") == 0) {
+            if (type == VALUE_STRING) {
+                strncpy(out.period, token, sizeof(out.period) - 1);
+                out.period[sizeof(out.period) - 1] = '\0';
+            }
+        } else if (strcmp(key, "hour") == 0) {
+            if (number) {
+                if (!toInt(token, out.hour)) return false;
+                out.fields |= MQTT_SCHEDULE_HOUR;
+            }
+        } else if (strcmp(key, "minute") == 0) {
+            if (number) {
+                if (!toInt(token, out.minute)) return false;
+                out.fields |= MQTT_SCHEDULE_MINUTE;
+            }
+        } else if (strcmp(key, "heat") == 0) {
+            if (number) {
+                if (!toFloat(token, out.heat)) return false;
+                out.fields |= MQTT_SCHEDULE_HEAT;
+            }
+        } else if (strcmp(key, "cool") == 0) {
+            if (number) {
+                if (!toFloat(token, out.cool)) return false;
+                out.fields |= MQTT_SCHEDULE_COOL;
+            }
+        } else if (strcmp(key, "auto") == 0) {
+            if (number) {
+                if (!toFloat(token, out.autoTemp)) return false;
+                out.fields |= MQTT_SCHEDULE_AUTO;
+            }
+        } else if (strcmp(key, "active") == 0) {
+            if (boolean) { out.active = truth; out.fields |= MQTT_SCHEDULE_ACTIVE; }
+        } else if (strcmp(key, "enabled") == 0) {
+            if (boolean) { out.enabled = truth; out.fields |= MQTT_SCHEDULE_ENABLED; }
+        }
+    } while (c.consume(','));
+
+    return c.consume('}');
+}
@@ -0,0 +1,139 @@
+/*
+ * MqttQueue.cpp - Bounded outbound MQTT publish queue
+ *
+ * A fixed ring of slots guarded by a mutex. The lock is only ever held for a
+ * scan of at most MQTT_QUEUE_DEPTH records and one payload copy; the
+ * network write happens after the record has been copied out. If taking the
+ * lock times out, the outcome is still counted, in atomics folded into the
+ * stats when they are read.
+ */
+
+#include "MqttQueue.h"
+#include <atomic>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "Log.h"
+
+static_assert(MQTT_QUEUE_DEPTH > MQTT_TOPIC_COUNT, "state topics must fit the queue with room for events");
+
+static MqttPublish slots[MQTT_QUEUE_DEPTH];
+static uint32_t head = 0;   // Oldest record
+static uint32_t count = 0;
+static SemaphoreHandle_t queueMutex = NULL;
+
+static MqttQueueStats stats;
+static uint64_t latencySumMs = 0;
+static std::atomic<uint32_t> droppedUnlocked(0);   // Lock timed out
+static std::atomic<uint32_t> publishedUnlocked(0);
+static std::atomic<uint32_t> failedUnlocked(0);
+
+void mqttQueueBegin()
+{
+    if (queueMutex == NULL) queueMutex = xSemaphoreCreateMutex();
+    if (queueMutex == NULL) {
+        LOG_ERROR(MQTT, "Failed to create publish queue mutex!\n");
+    }
+}
+
+bool mqttQueuePublish(MqttTopic topic, const char* payload, bool retained, bool coalesce)
+{
+    size_t length = strlen(payload);
+    if (length >= MQTT_QUEUE_PAYLOAD) {
+        LOG_WARN(MQTT, "Publish to topic %d dropped, payload %u bytes\n", (int)topic, (unsigned)length);
+        droppedUnlocked.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    if (queueMutex == NULL || xSemaphoreTake(queueMutex, pdMS_TO_TICKS(10)) != pdTRUE) {
+        droppedUnlocked.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    MqttPublish* slot = NULL;
+    if (coalesce) {
+        for (uint32_t i = 0; i < count; i++) {
+            MqttPublish& pending = slots[(head + i) % MQTT_QUEUE_DEPTH];
+            if (pending.topic == topic && pending.coalesce) {
+                slot = &pending;
+                stats.coalesced++;
+                break;
+            }
+        }
+    }
+    if (slot == NULL) {
+        if (count == MQTT_QUEUE_DEPTH) {
+            stats.dropped++;
+            xSemaphoreGive(queueMutex);
+            return false;
+        }
+        slot = &slots[(head + count) % MQTT_QUEUE_DEPTH];
+        slot->queuedAt = millis();
+        slot->topic = (uint8_t)topic;
+        slot->coalesce = coalesce;
+        count++;
+        stats.queued++;
+        if (count > stats.peak) stats.peak = count;
+    }
+    slot->retained = retained;
+    slot->length = (uint16_t)length;
+    memcpy(slot->payload, payload, length + 1);
+
+    xSemaphoreGive(queueMutex);
+    return true;
+}
+
+bool mqttQueuePop(MqttPublish& out)
+{
+    // On a timeout nothing is lost: the record stays queued for the next pass
+    if (queueMutex == NULL || xSemaphoreTake(queueMutex, pdMS_TO_TICKS(10)) != pdTRUE) {
+        return false;
+    }
+    bool found = count > 0;
+    if (found) {
+        const MqttPublish& slot = slots[head];
+        // Copy only the used part of the payload
+        out.queuedAt = slot.queuedAt;
+        out.topic = slot.topic;
+        out.retained = slot.retained;
+        out.coalesce = slot.coalesce;
+        out.length = slot.length;
+        memcpy(out.payload, slot.payload, slot.length + 1);
+        head = (head + 1) % MQTT_QUEUE_DEPTH;
+        count--;
+    }
+    xSemaphoreGive(queueMutex);
+    return found;
+}
+
+void mqttQueueDone(const MqttPublish& record, bool published)
+{
+    uint32_t latency = millis() - record.queuedAt;
+    if (queueMutex == NULL || xSemaphoreTake(queueMutex, pdMS_TO_TICKS(10)) != pdTRUE) {
+        (published ? publishedUnlocked : failedUnlocked).fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (published) {
+        stats.published++;
+        latencySumMs += latency;
+        if (latency > stats.latencyMaxMs) stats.latencyMaxMs = latency;
+    } else {
+        stats.failed++;
+    }
+    xSemaphoreGive(queueMutex);
+}
+
+void mqttQueueGetStats(MqttQueueStats& out)
+{
+    // loop() only; the lock is never held across network I/O, so waiting is short
+    if (queueMutex == NULL || xSemaphoreTake(queueMutex, portMAX_DELAY) != pdTRUE) {
+        memset(&out, 0, sizeof(out));
+        return;
+    }
+    out = stats;
+    out.depth = count;
+    out.latencyAvgMs = stats.published ? (uint32_t)(latencySumMs / stats.published) : 0;
+    xSemaphoreGive(queueMutex);
+    out.dropped += droppedUnlocked.load(std::memory_order_relaxed);
+    out.published += publishedUnlocked.load(std::memory_order_relaxed);
+    out.failed += failedUnlocked.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,171 @@
+/*
+ * MqttState.cpp - Consolidated <hostname>/state JSON document
+ *
+ * Keys and text values are our own tokens, so the document is written with
+ * snprintf and needs no escaping. Numbers are compared against the value in
+ * the last published document, not the previous sample, so a slow drift
+ * still goes out once it adds up to the deadband.
+ */
+
+#include "MqttState.h"
+#include <string.h>
+#include <math.h>
+#include "MqttQueue.h"
+#include "Log.h"
+
+const size_t STATE_TEXT_MAX = 16;
+
+struct StateFieldInfo {
+    const char* key;
+    uint8_t decimals;     // Numbers only
+    float deadband;       // Default
+};
+
+static const StateFieldInfo FIELD_INFO[MQTT_STATE_FIELD_COUNT] = {
+    {"temperature",          1, 0.2f},
+    {"humidity",             1, 1.0f},
+    {"pressure",             2, 0.02f},
+    {"gas_resistance",       1, 5.0f},
+    {"air_quality",          0, 5.0f},
+    {"target_temperature",   1, 0.0f},
+    {"hydronic_temperature", 1, 0.5f},
+    {"supply_temperature",   1, 0.5f},
+    {"return_temperature",   1, 0.5f},
+    {"shower_remaining",     0, 0.0f},
+    {"mode",                 0, 0.0f},
+    {"fan_mode",             0, 0.0f},
+    {"action",               0, 0.0f},
+    {"motion",               0, 0.0f},
+    {"shower_mode",          0, 0.0f},
+    {"schedule_enabled",     0, 0.0f},
+    {"active_period",        0, 0.0f},
+    {"schedule_override",    0, 0.0f}
+};
+
+struct StateField {
+    bool present;
+    bool publishedPresent;
+    float value;
+    float publishedValue;
+    char text[STATE_TEXT_MAX];
+    char publishedText[STATE_TEXT_MAX];
+    float deadband;
+    uint32_t maxAgeMs;
+    uint32_t publishedAt;
+};
+
+static StateField fields[MQTT_STATE_FIELD_COUNT];
+static bool configured = false;
+static bool forced = true;
+static char document[MQTT_QUEUE_PAYLOAD];
+
+static bool isText(int field)
+{
+    return field >= MQTT_STATE_MODE;
+}
+
+static void applyDefaults()
+{
+    if (configured) return;
+    for (int i = 0; i < MQTT_STATE_FIELD_COUNT; i++) fields[i].deadband = FIELD_INFO[i].deadband;
+    configured = true;
+}
+
+const char* mqttStateKey(MqttStateField field)
+{
+    return FIELD_INFO[field].key;
+}
+
+void mqttStateSetDeadband(MqttStateField field, float deadband)
+{
+    applyDefaults();
+    fields[field].deadband = deadband < 0 ? 0 : deadband;
+}
+
+void mqttStateSetMaxAge(MqttStateField field, uint32_t seconds)
+{
+    fields[field].maxAgeMs = seconds * 1000UL;
+}
+
+void mqttStateSetNumber(MqttStateField field, float value)
+{
+    if (isnan(value)) {
+        mqttStateRemove(field);
+        return;
+    }
+    fields[field].present = true;
+    fields[field].value = value;
+}
+
+void mqttStateSetText(MqttStateField field, const char* value)
+{
+    if (value == NULL) {
+        mqttStateRemove(field);
+        return;
+    }
+    fields[field].present = true;
+    strncpy(fields[field].text, value, STATE_TEXT_MAX - 1);
+    fields[field].text[STATE_TEXT_MAX - 1] = '\0';
+}
+
+void mqttStateRemove(MqttStateField field)
+{
+    fields[field].present = false;
+}
+
+void mqttStateInvalidate()
+{
+    forced = true;
+}
+
+static bool fieldDue(int i, uint32_t now)
+{
+    const StateField& f = fields[i];
+    if (f.present != f.publishedPresent) return true;
+    if (!f.present) return false;
+    if (f.maxAgeMs > 0 && now - f.publishedAt >= f.maxAgeMs) return true;
+    if (isText(i)) return strcmp(f.text, f.publishedText) != 0;
+    if (f.deadband <= 0) return f.value != f.publishedValue;
+    return fabsf(f.value - f.publishedValue) >= f.deadband;
+}
+
+const char* mqttStateTake()
+{
+    applyDefaults();
+    uint32_t now = millis();
+    bool due = forced;
+    for (int i = 0; i < MQTT_STATE_FIELD_COUNT && !due; i++) due = fieldDue(i, now);
+    if (!due) return NULL;
+
+    size_t used = 0;
+    document[used++] = '{';
+    for (int i = 0; i < MQTT_STATE_FIELD_COUNT; i++) {
+        const StateField& f = fields[i];
+        if (!f.present) continue;
+        int n;
+        if (isText(i)) {
+            n = snprintf(document + used, sizeof(document) - used, "%s\"%s\":\"%s\"",
+                         used > 1 ? "," : "", FIELD_INFO[i].key, f.text);
+        } else {
+            n = snprintf(document + used, sizeof(document) - used, "%s\"%s\":%.*f",
+                         used > 1 ? "," : "", FIELD_INFO[i].key, FIELD_INFO[i].decimals, f.value);
+        }
+        if (n < 0 || used + n + 2 > sizeof(document)) {
+            LOG_WARN(MQTT, "State document does not fit %u bytes\n", (unsigned)sizeof(document));
+            return NULL;
+        }
+        used += n;
+    }
+    document[used++] = '}';
+    document[used] = '\0';
+
+    for (int i = 0; i < MQTT_STATE_FIELD_COUNT; i++) {
+        StateField& f = fields[i];
+        f.publishedPresent = f.present;
+        f.publishedValue = f.value;
+        memcpy(f.publishedText, f.text, STATE_TEXT_MAX);
+        f.publishedAt = now;
+    }
+    forced = false;
+    return document;
+}
@@ -0,0 +1,402 @@
+/*
+ * MqttTlsClient.cpp - TLS transport for PubSubClient with session resumption
+ *
+ * Only the public mbedTLS API is used. Free heap is sampled in the socket
+ * callbacks, so once per handshake message. A handshake counts as resumed
+ * when the broker echoed the offered session ID, or when no certificate had
+ * to be verified (ticket resumption gets a fresh random ID). The SSL context
+ * and its record buffers exist only while connected; the config, CA and DRBG
+ * are built once.
+ */
+
+#include "MqttTlsClient.h"
+#include <string.h>
+#include <esp_heap_caps.h>
+#include <mbedtls/error.h>
+#include <mbedtls/net_sockets.h>
+#include <mbedtls/version.h>
+#include "Log.h"
+
+static void logTlsError(const char* what, int ret)
+{
+    char text[96];
+    mbedtls_strerror(ret, text, sizeof(text));
+    LOG_WARN(MQTT, "TLS: %s failed, -0x%04x %s\n", what, (unsigned)-ret, text);
+}
+
+static uint32_t freeHeap()
+{
+    return heap_caps_get_free_size(MALLOC_CAP_8BIT);
+}
+
+// The session ID is a public field before mbedTLS 3.0 and has getters from
+// 3.6; in between, resumption is only seen through the verify callback.
+static size_t sessionId(const mbedtls_ssl_session* s, const unsigned char** id)
+{
+#if MBEDTLS_VERSION_NUMBER >= 0x03060000
+    *id = mbedtls_ssl_session_get_id(s);
+    return mbedtls_ssl_session_get_id_len(s);
+#elif MBEDTLS_VERSION_NUMBER < 0x03000000
+    *id = s->id;
+    return s->id_len;
+#else
+    *id = NULL;
+    return 0;
+#endif
+}
+
+int MqttTlsClient::tlsSend(void* ctx, const unsigned char* buf, size_t len)
+{
+    MqttTlsClient* self = (MqttTlsClient*)ctx;
+    self->sampleHeap();
+    if (!self->tcp.connected()) return MBEDTLS_ERR_NET_CONN_RESET;
+    size_t sent = self->tcp.write(buf, len);
+    return sent > 0 ? (int)sent : MBEDTLS_ERR_NET_SEND_FAILED;
+}
+
+// Blocks until some bytes arrive; mbedTLS passes the configured read timeout
+int MqttTlsClient::tlsRecv(void* ctx, unsigned char* buf, size_t len, uint32_t timeoutMs)
+{
+    MqttTlsClient* self = (MqttTlsClient*)ctx;
+    self->sampleHeap();
+    uint32_t start = millis();
+    while (self->tcp.available() <= 0) {
+        if (!self->tcp.connected()) return MBEDTLS_ERR_NET_CONN_RESET;
+        if (millis() - start >= timeoutMs) return MBEDTLS_ERR_SSL_TIMEOUT;
+        delay(1);
+    }
+    int got = self->tcp.read(buf, len);
+    return got > 0 ? got : MBEDTLS_ERR_NET_RECV_FAILED;
+}
+
+// Runs for each certificate in the broker's chain, so only on a full handshake
+int MqttTlsClient::tlsVerify(void* ctx, mbedtls_x509_crt* crt, int depth, uint32_t* flags)
+{
+    (void)crt;
+    (void)depth;
+    (void)flags;
+    ((MqttTlsClient*)ctx)->certVerified = true;
+    return 0;
+}
+
+void MqttTlsClient::sampleHeap()
+{
+    uint32_t heapNow = freeHeap();
+    if (heapNow < heapLow) heapLow = heapNow;
+}
+
+MqttTlsClient::MqttTlsClient()
+    : configured(false), caLoaded(false), haveSession(false), open(false),
+      certVerified(false), ioTimeoutMs(5000), heapLow(0), rxStart(0), rxEnd(0)
+{
+    mbedtls_entropy_init(&entropy);
+    mbedtls_ctr_drbg_init(&drbg);
+    mbedtls_x509_crt_init(&ca);
+    mbedtls_ssl_config_init(&conf);
+    mbedtls_ssl_init(&ssl);
+    mbedtls_ssl_session_init(&session);
+    memset(&stats, 0, sizeof(stats));
+    memset(&published, 0, sizeof(published));
+    statsMutex = xSemaphoreCreateMutex();
+}
+
+MqttTlsClient::~MqttTlsClient()
+{
+    stop();
+    mbedtls_ssl_session_free(&session);
+    mbedtls_ssl_config_free(&conf);
+    mbedtls_x509_crt_free(&ca);
+    mbedtls_ctr_drbg_free(&drbg);
+    mbedtls_entropy_free(&entropy);
+    if (statsMutex != NULL) vSemaphoreDelete(statsMutex);
+}
+
+bool MqttTlsClient::setCACert(const char* pem)
+{
+    forgetSession();
+    mbedtls_x509_crt_free(&ca);
+    mbedtls_x509_crt_init(&ca);
+    caLoaded = false;
+    if (pem == NULL || pem[0] == '\0') return false;
+    // The PEM parser wants the terminating NUL counted in the length
+    int ret = mbedtls_x509_crt_parse(&ca, (const unsigned char*)pem, strlen(pem) + 1);
+    if (ret != 0) {
+        logTlsError("CA certificate parse", ret);
+        return false;
+    }
+    caLoaded = true;
+    return true;
+}
+
+void MqttTlsClient::forgetSession()
+{
+    mbedtls_ssl_session_free(&session);
+    mbedtls_ssl_session_init(&session);
+    haveSession = false;
+}
+
+bool MqttTlsClient::configure()
+{
+    if (configured) return true;
+    static const char personalization[] = "mqtt-tls";
+    int ret = mbedtls_ctr_drbg_seed(&drbg, mbedtls_entropy_func, &entropy,
+                                    (const unsigned char*)personalization, sizeof(personalization) - 1);
+    if (ret == 0) {
+        ret = mbedtls_ssl_config_defaults(&conf, MBEDTLS_SSL_IS_CLIENT,
+                                          MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT);
+    }
+    if (ret != 0) {
+        logTlsError("setup", ret);
+        stats.lastError = ret;
+        return false;
+    }
+    mbedtls_ssl_conf_authmode(&conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+    mbedtls_ssl_conf_ca_chain(&conf, &ca, NULL);
+    mbedtls_ssl_conf_verify(&conf, tlsVerify, this);
+    mbedtls_ssl_conf_rng(&conf, mbedtls_ctr_drbg_random, &drbg);
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    mbedtls_ssl_conf_session_tickets(&conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+    configured = true;
+    return true;
+}
+
+int MqttTlsClient::connect(IPAddress ip, uint16_t port)
+{
+    // Verified against the certificate's CN as text
+    return connect(ip.toString().c_str(), port);
+}
+
+int MqttTlsClient::connect(const char* host, uint16_t port)
+{
+    int ret = connectOnce(host, port);
+    if (statsMutex != NULL && xSemaphoreTake(statsMutex, portMAX_DELAY) == pdTRUE) {
+        published = stats;
+        xSemaphoreGive(statsMutex);
+    }
+    return ret;
+}
+
+void MqttTlsClient::getStats(MqttTlsStats& out)
+{
+    if (statsMutex == NULL || xSemaphoreTake(statsMutex, portMAX_DELAY) != pdTRUE) {
+        memset(&out, 0, sizeof(out));
+        return;
+    }
+    out = published;
+    xSemaphoreGive(statsMutex);
+}
+
+int MqttTlsClient::connectOnce(const char* host, uint16_t port)
+{
+    stop();
+    if (!caLoaded) {
+        LOG_ERROR(MQTT, "TLS: no valid CA certificate configured\n");
+        stats.failures++;
+        return 0;
+    }
+    if (!configure()) {
+        stats.failures++;
+        return 0;
+    }
+    mbedtls_ssl_conf_read_timeout(&conf, ioTimeoutMs);
+
+    uint32_t start = millis();
+    if (!tcp.connect(host, port, ioTimeoutMs)) {
+        LOG_WARN(MQTT, "TLS: TCP connect to %s:%u failed\n", host, (unsigned)port);
+        stats.failures++;
+        return 0;
+    }
+    tcp.setTimeout(ioTimeoutMs / 1000 > 0 ? ioTimeoutMs / 1000 : 1); // WiFiClient takes seconds
+
+    if (!handshake(host)) {
+        stats.failures++;
+        stop();
+        return 0;
+    }
+
+    uint32_t elapsed = millis() - start;
+    stats.handshakes++;
+    stats.lastMs = elapsed;
+    if (elapsed > stats.maxMs) stats.maxMs = elapsed;
+    return 1;
+}
+
+bool MqttTlsClient::handshake(const char* host)
+{
+    uint32_t heapBefore = freeHeap();
+    heapLow = heapBefore;
+    certVerified = false;
+    bool offered = haveSession;
+
+    // What was offered, to compare with what the broker settles on
+    unsigned char offeredId[32];
+    size_t offeredIdLen = 0;
+    if (offered) {
+        const unsigned char* id;
+        offeredIdLen = sessionId(&session, &id);
+        if (offeredIdLen > sizeof(offeredId)) offeredIdLen = 0;
+        if (offeredIdLen > 0) memcpy(offeredId, id, offeredIdLen);
+    }
+
+    int ret = mbedtls_ssl_setup(&ssl, &conf);
+    if (ret == 0) ret = mbedtls_ssl_set_hostname(&ssl, host);
+    if (ret == 0 && offered) ret = mbedtls_ssl_set_session(&ssl, &session);
+    if (ret != 0) {
+        logTlsError("session setup", ret);
+        stats.lastError = ret;
+        mbedtls_ssl_free(&ssl);
+        mbedtls_ssl_init(&ssl);
+        return false;
+    }
+    mbedtls_ssl_set_bio(&ssl, this, tlsSend, NULL, tlsRecv);
+    open = true;
+
+    uint32_t start = millis();
+    while ((ret = mbedtls_ssl_handshake(&ssl)) == MBEDTLS_ERR_SSL_WANT_READ ||
+           ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+        if (millis() - start >= ioTimeoutMs) {
+            ret = MBEDTLS_ERR_SSL_TIMEOUT;
+            break;
+        }
+    }
+    sampleHeap();
+
+    // Other tasks allocate meanwhile, so this is an upper bound
+    stats.heapLastBytes = heapBefore - heapLow;
+    if (stats.heapLastBytes > stats.heapPeakBytes) stats.heapPeakBytes = stats.heapLastBytes;
+
+    if (ret != 0) {
+        uint32_t flags = mbedtls_ssl_get_verify_result(&ssl);
+        if (flags != 0 && flags != (uint32_t)-1) {
+            char text[128];
+            mbedtls_x509_crt_verify_info(text, sizeof(text), "", flags);
+            LOG_WARN(MQTT, "TLS: broker certificate rejected: %s", text);
+        }
+        logTlsError("handshake", ret);
+        stats.lastError = ret;
+        // Don't keep offering a session the broker may be choking on
+        if (offered) forgetSession();
+        return false;
+    }
+
+    uint32_t elapsed = millis() - start;
+    stats.heapHeldBytes = heapBefore - freeHeap();
+
+    // Keep the (possibly renewed) session for the next connect
+    mbedtls_ssl_session_free(&session);
+    mbedtls_ssl_session_init(&session);
+    haveSession = mbedtls_ssl_get_session(&ssl, &session) == 0;
+
+    bool resumed = false;
+    if (offered) {
+        const unsigned char* id;
+        size_t idLen = haveSession ? sessionId(&session, &id) : 0;
+        bool sameId = offeredIdLen > 0 && idLen == offeredIdLen && memcmp(id, offeredId, idLen) == 0;
+        // VERIFY_REQUIRED is set, so a completed handshake without a
+        // verified chain can only have been resumed
+        resumed = sameId || !certVerified;
+    }
+    if (resumed) {
+        stats.resumed++;
+        stats.lastResumedMs = elapsed;
+    } else {
+        stats.lastFullMs = elapsed;
+    }
+
+    LOG_INFO(MQTT, "TLS: %s handshake in %lums (%s), heap %luB peak, %luB held\n",
+             resumed ? "resumed" : "full", (unsigned long)elapsed, mbedtls_ssl_get_ciphersuite(&ssl),
+             (unsigned long)stats.heapLastBytes, (unsigned long)stats.heapHeldBytes);
+    return true;
+}
+
+// Decrypt the next record into rx; false once the session is gone
+bool MqttTlsClient::fill()
+{
+    int ret = mbedtls_ssl_read(&ssl, rx, sizeof(rx));
+    if (ret > 0) {
+        rxStart = 0;
+        rxEnd = (size_t)ret;
+        return true;
+    }
+    if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) return true;
+    if (ret != 0 && ret != MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY) logTlsError("read", ret);
+    stop();
+    return false;
+}
+
+int MqttTlsClient::available()
+{
+    if (rxEnd > rxStart) return (int)(rxEnd - rxStart);
+    if (!open) return 0;
+    // Only read when something is there: mbedtls_ssl_read() blocks
+    if (mbedtls_ssl_get_bytes_avail(&ssl) == 0 && tcp.available() <= 0) return 0;
+    if (!fill()) return 0;
+    return (int)(rxEnd - rxStart);
+}
+
+int MqttTlsClient::read()
+{
+    uint8_t b;
+    return read(&b, 1) == 1 ? b : -1;
+}
+
+int MqttTlsClient::read(uint8_t* buf, size_t size)
+{
+    if (available() <= 0) return -1;
+    size_t n = rxEnd - rxStart;
+    if (n > size) n = size;
+    memcpy(buf, rx + rxStart, n);
+    rxStart += n;
+    return (int)n;
+}
+
+int MqttTlsClient::peek()
+{
+    return available() > 0 ? rx[rxStart] : -1;
+}
+
+size_t MqttTlsClient::write(uint8_t b)
+{
+    return write(&b, 1);
+}
+
+size_t MqttTlsClient::write(const uint8_t* buf, size_t size)
+{
+    if (!open) return 0;
+    size_t done = 0;
+    while (done < size) {
+        int ret = mbedtls_ssl_write(&ssl, buf + done, size - done);
+        if (ret > 0) {
+            done += (size_t)ret;
+        } else if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+            logTlsError("write", ret);
+            stop();
+            break;
+        }
+    }
+    return done;
+}
+
+void MqttTlsClient::flush()
+{
+    // Records go out as they are written
+}
+
+void MqttTlsClient::stop()
+{
+    if (open) {
+        mbedtls_ssl_close_notify(&ssl);
+        open = false;
+    }
+    mbedtls_ssl_free(&ssl);
+    mbedtls_ssl_init(&ssl);
+    tcp.stop();
+    rxStart = rxEnd = 0;
+}
+
+uint8_t MqttTlsClient::connected()
+{
+    if (rxEnd > rxStart) return 1;
+    return open && tcp.connected();
+}
@@ -0,0 +1,151 @@
+/*
+ * MqttTopics.cpp - Interned "<hostname>/..." MQTT topic table
+ *
+ * All topics live in one static buffer; offsets are recomputed on rebuild.
+ * Only the MQTT task resolves topics (publishing, subscribing and the
+ * PubSubClient callback), and it is also the only caller of
+ * mqttTopicsUpdate(), so the table never changes under a reader.
+ */
+
+#include "MqttTopics.h"
+#include <string.h>
+#include "Log.h"
+
+static const char* const TOPIC_SUFFIXES[MQTT_TOPIC_COUNT] = {
+    "current_temperature",
+    "current_humidity",
+    "barometric_pressure",
+    "gas_resistance",
+    "air_quality_index",
+    "target_temperature",
+    "mode",
+    "fan_mode",
+    "action",
+    "hydronic_temperature",
+    "ds18b20_supply_temperature",
+    "ds18b20_return_temperature",
+    "hydronic_alert",
+    "motion_detected",
+    "shower_mode",
+    "shower_time_remaining",
+    "schedule_enabled",
+    "active_period",
+    "schedule_override",
+    "schedule/sunday",
+    "schedule/monday",
+    "schedule/tuesday",
+    "schedule/wednesday",
+    "schedule/thursday",
+    "schedule/friday",
+    "schedule/saturday",
+    "availability",
+    "postmortem",
+    "state",
+    "history",
+    "nvs",
+    "homeassistant/notify/thermostat_alerts",
+    "homeassistant/status",
+    "thermostat/setTempHeat",
+    "thermostat/setTempCool",
+    "thermostat/setTempAuto",
+    "thermostat/activePeriod"
+};
+
+static const char* const COMMAND_SUFFIXES[MQTT_CMD_COUNT] = {
+    "target_temperature/set",
+    "mode/set",
+    "fan_mode/set",
+    "shower_mode/set",
+    "schedule_enabled/set",
+    "schedule_override/set",
+    "schedule/set"
+};
+
+// Hostnames are limited to 63 characters; the prefixed suffixes add < 600 bytes
+static const size_t HOSTNAME_MAX = 63;
+static const size_t TOPIC_STORE_SIZE = (MQTT_TOPIC_FIRST_FIXED + MQTT_CMD_COUNT + 1) * (HOSTNAME_MAX + 2) + 640;
+
+static char topicStore[TOPIC_STORE_SIZE];
+static uint16_t topicOffsets[MQTT_TOPIC_FIRST_FIXED];
+static uint16_t commandOffsets[MQTT_CMD_COUNT];
+static char builtFor[HOSTNAME_MAX + 1] = "";
+static size_t prefixLen = 0;
+static bool built = false;
+
+// FNV-1a, recursive so it is a C++11 constexpr and usable as a case label
+static constexpr uint32_t fnv1a(const char* s, uint32_t h = 2166136261u)
+{
+    return *s == '\0' ? h : fnv1a(s + 1, (h ^ (uint8_t)*s) * 16777619u);
+}
+
+static uint16_t appendTopic(size_t& used, const char* suffix)
+{
+    uint16_t offset = (uint16_t)used;
+    // prefix ("<hostname>/") is already at the start of the store
+    memcpy(topicStore + used, topicStore, prefixLen);
+    size_t suffixLen = strlen(suffix);
+    memcpy(topicStore + used + prefixLen, suffix, suffixLen + 1);
+    used += prefixLen + suffixLen + 1;
+    return offset;
+}
+
+bool mqttTopicsUpdate(const char* hostname)
+{
+    if (built && strcmp(hostname, builtFor) == 0) return false;
+
+    size_t hostLen = strnlen(hostname, HOSTNAME_MAX);
+    memcpy(builtFor, hostname, hostLen);
+    builtFor[hostLen] = '\0';
+    if (hostLen < strlen(hostname)) {
+        LOG_WARN(MQTT, "Hostname longer than %u characters, topics use \"%s\"\n", (unsigned)HOSTNAME_MAX, builtFor);
+    }
+
+    // Slot 0 holds the bare prefix that each topic is copied from
+    memcpy(topicStore, builtFor, hostLen);
+    topicStore[hostLen] = '/';
+    topicStore[hostLen + 1] = '\0';
+    prefixLen = hostLen + 1;
+    size_t used = prefixLen + 1;
+    for (int i = 0; i < MQTT_TOPIC_FIRST_FIXED; i++) topicOffsets[i] = appendTopic(used, TOPIC_SUFFIXES[i]);
+    for (int i = 0; i < MQTT_CMD_COUNT; i++) commandOffsets[i] = appendTopic(used, COMMAND_SUFFIXES[i]);
+    built = true;
+
+    LOG_DEBUG(MQTT, "Topic table built for \"%s\" (%u bytes)\n", builtFor, (unsigned)used);
+    return true;
+}
+
+const char* mqttTopic(MqttTopic topic)
+{
+    if (topic >= MQTT_TOPIC_FIRST_FIXED) return TOPIC_SUFFIXES[topic];
+    return topicStore + topicOffsets[topic];
+}
+
+const char* mqttCommandTopic(MqttCommand command)
+{
+    return topicStore + commandOffsets[command];
+}
+
+const char* mqttCommandName(MqttCommand command)
+{
+    return COMMAND_SUFFIXES[command];
+}
+
+MqttCommand mqttCommandFromTopic(const char* topic)
+{
+    if (!built || strncmp(topic, topicStore, prefixLen) != 0) return MQTT_CMD_UNKNOWN;
+    const char* suffix = topic + prefixLen;
+
+    MqttCommand command;
+    switch (fnv1a(suffix)) {
+        case fnv1a("target_temperature/set"): command = MQTT_CMD_TARGET_TEMPERATURE; break;
+        case fnv1a("mode/set"):               command = MQTT_CMD_MODE; break;
+        case fnv1a("fan_mode/set"):           command = MQTT_CMD_FAN_MODE; break;
+        case fnv1a("shower_mode/set"):        command = MQTT_CMD_SHOWER_MODE; break;
+        case fnv1a("schedule_enabled/set"):   command = MQTT_CMD_SCHEDULE_ENABLED; break;
+        case fnv1a("schedule_override/set"):  command = MQTT_CMD_SCHEDULE_OVERRIDE; break;
+        case fnv1a("schedule/set"):           command = MQTT_CMD_SCHEDULE; break;
+        default: return MQTT_CMD_UNKNOWN;
+    }
+    // A hash match on an unrelated topic is possible; confirm it
+    return strcmp(suffix, COMMAND_SUFFIXES[command]) == 0 ? command : MQTT_CMD_UNKNOWN;
+}
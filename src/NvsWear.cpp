@@ -0,0 +1,263 @@
+/*
+ * NvsWear.cpp - NVS write accounting and flash wear estimate
+ *
+ * Recording and reading both take statsMutex. Readers (web server, MQTT
+ * task, diagnostics) copy everything into a Snapshot under it and format
+ * from the copy, so totals, per-key counts and the histogram in one report
+ * come from the same instant.
+ */
+
+#include "NvsWear.h"
+#include <string.h>
+#include <esp_partition.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "ConfigBlob.h"
+#include "Log.h"
+
+static const uint32_t NVS_PAGE_SIZE = 4096;
+static const uint32_t NVS_PAGE_ENTRIES = 126;  // 32-byte entries after the page header and bitmap
+static const uint32_t NVS_ENTRY_SIZE = 32;
+
+static const char* const WRITER_NAMES[NVS_WRITER_COUNT] = {
+    "web", "mqtt", "touch", "schedule", "system", "calibration"
+};
+
+static const uint32_t HISTOGRAM_LIMITS_MS[NVS_WEAR_HISTOGRAM_BUCKETS - 1] = {
+    5, 10, 20, 50, 100, 200, 500
+};
+
+struct KeyCounter {
+    char key[16];             // NVS keys are at most 15 characters
+    NvsWearCounter count;
+};
+
+static KeyCounter keys[NVS_WEAR_KEYS];
+static int keyCount = 0;
+static NvsWearCounter otherKeys;
+
+static NvsWearStats stats;
+static uint8_t currentWriters = 0;
+static SemaphoreHandle_t statsMutex = NULL;
+
+struct Snapshot {
+    NvsWearStats stats;
+    KeyCounter keys[NVS_WEAR_KEYS];
+    int keyCount;
+    NvsWearCounter otherKeys;
+};
+
+static bool lockStats()
+{
+    return statsMutex != NULL && xSemaphoreTake(statsMutex, portMAX_DELAY) == pdTRUE;
+}
+
+// Only what a caller needs: the key table is most of the copy
+static void takeSnapshot(Snapshot& out, bool withKeys)
+{
+    if (!lockStats()) {
+        memset(&out, 0, sizeof(out));
+        return;
+    }
+    out.stats = stats;
+    out.keyCount = 0;
+    if (withKeys) {
+        out.keyCount = keyCount;
+        memcpy(out.keys, keys, sizeof(keys[0]) * keyCount);
+        out.otherKeys = otherKeys;
+    }
+    xSemaphoreGive(statsMutex);
+}
+
+void nvsWearBegin()
+{
+    if (statsMutex == NULL) statsMutex = xSemaphoreCreateMutex();
+    const esp_partition_t* partition =
+        esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_NVS, "nvs");
+    if (partition == NULL) {
+        LOG_WARN(SETTINGS, "NVS wear: nvs partition not found, no wear estimate\n");
+        return;
+    }
+    if (!lockStats()) return;
+    stats.partitionBytes = partition->size;
+    stats.partitionEntries = partition->size / NVS_PAGE_SIZE * NVS_PAGE_ENTRIES;
+    xSemaphoreGive(statsMutex);
+}
+
+void nvsWearSaveBegin(uint8_t writers)
+{
+    currentWriters = writers;
+}
+
+void nvsWearSaveDone(uint32_t elapsedMs)
+{
+    currentWriters = 0;
+    int bucket = 0;
+    while (bucket < NVS_WEAR_HISTOGRAM_BUCKETS - 1 && elapsedMs >= HISTOGRAM_LIMITS_MS[bucket]) bucket++;
+    if (!lockStats()) return;
+    stats.saveHistogram[bucket]++;
+    stats.saves++;
+    if (elapsedMs > stats.saveMsMax) stats.saveMsMax = elapsedMs;
+    xSemaphoreGive(statsMutex);
+}
+
+// Entries a write appends: strings and blobs take a header entry plus their
+// data rounded up to whole entries, and a blob adds an index entry
+static uint32_t entriesFor(NvsValueType type, size_t bytes)
+{
+    switch (type) {
+        case NVS_TYPE_STRING: return 1 + (bytes + 1 + NVS_ENTRY_SIZE - 1) / NVS_ENTRY_SIZE;
+        case NVS_TYPE_BLOB:   return 2 + (bytes + NVS_ENTRY_SIZE - 1) / NVS_ENTRY_SIZE;
+        default:              return 1;
+    }
+}
+
+static void add(NvsWearCounter& counter, size_t bytes, uint32_t entries)
+{
+    counter.writes++;
+    counter.bytes += bytes;
+    counter.entries += entries;
+}
+
+// With statsMutex held
+static NvsWearCounter& counterForKey(const char* key)
+{
+    for (int i = 0; i < keyCount; i++) {
+        if (strncmp(keys[i].key, key, sizeof(keys[i].key)) == 0) return keys[i].count;
+    }
+    if (keyCount == NVS_WEAR_KEYS) return otherKeys;
+    strncpy(keys[keyCount].key, key, sizeof(keys[keyCount].key) - 1);
+    return keys[keyCount++].count;
+}
+
+void nvsWearRecord(const char* key, NvsValueType type, size_t bytes)
+{
+    uint32_t entries = entriesFor(type, bytes);
+    uint8_t writers = currentWriters != 0 ? currentWriters : NVS_WRITER_SYSTEM;
+    if (!lockStats()) return;
+    add(stats.total, bytes, entries);
+    add(counterForKey(key), bytes, entries);
+    for (int i = 0; i < NVS_WRITER_COUNT; i++) {
+        if (writers & (1 << i)) add(stats.writer[i], bytes, entries);
+    }
+    xSemaphoreGive(statsMutex);
+}
+
+const char* nvsWriterName(int index)
+{
+    return index >= 0 && index < NVS_WRITER_COUNT ? WRITER_NAMES[index] : "?";
+}
+
+void nvsWearGetStats(NvsWearStats& out)
+{
+    if (!lockStats()) {
+        memset(&out, 0, sizeof(out));
+        return;
+    }
+    out = stats;
+    xSemaphoreGive(statsMutex);
+}
+
+float nvsWearCyclesSinceBoot(const NvsWearStats& s)
+{
+    if (s.partitionEntries == 0) return 0;
+    return (float)s.total.entries / s.partitionEntries;
+}
+
+// Config blob writes only, one per generation: keys kept outside the blob
+// (CA certificate, touch calibration) are not counted before this boot
+float nvsWearCyclesLifetimeBlobOnly(const NvsWearStats& s)
+{
+    if (s.partitionEntries == 0) return 0;
+    ConfigBlobStats blob;
+    configBlobGetStats(blob);
+    uint32_t blobEntries = entriesFor(NVS_TYPE_BLOB, blob.bytes);
+    float lifetime = (float)blob.generation * blobEntries / s.partitionEntries;
+    float sinceBoot = nvsWearCyclesSinceBoot(s);
+    return lifetime > sinceBoot ? lifetime : sinceBoot;
+}
+
+float nvsWearYearsRemaining(const NvsWearStats& s)
+{
+    float cycles = nvsWearCyclesSinceBoot(s);
+    if (cycles <= 0) return -1;
+    float uptimeYears = esp_timer_get_time() / 1e6f / (365.25f * 86400.0f);
+    float left = NVS_WEAR_ENDURANCE_CYCLES - nvsWearCyclesLifetimeBlobOnly(s);
+    return left > 0 ? left / (cycles / uptimeYears) : 0;
+}
+
+static void writeCounter(Print& out, const char* name, const NvsWearCounter& c)
+{
+    out.printf("\"%s\":{\"writes\":%lu,\"bytes\":%lu,\"entries\":%lu}", name,
+               (unsigned long)c.writes, (unsigned long)c.bytes, (unsigned long)c.entries);
+}
+
+void nvsWearWriteJson(Print& out)
+{
+    Snapshot snap;
+    takeSnapshot(snap, true);
+    const NvsWearStats& stats = snap.stats;
+    out.print("{");
+    writeCounter(out, "total", stats.total);
+    out.print(",\"writers\":{");
+    for (int i = 0; i < NVS_WRITER_COUNT; i++) {
+        if (i) out.print(",");
+        writeCounter(out, WRITER_NAMES[i], stats.writer[i]);
+    }
+    out.print("},\"keys\":{");
+    for (int i = 0; i < snap.keyCount; i++) {
+        if (i) out.print(",");
+        writeCounter(out, snap.keys[i].key, snap.keys[i].count);
+    }
+    if (snap.otherKeys.writes > 0) {
+        if (snap.keyCount) out.print(",");
+        writeCounter(out, "other", snap.otherKeys);
+    }
+    out.printf("},\"saves\":%lu,\"save_ms_max\":%lu,\"save_ms_histogram\":[",
+               (unsigned long)stats.saves, (unsigned long)stats.saveMsMax);
+    for (int i = 0; i < NVS_WEAR_HISTOGRAM_BUCKETS; i++) {
+        out.printf("%s%lu", i ? "," : "", (unsigned long)stats.saveHistogram[i]);
+    }
+    out.print("],\"save_ms_buckets\":[");
+    for (int i = 0; i < NVS_WEAR_HISTOGRAM_BUCKETS - 1; i++) {
+        out.printf("%s%lu", i ? "," : "", (unsigned long)HISTOGRAM_LIMITS_MS[i]);
+    }
+    float years = nvsWearYearsRemaining(stats);
+    float decade = stats.partitionEntries * (float)NVS_WEAR_ENDURANCE_CYCLES / (10 * 365.25f);
+    out.printf("],\"wear\":{\"partition_bytes\":%lu,\"partition_entries\":%lu,\"endurance_cycles\":%lu,"
+               "\"cycles_since_boot\":%.4f,\"cycles_lifetime_blob_only\":%.3f,\"entries_per_day_10y\":%.0f,"
+               "\"uptime_s\":%lu,",
+               (unsigned long)stats.partitionBytes, (unsigned long)stats.partitionEntries,
+               (unsigned long)NVS_WEAR_ENDURANCE_CYCLES, nvsWearCyclesSinceBoot(stats),
+               nvsWearCyclesLifetimeBlobOnly(stats), decade, (unsigned long)(esp_timer_get_time() / 1000000));
+    if (years >= 0) {
+        out.printf("\"years_remaining\":%.1f}}", years);
+    } else {
+        out.print("\"years_remaining\":null}}");
+    }
+}
+
+// Renders into a caller's buffer; counts what did not fit
+class NvsWearBufferPrint : public Print {
+public:
+    NvsWearBufferPrint(char* buf, size_t size) : buf(buf), size(size), length(0) {}
+    size_t write(uint8_t c) override
+    {
+        if (length + 1 < size) buf[length] = (char)c;
+        length++;
+        return 1;
+    }
+    char* buf;
+    size_t size;
+    size_t length;
+};
+
+size_t nvsWearFormatJson(char* buf, size_t size)
+{
+    NvsWearBufferPrint out(buf, size);
+    nvsWearWriteJson(out);
+    if (out.length >= size) return 0;
+    buf[out.length] = '\0';
+    return out.length;
+}
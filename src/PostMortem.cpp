@@ -0,0 +1,215 @@
+/*
+ * PostMortem.cpp - Last-events trace that survives a soft reset
+ *
+ * RTC no-init memory keeps its contents through panic, watchdog, brownout and
+ * software resets but is random after power-on, so the block carries a magic
+ * and each event its own sequence number; anything that doesn't line up is
+ * ignored. The sequence counter lives in normal RAM (S32C1I atomics are only
+ * used on internal SRAM) and is restarted every boot.
+ */
+
+#include "PostMortem.h"
+#include <atomic>
+#include <esp_attr.h>
+#include <esp_system.h>
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <soc/gpio_struct.h>
+#include "sdkconfig.h"
+#include "HardwarePins.h"
+
+#if defined(CONFIG_ESP_COREDUMP_ENABLE_TO_FLASH) && defined(CONFIG_ESP_COREDUMP_DATA_FORMAT_ELF)
+#include "esp_core_dump.h"
+#define POST_MORTEM_COREDUMP 1
+#else
+#define POST_MORTEM_COREDUMP 0
+#endif
+
+static const uint32_t POST_MORTEM_MAGIC = 0x504D5231; // "PMR1"; bump if PostMortemRecord changes
+
+struct PostMortemRecord {
+    uint32_t seq;      // 1-based, slot = (seq - 1) % POST_MORTEM_EVENTS
+    uint32_t ms;       // millis()
+    uint32_t arg;
+    uint16_t event;    // PostMortemEvent; written last
+    uint16_t heapKB;   // Free heap at the time
+    char task[4];      // First characters of the task name
+};
+
+struct PostMortemBlock {
+    uint32_t magic;
+    uint32_t boot;     // Boots since the last power-on
+    uint32_t minHeap;  // Lowest free heap seen this boot
+    PostMortemRecord events[POST_MORTEM_EVENTS];
+};
+
+static RTC_NOINIT_ATTR PostMortemBlock pmBlock;
+static std::atomic<uint32_t> pmSeq(0);
+
+// Copy of the previous boot's trace, taken before pmBlock is reused
+static PostMortemRecord pmLast[POST_MORTEM_EVENTS];
+static uint32_t pmLastCount = 0;
+static uint32_t pmLastBoot = 0;
+static uint32_t pmLastMinHeap = 0;
+static bool pmLastValid = false;
+static esp_reset_reason_t pmResetReason = ESP_RST_UNKNOWN;
+
+#if POST_MORTEM_COREDUMP
+static bool pmDumpValid = false;
+static esp_core_dump_summary_t pmDump;
+#endif
+
+static const char* const PM_EVENT_NAMES[] = {
+    "?", "boot", "heartbeat", "heap_low", "wifi_up", "wifi_down", "mqtt_up",
+    "mqtt_down", "ota_start", "ota_end", "relays", "sensor_stall", "restart"
+};
+
+static const char* eventName(uint16_t event)
+{
+    return event < sizeof(PM_EVENT_NAMES) / sizeof(PM_EVENT_NAMES[0]) ? PM_EVENT_NAMES[event] : "?";
+}
+
+static const char* resetReasonName(esp_reset_reason_t reason)
+{
+    switch (reason) {
+        case ESP_RST_POWERON:   return "POWERON";
+        case ESP_RST_EXT:       return "EXT";
+        case ESP_RST_SW:        return "SW";
+        case ESP_RST_PANIC:     return "PANIC";
+        case ESP_RST_INT_WDT:   return "INT_WDT";
+        case ESP_RST_TASK_WDT:  return "TASK_WDT";
+        case ESP_RST_WDT:       return "WDT";
+        case ESP_RST_DEEPSLEEP: return "DEEPSLEEP";
+        case ESP_RST_BROWNOUT:  return "BROWNOUT";
+        case ESP_RST_SDIO:      return "SDIO";
+        default:                return "UNKNOWN";
+    }
+}
+
+void postMortemBegin()
+{
+    pmResetReason = esp_reset_reason();
+
+    // Recover the previous boot's events, oldest first
+    if (pmBlock.magic == POST_MORTEM_MAGIC && pmResetReason != ESP_RST_POWERON) {
+        uint32_t newest = 0;
+        for (uint32_t i = 0; i < POST_MORTEM_EVENTS; i++) {
+            const PostMortemRecord& r = pmBlock.events[i];
+            if (r.event != 0 && r.seq != 0 && (r.seq - 1) % POST_MORTEM_EVENTS == i && r.seq > newest) {
+                newest = r.seq;
+            }
+        }
+        uint32_t first = newest > POST_MORTEM_EVENTS ? newest - POST_MORTEM_EVENTS + 1 : 1;
+        for (uint32_t seq = first; newest != 0 && seq <= newest; seq++) {
+            const PostMortemRecord& r = pmBlock.events[(seq - 1) % POST_MORTEM_EVENTS];
+            if (r.seq == seq && r.event != 0) pmLast[pmLastCount++] = r;
+        }
+        pmLastBoot = pmBlock.boot;
+        pmLastMinHeap = pmBlock.minHeap;
+        pmLastValid = true;
+    }
+
+#if POST_MORTEM_COREDUMP
+    // Only attribute the dump to the previous boot if that boot crashed;
+    // otherwise it is left over from an older crash
+    if (pmResetReason == ESP_RST_PANIC || pmResetReason == ESP_RST_INT_WDT ||
+        pmResetReason == ESP_RST_TASK_WDT || pmResetReason == ESP_RST_WDT) {
+        pmDumpValid = (esp_core_dump_image_check() == ESP_OK &&
+                       esp_core_dump_get_summary(&pmDump) == ESP_OK);
+    }
+#endif
+
+    uint32_t boot = pmLastValid ? pmLastBoot + 1 : 1;
+    memset(&pmBlock, 0, sizeof(pmBlock));
+    pmBlock.boot = boot;
+    pmBlock.minHeap = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    pmBlock.magic = POST_MORTEM_MAGIC;
+    pmSeq.store(0);
+
+    postMortemRecord(PM_BOOT, (uint32_t)pmResetReason);
+}
+
+void postMortemRecord(PostMortemEvent event, uint32_t arg)
+{
+    uint32_t seq = pmSeq.fetch_add(1, std::memory_order_relaxed) + 1;
+    PostMortemRecord& r = pmBlock.events[(seq - 1) % POST_MORTEM_EVENTS];
+    size_t freeHeap = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+
+    r.event = 0; // Invalid until the other fields are in
+    r.seq = seq;
+    r.ms = millis();
+    r.arg = arg;
+    r.heapKB = (uint16_t)(freeHeap / 1024);
+    const char* name = pcTaskGetName(NULL);
+    strncpy(r.task, name != nullptr ? name : "?", sizeof(r.task));
+    r.event = (uint16_t)event;
+
+    if (freeHeap < pmBlock.minHeap) pmBlock.minHeap = freeHeap;
+}
+
+bool postMortemAvailable()
+{
+    return pmLastValid;
+}
+
+const char* postMortemResetReason()
+{
+    return resetReasonName(pmResetReason);
+}
+
+void postMortemWriteJson(Print& out)
+{
+    out.printf("{\"reset_reason\":\"%s\",\"available\":%s", resetReasonName(pmResetReason),
+               pmLastValid ? "true" : "false");
+    if (pmLastValid) {
+        uint32_t uptime = pmLastCount > 0 ? pmLast[pmLastCount - 1].ms : 0;
+        out.printf(",\"boot\":%lu,\"last_uptime_ms\":%lu,\"min_free_heap\":%lu",
+                   (unsigned long)pmLastBoot, (unsigned long)uptime, (unsigned long)pmLastMinHeap);
+    }
+#if POST_MORTEM_COREDUMP
+    if (pmDumpValid) {
+        out.printf(",\"coredump\":{\"task\":\"%.16s\",\"pc\":\"0x%08lx\"}",
+                   pmDump.exc_task, (unsigned long)pmDump.exc_pc);
+    }
+#endif
+    out.print(",\"events\":[");
+    for (uint32_t i = 0; i < pmLastCount; i++) {
+        const PostMortemRecord& r = pmLast[i];
+        out.printf("%s{\"seq\":%lu,\"ms\":%lu,\"task\":\"%.4s\",\"event\":\"%s\",\"arg\":%ld,\"heap_kb\":%u}",
+                   i ? "," : "", (unsigned long)r.seq, (unsigned long)r.ms, r.task,
+                   eventName(r.event), (long)(int32_t)r.arg, (unsigned)r.heapKB);
+    }
+    out.print("]}");
+}
+
+// Counts instead of writing, to size an MQTT publish before streaming it
+class PostMortemCounter : public Print {
+public:
+    size_t count = 0;
+    size_t write(uint8_t) override { count++; return 1; }
+    size_t write(const uint8_t*, size_t size) override { count += size; return size; }
+};
+
+size_t postMortemJsonLength()
+{
+    PostMortemCounter counter;
+    postMortemWriteJson(counter);
+    return counter.count;
+}
+
+// Output latch, not the pad: digitalRead() returns 0 for OUTPUT-only pins
+static inline uint32_t outputLevel(int pin)
+{
+    return pin < 32 ? (GPIO.out >> pin) & 1 : (GPIO.out1.val >> (pin - 32)) & 1;
+}
+
+uint32_t postMortemRelayMask()
+{
+    return outputLevel(HEAT_RELAY_1_PIN) |
+           (outputLevel(HEAT_RELAY_2_PIN) << 1) |
+           (outputLevel(COOL_RELAY_1_PIN) << 2) |
+           (outputLevel(COOL_RELAY_2_PIN) << 3) |
+           (outputLevel(FAN_RELAY_PIN) << 4) |
+           (outputLevel(PUMP_RELAY_PIN) << 5);
+}
@@ -0,0 +1,599 @@
+/*
+ * SettingsRegistry.cpp - Lookup, parsing and persistence over SETTINGS[]
+ *
+ * Perfect hash: each name's FNV-1a hash picks one of HASH_BUCKETS buckets,
+ * and each bucket gets a seed that sends all of its names to free slots of
+ * a HASH_SLOTS table. Buckets are placed largest first; with the table well
+ * under half full a seed is found within a few tries. Should none be found,
+ * lookups fall back to a linear scan.
+ */
+
+#include "SettingsRegistry.h"
+#include <ctype.h>
+#include <limits.h>
+#include <math.h>
+#include <string.h>
+#include "Log.h"
+
+static const size_t HASH_SLOTS = 256;     // Power of two
+static const size_t HASH_BUCKETS = 32;    // Power of two
+
+static_assert(SETTINGS_MAX < 255, "slot table stores index + 1 in a byte");
+static_assert(SETTINGS_MAX * 2 <= HASH_SLOTS, "keep the slot table at most half full");
+
+static uint8_t bucketSeed[HASH_BUCKETS];
+static uint8_t slotSetting[HASH_SLOTS];   // Setting index + 1, 0 = empty
+static bool hashReady = false;
+
+static const String EMPTY_STRING;
+
+static uint32_t nameHash(const char* name, size_t length)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (uint8_t)name[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static size_t bucketFor(uint32_t hash)
+{
+    return (hash >> 24) & (HASH_BUCKETS - 1);
+}
+
+static size_t slotFor(uint32_t hash, uint8_t seed)
+{
+    uint32_t x = hash ^ (seed * 0x9E3779B9u);
+    x ^= x >> 15;
+    x *= 0x2C1B3C6Du;
+    x ^= x >> 12;
+    return x & (HASH_SLOTS - 1);
+}
+
+// Find a seed that puts every name of `bucket` in a free slot, and take the slots
+static bool placeBucket(size_t bucket, const uint32_t* hashes, const uint8_t* buckets)
+{
+    size_t slots[SETTINGS_MAX];
+    for (unsigned seed = 0; seed < 256; seed++) {
+        size_t placed = 0;
+        bool ok = true;
+        for (size_t i = 0; i < SETTINGS_COUNT && ok; i++) {
+            if (buckets[i] != bucket) continue;
+            size_t slot = slotFor(hashes[i], seed);
+            ok = slotSetting[slot] == 0;
+            for (size_t j = 0; j < placed && ok; j++) ok = slots[j] != slot;
+            slots[placed++] = slot;
+        }
+        if (!ok) continue;
+        placed = 0;
+        for (size_t i = 0; i < SETTINGS_COUNT; i++) {
+            if (buckets[i] == bucket) slotSetting[slots[placed++]] = i + 1;
+        }
+        bucketSeed[bucket] = seed;
+        return true;
+    }
+    return false;
+}
+
+void settingsRegistryBegin()
+{
+    uint32_t start = micros();
+    if (SETTINGS_COUNT > SETTINGS_MAX) {
+        LOG_ERROR(SETTINGS, "%u settings, SETTINGS_MAX is %u: raise it\n",
+                  (unsigned)SETTINGS_COUNT, (unsigned)SETTINGS_MAX);
+        return;
+    }
+
+    uint32_t hashes[SETTINGS_MAX];
+    uint8_t buckets[SETTINGS_MAX];
+    uint8_t bucketSize[HASH_BUCKETS] = {0};
+    uint8_t largest = 0;
+    for (size_t i = 0; i < SETTINGS_COUNT; i++) {
+        hashes[i] = nameHash(SETTINGS[i].name, strlen(SETTINGS[i].name));
+        buckets[i] = bucketFor(hashes[i]);
+        if (++bucketSize[buckets[i]] > largest) largest = bucketSize[buckets[i]];
+    }
+
+    memset(slotSetting, 0, sizeof(slotSetting));
+    bool ok = true;
+    for (uint8_t size = largest; size > 0 && ok; size--) {
+        for (size_t bucket = 0; bucket < HASH_BUCKETS && ok; bucket++) {
+            if (bucketSize[bucket] == size) ok = placeBucket(bucket, hashes, buckets);
+        }
+    }
+    hashReady = ok;
+    if (!ok) {
+        LOG_WARN(SETTINGS, "Settings registry: no perfect hash found, using linear lookup\n");
+        return;
+    }
+    LOG_INFO(SETTINGS, "Settings registry: %u settings, perfect hash built in %luus\n",
+             (unsigned)SETTINGS_COUNT, (unsigned long)(micros() - start));
+}
+
+const SettingDesc* settingFind(const char* name, size_t length)
+{
+    if (!hashReady) {
+        for (size_t i = 0; i < SETTINGS_COUNT; i++) {
+            if (strncmp(SETTINGS[i].name, name, length) == 0 && SETTINGS[i].name[length] == '\0') {
+                return &SETTINGS[i];
+            }
+        }
+        return NULL;
+    }
+    uint32_t hash = nameHash(name, length);
+    uint8_t index = slotSetting[slotFor(hash, bucketSeed[bucketFor(hash)])];
+    if (index == 0) return NULL;
+    const SettingDesc* setting = &SETTINGS[index - 1];
+    return strncmp(setting->name, name, length) == 0 && setting->name[length] == '\0' ? setting : NULL;
+}
+
+const SettingDesc* settingFind(const char* name)
+{
+    return settingFind(name, strlen(name));
+}
+
+static bool isChoice(const char* choices, const char* text, size_t length)
+{
+    const char* choice = choices;
+    while (true) {
+        const char* end = strchr(choice, '|');
+        size_t n = end != NULL ? (size_t)(end - choice) : strlen(choice);
+        if (n == length && strncmp(choice, text, n) == 0) return true;
+        if (end == NULL) return false;
+        choice = end + 1;
+    }
+}
+
+// The span of `text` a string setting would store. SETTING_UNCHANGED for an
+// empty SETTING_KEEP_IF_EMPTY value, SETTING_REJECTED (logged) if not allowed.
+static SettingResult checkString(const SettingDesc* setting, const char*& text, size_t& length)
+{
+    length = strlen(text);
+    // Trim first, so " heat" from a form or MQTT client still matches a choice
+    if (setting->flags & SETTING_TRIM) {
+        while (isspace((unsigned char)*text)) text++, length--;
+        while (length > 0 && isspace((unsigned char)text[length - 1])) length--;
+    }
+    if ((setting->flags & SETTING_KEEP_IF_EMPTY) && length == 0) return SETTING_UNCHANGED;
+    if (setting->choices != NULL && !isChoice(setting->choices, text, length)) {
+        LOG_WARN(SETTINGS, "%s: \"%.*s\" is not one of %s\n", setting->name,
+                 (int)(length < 16 ? length : 16), text, setting->choices);
+        return SETTING_REJECTED;
+    }
+    // Leave room for the NUL in ConfigData: packing would cut it short
+    if (setting->offset != SETTING_NOT_IN_BLOB && length >= setting->size) {
+        LOG_WARN(SETTINGS, "%s: %u characters, at most %u fit\n", setting->name,
+                 (unsigned)length, (unsigned)(setting->size - 1));
+        return SETTING_REJECTED;
+    }
+    return SETTING_CHANGED;
+}
+
+static SettingResult setString(const SettingDesc* setting, const char* text)
+{
+    size_t length;
+    SettingResult check = checkString(setting, text, length);
+    if (check != SETTING_CHANGED) return check;
+    String& value = *static_cast<String*>(setting->value);
+    if (value.length() == length && strncmp(value.c_str(), text, length) == 0) return SETTING_UNCHANGED;
+    value = "";
+    value.concat(text, length);
+    return SETTING_CHANGED;
+}
+
+template <typename T>
+static SettingResult store(const SettingDesc* setting, T v)
+{
+    T& value = *static_cast<T*>(setting->value);
+    if (value == v) return SETTING_UNCHANGED;
+    value = v;
+    return SETTING_CHANGED;
+}
+
+// Checkboxes post "on"; JSON and MQTT send true/false or 1/0. Anything
+// else is rejected (logged) rather than read as false.
+static bool parseBool(const SettingDesc* setting, const char* text, bool& v)
+{
+    if (strcmp(text, "on") == 0 || strcmp(text, "true") == 0 || strcmp(text, "1") == 0) {
+        v = true;
+    } else if (strcmp(text, "off") == 0 || strcmp(text, "false") == 0 || strcmp(text, "0") == 0) {
+        v = false;
+    } else {
+        LOG_WARN(SETTINGS, "%s: \"%.16s\" is not on/off, true/false or 1/0\n", setting->name, text);
+        return false;
+    }
+    return true;
+}
+
+// Numeric settings; false (logged) unless all of `text`, surrounding
+// whitespace aside, is one finite number: "72abc" and "inf" are not
+static bool parseNumber(const SettingDesc* setting, const char* text, double& v)
+{
+    char* end;
+    v = strtod(text, &end);
+    const char* rest = end;
+    while (isspace((unsigned char)*rest)) rest++;
+    if (end == text || *rest != '\0' || !isfinite(v)) {
+        LOG_WARN(SETTINGS, "%s: \"%.16s\" is not a number\n", setting->name, text);
+        return false;
+    }
+    return true;
+}
+
+bool settingCheckText(const SettingDesc* setting, const char* text)
+{
+    if (setting == NULL || text == NULL) return false;
+    if (setting->type == SETTING_STRING) {
+        size_t length;
+        return checkString(setting, text, length) != SETTING_REJECTED;
+    }
+    if (setting->type == SETTING_BOOL) {
+        bool b;
+        return parseBool(setting, text, b);
+    }
+    double v;
+    return parseNumber(setting, text, v);
+}
+
+SettingResult settingSetText(const SettingDesc* setting, const char* text)
+{
+    if (setting == NULL || text == NULL) return SETTING_REJECTED;
+    if (setting->type == SETTING_STRING) return setString(setting, text);
+    if (setting->type == SETTING_BOOL) {
+        bool b;
+        return parseBool(setting, text, b) ? store<bool>(setting, b) : SETTING_REJECTED;
+    }
+
+    double v;
+    if (!parseNumber(setting, text, v)) return SETTING_REJECTED;
+    if (setting->min <= setting->max) v = constrain(v, (double)setting->min, (double)setting->max);
+    v *= setting->scale;
+    // Finite but beyond the type ("any" range) would still be undefined
+    switch (setting->type) {
+        case SETTING_INT:   return store<int>(setting, (int)constrain(v, (double)INT_MIN, (double)INT_MAX));
+        case SETTING_ULONG: return store<unsigned long>(setting, (unsigned long)constrain(v, 0.0, (double)ULONG_MAX));
+        default:            return store<float>(setting, (float)v);
+    }
+}
+
+static double numberOf(const SettingDesc* setting)
+{
+    switch (setting->type) {
+        case SETTING_BOOL:  return *static_cast<bool*>(setting->value) ? 1 : 0;
+        case SETTING_INT:   return *static_cast<int*>(setting->value);
+        case SETTING_ULONG: return *static_cast<unsigned long*>(setting->value);
+        case SETTING_FLOAT: return *static_cast<float*>(setting->value);
+        default:            return 0;
+    }
+}
+
+static const SettingDesc* lookup(const char* name)
+{
+    const SettingDesc* setting = settingFind(name);
+    if (setting == NULL) LOG_ERROR(SETTINGS, "Unknown setting \"%s\"\n", name);
+    return setting;
+}
+
+bool settingBool(const char* name)
+{
+    const SettingDesc* setting = lookup(name);
+    return setting != NULL && numberOf(setting) != 0;
+}
+
+int32_t settingInt(const char* name)
+{
+    const SettingDesc* setting = lookup(name);
+    return setting != NULL ? (int32_t)numberOf(setting) : 0;
+}
+
+uint32_t settingULong(const char* name)
+{
+    const SettingDesc* setting = lookup(name);
+    return setting != NULL ? (uint32_t)numberOf(setting) : 0;
+}
+
+float settingFloat(const char* name)
+{
+    const SettingDesc* setting = lookup(name);
+    return setting != NULL ? (float)numberOf(setting) : 0;
+}
+
+const String& settingString(const char* name)
+{
+    const SettingDesc* setting = lookup(name);
+    if (setting == NULL || setting->type != SETTING_STRING) return EMPTY_STRING;
+    return *static_cast<String*>(setting->value);
+}
+
+void settingsPack(ConfigData& data)
+{
+    uint8_t* base = reinterpret_cast<uint8_t*>(&data);
+    for (size_t i = 0; i < SETTINGS_COUNT; i++) {
+        const SettingDesc& s = SETTINGS[i];
+        if (s.offset == SETTING_NOT_IN_BLOB) continue;
+        uint8_t* field = base + s.offset;
+        switch (s.type) {
+            case SETTING_BOOL: {
+                *field = *static_cast<bool*>(s.value) ? 1 : 0;
+                break;
+            }
+            case SETTING_INT: {
+                int32_t v = *static_cast<int*>(s.value);
+                memcpy(field, &v, sizeof(v));
+                break;
+            }
+            case SETTING_ULONG: {
+                uint32_t v = *static_cast<unsigned long*>(s.value);
+                memcpy(field, &v, sizeof(v));
+                break;
+            }
+            case SETTING_FLOAT: {
+                memcpy(field, s.value, sizeof(float));
+                break;
+            }
+            case SETTING_STRING: {
+                const String& v = *static_cast<String*>(s.value);
+                if (v.length() >= s.size) {
+                    LOG_WARN(SETTINGS, "%s \"%.16s...\" is longer than %u characters, truncated\n",
+                             s.name, v.c_str(), (unsigned)(s.size - 1));
+                }
+                strncpy(reinterpret_cast<char*>(field), v.c_str(), s.size - 1);
+                field[s.size - 1] = '\0';
+                break;
+            }
+        }
+    }
+}
+
+void settingsUnpack(const ConfigData& data)
+{
+    const uint8_t* base = reinterpret_cast<const uint8_t*>(&data);
+    for (size_t i = 0; i < SETTINGS_COUNT; i++) {
+        const SettingDesc& s = SETTINGS[i];
+        if (s.offset == SETTING_NOT_IN_BLOB) continue;
+        const uint8_t* field = base + s.offset;
+        switch (s.type) {
+            case SETTING_BOOL: {
+                *static_cast<bool*>(s.value) = *field != 0;
+                break;
+            }
+            case SETTING_INT: {
+                int32_t v;
+                memcpy(&v, field, sizeof(v));
+                *static_cast<int*>(s.value) = v;
+                break;
+            }
+            case SETTING_ULONG: {
+                uint32_t v;
+                memcpy(&v, field, sizeof(v));
+                *static_cast<unsigned long*>(s.value) = v;
+                break;
+            }
+            case SETTING_FLOAT: {
+                memcpy(s.value, field, sizeof(float));
+                break;
+            }
+            case SETTING_STRING: {
+                // Packed strings are terminated; keep the default if this one is not
+                if (memchr(field, '\0', s.size) == NULL) {
+                    LOG_WARN(SETTINGS, "%s: stored value not terminated, default kept\n", s.name);
+                    break;
+                }
+                *static_cast<String*>(s.value) = reinterpret_cast<const char*>(field);
+                break;
+            }
+        }
+    }
+}
+
+static void setDefault(const SettingDesc& s)
+{
+    switch (s.type) {
+        case SETTING_BOOL:   *static_cast<bool*>(s.value) = s.def != 0; break;
+        case SETTING_INT:    *static_cast<int*>(s.value) = (int)s.def; break;
+        case SETTING_ULONG:  *static_cast<unsigned long*>(s.value) = (unsigned long)s.def; break;
+        case SETTING_FLOAT:  *static_cast<float*>(s.value) = s.def; break;
+        case SETTING_STRING: *static_cast<String*>(s.value) = s.defText; break;
+    }
+}
+
+void settingsRestoreDefaults()
+{
+    for (size_t i = 0; i < SETTINGS_COUNT; i++) {
+        if (!(SETTINGS[i].flags & SETTING_KEEP_ON_RESET)) setDefault(SETTINGS[i]);
+    }
+}
+
+size_t settingsReadLegacy(Preferences& prefs)
+{
+    size_t found = 0;
+    for (size_t i = 0; i < SETTINGS_COUNT; i++) {
+        const SettingDesc& s = SETTINGS[i];
+        if (s.legacyKey == NULL) continue;
+        if (!prefs.isKey(s.legacyKey)) {
+            setDefault(s);
+            continue;
+        }
+        found++;
+        switch (s.type) {
+            case SETTING_BOOL:
+                *static_cast<bool*>(s.value) = prefs.getBool(s.legacyKey, s.def != 0);
+                break;
+            case SETTING_INT:
+                *static_cast<int*>(s.value) = prefs.getInt(s.legacyKey, (int)s.def);
+                break;
+            case SETTING_ULONG:
+                // putUInt() and putULong() both stored a u32
+                *static_cast<unsigned long*>(s.value) = prefs.getULong(s.legacyKey, (unsigned long)s.def);
+                break;
+            case SETTING_FLOAT:
+                *static_cast<float*>(s.value) = prefs.getFloat(s.legacyKey, s.def);
+                break;
+            case SETTING_STRING:
+                *static_cast<String*>(s.value) = prefs.getString(s.legacyKey, s.defText);
+                break;
+        }
+    }
+    return found;
+}
+
+size_t settingsRemoveLegacy(Preferences& prefs)
+{
+    size_t removed = 0;
+    for (size_t i = 0; i < SETTINGS_COUNT; i++) {
+        const char* key = SETTINGS[i].legacyKey;
+        if (key != NULL && prefs.isKey(key) && prefs.remove(key)) removed++;
+    }
+    return removed;
+}
+
+void settingsLog()
+{
+    for (size_t i = 0; i < SETTINGS_COUNT; i++) {
+        const SettingDesc& s = SETTINGS[i];
+        switch (s.type) {
+            case SETTING_BOOL:
+                LOG_DEBUG(SETTINGS, "%s: %d\n", s.name, *static_cast<bool*>(s.value));
+                break;
+            case SETTING_INT:
+                LOG_DEBUG(SETTINGS, "%s: %d\n", s.name, *static_cast<int*>(s.value));
+                break;
+            case SETTING_ULONG:
+                LOG_DEBUG(SETTINGS, "%s: %lu\n", s.name, *static_cast<unsigned long*>(s.value));
+                break;
+            case SETTING_FLOAT:
+                LOG_DEBUG(SETTINGS, "%s: %.2f\n", s.name, *static_cast<float*>(s.value));
+                break;
+            case SETTING_STRING: {
+                const String& v = *static_cast<String*>(s.value);
+                if (s.flags & SETTING_SECRET) {
+                    LOG_DEBUG(SETTINGS, "%s: %s\n", s.name, v.length() > 0 ? "[SET]" : "[NOT SET]");
+                } else if (v.length() > 64) {
+                    LOG_DEBUG(SETTINGS, "%s: (%u characters)\n", s.name, (unsigned)v.length());
+                } else {
+                    LOG_DEBUG(SETTINGS, "%s: %s\n", s.name, v.c_str());
+                }
+                break;
+            }
+        }
+    }
+}
+
+void printJsonString(Print& out, const char* text)
+{
+    static const char HEX_DIGITS[] = "0123456789abcdef";
+    out.print('"');
+    for (const char* p = text; *p; p++) {
+        char c = *p;
+        if (c == '"' || c == '\\') {
+            out.print('\\');
+            out.print(c);
+        } else if (c == '\n') {
+            out.print("\\n");
+        } else if ((unsigned char)c < 0x20) {
+            out.print("\\u00");
+            out.print(HEX_DIGITS[(unsigned char)c >> 4]);
+            out.print(HEX_DIGITS[c & 0x0F]);
+        } else {
+            out.print(c);
+        }
+    }
+    out.print('"');
+}
+
+void settingsWriteJson(Print& out)
+{
+    out.print('{');
+    for (size_t i = 0; i < SETTINGS_COUNT; i++) {
+        const SettingDesc& s = SETTINGS[i];
+        if (i) out.print(',');
+        out.printf("\"%s\":", s.name);
+        switch (s.type) {
+            case SETTING_BOOL:
+                out.print(*static_cast<bool*>(s.value) ? "true" : "false");
+                break;
+            case SETTING_INT:
+                out.printf("%d", *static_cast<int*>(s.value) / (int)s.scale);
+                break;
+            case SETTING_ULONG:
+                out.printf("%lu", *static_cast<unsigned long*>(s.value) / s.scale);
+                break;
+            case SETTING_FLOAT: {
+                float v = *static_cast<float*>(s.value);
+                if (isfinite(v)) out.printf("%g", v);
+                else out.print("null");
+                break;
+            }
+            case SETTING_STRING:
+                printJsonString(out, (s.flags & SETTING_SECRET) ? "" : static_cast<String*>(s.value)->c_str());
+                break;
+        }
+    }
+    out.print('}');
+}
+
+static inline void setBit(uint32_t* bits, size_t index)
+{
+    bits[index / 32] |= 1u << (index % 32);
+}
+
+static inline bool hasBit(const uint32_t* bits, size_t index)
+{
+    return (bits[index / 32] & (1u << (index % 32))) != 0;
+}
+
+void settingsFormBegin(SettingsForm& form)
+{
+    memset(&form, 0, sizeof(form));
+}
+
+bool settingsFormField(SettingsForm& form, const char* name, const char* value)
+{
+    const SettingDesc* setting = settingFind(name);
+    if (setting == NULL || setting->group == SETTING_GROUP_NONE) return false;
+    size_t index = setting - SETTINGS;
+    setBit(form.posted, index);
+    form.groups |= 1 << setting->group;
+    SettingResult result = settingSetText(setting, value);
+    if (result == SETTING_CHANGED) setBit(form.changed, index);
+    if (result == SETTING_REJECTED) form.rejected++;
+    return true;
+}
+
+bool settingsFormField(SettingsForm& form, const String& name, const String& value)
+{
+    return settingsFormField(form, name.c_str(), value.c_str());
+}
+
+void settingsFormEnd(SettingsForm& form)
+{
+    for (size_t i = 0; i < SETTINGS_COUNT; i++) {
+        const SettingDesc& s = SETTINGS[i];
+        if (!(s.flags & SETTING_CHECKBOX) || !(form.groups & (1 << s.group)) || hasBit(form.posted, i)) continue;
+        bool& value = *static_cast<bool*>(s.value);
+        if (value) {
+            value = false;
+            setBit(form.changed, i);
+        }
+    }
+}
+
+bool settingsFormChanged(const SettingsForm& form, const char* name)
+{
+    const SettingDesc* setting = lookup(name);
+    return setting != NULL && hasBit(form.changed, setting - SETTINGS);
+}
+
+bool settingsFormChangedFlag(const SettingsForm& form, uint8_t flag)
+{
+    for (size_t i = 0; i < SETTINGS_COUNT; i++) {
+        if ((SETTINGS[i].flags & flag) && hasBit(form.changed, i)) return true;
+    }
+    return false;
+}
+
+bool settingsFormPosted(const SettingsForm& form, SettingGroup group)
+{
+    return (form.groups & (1 << group)) != 0;
+}
@@ -0,0 +1,231 @@
+/*
+ * SettingsStore.cpp - Write-behind persistence of settings and schedule to NVS
+ *
+ * The shadow is an open-addressed table of (key hash, value fingerprint).
+ * Scalars are fingerprinted by their bits, strings by FNV-1a of their
+ * contents. It is only touched by the put helpers, which run under
+ * nvsSaveMutex; the dirty state has its own short-held lock because web
+ * handlers mark it from the async server task.
+ */
+
+#include "SettingsStore.h"
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "Log.h"
+#include "NvsWear.h"
+
+static const size_t SHADOW_SLOTS = 16;    // Power of two, > keys saved through settingsPut*()
+
+enum ValueKind { KIND_BOOL, KIND_INT, KIND_UINT, KIND_FLOAT, KIND_STRING };
+
+struct ShadowEntry {
+    uint32_t keyHash;
+    uint32_t value;
+    bool used;
+};
+
+static Preferences* store = NULL;
+static ShadowEntry shadow[SHADOW_SLOTS];
+
+static SemaphoreHandle_t dirtyMutex = NULL;
+static uint8_t dirty = 0;
+static uint8_t dirtyWriters = 0;    // NVS_WRITER_* behind the pending changes
+static uint32_t firstDirtyAt = 0;
+static uint32_t lastDirtyAt = 0;
+
+static SettingsStoreStats stats;
+
+static uint32_t fnv1a(const char* s)
+{
+    uint32_t h = 2166136261u;
+    while (*s) h = (h ^ (uint8_t)*s++) * 16777619u;
+    return h;
+}
+
+void settingsStoreBegin(Preferences& prefs)
+{
+    store = &prefs;
+    if (dirtyMutex == NULL) dirtyMutex = xSemaphoreCreateMutex();
+    if (dirtyMutex == NULL) {
+        LOG_ERROR(SETTINGS, "Failed to create settings store mutex!\n");
+    }
+}
+
+void settingsMarkDirty(uint8_t what, uint8_t writer)
+{
+    if (dirtyMutex == NULL || xSemaphoreTake(dirtyMutex, portMAX_DELAY) != pdTRUE) return;
+    uint32_t now = millis();
+    stats.requests++;
+    if (dirty == 0) {
+        firstDirtyAt = now;
+    } else {
+        stats.coalesced++;
+    }
+    dirty |= what;
+    dirtyWriters |= writer;
+    lastDirtyAt = now;
+    xSemaphoreGive(dirtyMutex);
+}
+
+uint8_t settingsFlushDue(uint32_t now, bool force)
+{
+    if (dirtyMutex == NULL || xSemaphoreTake(dirtyMutex, portMAX_DELAY) != pdTRUE) return 0;
+    uint8_t due = 0;
+    if (dirty != 0 && (force || now - lastDirtyAt >= SETTINGS_FLUSH_QUIET_MS ||
+                       now - firstDirtyAt >= SETTINGS_FLUSH_MAX_DELAY_MS)) {
+        due = dirty;
+    }
+    xSemaphoreGive(dirtyMutex);
+    return due;
+}
+
+void settingsFlushDone(uint8_t what, uint32_t startedAt)
+{
+    uint32_t now = millis();
+    if (dirtyMutex == NULL || xSemaphoreTake(dirtyMutex, portMAX_DELAY) != pdTRUE) return;
+    stats.flushes++;
+    if (now - startedAt > stats.durationMaxMs) stats.durationMaxMs = now - startedAt;
+    // A change marked after the save started may have missed it; stay dirty
+    if ((dirty & what) != 0 && (int32_t)(lastDirtyAt - startedAt) < 0) {
+        stats.latencyLastMs = now - firstDirtyAt;
+        if (stats.latencyLastMs > stats.latencyMaxMs) stats.latencyMaxMs = stats.latencyLastMs;
+        dirty &= ~what;
+        if (dirty == 0) dirtyWriters = 0;
+    }
+    xSemaphoreGive(dirtyMutex);
+}
+
+uint8_t settingsDirtyWriters()
+{
+    if (dirtyMutex == NULL || xSemaphoreTake(dirtyMutex, portMAX_DELAY) != pdTRUE) return 0;
+    uint8_t writers = dirtyWriters;
+    xSemaphoreGive(dirtyMutex);
+    return writers;
+}
+
+// Slot for the key: its own entry, or the empty one where it goes. NULL if
+// the table is full, in which case the key is always written.
+static ShadowEntry* findEntry(uint32_t keyHash)
+{
+    for (size_t i = 0; i < SHADOW_SLOTS; i++) {
+        ShadowEntry& entry = shadow[(keyHash + i) & (SHADOW_SLOTS - 1)];
+        if (!entry.used || entry.keyHash == keyHash) return &entry;
+    }
+    return NULL;
+}
+
+// Fingerprint of what NVS holds for the key now
+static bool storedFingerprint(const char* key, ValueKind kind, uint32_t& out)
+{
+    if (!store->isKey(key)) return false;
+    switch (kind) {
+        case KIND_BOOL:   out = store->getBool(key) ? 1 : 0; break;
+        case KIND_INT:    out = (uint32_t)store->getInt(key); break;
+        case KIND_UINT:   out = store->getUInt(key); break;
+        case KIND_FLOAT: {
+            float value = store->getFloat(key);
+            memcpy(&out, &value, sizeof(out));
+            break;
+        }
+        case KIND_STRING: out = fnv1a(store->getString(key).c_str()); break;
+    }
+    return true;
+}
+
+// True if the key needs writing; `entry` is where to record the new value
+static bool changed(const char* key, ValueKind kind, uint32_t fingerprint, ShadowEntry*& entry)
+{
+    uint32_t keyHash = fnv1a(key);
+    entry = findEntry(keyHash);
+    if (entry != NULL && !entry->used) {
+        uint32_t stored;
+        if (storedFingerprint(key, kind, stored)) {
+            entry->keyHash = keyHash;
+            entry->value = stored;
+            entry->used = true;
+        }
+    }
+    if (entry != NULL && entry->used && entry->value == fingerprint) {
+        stats.keysUnchanged++;
+        return false;
+    }
+    return true;
+}
+
+static bool written(ShadowEntry* entry, const char* key, uint32_t fingerprint, bool ok,
+                    NvsValueType type = NVS_TYPE_SCALAR, size_t bytes = 4)
+{
+    if (!ok) {
+        LOG_ERROR(SETTINGS, "NVS write of \"%s\" failed\n", key);
+        return false;
+    }
+    stats.keysWritten++;
+    nvsWearRecord(key, type, bytes);
+    if (entry != NULL) {
+        entry->keyHash = fnv1a(key);
+        entry->value = fingerprint;
+        entry->used = true;
+    }
+    return true;
+}
+
+bool settingsPutBool(const char* key, bool value)
+{
+    ShadowEntry* entry;
+    uint32_t fingerprint = value ? 1 : 0;
+    if (!changed(key, KIND_BOOL, fingerprint, entry)) return false;
+    return written(entry, key, fingerprint, store->putBool(key, value) > 0, NVS_TYPE_SCALAR, 1);
+}
+
+bool settingsPutInt(const char* key, int32_t value)
+{
+    ShadowEntry* entry;
+    uint32_t fingerprint = (uint32_t)value;
+    if (!changed(key, KIND_INT, fingerprint, entry)) return false;
+    return written(entry, key, fingerprint, store->putInt(key, value) > 0);
+}
+
+bool settingsPutUInt(const char* key, uint32_t value)
+{
+    ShadowEntry* entry;
+    if (!changed(key, KIND_UINT, value, entry)) return false;
+    return written(entry, key, value, store->putUInt(key, value) > 0);
+}
+
+// ULong and UInt are the same 32-bit NVS type on the ESP32
+bool settingsPutULong(const char* key, uint32_t value)
+{
+    ShadowEntry* entry;
+    if (!changed(key, KIND_UINT, value, entry)) return false;
+    return written(entry, key, value, store->putULong(key, value) > 0);
+}
+
+bool settingsPutFloat(const char* key, float value)
+{
+    ShadowEntry* entry;
+    uint32_t fingerprint;
+    memcpy(&fingerprint, &value, sizeof(fingerprint));
+    if (!changed(key, KIND_FLOAT, fingerprint, entry)) return false;
+    return written(entry, key, fingerprint, store->putFloat(key, value) > 0);
+}
+
+bool settingsPutString(const char* key, const String& value)
+{
+    ShadowEntry* entry;
+    uint32_t fingerprint = fnv1a(value.c_str());
+    if (!changed(key, KIND_STRING, fingerprint, entry)) return false;
+    // putString() returns the length written, so 0 for "" even on success
+    return written(entry, key, fingerprint, store->putString(key, value) > 0 || value.length() == 0,
+                   NVS_TYPE_STRING, value.length());
+}
+
+void settingsStoreGetStats(SettingsStoreStats& out)
+{
+    if (dirtyMutex == NULL || xSemaphoreTake(dirtyMutex, portMAX_DELAY) != pdTRUE) {
+        memset(&out, 0, sizeof(out));
+        return;
+    }
+    out = stats;
+    xSemaphoreGive(dirtyMutex);
+}
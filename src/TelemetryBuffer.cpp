@@ -0,0 +1,137 @@
+/*
+ * TelemetryBuffer.cpp - Store-and-forward history for MQTT outages
+ *
+ * Flash holds the older part of the backlog and RAM the newer part, so
+ * replay reads flash first. The flash ring is addressed in records; a
+ * sector is erased when the write position enters it, dropping any unsent
+ * records still in it. Each boot starts at a random sector to spread wear.
+ */
+
+#include "TelemetryBuffer.h"
+#include <string.h>
+#include <esp_partition.h>
+#include <esp_system.h>
+#include "Log.h"
+
+static const size_t SECTOR_SIZE = 4096;
+static const uint32_t SECTOR_RECORDS = SECTOR_SIZE / sizeof(TelemetrySample);
+
+static_assert(sizeof(TelemetrySample) == 16, "flash records must tile a sector");
+
+static TelemetrySample ram[TELEMETRY_RAM_SAMPLES];
+static uint32_t ramHead = 0;
+static uint32_t ramCount = 0;
+
+static const esp_partition_t* partition = NULL;
+static bool spill = false;
+static uint32_t flashCapacity = 0;   // Records
+static uint32_t flashHead = 0;       // Oldest record
+static uint32_t flashCount = 0;
+
+static TelemetryStats stats;
+
+void telemetrySetSpill(bool enabled)
+{
+    if (enabled && partition == NULL) {
+        partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS, NULL);
+        if (partition == NULL) {
+            LOG_WARN(MQTT, "History: no spiffs partition, keeping %u samples in RAM only\n",
+                     (unsigned)TELEMETRY_RAM_SAMPLES);
+            return;
+        }
+        uint32_t sectors = partition->size / SECTOR_SIZE;
+        flashCapacity = sectors * SECTOR_RECORDS;
+        flashHead = (esp_random() % sectors) * SECTOR_RECORDS;
+        LOG_INFO(MQTT, "History: spilling to flash, %lu samples\n", (unsigned long)flashCapacity);
+    }
+    spill = enabled && partition != NULL;
+}
+
+static bool flashAppend(const TelemetrySample& sample)
+{
+    uint32_t pos = (flashHead + flashCount) % flashCapacity;
+    if (pos % SECTOR_RECORDS == 0) {
+        // Make room for the whole sector, oldest records first
+        uint32_t free = flashCapacity - flashCount;
+        if (free < SECTOR_RECORDS) {
+            uint32_t lost = SECTOR_RECORDS - free;
+            flashHead = (flashHead + lost) % flashCapacity;
+            flashCount -= lost;
+            stats.dropped += lost;
+        }
+        if (esp_partition_erase_range(partition, pos * sizeof(TelemetrySample), SECTOR_SIZE) != ESP_OK) {
+            LOG_ERROR(MQTT, "History: flash erase failed at sector %lu\n", (unsigned long)(pos / SECTOR_RECORDS));
+            return false;
+        }
+        stats.sectorErases++;
+    }
+    if (esp_partition_write(partition, pos * sizeof(TelemetrySample), &sample, sizeof(sample)) != ESP_OK) {
+        LOG_ERROR(MQTT, "History: flash write failed\n");
+        return false;
+    }
+    flashCount++;
+    return true;
+}
+
+// Move the oldest RAM samples to flash; false if nothing could be moved
+static bool spillBatch()
+{
+    if (!spill) return false;
+    uint32_t moved = 0;
+    while (moved < TELEMETRY_SPILL_BATCH && ramCount > 0) {
+        if (!flashAppend(ram[ramHead])) break;
+        ramHead = (ramHead + 1) % TELEMETRY_RAM_SAMPLES;
+        ramCount--;
+        moved++;
+    }
+    return moved > 0;
+}
+
+void telemetryPush(const TelemetrySample& sample)
+{
+    if (ramCount == TELEMETRY_RAM_SAMPLES && !spillBatch()) {
+        ramHead = (ramHead + 1) % TELEMETRY_RAM_SAMPLES;
+        ramCount--;
+        stats.dropped++;
+    }
+    ram[(ramHead + ramCount) % TELEMETRY_RAM_SAMPLES] = sample;
+    ramCount++;
+    stats.recorded++;
+}
+
+bool telemetryPeek(TelemetrySample& out)
+{
+    if (flashCount > 0) {
+        if (esp_partition_read(partition, flashHead * sizeof(TelemetrySample), &out, sizeof(out)) == ESP_OK) {
+            return true;
+        }
+        LOG_ERROR(MQTT, "History: flash read failed, dropping flash backlog\n");
+        stats.dropped += flashCount;
+        flashCount = 0;
+    }
+    if (ramCount == 0) return false;
+    out = ram[ramHead];
+    return true;
+}
+
+void telemetryPop()
+{
+    if (flashCount > 0) {
+        flashHead = (flashHead + 1) % flashCapacity;
+        flashCount--;
+    } else if (ramCount > 0) {
+        ramHead = (ramHead + 1) % TELEMETRY_RAM_SAMPLES;
+        ramCount--;
+    } else {
+        return;
+    }
+    stats.replayed++;
+}
+
+void telemetryGetStats(TelemetryStats& out)
+{
+    out = stats;
+    out.ramSamples = ramCount;
+    out.flashSamples = flashCount;
+    out.flashCapacity = spill ? flashCapacity : 0;
+}
@@ -0,0 +1,745 @@
+let currentTab = 'status';
+let updateInterval;
+let state = null; // Last full GET /api/state document
+
+function showTab(tabName) {
+    // Hide all tab contents
+    const contents = document.querySelectorAll('.tab-content');
+    contents.forEach(content => {
+        content.classList.remove('active');
+        content.classList.remove('fade-in');
+    });
+
+    // Remove active class from all tabs
+    const tabs = document.querySelectorAll('.nav-tab');
+    tabs.forEach(tab => tab.classList.remove('active'));
+
+    // Show selected tab content
+    const selectedContent = document.getElementById(tabName + '-content');
+    if (selectedContent) {
+        selectedContent.classList.add('active');
+        selectedContent.classList.add('fade-in');
+    }
+
+    // Add active class to selected tab
+    const selectedTab = document.querySelector(".nav-tab[data-tab='" + tabName + "']");
+    if (selectedTab) {
+        selectedTab.classList.add('active');
+    }
+
+    currentTab = tabName;
+
+    // Handle auto-refresh for status tab
+    if (tabName === 'status') {
+        startAutoRefresh();
+    } else {
+        stopAutoRefresh();
+    }
+}
+
+function startAutoRefresh() {
+    stopAutoRefresh();
+    updateInterval = setInterval(() => {
+        if (currentTab === 'status') {
+            refreshStatus();
+        }
+    }, 10000);
+}
+
+function stopAutoRefresh() {
+    if (updateInterval) {
+        clearInterval(updateInterval);
+    }
+}
+
+// Format uptime in human-readable format
+function formatUptime(ms) {
+    let seconds = Math.floor(ms / 1000);
+    let minutes = Math.floor(seconds / 60);
+    let hours = Math.floor(minutes / 60);
+    const days = Math.floor(hours / 24);
+    seconds %= 60;
+    minutes %= 60;
+    hours %= 24;
+
+    let uptime = '';
+    if (days > 0) uptime += days + 'd ';
+    if (hours > 0 || days > 0) uptime += hours + 'h ';
+    if (minutes > 0 || hours > 0 || days > 0) uptime += minutes + 'm ';
+    return uptime + seconds + 's';
+}
+
+function formatNumber(value, digits) {
+    return value === null || value === undefined ? '--' : Number(value).toFixed(digits);
+}
+
+// Full document: settings, schedule and system info as well as live values
+function loadState() {
+    return fetch('/api/state?ts=' + Date.now(), { cache: 'no-store' })
+    .then(response => {
+        if (!response.ok) throw new Error('HTTP ' + response.status);
+        return response.json();
+    })
+    .then(renderState)
+    .catch(error => {
+        console.error('State load error:', error);
+    });
+}
+
+// Status tab refresh: only the "live" part of the document
+function refreshStatus() {
+    if (!state) {
+        loadState();
+        return;
+    }
+    const statusCards = document.querySelectorAll('.status-card');
+    statusCards.forEach(card => card.style.opacity = '0.7');
+
+    fetch('/api/state?live=1&ts=' + Date.now(), { cache: 'no-store' })
+    .then(response => {
+        if (!response.ok) throw new Error('HTTP ' + response.status);
+        return response.json();
+    })
+    .then(data => {
+        state.live = data.live;
+        renderLive();
+    })
+    .catch(error => {
+        console.error('Status refresh error:', error);
+    })
+    .finally(() => {
+        statusCards.forEach(card => card.style.opacity = '1');
+    });
+}
+
+function renderState(data) {
+    state = data;
+    const settings = data.settings;
+
+    document.querySelectorAll('[data-state]').forEach(el => {
+        const path = el.dataset.state.split('.');
+        const value = data[path[0]] ? data[path[0]][path[1]] : undefined;
+        el.textContent = value === undefined || value === null ? '' : value;
+    });
+    document.getElementById('system-uptime').textContent = formatUptime(data.system.uptime);
+    if (data.system.configReadOnly) {
+        showAlert('Settings are read-only: the stored configuration is from newer firmware. ' +
+                  'Changes will not be saved until it is reinstalled or the thermostat is factory reset.', 'error');
+    }
+
+    fillForm(document.getElementById('settings-form'), settings);
+    fillForm(document.getElementById('weather-form'), settings);
+    updateWeatherFields(String(settings.weatherSource));
+    applyRelayConflicts();
+    renderSchedule();
+    renderLive();
+}
+
+function setRelay(id, visible, name, on, onText, offText) {
+    const row = document.getElementById(id);
+    row.hidden = !visible;
+    row.classList.toggle('active', !!on);
+    if (name) row.querySelector('.relay-name').textContent = name;
+    const indicator = row.querySelector('.status-indicator');
+    indicator.className = 'status-indicator ' + (on ? 'status-on' : 'status-off');
+    indicator.textContent = on ? onText : offText;
+}
+
+function renderLive() {
+    const live = state.live;
+    const settings = state.settings;
+
+    document.querySelectorAll('.unit-letter').forEach(el => el.textContent = settings.useFahrenheit ? 'F' : 'C');
+    document.getElementById('current-temp-value').textContent = formatNumber(live.temp, 1);
+    document.getElementById('current-humidity-value').textContent = formatNumber(live.humidity, 1);
+
+    const modeIndicator = document.getElementById('thermostat-mode-indicator');
+    const mode = String(live.mode).toLowerCase();
+    modeIndicator.textContent = mode;
+    modeIndicator.classList.remove('status-on', 'status-off', 'status-auto');
+    if (mode === 'off') modeIndicator.classList.add('status-off');
+    else if (mode === 'auto') modeIndicator.classList.add('status-auto');
+    else modeIndicator.classList.add('status-on');
+    document.getElementById('fan-mode-value').textContent = live.fanMode;
+
+    // EU dehumidification status card
+    document.getElementById('eu-card').hidden = !(settings.thermostatRegion === 'EU' && settings.euHumidityControlEnabled);
+    const euDemand = document.getElementById('eu-demand');
+    euDemand.className = 'status-indicator ' + (live.euDemand ? 'status-on' : 'status-off');
+    euDemand.textContent = live.euDemand ? 'Active' : 'Standby';
+    document.getElementById('eu-setpoint').textContent = formatNumber(settings.euHumiditySetpoint, 1);
+
+    // Hydronic temperature (if enabled)
+    document.getElementById('hydronic-card').hidden = !settings.hydronicHeatingEnabled;
+    document.getElementById('hydronic-supply').textContent = formatNumber(live.supply, 1);
+    document.getElementById('hydronic-return').textContent = formatNumber(live.return, 1);
+
+    // Weather card (if enabled and valid)
+    const weather = live.weather;
+    document.getElementById('weather-card').hidden = !(settings.weatherSource !== 0 && weather.valid);
+    document.getElementById('weather-temp').textContent = formatNumber(weather.temp, 1);
+    document.getElementById('weather-desc').textContent = weather.desc;
+    document.getElementById('weather-range').hidden = !(weather.high || weather.low);
+    document.getElementById('weather-high').textContent = formatNumber(weather.high, 0);
+    document.getElementById('weather-low').textContent = formatNumber(weather.low, 0);
+
+    // Heat Stage 2 row is the reversing valve on heat pumps, hidden if neither
+    const relays = live.relays;
+    setRelay('relay-heat1', true, null, relays.heat1, 'ON', 'OFF');
+    if (settings.reversingValveEnabled) {
+        setRelay('relay-heat2', true, 'Reversing Valve', relays.heat2, 'HEAT', 'COOL');
+    } else {
+        setRelay('relay-heat2', settings.stage2HeatingEnabled, 'Heat Stage 2', relays.heat2, 'ON', 'OFF');
+    }
+    setRelay('relay-cool1', true, null, relays.cool1, 'ON', 'OFF');
+    setRelay('relay-cool2', settings.stage2CoolingEnabled, null, relays.cool2, 'ON', 'OFF');
+    setRelay('relay-fan', true, null, relays.fan, 'ON', 'OFF');
+
+    let scheduleText = 'Schedule Disabled';
+    if (settings.scheduleEnabled) {
+        scheduleText = 'Schedule Active - ' + live.period + (live.override ? ' (Override Active)' : '');
+    }
+    document.getElementById('schedule-current').textContent = scheduleText;
+}
+
+// Form fields are named after their settings. Secrets come back empty and
+// are only sent once the user types a new one.
+function fillForm(form, values) {
+    for (const el of form.elements) {
+        if (!el.name || !(el.name in values)) continue;
+        const value = values[el.name];
+        if (el.type === 'checkbox') el.checked = !!value;
+        else el.value = value === null ? '' : value;
+        delete el.dataset.edited;
+    }
+}
+
+function formSettings(form) {
+    const settings = {};
+    for (const el of form.elements) {
+        if (!el.name) continue;
+        if ('secret' in el.dataset && !el.dataset.edited) continue;
+        if (el.type === 'checkbox') settings[el.name] = el.checked;
+        else if (el.type === 'number') { if (el.value !== '') settings[el.name] = Number(el.value); }
+        else settings[el.name] = el.value;
+    }
+    return settings;
+}
+
+// Resolves with the reply on success; reloads the state either way, so the
+// page shows what the thermostat kept
+function postState(body) {
+    return fetch('/api/state', {
+        method: 'POST',
+        headers: { 'Content-Type': 'application/json' },
+        body: JSON.stringify(body)
+    })
+    .then(response => response.json())
+    .then(data => {
+        if (data.status !== 'success') throw new Error(data.message || 'Unknown error');
+        return data;
+    })
+    .finally(loadState);
+}
+
+const DAY_NAMES = ['Sunday', 'Monday', 'Tuesday', 'Wednesday', 'Thursday', 'Friday', 'Saturday'];
+
+function schedulePeriodCells(prefix, period) {
+    const name = prefix + period + '_';
+    return "<div class='schedule-cell'><input type='time' name='" + name + "time' class='form-input time-input'></div>" +
+        "<div class='schedule-cell'><div class='temp-inputs'>" +
+        "<label class='temp-label'>Heat:</label><input type='number' name='" + name + "heat' step='0.5' min='40' max='90' class='form-input temp-input'>" +
+        "<label class='temp-label'>Cool:</label><input type='number' name='" + name + "cool' step='0.5' min='50' max='95' class='form-input temp-input'>" +
+        "<label class='temp-label'>Auto:</label><input type='number' name='" + name + "auto' step='0.5' min='45' max='90' class='form-input temp-input'>" +
+        "</div></div>";
+}
+
+function buildScheduleTable() {
+    const table = document.getElementById('schedule-table');
+    DAY_NAMES.forEach((dayName, day) => {
+        const prefix = 'day' + day + '_';
+        const row = document.createElement('div');
+        row.className = 'schedule-row';
+        row.innerHTML = "<div class='schedule-cell'><strong>" + dayName + "</strong></div>" +
+            "<div class='schedule-cell'><label class='toggle-switch small'>" +
+            "<input type='checkbox' name='" + prefix + "enabled'><span class='toggle-slider'></span></label></div>" +
+            schedulePeriodCells(prefix, 'day') + schedulePeriodCells(prefix, 'night');
+        const enabled = row.querySelector("input[type='checkbox']");
+        enabled.addEventListener('change', () => setScheduleRowEnabled(row, enabled.checked));
+        table.appendChild(row);
+    });
+}
+
+function setScheduleRowEnabled(row, enabled) {
+    row.querySelectorAll('.time-input, .temp-input').forEach(input => input.disabled = !enabled);
+}
+
+function pad2(n) {
+    return (n < 10 ? '0' : '') + n;
+}
+
+function renderSchedule() {
+    const form = document.getElementById('schedule-form');
+    const settings = state.settings;
+    form.elements.scheduleEnabled.checked = settings.scheduleEnabled;
+    form.elements.scheduleOverride.value = settings.scheduleOverride ? 'temporary' : 'resume';
+    delete form.elements.scheduleOverride.dataset.edited;
+
+    const rows = document.querySelectorAll('#schedule-table .schedule-row:not(.schedule-header)');
+    state.schedule.forEach((entry, day) => {
+        const field = name => form.elements['day' + day + '_' + name];
+        field('enabled').checked = entry.enabled;
+        ['day', 'night'].forEach(period => {
+            const p = entry[period];
+            field(period + '_time').value = pad2(p.hour) + ':' + pad2(p.minute);
+            field(period + '_heat').value = formatNumber(p.heat, 1);
+            field(period + '_cool').value = formatNumber(p.cool, 1);
+            field(period + '_auto').value = formatNumber(p.auto, 1);
+        });
+        setScheduleRowEnabled(rows[day], entry.enabled);
+    });
+}
+
+function numberOrNull(value) {
+    return value === '' ? null : Number(value);
+}
+
+function scheduleFromForm(form) {
+    const body = { scheduleEnabled: form.elements.scheduleEnabled.checked, schedule: [] };
+    // Sending the override resets its timer, so only when it was changed
+    if (form.elements.scheduleOverride.dataset.edited) {
+        body.scheduleOverride = form.elements.scheduleOverride.value;
+    }
+    for (let day = 0; day < 7; day++) {
+        const field = name => form.elements['day' + day + '_' + name];
+        const entry = { enabled: field('enabled').checked };
+        ['day', 'night'].forEach(period => {
+            const time = field(period + '_time').value.split(':');
+            entry[period] = {
+                hour: time.length === 2 ? Number(time[0]) : null,
+                minute: time.length === 2 ? Number(time[1]) : null,
+                heat: numberOrNull(field(period + '_heat').value),
+                cool: numberOrNull(field(period + '_cool').value),
+                auto: numberOrNull(field(period + '_auto').value)
+            };
+        });
+        body.schedule.push(entry);
+    }
+    return body;
+}
+
+function confirmAction(actionName, actionUrl) {
+    if (confirm("Are you sure you want to " + actionName + "?")) {
+        window.location.href = actionUrl;
+    }
+}
+
+function showAlert(message, type) {
+    if (typeof type === 'undefined') type = 'success';
+    const alertDiv = document.createElement('div');
+    alertDiv.className = 'alert alert-' + type;
+    alertDiv.textContent = message;
+
+    const container = document.querySelector('.container');
+    container.insertBefore(alertDiv, container.firstChild);
+
+    setTimeout(() => {
+        alertDiv.remove();
+    }, 5000);
+}
+
+function handleSettingsSubmit(event) {
+    event.preventDefault();
+
+    const form = event.target;
+    const submitBtn = form.querySelector('input[type="submit"]');
+
+    // Show loading state
+    const originalValue = submitBtn.value;
+    submitBtn.value = 'Saving...';
+    submitBtn.disabled = true;
+
+    postState({ settings: formSettings(form) })
+    .then(data => {
+        showAlert(data.message, 'success');
+    })
+    .catch(error => {
+        showAlert('Error saving settings: ' + error.message, 'error');
+    })
+    .finally(() => {
+        // Restore button state
+        submitBtn.value = originalValue;
+        submitBtn.disabled = false;
+    });
+
+    return false;
+}
+
+function handleScheduleSubmit(event) {
+    event.preventDefault();
+
+    const form = event.target;
+    const submitBtn = form.querySelector('button[type="submit"]');
+    const statusDiv = document.getElementById('schedule-status');
+
+    // Show loading state
+    const originalText = submitBtn.textContent;
+    submitBtn.textContent = 'Saving...';
+    submitBtn.disabled = true;
+
+    postState(scheduleFromForm(form))
+    .then(data => {
+        statusDiv.style.display = 'block';
+        statusDiv.style.backgroundColor = '#E8F5E9';
+        statusDiv.style.color = '#2E7D32';
+        statusDiv.textContent = '✓ ' + data.message;
+        setTimeout(() => {
+            statusDiv.style.display = 'none';
+        }, 5000);
+    })
+    .catch(error => {
+        statusDiv.style.display = 'block';
+        statusDiv.style.backgroundColor = '#FFEBEE';
+        statusDiv.style.color = '#C62828';
+        statusDiv.textContent = '✗ Error saving schedule: ' + error.message;
+    })
+    .finally(() => {
+        // Restore button state
+        submitBtn.textContent = originalText;
+        submitBtn.disabled = false;
+    });
+
+    return false;
+}
+
+// Initialize the interface when page loads
+document.addEventListener('DOMContentLoaded', function() {
+    buildScheduleTable();
+
+    // Secrets and the schedule override are only sent once touched
+    document.querySelectorAll('form').forEach(form => {
+        form.addEventListener('input', e => { e.target.dataset.edited = '1'; });
+        form.addEventListener('change', e => { e.target.dataset.edited = '1'; });
+    });
+
+    // Check URL parameters for tab switching
+    const urlParams = new URLSearchParams(window.location.search);
+    const tabParam = urlParams.get('tab');
+    const initialTab = tabParam && ['status', 'settings', 'schedule', 'weather', 'system'].includes(tabParam) ? tabParam : 'status';
+    showTab(initialTab);
+    loadState();
+});
+
+// Weather source toggle function
+function updateWeatherFields(source) {
+    const owmSettings = document.getElementById('owm-settings');
+    const haSettings = document.getElementById('ha-settings');
+
+    if (source == '1') {
+        owmSettings.style.display = 'block';
+        haSettings.style.display = 'none';
+    } else if (source == '2') {
+        owmSettings.style.display = 'none';
+        haSettings.style.display = 'block';
+    } else {
+        owmSettings.style.display = 'none';
+        haSettings.style.display = 'none';
+    }
+}
+
+// Handle weather form submission
+document.addEventListener('DOMContentLoaded', function() {
+    const weatherForm = document.getElementById('weather-form');
+    if (weatherForm) {
+        weatherForm.addEventListener('submit', function(e) {
+            e.preventDefault();
+            postState({ settings: formSettings(weatherForm) })
+            .then(data => {
+                // Show success message
+                alert('Weather settings saved successfully!');
+            })
+            .catch(error => {
+                console.error('Error:', error);
+                alert('Failed to save weather settings: ' + error.message);
+            });
+        });
+    }
+});
+
+// Force weather update
+function forceWeatherUpdate() {
+    fetch('/weather_refresh', {
+        method: 'POST',
+        headers: {
+            'Content-Type': 'application/json',
+        }
+    })
+    .then(response => response.text())
+    .then(data => {
+        alert('Weather update triggered! Checking for new data...');
+    })
+    .catch(error => {
+        console.error('Error:', error);
+        alert('Failed to trigger weather update');
+    });
+}
+
+// Handle page visibility for auto-refresh
+document.addEventListener('visibilitychange', function() {
+    if (document.hidden) {
+        stopAutoRefresh();
+    } else if (currentTab === 'status') {
+        startAutoRefresh();
+    }
+});
+
+// Relay conflicts: stage 2 heating and the reversing valve share the H2 relay,
+// and backup heat or EU dehumidification may claim a stage 2 relay
+function applyRelayConflicts() {
+    const stage2Heat = document.getElementById('stage2HeatingEnabled');
+    const revValve = document.getElementById('reversingValveEnabled');
+    const stage2Cool = document.getElementById('stage2CoolingEnabled');
+    const backupHeat = document.getElementById('backupHeatEnabled');
+    const backupRelay = document.getElementById('backupHeatRelay');
+    const regionMode = document.getElementById('thermostatRegion');
+    const euHumidityWrap = document.getElementById('euHumiditySettings');
+    const euHumidityEn = document.getElementById('euHumidityControlEnabled');
+    const euHumidityRelay = document.getElementById('euHumidityRelay');
+
+    euHumidityWrap.style.display = regionMode.value === 'EU' ? '' : 'none';
+    if (stage2Heat.checked && revValve.checked) {
+        revValve.checked = false;
+    }
+    if (backupHeat.checked && backupRelay.value === '1') {
+        stage2Heat.checked = false;
+        revValve.checked = false;
+    }
+    if (backupHeat.checked && backupRelay.value === '2') {
+        stage2Cool.checked = false;
+    }
+    if (regionMode.value === 'EU' && euHumidityEn.checked && euHumidityRelay.value === '1') {
+        stage2Cool.checked = false;
+    }
+}
+
+document.addEventListener('DOMContentLoaded', function() {
+    ['stage2HeatingEnabled', 'reversingValveEnabled', 'stage2CoolingEnabled', 'backupHeatEnabled',
+     'backupHeatRelay', 'thermostatRegion', 'euHumidityControlEnabled', 'euHumidityRelay'].forEach(id => {
+        document.getElementById(id).addEventListener('change', applyRelayConflicts);
+    });
+});
+
+// Firmware upload with progress, then wait for the device to come back
+document.addEventListener('DOMContentLoaded', function() {
+    const file = document.getElementById('otaFile');
+    const btn = document.getElementById('otaStart');
+    const selected = document.getElementById('otaSelected');
+    const prog = document.getElementById('otaProgress');
+    const bar = document.getElementById('otaBar');
+    const eta = document.getElementById('otaEta');
+    const status = document.getElementById('otaStatus');
+    let poll = null;
+    let armed = false;
+    let rebootCheckTimer = null;
+    let rebootVerificationStarted = false;
+
+    function setStatus(ok, msg) {
+        status.style.display = 'block';
+        status.style.background = ok ? '#1b5e20' : '#b71c1c';
+        status.style.color = '#fff';
+        status.textContent = msg;
+    }
+    function human(ms) {
+        if (ms < 1000) return ms + ' ms';
+        let s = ms / 1000;
+        if (s < 60) return s.toFixed(1) + ' s';
+        let m = s / 60;
+        return m.toFixed(1) + ' m';
+    }
+    function otaSuccessText(j) {
+        return '✓ Update successful! Version ' + j.version + ' • ' + (j.device_datetime || 'Time not set');
+    }
+    function resetSelection(msg) {
+        file.value = '';
+        armed = false;
+        btn.disabled = true;
+        selected.textContent = msg || 'No file selected';
+    }
+    function stopPoll() {
+        if (poll) {
+            clearInterval(poll);
+            poll = null;
+        }
+    }
+    function startRebootVerification() {
+        if (rebootVerificationStarted) return;
+        rebootVerificationStarted = true;
+        eta.textContent = 'Waiting for reboot and startup (up to 70s)...';
+        setTimeout(() => {
+            const begin = Date.now();
+            rebootCheckTimer = setInterval(() => {
+                fetch('/version').then(r => r.json()).then(j => {
+                    setStatus(true, otaSuccessText(j));
+                    eta.textContent = 'Device ready. Redirecting to Status...';
+                    if (rebootCheckTimer) { clearInterval(rebootCheckTimer); rebootCheckTimer = null; }
+                    resetSelection();
+                    setTimeout(() => { window.location.href = '/?tab=status&r=' + Date.now(); }, 1200);
+                }).catch(() => {
+                    if (Date.now() - begin > 70000) {
+                        setStatus(false, 'Device did not return in 70s');
+                        eta.textContent = 'Timeout.';
+                        if (rebootCheckTimer) { clearInterval(rebootCheckTimer); rebootCheckTimer = null; }
+                        resetSelection('Select a new .bin file');
+                    }
+                });
+            }, 2500);
+        }, 3000);
+    }
+
+    file.addEventListener('change', () => {
+        if (!file.files.length) { resetSelection(); return; }
+        const f = file.files[0];
+        if (!f.name.toLowerCase().endsWith('.bin')) {
+            resetSelection('Invalid file: select a .bin');
+            alert('Select a .bin file');
+            return;
+        }
+        armed = true;
+        btn.disabled = false;
+        selected.textContent = 'Selected: ' + f.name + ' (' + Math.round(f.size / 1024) + ' KB)';
+    });
+
+    btn.addEventListener('click', () => {
+        if (!armed || !file.files.length) { alert('Select a .bin file'); return; }
+        const f = file.files[0];
+        if (!f.name.toLowerCase().endsWith('.bin')) { alert('Select a .bin file'); return; }
+        armed = false;
+        btn.disabled = true;
+        prog.style.display = 'block';
+        status.style.display = 'none';
+        eta.textContent = 'Starting...';
+        bar.textContent = '0%';
+        bar.style.width = '0%';
+        let started = Date.now();
+        let fallbackStarted = false;
+        let lastPct = 0;
+        let uploadLikelyComplete = false;
+        rebootVerificationStarted = false;
+
+        // No upload progress events: follow the flash write on the device instead
+        const fallbackTimer = setTimeout(() => {
+            if (bar.style.width === '0%' && !fallbackStarted) {
+                fallbackStarted = true;
+                eta.textContent = 'Upload complete, writing to flash...';
+                poll = setInterval(() => {
+                    fetch('/update_status').then(r => r.json()).then(j => {
+                        if (j.state === 'writing' && j.total > 0) {
+                            let pct = Math.round((j.bytes / j.total) * 100);
+                            if (pct > 100) pct = 100;
+                            if (pct > lastPct) {
+                                bar.style.width = pct + '%';
+                                bar.textContent = pct + '%';
+                                lastPct = pct;
+                                eta.textContent = 'Writing firmware to flash: ' + pct + '%';
+                            }
+                        } else if (j.state === 'rebooting') {
+                            uploadLikelyComplete = true;
+                            setStatus(true, 'Firmware written. Rebooting...');
+                            eta.textContent = 'Waiting for restart...';
+                            stopPoll();
+                        }
+                    }).catch(() => {});
+                }, 800);
+            }
+        }, 2500);
+
+        const xhr = new XMLHttpRequest();
+        xhr.open('POST', '/update');
+        const fd = new FormData();
+        fd.append('firmware', f);
+        xhr.upload.onprogress = (e) => {
+            if (e.lengthComputable) {
+                const p = Math.round(e.loaded / e.total * 100);
+                bar.style.width = p + '%';
+                bar.textContent = p + '%';
+                const elapsed = Date.now() - started;
+                const rate = e.loaded / (elapsed / 1000);
+                if (rate > 0) {
+                    const remain = (e.total - e.loaded) / rate * 1000;
+                    eta.textContent = 'Uploading: ' + human(remain) + ' remaining';
+                }
+                if (p >= 99) {
+                    uploadLikelyComplete = true;
+                    eta.textContent = 'Upload complete, writing to flash...';
+                }
+                if (p > 0) stopPoll();
+            }
+        };
+        xhr.onload = () => {
+            clearTimeout(fallbackTimer);
+            if (xhr.status == 200) {
+                uploadLikelyComplete = true;
+                setStatus(true, 'Flash complete. Device rebooting...');
+                bar.style.width = '100%';
+                bar.textContent = '100%';
+                stopPoll();
+                startRebootVerification();
+            } else if (xhr.status === 0 && uploadLikelyComplete) {
+                setStatus(true, 'Upload completed. Waiting for reboot...');
+                stopPoll();
+                startRebootVerification();
+            } else {
+                setStatus(false, 'Update failed: ' + (xhr.responseText || ('HTTP ' + xhr.status)));
+                eta.textContent = 'Error.';
+                resetSelection('Select a new .bin file');
+                stopPoll();
+            }
+        };
+        xhr.onerror = () => {
+            clearTimeout(fallbackTimer);
+            stopPoll();
+            if (uploadLikelyComplete) {
+                setStatus(true, 'Upload finished. Device may be rebooting...');
+                startRebootVerification();
+            } else {
+                setStatus(false, 'Update upload failed. Please select file again.');
+                eta.textContent = 'Error.';
+                resetSelection('Select a new .bin file');
+            }
+        };
+        xhr.send(fd);
+    });
+});
+
+function rebootDevice() {
+    if (!confirm('Are you sure you want to reboot the device?')) return;
+    var status = document.getElementById('reboot-status');
+    status.style.display = 'block';
+    status.style.backgroundColor = '#FFF3E0';
+    status.style.color = '#E65100';
+    status.innerHTML = 'Rebooting device... Please wait.';
+    fetch('/reboot', {method: 'POST'}).catch(function() {});
+    setTimeout(function() {
+        status.innerHTML = 'Waiting for device to restart...';
+        var startTime = Date.now();
+        var checkInterval = setInterval(function() {
+            fetch('/version?r=' + Date.now(), { cache: 'no-store' }).then(function(r) {
+                if (!r.ok) throw new Error('HTTP ' + r.status);
+                return r.json();
+            }).then(function() {
+                clearInterval(checkInterval);
+                status.style.backgroundColor = '#E8F5E9';
+                status.style.color = '#2E7D32';
+                status.innerHTML = 'Device restarted successfully. Redirecting to Status...';
+                setTimeout(function() { window.location.href='/?tab=status&r=' + Date.now(); }, 1000);
+            }).catch(function() {
+                if (Date.now() - startTime > 70000) {
+                    clearInterval(checkInterval);
+                    status.style.backgroundColor = '#FFEBEE';
+                    status.style.color = '#C62828';
+                    status.innerHTML = 'Timeout waiting for restart. Please refresh manually.';
+                }
+            });
+        }, 2500);
+    }, 2500);
+}